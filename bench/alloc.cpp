@@ -0,0 +1,26 @@
+#include "iso8583/allocator.h"
+#include "bench.h"
+
+/*
+ * Heap call counters.
+ *
+ * All memory the library uses is allocated through its default allocator,
+ * so a counting allocator installed at startup sees every heap call
+ * made by encode, decode, and other operations.
+ * Heap calls made by the benchmark code itself are not counted.
+ */
+
+static ISO8583::TCountingAllocator counter;
+
+//------------------------------------------------------------------------------
+void bench::install_allocator()
+{
+    iso8583_allocator_set_default(counter.GetInterface());
+}
+//------------------------------------------------------------------------------
+uint64_t bench::alloc_count()
+{
+    iso8583_alloc_stats_t stats = counter.GetStats();
+    return stats.allocs + stats.reallocs;
+}
+//------------------------------------------------------------------------------
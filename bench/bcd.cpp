@@ -0,0 +1,134 @@
+#include <string>
+#include <gen/bcd.h>
+#include "iso8583/iso8583.h"
+#include "iso8583/helper.h"
+#include "bcdconv.h"
+#include "bench.h"
+
+/*
+ * BCD conversion kernels against the digit by digit code
+ * (genutil bcd_decode / bcd_encode and a plain nibble loop),
+ * on the sizes of amount fields (6 bytes), PAN (10 bytes), and a long numeric field.
+ */
+
+static const uint64_t loops = 1000000;
+
+static volatile uint64_t sink;
+
+//------------------------------------------------------------------------------
+static
+void bench_to_int()
+{
+    static const uint8_t amount[6]  = { 0x00,0x00,0x00,0x01,0x25,0x00 };
+    static const uint8_t pan   [10] = { 0x04,0x76,0x17,0x39,0x00,0x10,0x10,0x01,0x09,0x99 };
+
+    bench::measure("bcd to int, amount, genutil", loops, sizeof(amount), [&]()
+    {
+        sink = bcd_decode(amount, sizeof(amount));
+    });
+    bench::measure("bcd to int, 19 digits, genutil", loops, sizeof(pan), [&]()
+    {
+        sink = bcd_decode(pan, sizeof(pan));
+    });
+
+    static const char *isa_names[] = { "scalar", "ssse3" };
+    for(int isa=BCDCONV_ISA_SCALAR; isa<=(int)bcdconv_get_best_isa(); ++isa)
+    {
+        std::string name = std::string("bcd to int, amount, ") + isa_names[isa];
+        bench::measure(name.c_str(), loops, sizeof(amount), [&]()
+        {
+            sink = bcdconv_to_int_isa(amount, sizeof(amount), (bcdconv_isa_t) isa);
+        });
+
+        name = std::string("bcd to int, 19 digits, ") + isa_names[isa];
+        bench::measure(name.c_str(), loops, sizeof(pan), [&]()
+        {
+            sink = bcdconv_to_int_isa(pan, sizeof(pan), (bcdconv_isa_t) isa);
+        });
+    }
+}
+//------------------------------------------------------------------------------
+static
+void bench_from_int()
+{
+    uint8_t  buf[10];
+    uint64_t value = 4761739001010010999ULL;
+
+    bench::measure("int to bcd, 19 digits, genutil", loops, sizeof(buf), [&]()
+    {
+        bcd_encode(buf, sizeof(buf), value);
+        sink = buf[0];
+    });
+    bench::measure("int to bcd, 19 digits, grouped", loops, sizeof(buf), [&]()
+    {
+        bcdconv_from_int(buf, sizeof(buf), value);
+        sink = buf[0];
+    });
+}
+//------------------------------------------------------------------------------
+static
+void bench_ascii()
+{
+    static uint8_t bcd[52];
+    static char    str[104];
+    for(size_t i=0; i<sizeof(bcd); ++i)
+        bcd[i] = ( ( i % 10 ) << 4 ) | ( ( i * 3 ) % 10 );
+
+    bench::measure("bcd to ascii, 104 digits, loop", loops, sizeof(bcd), [&]()
+    {
+        for(size_t i=0; i<sizeof(bcd); ++i)
+        {
+            str[2*i  ] = '0' + ( bcd[i] >> 4 );
+            str[2*i+1] = '0' + ( bcd[i] & 0x0F );
+        }
+        sink = str[0];
+    });
+
+    static const char *isa_names[] = { "scalar", "ssse3" };
+    for(int isa=BCDCONV_ISA_SCALAR; isa<=(int)bcdconv_get_best_isa(); ++isa)
+    {
+        std::string name = std::string("bcd to ascii, 104 digits, ") + isa_names[isa];
+        bench::measure(name.c_str(), loops, sizeof(bcd), [&]()
+        {
+            bcdconv_to_ascii_isa(str, bcd, sizeof(bcd), (bcdconv_isa_t) isa);
+            sink = str[0];
+        });
+
+        name = std::string("ascii to bcd, 104 digits, ") + isa_names[isa];
+        bench::measure(name.c_str(), loops, sizeof(str), [&]()
+        {
+            sink = bcdconv_from_ascii_isa(bcd, str, sizeof(str), (bcdconv_isa_t) isa);
+        });
+    }
+}
+//------------------------------------------------------------------------------
+static
+void bench_helpers()
+{
+    ISO8583::TFields fields;
+    ISO8583::helper::SetInteger(fields, 4, 125000);
+
+    bench::measure("helper get_int, amount", loops, 6, [&]()
+    {
+        sink = ISO8583::helper::GetInteger(fields, 4, 0);
+    });
+    bench::measure("helper set_int, amount", loops, 6, [&]()
+    {
+        sink = ISO8583::helper::SetInteger(fields, 4, 125000);
+    });
+
+    char buf[16];
+    bench::measure("helper get_digits, amount", loops, 6, [&]()
+    {
+        sink = iso8583_helper_get_digits(fields.cptr(), 4, buf, sizeof(buf))[0];
+    });
+}
+//------------------------------------------------------------------------------
+void bench_bcd()
+{
+    bench_to_int();
+    bench_from_int();
+    bench_ascii();
+    bench_helpers();
+}
+//------------------------------------------------------------------------------
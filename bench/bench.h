@@ -0,0 +1,89 @@
+/*
+ * Benchmark utilities.
+ */
+#ifndef _ISO8583_BENCH_H_
+#define _ISO8583_BENCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+
+namespace bench
+{
+
+inline double now_ns()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>( steady_clock::now().time_since_epoch() ).count();
+}
+
+inline void report(const char *name, uint64_t ops, double elapsed_ns)
+{
+    double secs = elapsed_ns / 1e9;
+    printf("%-40s %12.1f ns/op %14.0f ops/s\n", name, elapsed_ns / ops, ops / secs);
+}
+
+inline void report_allocs(const char *name, uint64_t ops, uint64_t allocs)
+{
+    printf("%-40s %12.2f allocs/op\n", name, (double) allocs / ops);
+}
+
+// Make the counting allocator the default allocator of the library,
+// it should be called before any library object is constructed.
+void install_allocator();
+
+// Count of heap allocations (alloc and realloc) made by the library since the allocator installed.
+uint64_t alloc_count();
+
+template < typename Func >
+void measure(const char *name, uint64_t ops, size_t bytes_per_op, Func func)
+{
+    /*
+     * Run a function for a number of times after a short warm up,
+     * and report time, throughput and heap allocations of each call.
+     */
+    for(uint64_t i=0; i<ops/100; ++i)
+        func();
+
+    uint64_t allocs = alloc_count();
+    double   start  = now_ns();
+    for(uint64_t i=0; i<ops; ++i)
+        func();
+    double   elapsed = now_ns() - start;
+    allocs = alloc_count() - allocs;
+
+    double secs = elapsed / 1e9;
+    printf("%-40s %10.1f ns/op %12.0f ops/s %10.1f MB/s %6.2f allocs/op\n",
+           name,
+           elapsed / ops,
+           ops / secs,
+           bytes_per_op * ops / secs / 1e6,
+           (double) allocs / ops);
+}
+
+}  // namespace bench
+
+// Benchmark entries.
+void bench_queue();
+void bench_pool();
+void bench_reuse();
+void bench_stan();
+void bench_decoder();
+void bench_codec();
+void bench_latency();
+void bench_trace();
+void bench_charset();
+void bench_bcd();
+void bench_pan();
+void bench_typed();
+void bench_tlv();
+void bench_subfield();
+void bench_ebcdic();
+void bench_template();
+void bench_hash();
+void bench_replay();
+void bench_dispatch();
+void bench_response();
+
+#endif
@@ -0,0 +1,94 @@
+#include <string.h>
+#include <string>
+#include "iso8583/iso8583.h"
+#include "charset.h"
+#include "profiles.h"
+#include "bench.h"
+
+/*
+ * Throughput of the character class validation kernels,
+ * compared with a plain copy of the same size,
+ * and the cost of validation in decode of the fixed message profiles.
+ */
+
+static const uint64_t loops = 200000;
+
+static volatile int sink;
+
+//------------------------------------------------------------------------------
+static
+void bench_kernels()
+{
+    static const char *isa_names[] = { "scalar", "sse2", "avx2" };
+
+    static uint8_t text[1024];
+    static uint8_t bcd [1024];
+    static uint8_t copy[1024];
+    for(size_t i=0; i<sizeof(text); ++i)
+    {
+        text[i] = 'A' + i % 26;
+        bcd [i] = 0x12 + i % 0x08;
+    }
+
+    bench::measure("memcpy, 1 KB", loops, sizeof(copy), [&]()
+    {
+        memcpy(copy, text, sizeof(copy));
+        sink = copy[sizeof(copy)-1];
+    });
+
+    for(int isa=CHARSET_ISA_SCALAR; isa<=(int)charset_get_best_isa(); ++isa)
+    {
+        std::string name = std::string("validate ans, 1 KB, ") + isa_names[isa];
+        bench::measure(name.c_str(), loops, sizeof(text), [&]()
+        {
+            sink = charset_validate_isa(text, sizeof(text), FINFO_ELE_ANS, (charset_isa_t) isa);
+        });
+
+        name = std::string("validate n, 1 KB, ") + isa_names[isa];
+        bench::measure(name.c_str(), loops, sizeof(bcd), [&]()
+        {
+            sink = charset_validate_isa(bcd, sizeof(bcd), FINFO_ELE_N, (charset_isa_t) isa);
+        });
+    }
+}
+//------------------------------------------------------------------------------
+static
+void bench_decode()
+{
+    for(unsigned i=0; i<bench::profile_count; ++i)
+    {
+        const bench::profile_t &profile = bench::profiles[i];
+
+        ISO8583::TISO8583 msg;
+        profile.build(msg);
+
+        uint8_t buf[4096];
+        int size = msg.Encode(buf, sizeof(buf), ISO8583_FLAG_LVAR_COMPRESSED);
+        if( size <= 0 ) continue;
+
+        for(int flags : { (int) ISO8583_FLAG_LVAR_COMPRESSED,
+                          ISO8583_FLAG_LVAR_COMPRESSED | ISO8583_FLAG_VALIDATE_CHARSET })
+        {
+            std::string name = std::string("decode ") + profile.name +
+                               ( ( flags & ISO8583_FLAG_VALIDATE_CHARSET ) ? ", validated" : "" );
+            if( msg.Decode(buf, size, flags) != size )
+            {
+                // Only valid messages are measured, the profiles are expected to pass.
+                printf("%-40s rejected at field %d\n", name.c_str(), msg.Fields().GetErrorID());
+                continue;
+            }
+
+            bench::measure(name.c_str(), loops, size, [&]()
+            {
+                sink = msg.Decode(buf, size, flags);
+            });
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void bench_charset()
+{
+    bench_kernels();
+    bench_decode();
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,221 @@
+#include <string>
+#include <utility>
+#include "iso8583/iso8583.h"
+#include "iso8583/helper.h"
+extern "C"
+{
+#include "bitmap.h"
+#include "lvar.h"
+}
+#include "profiles.h"
+#include "bench.h"
+
+/*
+ * Micro benchmarks of each codec layer:
+ * bitmap, LVAR, field item, field container, and the whole message,
+ * on the fixed message profiles.
+ * Message objects are reused in loops, as what a long running service does.
+ */
+
+static const uint64_t loops = 200000;
+static const int      flags = ISO8583_FLAG_LVAR_COMPRESSED;
+
+static volatile int sink;
+
+//------------------------------------------------------------------------------
+static
+void bench_bitmap()
+{
+    bitmap_t bmp;
+    bitmap_init(&bmp);
+    for(int id : { 3, 11, 15, 41, 42, 50, 74, 82, 89, 97, 99, 128 })
+        bitmap_set_id(&bmp, id);
+
+    uint8_t buf[16];
+    int     size = bitmap_encode(&bmp, buf, sizeof(buf), flags);
+
+    bench::measure("bitmap encode, secondary", loops, size, [&]()
+    {
+        sink = bitmap_encode(&bmp, buf, sizeof(buf), flags);
+    });
+
+    bitmap_t out;
+    bench::measure("bitmap decode, secondary", loops, size, [&]()
+    {
+        sink = bitmap_decode(&out, buf, size, flags);
+    });
+}
+//------------------------------------------------------------------------------
+static
+void bench_lvar()
+{
+    static const uint8_t pan[10] = { 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x00, 0x10 };
+    static const uint8_t tlv[180] = { 0x9F, 0x26, 0x08 };
+
+    uint8_t buf[1024];
+    int     size;
+
+    size = lvar_encode(buf, sizeof(buf), pan, 8, FINFO_ELE_PAN, FINFO_LEN_LLVAR, 19, flags);
+    bench::measure("lvar encode, LLVAR PAN", loops, size, [&]()
+    {
+        sink = lvar_encode(buf, sizeof(buf), pan, 8, FINFO_ELE_PAN, FINFO_LEN_LLVAR, 19, flags);
+    });
+    bench::measure("lvar decode, LLVAR PAN", loops, size, [&]()
+    {
+        const void *payload;
+        size_t      paysz;
+        sink = lvar_decode_view(&payload, &paysz, buf, size, FINFO_ELE_PAN, FINFO_LEN_LLVAR, 19, flags);
+    });
+
+    size = lvar_encode(buf, sizeof(buf), tlv, sizeof(tlv), FINFO_ELE_ANS, FINFO_LEN_LLLVAR, 999, flags);
+    bench::measure("lvar encode, LLLVAR 180 bytes", loops, size, [&]()
+    {
+        sink = lvar_encode(buf, sizeof(buf), tlv, sizeof(tlv), FINFO_ELE_ANS, FINFO_LEN_LLLVAR, 999, flags);
+    });
+    bench::measure("lvar decode, LLLVAR 180 bytes", loops, size, [&]()
+    {
+        const void *payload;
+        size_t      paysz;
+        sink = lvar_decode_view(&payload, &paysz, buf, size, FINFO_ELE_ANS, FINFO_LEN_LLLVAR, 999, flags);
+    });
+}
+//------------------------------------------------------------------------------
+static
+void bench_fitem()
+{
+    ISO8583::TISO8583 msg;
+    bench::build_0200_emv(msg);
+
+    for(int id : { 2, 4, 35, 55 })
+    {
+        const ISO8583::TFitem &item = msg.Fields().GetItem(id);
+
+        uint8_t buf[1024];
+        int     size = item.Encode(buf, sizeof(buf), flags);
+
+        std::string name = "fitem encode, field " + std::to_string(id);
+        bench::measure(name.c_str(), loops, size, [&]()
+        {
+            sink = item.Encode(buf, sizeof(buf), flags);
+        });
+
+        ISO8583::TFitem out;
+        name = "fitem decode, field " + std::to_string(id);
+        bench::measure(name.c_str(), loops, size, [&]()
+        {
+            sink = out.Decode(buf, size, flags, id);
+        });
+    }
+}
+//------------------------------------------------------------------------------
+static
+void bench_profile(const bench::profile_t &profile)
+{
+    ISO8583::TISO8583 msg;
+    profile.build(msg);
+
+    uint8_t buf[2048];
+    int     size;
+    std::string prefix = std::string(profile.name) + " ";
+
+    size = msg.Fields().Encode(buf, sizeof(buf), flags);
+    bench::measure(( prefix + "fields encode" ).c_str(), loops, size, [&]()
+    {
+        sink = msg.Fields().Encode(buf, sizeof(buf), flags);
+    });
+
+    ISO8583::TFields fields;
+    bench::measure(( prefix + "fields decode" ).c_str(), loops, size, [&]()
+    {
+        sink = fields.Decode(buf, size, flags);
+    });
+
+    size = msg.Encode(buf, sizeof(buf), flags);
+    bench::measure(( prefix + "message encode" ).c_str(), loops, size, [&]()
+    {
+        sink = msg.Encode(buf, sizeof(buf), flags);
+    });
+
+    ISO8583::TISO8583 out;
+    bench::measure(( prefix + "message decode" ).c_str(), loops, size, [&]()
+    {
+        sink = out.Decode(buf, size, flags);
+    });
+
+    bench::measure(( prefix + "message build" ).c_str(), loops, size, [&]()
+    {
+        profile.build(out);
+    });
+
+    ISO8583::TISO8583 copy;
+    bench::measure(( prefix + "message clone" ).c_str(), loops, size, [&]()
+    {
+        copy = msg;
+    });
+
+    bench::measure(( prefix + "message move x2" ).c_str(), loops, size, [&]()
+    {
+        // Move forth and back to keep the source valid.
+        copy = std::move(out);
+        out  = std::move(copy);
+    });
+}
+//------------------------------------------------------------------------------
+static
+void bench_helpers()
+{
+    ISO8583::TISO8583 msg;
+    bench::build_0200_emv(msg);
+    ISO8583::TFields &fields = msg.Fields();
+
+    bench::measure("helper set PAN", loops, 0, [&]()
+    {
+        ISO8583::helper::SetPAN(fields, 4761739001010010ULL);
+    });
+    bench::measure("helper get PAN", loops, 0, [&]()
+    {
+        sink = ISO8583::helper::GetPAN(fields);
+    });
+    bench::measure("helper set STAN", loops, 0, [&]()
+    {
+        ISO8583::helper::SetSTAN(fields, 1234);
+    });
+    bench::measure("helper get STAN", loops, 0, [&]()
+    {
+        sink = ISO8583::helper::GetSTAN(fields);
+    });
+    bench::measure("helper set amount", loops, 0, [&]()
+    {
+        ISO8583::helper::SetInteger(fields, 4, 12500);
+    });
+    bench::measure("helper get amount", loops, 0, [&]()
+    {
+        sink = ISO8583::helper::GetInteger(fields, 4, 0);
+    });
+    bench::measure("helper set local date time", loops, 0, [&]()
+    {
+        ISO8583::helper::SetLocalDateTime(fields, 1760000000);
+    });
+    bench::measure("helper set terminal ID", loops, 0, [&]()
+    {
+        iso8583_helper_set_terminal_id(fields.cptr(), "TERM0001");
+    });
+    bench::measure("helper get terminal ID", loops, 0, [&]()
+    {
+        char id[8+1];
+        sink = iso8583_helper_get_terminal_id(fields.cptr(), id)[0];
+    });
+}
+//------------------------------------------------------------------------------
+void bench_codec()
+{
+    bench_bitmap();
+    bench_lvar();
+    bench_fitem();
+
+    for(unsigned i=0; i<bench::profile_count; ++i)
+        bench_profile(bench::profiles[i]);
+
+    bench_helpers();
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,44 @@
+/*
+ * Synthetic message corpus file.
+ *
+ * A corpus file is a plain sequence of frames, each of them is a message
+ * encoded with a size header, as what iso8583_exg_t sends and receives.
+ */
+#ifndef _ISO8583_BENCH_CORPUS_H_
+#define _ISO8583_BENCH_CORPUS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "iso8583/flags.h"
+
+namespace bench
+{
+
+// Encode options of messages in corpus files.
+static const int corpus_flags = ISO8583_FLAG_HAVE_SIZEHDR | ISO8583_FLAG_LVAR_COMPRESSED;
+
+// Environment variable to assign a corpus file to benchmarks.
+#define ISO8583_BENCH_CORPUS_ENV "ISO8583_BENCH_CORPUS"
+
+inline bool load_corpus(const char *filename, std::vector<uint8_t> &data)
+{
+    FILE *file = fopen(filename, "rb");
+    if( !file ) return false;
+
+    data.clear();
+
+    uint8_t buf[64*1024];
+    size_t  readsz;
+    while( 0 < ( readsz = fread(buf, 1, sizeof(buf), file) ) )
+        data.insert(data.end(), buf, buf + readsz);
+
+    bool res = !ferror(file);
+    fclose(file);
+
+    return res;
+}
+
+}  // namespace bench
+
+#endif
@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <set>
+#include "iso8583/iso8583.h"
+#include "finfo.h"
+#include "corpus.h"
+
+/*
+ * Synthetic message corpus generator.
+ *
+ * Messages are generated with field presence distributions of each MTI class,
+ * and the field values are random but valid to the element type and
+ * the length mode of the field in finfo_list.
+ */
+
+struct options_t
+{
+    unsigned long count;
+    unsigned long seed;
+    double        secondary;  // Ratio of messages with secondary bitmap in classes which do not need it.
+    unsigned      lllmin;     // Size range of LLLVAR payloads.
+    unsigned      lllmax;
+    const char   *output;
+};
+
+struct presence_t
+{
+    int    id;
+    double ratio;  // Probability of the field to be present.
+};
+
+struct mticlass_t
+{
+    int               mti;     // MTI of the request.
+    double            weight;  // Share of the class in the traffic.
+    const presence_t *fields;  // Field list ended by ID zero.
+};
+
+static const presence_t fields_auth[] =
+{
+    {  2, 1.0 }, {  3, 1.0 }, {  4, 1.0 }, {  7, 1.0 }, { 11, 1.0 }, { 12, 1.0 }, { 13, 1.0 },
+    { 14, 0.6 }, { 22, 1.0 }, { 23, 0.5 }, { 25, 1.0 }, { 32, 0.8 }, { 35, 0.7 }, { 37, 0.8 },
+    { 41, 1.0 }, { 42, 1.0 }, { 43, 0.4 }, { 49, 1.0 }, { 52, 0.3 }, { 55, 0.5 }, { 60, 0.2 },
+    { 62, 0.2 }, {  0, 0.0 },
+};
+
+static const presence_t fields_financial[] =
+{
+    {  2, 1.0 }, {  3, 1.0 }, {  4, 1.0 }, {  7, 1.0 }, { 11, 1.0 }, { 12, 1.0 }, { 13, 1.0 },
+    { 14, 0.6 }, { 18, 0.7 }, { 22, 1.0 }, { 23, 0.6 }, { 25, 1.0 }, { 32, 0.9 }, { 35, 0.7 },
+    { 37, 0.9 }, { 41, 1.0 }, { 42, 1.0 }, { 43, 0.5 }, { 49, 1.0 }, { 52, 0.4 }, { 54, 0.1 },
+    { 55, 0.6 }, { 60, 0.3 }, { 62, 0.3 }, { 63, 0.2 }, { 64, 0.3 }, {  0, 0.0 },
+};
+
+static const presence_t fields_reversal[] =
+{
+    {  2, 1.0 }, {  3, 1.0 }, {  4, 1.0 }, {  7, 1.0 }, { 11, 1.0 }, { 12, 1.0 }, { 13, 1.0 },
+    { 22, 1.0 }, { 25, 1.0 }, { 32, 0.9 }, { 37, 1.0 }, { 41, 1.0 }, { 42, 1.0 }, { 49, 1.0 },
+    { 55, 0.3 }, { 90, 0.9 }, {  0, 0.0 },
+};
+
+static const presence_t fields_settlement[] =
+{
+    {  3, 1.0 }, {  7, 1.0 }, { 11, 1.0 }, { 15, 1.0 }, { 41, 1.0 }, { 42, 1.0 }, { 50, 1.0 },
+    { 74, 0.9 }, { 75, 0.9 }, { 76, 0.9 }, { 77, 0.9 }, { 78, 0.5 }, { 79, 0.5 }, { 80, 0.7 },
+    { 81, 0.9 }, { 82, 0.8 }, { 83, 0.8 }, { 84, 0.8 }, { 85, 0.8 }, { 86, 0.9 }, { 87, 0.9 },
+    { 88, 0.9 }, { 89, 0.9 }, { 97, 1.0 }, { 99, 0.8 }, {128, 0.5 }, {  0, 0.0 },
+};
+
+static const presence_t fields_network[] =
+{
+    {  7, 1.0 }, { 11, 1.0 }, { 33, 0.5 }, { 41, 0.5 }, { 53, 0.3 }, { 70, 1.0 }, { 96, 0.2 },
+    {  0, 0.0 },
+};
+
+static const mticlass_t classes[] =
+{
+    { 0x0100, 0.30, fields_auth       },
+    { 0x0200, 0.45, fields_financial  },
+    { 0x0400, 0.05, fields_reversal   },
+    { 0x0500, 0.05, fields_settlement },
+    { 0x0800, 0.15, fields_network    },
+};
+
+// Secondary fields which may be added to messages of any class.
+static const int secondary_fields[] = { 100, 102, 103, 104, 123, 124, 125, 126, 127 };
+
+// Fields which only appear in responses.
+static const presence_t fields_response[] =
+{
+    { 38, 0.7 }, { 39, 1.0 }, { 44, 0.2 }, {  0, 0.0 },
+};
+
+static std::mt19937_64 rng;
+
+//------------------------------------------------------------------------------
+static
+unsigned rand_range(unsigned min, unsigned max)
+{
+    return std::uniform_int_distribution<unsigned>(min, max)(rng);
+}
+//------------------------------------------------------------------------------
+static
+bool rand_hit(double ratio)
+{
+    return std::uniform_real_distribution<double>(0, 1)(rng) < ratio;
+}
+//------------------------------------------------------------------------------
+static
+char rand_char(const char *charset)
+{
+    return charset[ rand_range(0, strlen(charset) - 1) ];
+}
+//------------------------------------------------------------------------------
+static
+size_t gen_value(uint8_t *buf, int id, const options_t &opts)
+{
+    static const char alpha  [] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    static const char alnum  [] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    static const char special[] = " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+    static const char printable[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+    const finfo_t *finfo = &finfo_list[id];
+
+    // Element count.
+    unsigned count;
+    switch( finfo->lenmode )
+    {
+    case FINFO_LEN_LLVAR :
+        count = rand_range(( finfo->maxcount + 1 ) / 2, finfo->maxcount);
+        break;
+
+    case FINFO_LEN_LLLVAR :
+        {
+            unsigned max = opts.lllmax < (unsigned) finfo->maxcount ? opts.lllmax : finfo->maxcount;
+            unsigned min = opts.lllmin < max ? opts.lllmin : max;
+            count = rand_range(min, max);
+        }
+        break;
+
+    default :
+        count = finfo->maxcount;
+        break;
+    }
+
+    switch( finfo->eletype )
+    {
+    case FINFO_ELE_N :
+    case FINFO_ELE_PAN :
+        {
+            size_t size = ( count + 1 ) / 2;
+            for(size_t i=0; i<size; ++i)
+                buf[i] = ( rand_range(0, 9) << 4 ) | rand_range(0, 9);
+            return size;
+        }
+
+    case FINFO_ELE_B :
+        {
+            size_t size = ( count + 7 ) / 8;
+            for(size_t i=0; i<size; ++i)
+                buf[i] = rand_range(0, 255);
+            return size;
+        }
+
+    case FINFO_ELE_BIN :
+        for(unsigned i=0; i<count; ++i)
+            buf[i] = rand_range(0, 255);
+        return count;
+
+    case FINFO_ELE_Z :
+        {
+            // Track 2 data: PAN, separator, and the discretionary digits.
+            unsigned sep = rand_range(count / 3, count / 2);
+            for(unsigned i=0; i<count; ++i)
+                buf[i] = ( i == sep ) ? '=' : '0' + rand_range(0, 9);
+            return count;
+        }
+
+    default :
+        {
+            const char *charset = printable;
+            switch( finfo->eletype )
+            {
+            case FINFO_ELE_A  :  charset = alpha;   break;
+            case FINFO_ELE_AN :  charset = alnum;   break;
+            case FINFO_ELE_S  :  charset = special; break;
+            default           :  break;
+            }
+
+            for(unsigned i=0; i<count; ++i)
+                buf[i] = rand_char(charset);
+            return count;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+static
+const mticlass_t& pick_class()
+{
+    double point = std::uniform_real_distribution<double>(0, 1)(rng);
+    for(const mticlass_t &cls : classes)
+    {
+        if( point < cls.weight ) return cls;
+        point -= cls.weight;
+    }
+
+    return classes[0];
+}
+//------------------------------------------------------------------------------
+static
+void gen_message(iso8583_t *msg, const options_t &opts)
+{
+    const mticlass_t &cls = pick_class();
+    bool response = rand_hit(0.5);
+
+    std::set<int> ids;
+    for(const presence_t *pres = cls.fields; pres->id; ++pres)
+        if( rand_hit(pres->ratio) ) ids.insert(pres->id);
+
+    if( response )
+        for(const presence_t *pres = fields_response; pres->id; ++pres)
+            if( rand_hit(pres->ratio) ) ids.insert(pres->id);
+
+    if( rand_hit(opts.secondary) )
+    {
+        size_t count = sizeof(secondary_fields) / sizeof(secondary_fields[0]);
+        ids.insert(secondary_fields[ rand_range(0, count - 1) ]);
+    }
+
+    iso8583_clear(msg);
+    iso8583_set_mti(msg, response ? cls.mti + 0x10 : cls.mti);
+
+    iso8583_fields_t *fields = iso8583_get_fields(msg);
+    for(int id : ids)
+    {
+        uint8_t buf[1024];
+        size_t  size = gen_value(buf, id, opts);
+        iso8583_fields_set_data(fields, id, buf, size);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void print_usage()
+{
+    printf("Usage: iso8583_corpusgen [options]\n"
+           "  -n COUNT    Count of messages to generate (default 100000).\n"
+           "  -o FILE     Output file name (default corpus.bin).\n"
+           "  -s SEED     Random seed (default 1).\n"
+           "  -x RATIO    Ratio of messages which have an extra secondary field (default 0.1).\n"
+           "  -l MIN-MAX  Payload size range of LLLVAR fields (default 16-256).\n");
+}
+//------------------------------------------------------------------------------
+static
+bool parse_options(options_t &opts, int argc, char *argv[])
+{
+    opts.count     = 100000;
+    opts.seed      = 1;
+    opts.secondary = 0.1;
+    opts.lllmin    = 16;
+    opts.lllmax    = 256;
+    opts.output    = "corpus.bin";
+
+    for(int i=1; i<argc; ++i)
+    {
+        const char *opt = argv[i];
+        const char *val = i+1 < argc ? argv[i+1] : NULL;
+        if( opt[0] != '-' || !opt[1] || opt[2] || !val ) return false;
+        ++i;
+
+        switch( opt[1] )
+        {
+        case 'n' :  opts.count     = strtoul(val, NULL, 10); break;
+        case 'o' :  opts.output    = val;                    break;
+        case 's' :  opts.seed      = strtoul(val, NULL, 10); break;
+        case 'x' :  opts.secondary = strtod(val, NULL);      break;
+        case 'l' :
+            if( 2 != sscanf(val, "%u-%u", &opts.lllmin, &opts.lllmax) ) return false;
+            if( opts.lllmin > opts.lllmax ) return false;
+            break;
+
+        default :
+            return false;
+        }
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    options_t opts;
+    if( !parse_options(opts, argc, argv) )
+    {
+        print_usage();
+        return 1;
+    }
+
+    FILE *file = fopen(opts.output, "wb");
+    if( !file )
+    {
+        fprintf(stderr, "Cannot open file: %s\n", opts.output);
+        return 1;
+    }
+
+    rng.seed(opts.seed);
+
+    iso8583_t msg;
+    iso8583_init(&msg);
+
+    unsigned long      written = 0;
+    unsigned long long total   = 0;
+    for(unsigned long i=0; i<opts.count; ++i)
+    {
+        gen_message(&msg, opts);
+
+        uint8_t buf[16*1024];
+        int size = iso8583_encode(&msg, buf, sizeof(buf), bench::corpus_flags);
+        if( size < 0 )
+        {
+            fprintf(stderr, "Failed to encode message %lu, error code: %d\n", i, size);
+            break;
+        }
+
+        fwrite(buf, 1, size, file);
+        total += size;
+        ++written;
+    }
+
+    iso8583_deinit(&msg);
+    fclose(file);
+
+    printf("%lu messages, %llu bytes written to %s\n", written, total, opts.output);
+    return written == opts.count ? 0 : 1;
+}
+//------------------------------------------------------------------------------
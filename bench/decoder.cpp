@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "iso8583/iso8583.h"
+#include "iso8583/helper.h"
+#include "iso8583/exchange.h"
+#include "iso8583/decoder.h"
+#include "corpus.h"
+#include "bench.h"
+
+/*
+ * Capture stream decode: a sequential loop of iso8583_exg_recv_frame,
+ * against the parallel decoder from 1 thread to the count of CPUs.
+ * The stream is loaded from the corpus file assigned by ISO8583_BENCH_CORPUS if any.
+ */
+
+static const unsigned build_frames = 200000;
+static const int      flags        = bench::corpus_flags;
+
+//------------------------------------------------------------------------------
+static
+void build_stream(std::vector<uint8_t> &stream)
+{
+    ISO8583::TISO8583 msg;
+    for(unsigned i=0; i<build_frames; ++i)
+    {
+        msg.Fields().Clear();
+        msg.SetMTI(0x0200);
+        ISO8583::helper::SetPAN          (msg.Fields(), 4761739001010010ULL + i);
+        ISO8583::helper::SetProcCode     (msg.Fields(), 2400);
+        ISO8583::helper::SetInteger      (msg.Fields(), 4, 100 + i % 5000);
+        ISO8583::helper::SetSTAN         (msg.Fields(), i % 999999 + 1);
+        ISO8583::helper::SetLocalDateTime(msg.Fields(), 1760000000 + i);
+        ISO8583::helper::SetTerminalID   (msg.Fields(), "TERM0001");
+        ISO8583::helper::SetMerchantID   (msg.Fields(), "MERCHANT0000001");
+
+        uint8_t buf[1024];
+        int size = msg.Encode(buf, sizeof(buf), flags);
+        if( size > 0 ) stream.insert(stream.end(), buf, buf + size);
+    }
+}
+//------------------------------------------------------------------------------
+struct counter_t
+{
+    std::atomic<unsigned long long> sum;
+    std::atomic<unsigned>           errors;
+
+    counter_t() : sum(0), errors(0) {}
+
+    void operator()(size_t index, const ISO8583::TISO8583 &msg, int errcode)
+    {
+        if( errcode ) errors.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(ISO8583::helper::GetSTAN(msg.Fields()), std::memory_order_relaxed);
+    }
+};
+//------------------------------------------------------------------------------
+void bench_decoder()
+{
+    std::vector<uint8_t> stream;
+
+    const char *corpus = getenv(ISO8583_BENCH_CORPUS_ENV);
+    if( corpus )
+    {
+        if( !bench::load_corpus(corpus, stream) )
+        {
+            printf("Cannot load corpus file: %s\n", corpus);
+            return;
+        }
+    }
+    else
+    {
+        build_stream(stream);
+    }
+
+    unsigned frames = 0;
+    for(size_t pos=0; pos<stream.size(); ++frames)
+    {
+        int framesz = ISO8583::TExchange::PeekFrame(&stream[pos], stream.size() - pos);
+        if( framesz <= 0 ) break;
+        pos += framesz;
+    }
+
+    {
+        ISO8583::TExchange exg(flags, NULL, NULL, NULL);
+        ISO8583::TISO8583  msg;
+        counter_t          counter;
+
+        double start = bench::now_ns();
+        for(size_t pos=0; pos<stream.size(); )
+        {
+            int framesz = ISO8583::TExchange::PeekFrame(&stream[pos], stream.size() - pos);
+            if( framesz <= 0 ) break;
+
+            int readsz = exg.RecvFrame(msg, &stream[pos], stream.size() - pos);
+            counter(0, msg, readsz < 0 ? readsz : 0);
+            pos += framesz;
+        }
+        bench::report("sequential recv_frame", frames, bench::now_ns() - start);
+        if( counter.errors ) printf("%u frames failed to be decoded\n", counter.errors.load());
+    }
+
+    unsigned ncpus = std::thread::hardware_concurrency();
+    if( !ncpus ) ncpus = 1;
+
+    for(int ordered=0; ordered<2; ++ordered)
+    {
+        for(unsigned nthreads=1; nthreads<=ncpus; nthreads*=2)
+        {
+            ISO8583::TDecoder decoder(nthreads, flags, ordered ? ISO8583_DECODER_ORDERED : 0);
+            counter_t         counter;
+
+            double start = bench::now_ns();
+            decoder.Run(stream.data(), stream.size(), counter);
+
+            std::string name = std::string(ordered ? "ordered" : "unordered") +
+                               ", " + std::to_string(nthreads) + " threads";
+            bench::report(name.c_str(), frames, bench::now_ns() - start);
+            if( counter.errors ) printf("%u frames failed to be decoded\n", counter.errors.load());
+        }
+    }
+}
+//------------------------------------------------------------------------------
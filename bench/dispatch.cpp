@@ -0,0 +1,83 @@
+#include <vector>
+#include "iso8583/iso8583.h"
+#include "iso8583/dispatch.h"
+#include "bench.h"
+
+/*
+ * Delivering messages of mixed types to their handlers,
+ * by a chain of MTI comparisons as host code usually does, against the dispatch table.
+ */
+
+static const uint64_t loops = 10000000;
+
+static const int mtis[] =
+{
+    0x0100, 0x0120, 0x0200, 0x0201, 0x0220, 0x0400, 0x0401, 0x0420,
+    0x0421, 0x0500, 0x0520, 0x0600, 0x0800, 0x0820, 0x1200, 0x1420,
+};
+
+static volatile int sink;
+
+//------------------------------------------------------------------------------
+static
+int on_message(void *userarg, void *context, iso8583_t *msg, int resp_mti)
+{
+    return (int)(intptr_t) userarg + resp_mti;
+}
+//------------------------------------------------------------------------------
+static
+int dispatch_by_chain(const ISO8583::TISO8583 &msg)
+{
+    int mti  = msg.GetMTI();
+    int resp = ISO8583::mti::SetFunction(ISO8583::mti::SetOrigin(mti, ISO8583_MTI_ORI_ACQ),
+                                         ISO8583::mti::GetFunction(mti) + ISO8583_MTI_FUN_RESPONSE);
+
+    int cla = ISO8583::mti::GetClass(mti);
+    int fun = ISO8583::mti::GetFunction(mti);
+    if     ( cla == ISO8583_MTI_CLA_AUTH      && fun == ISO8583_MTI_FUN_REQUEST ) return on_message((void*) 1, NULL, NULL, resp);
+    else if( cla == ISO8583_MTI_CLA_AUTH      && fun == ISO8583_MTI_FUN_ADVICE  ) return on_message((void*) 2, NULL, NULL, resp);
+    else if( cla == ISO8583_MTI_CLA_FINANCIAL && fun == ISO8583_MTI_FUN_REQUEST ) return on_message((void*) 3, NULL, NULL, resp);
+    else if( cla == ISO8583_MTI_CLA_FINANCIAL && fun == ISO8583_MTI_FUN_ADVICE  ) return on_message((void*) 4, NULL, NULL, resp);
+    else if( cla == ISO8583_MTI_CLA_REVERSAL  && fun == ISO8583_MTI_FUN_REQUEST ) return on_message((void*) 5, NULL, NULL, resp);
+    else if( cla == ISO8583_MTI_CLA_REVERSAL  && fun == ISO8583_MTI_FUN_ADVICE  ) return on_message((void*) 6, NULL, NULL, resp);
+    else if( cla == ISO8583_MTI_CLA_RECON                                       ) return on_message((void*) 7, NULL, NULL, resp);
+    else if( cla == ISO8583_MTI_CLA_ADMIN                                       ) return on_message((void*) 8, NULL, NULL, resp);
+    else if( cla == ISO8583_MTI_CLA_NETWORK                                     ) return on_message((void*) 9, NULL, NULL, resp);
+    else                                                                          return on_message((void*) 0, NULL, NULL, resp);
+}
+//------------------------------------------------------------------------------
+void bench_dispatch()
+{
+    const size_t count = sizeof(mtis) / sizeof(mtis[0]);
+
+    std::vector<ISO8583::TISO8583> msgs(count);
+    for(size_t i=0; i<count; ++i)
+        msgs[i].SetMTI(mtis[i]);
+
+    ISO8583::TDispatcher disp;
+    disp.Set(ISO8583_MTI_CLA_AUTH      | ISO8583_MTI_FUN_REQUEST, ISO8583_MTI_ORI_MASK, on_message, (void*) 1);
+    disp.Set(ISO8583_MTI_CLA_AUTH      | ISO8583_MTI_FUN_ADVICE , ISO8583_MTI_ORI_MASK, on_message, (void*) 2);
+    disp.Set(ISO8583_MTI_CLA_FINANCIAL | ISO8583_MTI_FUN_REQUEST, ISO8583_MTI_ORI_MASK, on_message, (void*) 3);
+    disp.Set(ISO8583_MTI_CLA_FINANCIAL | ISO8583_MTI_FUN_ADVICE , ISO8583_MTI_ORI_MASK, on_message, (void*) 4);
+    disp.Set(ISO8583_MTI_CLA_REVERSAL  | ISO8583_MTI_FUN_REQUEST, ISO8583_MTI_ORI_MASK, on_message, (void*) 5);
+    disp.Set(ISO8583_MTI_CLA_REVERSAL  | ISO8583_MTI_FUN_ADVICE , ISO8583_MTI_ORI_MASK, on_message, (void*) 6);
+    disp.Set(ISO8583_MTI_CLA_RECON  , ISO8583_MTI_FUN_MASK | ISO8583_MTI_ORI_MASK, on_message, (void*) 7);
+    disp.Set(ISO8583_MTI_CLA_ADMIN  , ISO8583_MTI_FUN_MASK | ISO8583_MTI_ORI_MASK, on_message, (void*) 8);
+    disp.Set(ISO8583_MTI_CLA_NETWORK, ISO8583_MTI_FUN_MASK | ISO8583_MTI_ORI_MASK, on_message, (void*) 9);
+    disp.SetDefault(on_message, (void*) 0);
+
+    // Messages are taken in a pseudo random order, so that branches cannot be learned.
+    uint32_t seed = 1;
+    bench::measure("dispatch, comparison chain", loops, 0, [&]()
+    {
+        seed = seed * 1103515245 + 12345;
+        sink = dispatch_by_chain(msgs[ ( seed >> 16 ) % count ]);
+    });
+    seed = 1;
+    bench::measure("dispatch, table", loops, 0, [&]()
+    {
+        seed = seed * 1103515245 + 12345;
+        sink = disp.Dispatch(msgs[ ( seed >> 16 ) % count ]);
+    });
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,114 @@
+#include <string.h>
+#include <string>
+#include "iso8583/iso8583.h"
+#include "ebcdic.h"
+#include "profiles.h"
+#include "bench.h"
+
+/*
+ * Throughput of the EBCDIC transcoding kernels compared with a plain copy,
+ * and the cost of messages transcoded by the library,
+ * compared with a separate pass over the character fields after decoded
+ * (which is what the mainframe facing links did outside the library).
+ * Most of the 0200/emv profile is binary ICC data that neither path converts,
+ * so the two are expected to be close there.
+ */
+
+static const uint64_t loops = 200000;
+
+static volatile int sink;
+
+static bool char_fields[ISO8583_FITEM_ID_MAX+1];
+
+//------------------------------------------------------------------------------
+static
+void init_char_fields()
+{
+#define ISO8583_BENCH_CHAR_FIELD(id, ele, len, max)                       \
+    char_fields[id] = ISO8583::field::ELE_##ele != ISO8583::field::ELE_N   && \
+                      ISO8583::field::ELE_##ele != ISO8583::field::ELE_B   && \
+                      ISO8583::field::ELE_##ele != ISO8583::field::ELE_PAN && \
+                      ISO8583::field::ELE_##ele != ISO8583::field::ELE_BIN;
+    ISO8583_FIELD_DEFS(ISO8583_BENCH_CHAR_FIELD)
+#undef ISO8583_BENCH_CHAR_FIELD
+}
+//------------------------------------------------------------------------------
+static
+void transcode_pass(ISO8583::TFields &fields)
+{
+    for(const ISO8583::TFitem *item=&fields.GetFirst(); item->GetID(); item=&fields.GetNext(*item))
+    {
+        if( !char_fields[item->GetID()] ) continue;
+
+        size_t size = item->GetSize();
+        void  *data = fields.ResizeData(item->GetID(), size);
+        ebcdic_to_ascii_isa(data, data, size, EBCDIC_ISA_SCALAR);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void bench_kernels()
+{
+    static const char *isa_names[] = { "scalar", "avx2" };
+
+    static uint8_t text[1024];
+    static uint8_t copy[1024];
+    for(size_t i=0; i<sizeof(text); ++i)
+        text[i] = 'A' + i % 26;
+
+    bench::measure("memcpy, 1 KB", loops, sizeof(copy), [&]()
+    {
+        memcpy(copy, text, sizeof(copy));
+        sink = copy[sizeof(copy)-1];
+    });
+
+    for(int isa=EBCDIC_ISA_SCALAR; isa<=(int)ebcdic_get_best_isa(); ++isa)
+    {
+        std::string name = std::string("to ebcdic, 1 KB, ") + isa_names[isa];
+        bench::measure(name.c_str(), loops, sizeof(text), [&]()
+        {
+            ebcdic_from_ascii_isa(copy, text, sizeof(text), (ebcdic_isa_t) isa);
+            sink = copy[sizeof(copy)-1];
+        });
+    }
+}
+//------------------------------------------------------------------------------
+static
+void bench_decode()
+{
+    for(unsigned i=0; i<bench::profile_count; ++i)
+    {
+        const bench::profile_t &profile = bench::profiles[i];
+
+        ISO8583::TISO8583 msg;
+        profile.build(msg);
+
+        // The separate pass is given ASCII length values,
+        // so that it is not charged for converting them.
+        uint8_t ascii[4096], ebcdic[4096];
+        int size = msg.Encode(ascii , sizeof(ascii) , 0);
+        int esize = msg.Encode(ebcdic, sizeof(ebcdic), ISO8583_FLAG_EBCDIC);
+        if( size <= 0 || esize != size ) continue;
+
+        std::string name = std::string("decode ") + profile.name + ", separate pass";
+        bench::measure(name.c_str(), loops, size, [&]()
+        {
+            sink = msg.Decode(ascii, size, 0);
+            transcode_pass(msg.Fields());
+        });
+
+        name = std::string("decode ") + profile.name + ", ebcdic";
+        bench::measure(name.c_str(), loops, size, [&]()
+        {
+            sink = msg.Decode(ebcdic, size, ISO8583_FLAG_EBCDIC);
+        });
+    }
+}
+//------------------------------------------------------------------------------
+void bench_ebcdic()
+{
+    init_char_fields();
+    bench_kernels();
+    bench_decode();
+}
+//------------------------------------------------------------------------------
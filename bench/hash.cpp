@@ -0,0 +1,72 @@
+#include <string.h>
+#include "iso8583/iso8583.h"
+#include "profiles.h"
+#include "bench.h"
+
+/*
+ * Comparing and hashing messages without the volatile fields (7 and 11),
+ * by encoding the messages with the fields erased and processing the encoded bytes,
+ * and by the structural functions over the present fields.
+ */
+
+static const uint64_t loops = 1000000;
+
+static volatile uint64_t sink;
+
+//------------------------------------------------------------------------------
+static
+uint64_t fnv1a(const uint8_t *data, size_t size)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for(size_t i=0; i<size; ++i)
+        hash = ( hash ^ data[i] ) * 0x100000001B3ULL;
+    return hash;
+}
+//------------------------------------------------------------------------------
+static
+int encode_stable(ISO8583::TISO8583 &tmp, const ISO8583::TISO8583 &msg, uint8_t *buf, size_t size)
+{
+    tmp = msg;
+    tmp.Fields().Erase(7);
+    tmp.Fields().Erase(11);
+    return tmp.Encode(buf, size, 0);
+}
+//------------------------------------------------------------------------------
+void bench_hash()
+{
+    ISO8583::TISO8583 msg1;
+    bench::build_0200_emv(msg1);
+    msg1.Fields().SetData(7, "\x10\x19\x12\x00\x00", 5);
+    msg1.Fields().Set<ISO8583::F11>(1);
+
+    ISO8583::TISO8583 msg2(msg1);
+    msg2.Fields().SetData(7, "\x10\x19\x12\x00\x01", 5);
+    msg2.Fields().Set<ISO8583::F11>(2);
+
+    ISO8583::TFieldMask mask;
+    mask.Remove(7).Remove(11);
+
+    ISO8583::TISO8583 tmp;
+    uint8_t buf1[1024], buf2[1024];
+
+    bench::measure("hash, encode + FNV-1a", loops, 0, [&]()
+    {
+        int size = encode_stable(tmp, msg1, buf1, sizeof(buf1));
+        sink = fnv1a(buf1, size);
+    });
+    bench::measure("hash, structural", loops, 0, [&]()
+    {
+        sink = msg1.Hash(mask.cptr());
+    });
+    bench::measure("equal, encode + memcmp", loops, 0, [&]()
+    {
+        int size1 = encode_stable(tmp, msg1, buf1, sizeof(buf1));
+        int size2 = encode_stable(tmp, msg2, buf2, sizeof(buf2));
+        sink = size1 == size2 && 0 == memcmp(buf1, buf2, size1);
+    });
+    bench::measure("equal, structural", loops, 0, [&]()
+    {
+        sink = msg1.Equal(msg2, mask.cptr());
+    });
+}
+//------------------------------------------------------------------------------
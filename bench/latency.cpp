@@ -0,0 +1,70 @@
+#include <string.h>
+#include <utility>
+#include "iso8583/exchange.h"
+#include "iso8583/helper.h"
+#include "bench.h"
+
+/*
+ * Overhead of latency recording in the exchange layer,
+ * an exchange sending to a null sink with and without statistics attached.
+ */
+
+static const unsigned loops = 500000;
+
+//------------------------------------------------------------------------------
+static
+int on_send_null(void *userarg, const void *data, size_t size)
+{
+    return size;
+}
+//------------------------------------------------------------------------------
+static
+int on_recv_loop(void *userarg, void *buf, size_t size)
+{
+    // Replay the same frame forever.
+    static size_t pos = 0;
+    const std::pair<const uint8_t*, size_t> *frame = (const std::pair<const uint8_t*, size_t>*) userarg;
+
+    size_t restsz = frame->second - pos;
+    if( size > restsz ) size = restsz;
+
+    memcpy(buf, frame->first + pos, size);
+    pos = ( pos + size ) % frame->second;
+    return size;
+}
+//------------------------------------------------------------------------------
+void bench_latency()
+{
+    int flags = ISO8583_FLAG_HAVE_SIZEHDR | ISO8583_FLAG_LVAR_COMPRESSED;
+
+    ISO8583::TISO8583 msg;
+    msg.SetMTI(0x0200);
+    ISO8583::helper::SetPAN       (msg.Fields(), 4761739001010010ULL);
+    ISO8583::helper::SetSTAN      (msg.Fields(), 1);
+    ISO8583::helper::SetTerminalID(msg.Fields(), "TERM0001");
+
+    uint8_t buf[1024];
+    int size = msg.Encode(buf, sizeof(buf), flags);
+    if( size <= 0 ) return;
+
+    std::pair<const uint8_t*, size_t> frame(buf, size);
+
+    ISO8583::THistogram hist;
+    uint64_t value = 0;
+    bench::measure("histogram record", loops, 0, [&]{ hist.Record(value += 97); });
+
+    ISO8583::TExgStats stats;
+    ISO8583::TExchange exg(flags, &frame, on_send_null, on_recv_loop);
+
+    bench::measure("exchange send, no stats", loops, size, [&]{ exg.Send(msg, 1000); });
+    bench::measure("exchange recv, no stats", loops, size, [&]{ exg.Recv(msg, 1000); });
+
+    exg.SetStats(&stats);
+    bench::measure("exchange send, with stats", loops, size, [&]{ exg.Send(msg, 1000); });
+    bench::measure("exchange recv, with stats", loops, size, [&]{ exg.Recv(msg, 1000); });
+
+    char report[1024];
+    if( stats.Export(report, sizeof(report)) > 0 )
+        printf("%s", report);
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+
+struct entry_t
+{
+    const char *name;
+    void      (*run)();
+};
+
+static const entry_t entries[] =
+{
+    { "queue"   , bench_queue    },
+    { "pool"    , bench_pool     },
+    { "reuse"   , bench_reuse    },
+    { "stan"    , bench_stan     },
+    { "decoder" , bench_decoder  },
+    { "codec"   , bench_codec    },
+    { "latency" , bench_latency  },
+    { "trace"   , bench_trace    },
+    { "charset" , bench_charset  },
+    { "bcd"     , bench_bcd      },
+    { "pan"     , bench_pan      },
+    { "typed"   , bench_typed    },
+    { "tlv"     , bench_tlv      },
+    { "subfield", bench_subfield },
+    { "ebcdic"  , bench_ebcdic   },
+    { "template", bench_template },
+    { "hash"    , bench_hash     },
+    { "replay"  , bench_replay   },
+    { "dispatch", bench_dispatch },
+    { "response", bench_response },
+};
+
+int main(int argc, char *argv[])
+{
+    bench::install_allocator();
+
+    // Run all benchmarks, or only the ones named in the arguments.
+    for(const entry_t &entry : entries)
+    {
+        bool selected = argc < 2;
+        for(int i=1; i<argc; ++i)
+            selected |= 0 == strcmp(argv[i], entry.name);
+
+        if( !selected ) continue;
+
+        printf("== %s ==\n", entry.name);
+        entry.run();
+    }
+
+    return 0;
+}
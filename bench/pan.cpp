@@ -0,0 +1,117 @@
+#include <string.h>
+#include <gen/bcd.h>
+#include "iso8583/iso8583.h"
+#include "iso8583/helper.h"
+#include "panval.h"
+#include "bench.h"
+
+/*
+ * PAN codec, compared with the previous implementation
+ * (digits counted by divisions, and packed by a multiply and a BCD encode),
+ * on the common 16 digits PAN and a 19 digits one.
+ */
+
+static const uint64_t loops = 1000000;
+
+static volatile uint64_t sink;
+
+//------------------------------------------------------------------------------
+static
+size_t legacy_encode(uint8_t *buf, size_t bufsize, uint64_t pan)
+{
+    unsigned digits = 0;
+    for(uint64_t rest=pan; rest; rest/=10) ++digits;
+
+    unsigned fillsize = ( digits + 1 ) >> 1;
+    if( !fillsize || fillsize > bufsize ) return 0;
+
+    bool need_append = digits & 1;
+    if( need_append ) pan *= 10;
+    bcd_encode(buf, fillsize, pan);
+    if( need_append ) buf[fillsize-1] |= 0x0F;
+
+    return fillsize;
+}
+//------------------------------------------------------------------------------
+static
+uint64_t legacy_decode(const uint8_t *data, size_t size)
+{
+    unsigned last_digit = data[size-1] & 0x0F;
+
+    uint64_t pan = bcd_decode(data, size);
+    if( last_digit == 0xF )
+    {
+        pan -= last_digit;
+        pan /= 10;
+    }
+
+    return pan;
+}
+//------------------------------------------------------------------------------
+void bench_pan()
+{
+    static const struct
+    {
+        const char *name;
+        uint64_t    value;
+        const char *digits;
+    } cases[] =
+    {
+        { "16 digits", 4761739001010010ULL   , "4761739001010010"    },
+        { "19 digits", 6011000990139424123ULL, "6011000990139424123" },
+    };
+
+    for(const auto &c : cases)
+    {
+        char    name[64];
+        uint8_t buf[16];
+        size_t  size = panval_encode(buf, sizeof(buf), c.value);
+        char    str[20];
+
+        snprintf(name, sizeof(name), "pan encode, %s, legacy", c.name);
+        bench::measure(name, loops, size, [&]()
+        {
+            sink = legacy_encode(buf, sizeof(buf), c.value);
+        });
+        snprintf(name, sizeof(name), "pan encode, %s", c.name);
+        bench::measure(name, loops, size, [&]()
+        {
+            sink = panval_encode(buf, sizeof(buf), c.value);
+        });
+        snprintf(name, sizeof(name), "pan encode string, %s", c.name);
+        bench::measure(name, loops, size, [&]()
+        {
+            sink = panval_encode_str(buf, sizeof(buf), c.digits, strlen(c.digits));
+        });
+
+        snprintf(name, sizeof(name), "pan decode, %s, legacy", c.name);
+        bench::measure(name, loops, size, [&]()
+        {
+            sink = legacy_decode(buf, size);
+        });
+        snprintf(name, sizeof(name), "pan decode, %s", c.name);
+        bench::measure(name, loops, size, [&]()
+        {
+            sink = panval_decode(buf, size);
+        });
+        snprintf(name, sizeof(name), "pan decode string, %s", c.name);
+        bench::measure(name, loops, size, [&]()
+        {
+            sink = panval_decode_str(str, sizeof(str), buf, size);
+        });
+    }
+
+    ISO8583::TFields fields;
+    ISO8583::helper::SetPAN(fields, 4761739001010010ULL);
+
+    char pan[19+1];
+    bench::measure("helper get_pan_str, 16 digits", loops, 8, [&]()
+    {
+        sink = iso8583_helper_get_pan_str(fields.cptr(), pan)[0];
+    });
+    bench::measure("helper set_pan_str, 16 digits", loops, 8, [&]()
+    {
+        sink = iso8583_helper_set_pan_str(fields.cptr(), "4761739001010010");
+    });
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,63 @@
+#include "iso8583/iso8583.h"
+#include "iso8583/helper.h"
+#include "iso8583/pool.h"
+#include "bench.h"
+
+/*
+ * Message life cycle cost: construct, fill a few fields, and destroy,
+ * against acquire, fill, and release with the message pool.
+ */
+
+static const unsigned loops = 200000;
+
+//------------------------------------------------------------------------------
+static
+void fill_sample(ISO8583::TISO8583 &msg)
+{
+    msg.SetMTI(0x0200);
+    ISO8583::helper::SetProcCode  (msg.Fields(), 2400);
+    ISO8583::helper::SetSTAN      (msg.Fields(), 1);
+    ISO8583::helper::SetTerminalID(msg.Fields(), "TERM0001");
+}
+//------------------------------------------------------------------------------
+void bench_pool()
+{
+    {
+        double start = bench::now_ns();
+        for(unsigned i=0; i<loops; ++i)
+        {
+            ISO8583::TISO8583 *msg = new ISO8583::TISO8583;
+            fill_sample(*msg);
+            delete msg;
+        }
+        bench::report("new/delete", loops, bench::now_ns() - start);
+    }
+
+    {
+        ISO8583::TPool pool(64);
+
+        double start = bench::now_ns();
+        for(unsigned i=0; i<loops; ++i)
+        {
+            ISO8583::TISO8583 *msg = pool.Acquire();
+            fill_sample(*msg);
+            pool.Release(msg);
+        }
+        bench::report("pool acquire/release", loops, bench::now_ns() - start);
+    }
+
+    {
+        ISO8583::TPool      pool(64);
+        ISO8583::TPoolCache cache(pool);
+
+        double start = bench::now_ns();
+        for(unsigned i=0; i<loops; ++i)
+        {
+            ISO8583::TISO8583 *msg = cache.Acquire();
+            fill_sample(*msg);
+            cache.Release(msg);
+        }
+        bench::report("pool thread cache acquire/release", loops, bench::now_ns() - start);
+    }
+}
+//------------------------------------------------------------------------------
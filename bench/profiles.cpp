@@ -0,0 +1,116 @@
+#include "iso8583/helper.h"
+#include "profiles.h"
+
+using namespace ISO8583;
+
+//------------------------------------------------------------------------------
+void bench::build_0100(TISO8583 &msg)
+{
+    msg.Fields().Clear();
+    msg.SetMTI(0x0100);
+
+    helper::SetPAN          (msg.Fields(), 4761739001010010ULL);
+    helper::SetProcCode     (msg.Fields(), 0);
+    helper::SetInteger      (msg.Fields(), 4, 12500);
+    helper::SetSTAN         (msg.Fields(), 1234);
+    helper::SetLocalDateTime(msg.Fields(), 1760000000);
+    helper::SetInteger      (msg.Fields(), 22, 51);
+    helper::SetInteger      (msg.Fields(), 25, 0);
+    helper::SetTerminalID   (msg.Fields(), "TERM0001");
+    helper::SetMerchantID   (msg.Fields(), "MERCHANT0000001");
+    helper::SetInteger      (msg.Fields(), 49, 901);
+}
+//------------------------------------------------------------------------------
+void bench::build_0200_emv(TISO8583 &msg)
+{
+    // A typical chip card data of ARQC, in tag-length-value format.
+    static const uint8_t emv[] =
+    {
+        0x5F, 0x2A, 0x02, 0x09, 0x01,
+        0x82, 0x02, 0x5C, 0x00,
+        0x84, 0x07, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10,
+        0x95, 0x05, 0x00, 0x00, 0x00, 0x80, 0x00,
+        0x9A, 0x03, 0x25, 0x10, 0x19,
+        0x9C, 0x01, 0x00,
+        0x9F, 0x02, 0x06, 0x00, 0x00, 0x00, 0x01, 0x25, 0x00,
+        0x9F, 0x03, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x9F, 0x09, 0x02, 0x00, 0x8C,
+        0x9F, 0x10, 0x07, 0x06, 0x01, 0x0A, 0x03, 0xA0, 0xA0, 0x00,
+        0x9F, 0x1A, 0x02, 0x01, 0x58,
+        0x9F, 0x1E, 0x08, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38,
+        0x9F, 0x26, 0x08, 0x1C, 0x4E, 0x3A, 0x7F, 0x22, 0x9D, 0x60, 0x11,
+        0x9F, 0x27, 0x01, 0x80,
+        0x9F, 0x33, 0x03, 0xE0, 0xF8, 0xC8,
+        0x9F, 0x34, 0x03, 0x42, 0x03, 0x00,
+        0x9F, 0x35, 0x01, 0x22,
+        0x9F, 0x36, 0x02, 0x00, 0x3A,
+        0x9F, 0x37, 0x04, 0x9B, 0xAD, 0xBC, 0xAB,
+        0x9F, 0x41, 0x04, 0x00, 0x00, 0x12, 0x34,
+        0x9F, 0x53, 0x01, 0x52,
+    };
+
+    msg.Fields().Clear();
+    msg.SetMTI(0x0200);
+
+    helper::SetPAN          (msg.Fields(), 4761739001010010ULL);
+    helper::SetProcCode     (msg.Fields(), 0);
+    helper::SetInteger      (msg.Fields(), 4, 12500);
+    helper::SetSTAN         (msg.Fields(), 1234);
+    helper::SetLocalDateTime(msg.Fields(), 1760000000);
+    helper::SetInteger      (msg.Fields(), 14, 2512);
+    helper::SetInteger      (msg.Fields(), 22, 51);
+    helper::SetInteger      (msg.Fields(), 23, 1);
+    helper::SetInteger      (msg.Fields(), 25, 0);
+    helper::SetString       (msg.Fields(), 35, "4761739001010010=25122011143804400000");
+    helper::SetString       (msg.Fields(), 37, "529012345678");
+    helper::SetTerminalID   (msg.Fields(), "TERM0001");
+    helper::SetMerchantID   (msg.Fields(), "MERCHANT0000001");
+    helper::SetInteger      (msg.Fields(), 49, 901);
+    iso8583_helper_set_bin  (msg.Fields().cptr(), 55, emv, sizeof(emv));
+}
+//------------------------------------------------------------------------------
+void bench::build_0800(TISO8583 &msg)
+{
+    msg.Fields().Clear();
+    msg.SetMTI(0x0800);
+
+    helper::SetInteger   (msg.Fields(), 7, 1019120000);
+    helper::SetSTAN      (msg.Fields(), 1234);
+    helper::SetTerminalID(msg.Fields(), "TERM0001");
+    helper::SetInteger   (msg.Fields(), 70, 301);
+}
+//------------------------------------------------------------------------------
+void bench::build_0500(TISO8583 &msg)
+{
+    static const uint8_t mac[8] = { 0x1A, 0x2B, 0x3C, 0x4D, 0x5E, 0x6F, 0x70, 0x81 };
+
+    msg.Fields().Clear();
+    msg.SetMTI(0x0500);
+
+    helper::SetProcCode  (msg.Fields(), 920000);
+    helper::SetSTAN      (msg.Fields(), 1234);
+    helper::SetInteger   (msg.Fields(), 15, 1019);
+    helper::SetTerminalID(msg.Fields(), "TERM0001");
+    helper::SetMerchantID(msg.Fields(), "MERCHANT0000001");
+    helper::SetInteger   (msg.Fields(), 50, 901);
+
+    for(int id=74; id<=81; ++id)
+        helper::SetInteger(msg.Fields(), id, 100 + id);
+    for(int id=82; id<=89; ++id)
+        helper::SetInteger(msg.Fields(), id, 1000000 + id);
+
+    helper::SetInteger   (msg.Fields(), 97, 12345678);
+    helper::SetInteger   (msg.Fields(), 99, 12345678901ULL);
+    iso8583_helper_set_bin(msg.Fields().cptr(), 128, mac, sizeof(mac));
+}
+//------------------------------------------------------------------------------
+const bench::profile_t bench::profiles[] =
+{
+    { "0100"    , build_0100     },
+    { "0200/emv", build_0200_emv },
+    { "0800"    , build_0800     },
+    { "0500"    , build_0500     },
+};
+
+const unsigned bench::profile_count = sizeof(profiles) / sizeof(profiles[0]);
+//------------------------------------------------------------------------------
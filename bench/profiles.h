@@ -0,0 +1,32 @@
+/*
+ * Fixed message profiles used by benchmarks.
+ */
+#ifndef _ISO8583_BENCH_PROFILES_H_
+#define _ISO8583_BENCH_PROFILES_H_
+
+#include "iso8583/iso8583.h"
+
+namespace bench
+{
+
+struct profile_t
+{
+    const char *name;
+    void      (*build)(ISO8583::TISO8583 &msg);
+};
+
+// Short authorisation request, 0100.
+void build_0100(ISO8583::TISO8583 &msg);
+// Financial request with EMV data in field 55, 0200.
+void build_0200_emv(ISO8583::TISO8583 &msg);
+// Network management request with secondary bitmap, 0800.
+void build_0800(ISO8583::TISO8583 &msg);
+// Settlement request with reconciliation totals (fields 74 to 128), 0500.
+void build_0500(ISO8583::TISO8583 &msg);
+
+extern const profile_t profiles[];
+extern const unsigned  profile_count;
+
+}  // namespace bench
+
+#endif
@@ -0,0 +1,136 @@
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "iso8583/iso8583.h"
+#include "iso8583/helper.h"
+#include "iso8583/queue.h"
+#include "iso8583/pool.h"
+#include "bench.h"
+
+/*
+ * Pipeline throughput: producers take messages from a message pool,
+ * fill them, and hand them to consumers which return them to the pool.
+ * The mutex queue of message objects is the reference of what a copy on each hop costs.
+ */
+
+static const unsigned msgs_per_thread = 200000;
+static const unsigned pool_size       = 1024;
+
+//------------------------------------------------------------------------------
+static
+void fill_sample(ISO8583::TISO8583 &msg)
+{
+    msg.SetMTI(0x0200);
+    ISO8583::helper::SetPAN         (msg.Fields(), 4012888818888188ULL);
+    ISO8583::helper::SetProcCode    (msg.Fields(), 2400);
+    ISO8583::helper::SetInteger     (msg.Fields(), 4, 2400);
+    ISO8583::helper::SetSTAN        (msg.Fields(), 1);
+    ISO8583::helper::SetTerminalID  (msg.Fields(), "TERM0001");
+    ISO8583::helper::SetMerchantID  (msg.Fields(), "MERCHANT0000001");
+}
+//------------------------------------------------------------------------------
+static
+void run_mutex_copy()
+{
+    std::mutex                    lock;
+    std::queue<ISO8583::TISO8583> queue;
+
+    double start = bench::now_ns();
+
+    std::thread producer([&]()
+    {
+        for(unsigned i=0; i<msgs_per_thread; ++i)
+        {
+            ISO8583::TISO8583 msg;
+            fill_sample(msg);
+
+            while( true )
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if( queue.size() < pool_size )
+                {
+                    queue.push(msg);
+                    break;
+                }
+            }
+        }
+    });
+
+    std::thread consumer([&]()
+    {
+        unsigned count = 0;
+        while( count < msgs_per_thread )
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if( queue.empty() ) continue;
+
+            ISO8583::TISO8583 msg = queue.front();
+            queue.pop();
+            ++count;
+        }
+    });
+
+    producer.join();
+    consumer.join();
+
+    bench::report("mutex std::queue, copy, 1x1", msgs_per_thread, bench::now_ns() - start);
+}
+//------------------------------------------------------------------------------
+static
+void run_lockfree(const char *name, int mode, unsigned producers, unsigned consumers)
+{
+    ISO8583::TPool  pool(pool_size);
+    ISO8583::TQueue work(pool_size, mode);
+
+    unsigned total = msgs_per_thread * producers;
+    unsigned quota = total / consumers;
+
+    double start = bench::now_ns();
+
+    std::vector<std::thread> threads;
+    for(unsigned i=0; i<producers; ++i)
+    {
+        threads.push_back(std::thread([&]()
+        {
+            for(unsigned n=0; n<msgs_per_thread; ++n)
+            {
+                ISO8583::TISO8583 *msg;
+                while( !( msg = pool.Acquire() ) ) std::this_thread::yield();
+
+                fill_sample(*msg);
+
+                while( !work.Push(msg) ) std::this_thread::yield();
+            }
+        }));
+    }
+
+    for(unsigned i=0; i<consumers; ++i)
+    {
+        threads.push_back(std::thread([&]()
+        {
+            for(unsigned n=0; n<quota; ++n)
+            {
+                ISO8583::TISO8583 *msg;
+                while( !( msg = work.Pop() ) ) std::this_thread::yield();
+
+                pool.Release(msg);
+            }
+        }));
+    }
+
+    for(std::thread &thread : threads)
+        thread.join();
+
+    bench::report(name, total, bench::now_ns() - start);
+}
+//------------------------------------------------------------------------------
+void bench_queue()
+{
+    run_mutex_copy();
+    run_lockfree("lock-free SPSC, handle, 1x1", ISO8583_QUEUE_SPSC, 1, 1);
+    run_lockfree("lock-free MPMC, handle, 1x1", ISO8583_QUEUE_MPMC, 1, 1);
+    run_lockfree("lock-free MPMC, handle, 2x2", ISO8583_QUEUE_MPMC, 2, 2);
+    run_lockfree("lock-free MPMC, handle, 4x4", ISO8583_QUEUE_MPMC, 4, 4);
+}
+//------------------------------------------------------------------------------
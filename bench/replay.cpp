@@ -0,0 +1,161 @@
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "iso8583/iso8583.h"
+#include "iso8583/replay.h"
+#include "bench.h"
+
+/*
+ * Duplicate detection with millions of entries:
+ * a map guarded by a mutex and keyed by the identity fields, against the sharded replay cache.
+ * Each operation looks up a request, and stores a response if it is not found,
+ * half of the requests are duplicates of the earlier ones.
+ */
+
+static const unsigned entries         = 2000000;
+static const unsigned ops_per_thread  = 2000000;
+static const uint8_t  response[]      = "0210 response with a few fields of approval, about sixty bytes";
+
+//------------------------------------------------------------------------------
+static
+void set_identity(ISO8583::TISO8583 &msg, uint64_t seq)
+{
+    msg.Fields().Set<ISO8583::F11>(seq % 1000000);
+    char rrn[13];
+    snprintf(rrn, sizeof(rrn), "%012llu", (unsigned long long) seq);
+    msg.Fields().SetData(37, rrn, 12);
+}
+//------------------------------------------------------------------------------
+static
+void build_request(ISO8583::TISO8583 &msg)
+{
+    msg.SetMTI(0x0200);
+    msg.Fields().SetData( 2, "\x45\x11\x11\x11\x11\x11\x11\x11", 8);
+    msg.Fields().SetData( 4, "\x00\x00\x00\x01\x25\x00", 6);
+    msg.Fields().SetData( 7, "\x10\x19\x12\x00\x00", 5);
+    msg.Fields().SetData(32, "\x06\x12\x34\x56", 4);
+    msg.Fields().SetData(41, "TERM0001", 8);
+    msg.Fields().SetData(42, "MERCHANT0000001", 15);
+}
+//------------------------------------------------------------------------------
+static
+std::string identity_string(const ISO8583::TISO8583 &msg)
+{
+    static const int ids[] = { 2, 11, 32, 37, 41 };
+
+    std::string key(1, (char)( msg.GetMTI() & ~ISO8583_MTI_ORI_ACQ_REPEAT ));
+    for(int id : ids)
+    {
+        const ISO8583::TFitem &item = msg.Fields().GetItem(id);
+        key += (char) id;
+        key += (char) item.GetSize();
+        key.append((const char*) item.GetData(), item.GetSize());
+    }
+
+    return key;
+}
+//------------------------------------------------------------------------------
+template < typename Process >
+static
+void run(const std::string &name, unsigned nthreads, Process process)
+{
+    double start = bench::now_ns();
+
+    std::vector<std::thread> threads;
+    for(unsigned t=0; t<nthreads; ++t)
+    {
+        threads.push_back(std::thread([&, t]()
+        {
+            ISO8583::TISO8583 msg;
+            build_request(msg);
+
+            // Odd operations repeat a request of the preloaded ones,
+            // and even operations are new requests of this thread.
+            uint64_t fresh = entries + (uint64_t) t * ops_per_thread;
+            for(unsigned i=0; i<ops_per_thread; ++i)
+            {
+                set_identity(msg, i & 1 ? ( i * 2654435761u ) % entries : fresh++);
+                process(msg);
+            }
+        }));
+    }
+
+    for(std::thread &thread : threads)
+        thread.join();
+
+    bench::report(( name + ", " + std::to_string(nthreads) + " threads" ).c_str(),
+                  (uint64_t) ops_per_thread * nthreads,
+                  bench::now_ns() - start);
+}
+//------------------------------------------------------------------------------
+void bench_replay()
+{
+    ISO8583::TFieldMask keymask(false);
+    keymask.Add(2).Add(11).Add(32).Add(37).Add(41);
+
+    for(unsigned nthreads : { 1, 4 })
+    {
+        std::mutex                                   lock;
+        std::unordered_map<std::string, std::string> map;
+        map.reserve(entries);
+        {
+            ISO8583::TISO8583 msg;
+            build_request(msg);
+            for(unsigned i=0; i<entries; ++i)
+            {
+                set_identity(msg, i);
+                map[identity_string(msg)].assign((const char*) response, sizeof(response));
+            }
+        }
+        run("mutex map", nthreads, [&](const ISO8583::TISO8583 &msg)
+        {
+            uint8_t     buf[128];
+            std::string key = identity_string(msg);
+
+            std::lock_guard<std::mutex> guard(lock);
+            auto iter = map.find(key);
+            if( iter != map.end() )
+            {
+                memcpy(buf, iter->second.data(), iter->second.size());
+            }
+            else
+            {
+                // Bounded as the replay cache, by evicting an arbitrary entry.
+                if( map.size() >= entries ) map.erase(map.begin());
+                map.emplace(std::move(key), std::string((const char*) response, sizeof(response)));
+            }
+        });
+    }
+
+    for(unsigned nthreads : { 1, 4 })
+    {
+        ISO8583::TReplayCache cache(entries, ISO8583::TFieldMask(keymask), 60000);
+        {
+            ISO8583::TISO8583 msg;
+            build_request(msg);
+
+            double start = bench::now_ns();
+            for(unsigned i=0; i<entries; ++i)
+            {
+                set_identity(msg, i);
+                cache.Store(msg, response, sizeof(response));
+            }
+            bench::report("replay cache, preload", entries, bench::now_ns() - start);
+        }
+        run("replay cache", nthreads, [&](const ISO8583::TISO8583 &msg)
+        {
+            uint8_t buf[128];
+            if( !cache.Lookup(msg, buf, sizeof(buf)) )
+                cache.Store(msg, response, sizeof(response));
+        });
+
+        iso8583_replay_stats_t stats = cache.GetStats();
+        printf("%-40s %12.1f %% hits %10llu evictions\n",
+               "replay cache, stats",
+               100.0 * stats.hits / ( stats.hits + stats.misses ),
+               (unsigned long long) stats.evictions);
+    }
+}
+//------------------------------------------------------------------------------
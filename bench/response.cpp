@@ -0,0 +1,62 @@
+#include "iso8583/iso8583.h"
+#include "profiles.h"
+#include "bench.h"
+
+/*
+ * Answering decoded requests: building the response by inserting the echo fields one by one
+ * into a new message, against sharing them into a reused message, and making it in place.
+ */
+
+static const uint64_t loops = 1000000;
+
+static const int echo_ids[] = { 2, 3, 4, 7, 11, 12, 13, 22, 25, 32, 37, 41, 42, 49 };
+
+static volatile int sink;
+
+//------------------------------------------------------------------------------
+void bench_response()
+{
+    ISO8583::TISO8583 base;
+    bench::build_0200_emv(base);
+
+    uint8_t req_buf[1024], resp_buf[1024];
+    int     req_size = base.Encode(req_buf, sizeof(req_buf), 0);
+
+    ISO8583::TFieldMask echo(false);
+    for(int id : echo_ids) echo.Add(id);
+
+    ISO8583::TISO8583 req;
+    ISO8583::TISO8583 resp;
+
+    bench::measure("response, new message + insert", loops, req_size, [&]()
+    {
+        req.Decode(req_buf, req_size, 0);
+
+        ISO8583::TISO8583 out;
+        out.SetMTI(0x0210);
+        for(int id : echo_ids)
+        {
+            const ISO8583::TFitem &item = req.Fields().GetItem(id);
+            if( item.GetID() ) out.Fields().Insert(item);
+        }
+        out.Fields().SetData(39, "00", 2);
+        sink = out.Encode(resp_buf, sizeof(resp_buf), 0);
+    });
+    bench::measure("response, shared", loops, req_size, [&]()
+    {
+        req.Decode(req_buf, req_size, 0);
+
+        resp.MakeResponse(req, -1, echo.cptr());
+        resp.Fields().SetData(39, "00", 2);
+        sink = resp.Encode(resp_buf, sizeof(resp_buf), 0);
+    });
+    bench::measure("response, in place", loops, req_size, [&]()
+    {
+        req.Decode(req_buf, req_size, 0);
+
+        req.MakeResponse(-1, echo.cptr());
+        req.Fields().SetData(39, "00", 2);
+        sink = req.Encode(resp_buf, sizeof(resp_buf), 0);
+    });
+}
+//------------------------------------------------------------------------------
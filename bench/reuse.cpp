@@ -0,0 +1,82 @@
+#include "iso8583/iso8583.h"
+#include "iso8583/helper.h"
+#include "bench.h"
+
+/*
+ * Heap allocations per message when a message object is reused,
+ * against a fresh message object for each round.
+ */
+
+static const unsigned loops = 200000;
+
+//------------------------------------------------------------------------------
+static
+void fill_sample(ISO8583::TISO8583 &msg, unsigned stan)
+{
+    msg.SetMTI(0x0200);
+    ISO8583::helper::SetPAN          (msg.Fields(), 4761739001010010ULL);
+    ISO8583::helper::SetProcCode     (msg.Fields(), 2400);
+    ISO8583::helper::SetInteger      (msg.Fields(), 4, 1000);
+    ISO8583::helper::SetSTAN         (msg.Fields(), stan);
+    ISO8583::helper::SetLocalDateTime(msg.Fields(), 1760000000);
+    ISO8583::helper::SetTerminalID   (msg.Fields(), "TERM0001");
+    ISO8583::helper::SetMerchantID   (msg.Fields(), "MERCHANT0000001");
+}
+//------------------------------------------------------------------------------
+static
+void run(const char *name, void(*round)(ISO8583::TISO8583 *reused, unsigned i))
+{
+    ISO8583::TISO8583 reused;
+    round(&reused, 0);  // Warm up the reused object.
+
+    uint64_t allocs = bench::alloc_count();
+    double   start  = bench::now_ns();
+    for(unsigned i=0; i<loops; ++i)
+        round(&reused, i);
+    double   elapsed = bench::now_ns() - start;
+    allocs = bench::alloc_count() - allocs;
+
+    bench::report       (name, loops, elapsed);
+    bench::report_allocs(name, loops, allocs);
+}
+//------------------------------------------------------------------------------
+static uint8_t sample[1024];
+static int     samplesz;
+//------------------------------------------------------------------------------
+void bench_reuse()
+{
+    {
+        ISO8583::TISO8583 msg;
+        fill_sample(msg, 1);
+        samplesz = msg.Encode(sample, sizeof(sample), 0);
+        if( samplesz <= 0 ) return;
+    }
+
+    run("build, fresh message",
+        [](ISO8583::TISO8583 *reused, unsigned i)
+        {
+            ISO8583::TISO8583 msg;
+            fill_sample(msg, i);
+        });
+
+    run("build, reused message",
+        [](ISO8583::TISO8583 *reused, unsigned i)
+        {
+            reused->Fields().Clear();
+            fill_sample(*reused, i);
+        });
+
+    run("decode, fresh message",
+        [](ISO8583::TISO8583 *reused, unsigned i)
+        {
+            ISO8583::TISO8583 msg;
+            msg.Decode(sample, samplesz, 0);
+        });
+
+    run("decode, reused message",
+        [](ISO8583::TISO8583 *reused, unsigned i)
+        {
+            reused->Decode(sample, samplesz, 0);
+        });
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,70 @@
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "iso8583/stan.h"
+#include "bench.h"
+
+/*
+ * STAN allocation under many threads:
+ * a counter guarded by a mutex, against the shared atomic counter and the per CPU shards.
+ */
+
+static const unsigned stans_per_thread = 1000000;
+
+//------------------------------------------------------------------------------
+template < typename Alloc >
+static
+void run(const std::string &name, unsigned nthreads, Alloc alloc)
+{
+    double start = bench::now_ns();
+
+    std::vector<std::thread> threads;
+    for(unsigned i=0; i<nthreads; ++i)
+    {
+        threads.push_back(std::thread([&]()
+        {
+            volatile unsigned sink = 0;
+            for(unsigned n=0; n<stans_per_thread; ++n)
+                sink = alloc();
+            (void) sink;
+        }));
+    }
+
+    for(std::thread &thread : threads)
+        thread.join();
+
+    bench::report(( name + ", " + std::to_string(nthreads) + " threads" ).c_str(),
+                  stans_per_thread * nthreads,
+                  bench::now_ns() - start);
+}
+//------------------------------------------------------------------------------
+void bench_stan()
+{
+    for(unsigned nthreads : { 1, 4 })
+    {
+        std::mutex lock;
+        unsigned   counter = 0;
+        run("mutex counter", nthreads, [&]()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            counter = counter % ISO8583_STAN_MAX + 1;
+            return counter;
+        });
+
+        ISO8583::TSTAN shared;
+        run("atomic counter", nthreads, [&]() { return shared.Next(); });
+
+        ISO8583::TSTAN sharded(1, ISO8583_STAN_SHARDED);
+        run("sharded counter", nthreads, [&]() { return sharded.Next(); });
+
+        ISO8583::TSTAN tracked(1, ISO8583_STAN_SHARDED | ISO8583_STAN_TRACK_OUTSTANDING);
+        run("sharded counter, tracked", nthreads, [&]()
+        {
+            unsigned stan = tracked.Next();
+            tracked.Release(stan);
+            return stan;
+        });
+    }
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,83 @@
+#include <string>
+#include "iso8583/iso8583.h"
+#include "bench.h"
+
+/*
+ * Sub-fields of a tagged private use field, read by slicing strings
+ * (which is what the consumers did by hand) and by an index;
+ * and written by concatenating strings and by the encoder.
+ */
+
+static const uint64_t loops = 1000000;
+
+static volatile uint64_t sink;
+
+static const iso8583_subfield_spec_t spec = ISO8583_SUBFIELD_SPEC_TAGGED(2, 3);
+
+static const iso8583_subfield_t subs[] =
+{
+    { "01", "MERCHANT NAME"  , 13 },
+    { "02", "TAIPEI"         , 6  },
+    { "10", "0123456789"     , 10 },
+    { "21", "Y"              , 1  },
+    { "33", "REFERENCE-00042", 15 },
+};
+
+//------------------------------------------------------------------------------
+static
+std::string slice_value(const std::string &data, const char *tag)
+{
+    for(size_t pos=0; pos + 5 <= data.size(); )
+    {
+        size_t len = std::stoul(data.substr(pos + 2, 3));
+        if( data.compare(pos, 2, tag) == 0 ) return data.substr(pos + 5, len);
+        pos += 5 + len;
+    }
+
+    return std::string();
+}
+//------------------------------------------------------------------------------
+void bench_subfield()
+{
+    const unsigned count = sizeof(subs)/sizeof(subs[0]);
+
+    ISO8583::TFields fields;
+    int size = iso8583_subfield_encode(&spec, fields.cptr(), 48, subs, count);
+
+    std::string data((const char*) fields.GetItem(48).GetData(), size);
+    bench::measure("subfield read 3 tags, string slicing", loops, size, [&]()
+    {
+        sink = slice_value(data, "10").size() + slice_value(data, "21").size() + slice_value(data, "33").size();
+    });
+
+    ISO8583::TSubfieldIndex index;
+    bench::measure("subfield read 3 tags, index", loops, size, [&]()
+    {
+        index.Build(spec, fields.GetItem(48));
+
+        size_t a, b, c;
+        index.Find("10", &a);
+        index.Find("21", &b);
+        index.Find("33", &c);
+        sink = a + b + c;
+    });
+
+    bench::measure("subfield write, string concatenation", loops, size, [&]()
+    {
+        std::string out;
+        char        len[4];
+        for(unsigned i=0; i<count; ++i)
+        {
+            snprintf(len, sizeof(len), "%03u", (unsigned) subs[i].size);
+            out += subs[i].tag;
+            out += len;
+            out.append((const char*) subs[i].data, subs[i].size);
+        }
+        sink = fields.SetData(48, out.data(), out.size());
+    });
+    bench::measure("subfield write, encoder", loops, size, [&]()
+    {
+        sink = iso8583_subfield_encode(&spec, fields.cptr(), 48, subs, count);
+    });
+}
+//------------------------------------------------------------------------------
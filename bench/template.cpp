@@ -0,0 +1,62 @@
+#include "iso8583/iso8583.h"
+#include "iso8583/template.h"
+#include "profiles.h"
+#include "bench.h"
+
+/*
+ * Building messages which have most fields in common,
+ * by cloning a base message and by deriving from a template,
+ * and then overriding the fields of each transaction.
+ */
+
+static const uint64_t loops = 1000000;
+
+static volatile int sink;
+
+//------------------------------------------------------------------------------
+static
+void override_fields(ISO8583::TISO8583 &msg, uint64_t seq)
+{
+    msg.Fields().Set<ISO8583::F11>(seq % 1000000);
+    msg.Fields().Set<ISO8583::F4 >(seq % 100000 + 100);
+    msg.Fields().SetData(37, "000000123456", 12);
+}
+//------------------------------------------------------------------------------
+void bench_template()
+{
+    ISO8583::TISO8583 base;
+    bench::build_0200_emv(base);
+
+    ISO8583::TTemplate tmpl(base);
+    uint64_t seq = 0;
+
+    {
+        ISO8583::TISO8583 msg;
+        bench::measure("new message, clone", loops, 0, [&]()
+        {
+            ISO8583::TISO8583 out(base);
+            override_fields(out, ++seq);
+            sink = out.Fields().GetCount();
+        });
+        bench::measure("new message, derive", loops, 0, [&]()
+        {
+            ISO8583::TISO8583 out;
+            tmpl.Derive(out);
+            override_fields(out, ++seq);
+            sink = out.Fields().GetCount();
+        });
+        bench::measure("reused message, clone", loops, 0, [&]()
+        {
+            msg = base;
+            override_fields(msg, ++seq);
+            sink = msg.Fields().GetCount();
+        });
+        bench::measure("reused message, derive", loops, 0, [&]()
+        {
+            tmpl.Derive(msg);
+            override_fields(msg, ++seq);
+            sink = msg.Fields().GetCount();
+        });
+    }
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,107 @@
+#include <string.h>
+#include "iso8583/iso8583.h"
+#include "bench.h"
+
+/*
+ * TLV data of field 55, looked up by re-scanning the data for each tag
+ * (which is what the consumers did by hand), and by an index built once;
+ * and a response built by the builder.
+ */
+
+static const uint64_t loops = 1000000;
+
+static volatile uint64_t sink;
+
+static const uint8_t emv[] =
+{
+    0x9F,0x02, 0x06, 0x00,0x00,0x00,0x01,0x25,0x00,
+    0x9F,0x03, 0x06, 0x00,0x00,0x00,0x00,0x00,0x00,
+    0x9F,0x1A, 0x02, 0x01,0x58,
+    0x95,      0x05, 0x00,0x00,0x00,0x00,0x00,
+    0x5F,0x2A, 0x02, 0x09,0x01,
+    0x9A,      0x03, 0x26,0x10,0x19,
+    0x9C,      0x01, 0x00,
+    0x9F,0x37, 0x04, 0x11,0x22,0x33,0x44,
+    0x82,      0x02, 0x5C,0x00,
+    0x9F,0x36, 0x02, 0x00,0x31,
+    0x9F,0x10, 0x12, 0x01,0x10,0xA0,0x00,0x03,0x22,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xFF,
+    0x9F,0x33, 0x03, 0xE0,0xF8,0xC8,
+    0x9F,0x34, 0x03, 0x1E,0x03,0x00,
+    0x9F,0x35, 0x01, 0x22,
+    0x84,      0x07, 0xA0,0x00,0x00,0x00,0x03,0x10,0x10,
+    0x9F,0x09, 0x02, 0x00,0x8C,
+    0x9F,0x27, 0x01, 0x80,
+    0x9F,0x26, 0x08, 0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,
+};
+
+static const uint32_t wanted[] = { 0x9F26, 0x9F27, 0x9F10, 0x9F37, 0x9F36, 0x95, 0x9A, 0x9F02 };
+
+//------------------------------------------------------------------------------
+static
+const uint8_t* scan_value(const uint8_t *data, size_t size, uint32_t tag, size_t *length)
+{
+    const uint8_t *end = data + size;
+    while( data < end )
+    {
+        uint32_t cur = *data++;
+        if( ( cur & 0x1F ) == 0x1F )
+        {
+            do cur = cur << 8 | *data; while( *data++ & 0x80 );
+        }
+
+        size_t len = *data++;
+        if( len & 0x80 )
+        {
+            size_t count = len & 0x7F;
+            for(len=0; count; --count) len = len << 8 | *data++;
+        }
+
+        if( cur == tag )
+        {
+            *length = len;
+            return data;
+        }
+
+        data += len;
+    }
+
+    return NULL;
+}
+//------------------------------------------------------------------------------
+void bench_tlv()
+{
+    const size_t count = sizeof(wanted)/sizeof(wanted[0]);
+
+    bench::measure("tlv lookup 8 tags, re-scan", loops, sizeof(emv), [&]()
+    {
+        size_t total = 0, len;
+        for(size_t i=0; i<count; ++i)
+            total += scan_value(emv, sizeof(emv), wanted[i], &len) ? len : 0;
+        sink = total;
+    });
+
+    ISO8583::TTlvIndex index;
+    bench::measure("tlv lookup 8 tags, index", loops, sizeof(emv), [&]()
+    {
+        index.Build(emv, sizeof(emv));
+
+        size_t total = 0, len;
+        for(size_t i=0; i<count; ++i)
+            total += index.GetValue(wanted[i], &len) ? len : 0;
+        sink = total;
+    });
+
+    uint8_t buf[256];
+    ISO8583::TTlvBuilder builder(buf, sizeof(buf));
+    bench::measure("tlv build response", loops, 32, [&]()
+    {
+        builder.Reset();
+        builder.Add(0x91, "\x01\x02\x03\x04\x05\x06\x07\x08\x00\x00", 10);
+        builder.Begin(0x72);
+        builder.Add(0x9F18, "\x00\x00\x00\x01", 4);
+        builder.Add(0x86, "\x84\x24\x00\x00\x08\x11\x22\x33\x44\x55\x66\x77\x88", 13);
+        builder.End();
+        sink = builder.Finish();
+    });
+}
+//------------------------------------------------------------------------------
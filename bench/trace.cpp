@@ -0,0 +1,50 @@
+#include "iso8583/trace.h"
+#include "bench.h"
+#include "profiles.h"
+
+/*
+ * Per-field cost attribution of encode and decode on the fixed message profiles.
+ * The library should be built with ISO8583_ENABLE_TRACE defined
+ * (make ISO8583_ENABLE_TRACE=1) to have trace records.
+ */
+
+static const unsigned loops = 100000;
+
+//------------------------------------------------------------------------------
+void bench_trace()
+{
+    if( !iso8583_trace_is_enabled() )
+    {
+        printf("The library is built without ISO8583_ENABLE_TRACE, nothing to trace.\n");
+        return;
+    }
+
+    int flags = ISO8583_FLAG_LVAR_COMPRESSED;
+
+    for(unsigned i=0; i<bench::profile_count; ++i)
+    {
+        const bench::profile_t &profile = bench::profiles[i];
+
+        ISO8583::TISO8583 msg;
+        profile.build(msg);
+
+        uint8_t buf[4096];
+        int size = msg.Encode(buf, sizeof(buf), flags);
+        if( size <= 0 ) continue;
+
+        ISO8583::TProfiler profiler;
+        profiler.Attach();
+        for(unsigned n=0; n<loops; ++n)
+        {
+            msg.Encode(buf, sizeof(buf), flags);
+            msg.Decode(buf, size, flags);
+        }
+        profiler.Detach();
+
+        static char report[64*1024];
+        if( profiler.Export(report, sizeof(report)) < 0 ) continue;
+
+        printf("-- %s --\n%s", profile.name, report);
+    }
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,64 @@
+#include "iso8583/iso8583.h"
+#include "iso8583/helper.h"
+#include "bench.h"
+
+/*
+ * Typed field accessors against the string and integer helpers,
+ * which copy text fields to a buffer and a string on each call.
+ */
+
+static const uint64_t loops = 1000000;
+
+static volatile uint64_t sink;
+
+//------------------------------------------------------------------------------
+void bench_typed()
+{
+    using namespace ISO8583;
+
+    TFields fields;
+    fields.Set<F4 >(125000);
+    fields.Set<F41>("TERM0001");
+    fields.Set<F43>("ACME STORE 001         TAIPEI        TWTW");
+
+    bench::measure("helper GetInteger, field 4", loops, 6, [&]()
+    {
+        sink = helper::GetInteger(fields, 4, 0);
+    });
+    bench::measure("typed Get<F4>", loops, 6, [&]()
+    {
+        sink = fields.Get<F4>();
+    });
+
+    bench::measure("helper GetString, field 41", loops, 8, [&]()
+    {
+        sink = helper::GetString(fields, 41).size();
+    });
+    bench::measure("helper GetTerminalID", loops, 8, [&]()
+    {
+        sink = helper::GetTerminalID(fields).size();
+    });
+    bench::measure("typed Get<F41>", loops, 8, [&]()
+    {
+        sink = fields.Get<F41>().size();
+    });
+
+    bench::measure("helper GetString, field 43", loops, 40, [&]()
+    {
+        sink = helper::GetString(fields, 43).size();
+    });
+    bench::measure("typed Get<F43>", loops, 40, [&]()
+    {
+        sink = fields.Get<F43>().size();
+    });
+
+    bench::measure("helper SetInteger, field 11", loops, 3, [&]()
+    {
+        sink = helper::SetInteger(fields, 11, 123456);
+    });
+    bench::measure("typed Set<F11>", loops, 3, [&]()
+    {
+        sink = fields.Set<F11>(123456);
+    });
+}
+//------------------------------------------------------------------------------
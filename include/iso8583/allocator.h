@@ -0,0 +1,110 @@
+/**
+ * @file
+ * @brief     Pluggable memory allocator.
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_ALLOCATOR_H_
+#define _ISO8583_ALLOCATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @class iso8583_allocator_t
+ * @brief Memory allocator interface.
+ * @details All memory the library uses is allocated through an allocator.
+ *          Each object takes the process default allocator when it is constructed,
+ *          and keeps using it to release and reallocate its buffers,
+ *          so that changing the default allocator only affects objects constructed later.
+ *          Messages can also be assigned their own allocator,
+ *          see ::iso8583_set_allocator.
+ *
+ * @remarks The functions should be thread safe if the objects using it
+ *          are operated by multiple threads.
+ */
+typedef struct iso8583_allocator_t
+{
+    void  *userarg;                                              ///< A user defined argument passed to functions.
+    void* (*on_alloc)  (void *userarg, size_t size);             ///< Allocate memory, the same as malloc.
+    void* (*on_realloc)(void *userarg, void *ptr, size_t size);  ///< Resize memory, the same as realloc.
+    void  (*on_free)   (void *userarg, void *ptr);               ///< Release memory, the same as free.
+} iso8583_allocator_t;
+
+ISO8583_API(const iso8583_allocator_t*) iso8583_allocator_get_libc(void);
+ISO8583_API(const iso8583_allocator_t*) iso8583_allocator_get_default(void);
+ISO8583_API(void                      ) iso8583_allocator_set_default(const iso8583_allocator_t *allocator);
+
+/**
+ * @brief Statistics of a counting allocator.
+ */
+typedef struct iso8583_alloc_stats_t
+{
+    uint64_t allocs;    ///< Count of alloc calls.
+    uint64_t reallocs;  ///< Count of realloc calls.
+    uint64_t frees;     ///< Count of free calls, freeing NULL is not counted.
+} iso8583_alloc_stats_t;
+
+/**
+ * @class iso8583_counting_allocator_t
+ * @brief An allocator which counts the calls and passes them to another allocator.
+ * @details It is used to track the heap traffic of encode, decode, and other operations,
+ *          and all counters are updated atomically.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_counting_allocator_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    iso8583_allocator_t        iface;
+    const iso8583_allocator_t *upstream;
+    iso8583_alloc_stats_t      stats;
+} iso8583_counting_allocator_t;
+#pragma pack(pop)
+
+ISO8583_API(void) iso8583_counting_allocator_init(iso8583_counting_allocator_t *obj, const iso8583_allocator_t *upstream);
+
+ISO8583_API(const iso8583_allocator_t*) iso8583_counting_allocator_get_interface(const iso8583_counting_allocator_t *obj);
+
+ISO8583_API(iso8583_alloc_stats_t) iso8583_counting_allocator_get_stats  (const iso8583_counting_allocator_t *obj);
+ISO8583_API(void                 ) iso8583_counting_allocator_reset_stats(      iso8583_counting_allocator_t *obj);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_counting_allocator_t.
+ */
+class TCountingAllocator : protected iso8583_counting_allocator_t
+{
+public:
+    TCountingAllocator(const iso8583_allocator_t *upstream = NULL) { iso8583_counting_allocator_init(this, upstream); }  ///< @see iso8583_counting_allocator_t::iso8583_counting_allocator_init
+
+private:
+    TCountingAllocator(const TCountingAllocator &src);
+    TCountingAllocator& operator=(const TCountingAllocator &src);
+
+public:
+    const iso8583_allocator_t* GetInterface() const { return iso8583_counting_allocator_get_interface(this); }  ///< @see iso8583_counting_allocator_t::iso8583_counting_allocator_get_interface
+
+    iso8583_alloc_stats_t GetStats  () const { return iso8583_counting_allocator_get_stats  (this); }  ///< @see iso8583_counting_allocator_t::iso8583_counting_allocator_get_stats
+    void                  ResetStats()       {        iso8583_counting_allocator_reset_stats(this); }  ///< @see iso8583_counting_allocator_t::iso8583_counting_allocator_reset_stats
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
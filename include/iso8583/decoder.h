@@ -0,0 +1,144 @@
+/**
+ * @file
+ * @brief     Parallel decoder of framed message streams.
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_DECODER_H_
+#define _ISO8583_DECODER_H_
+
+#include "iso8583.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISO8583_DECODER_MAXTHREADS 256   // Maximum count of worker threads.
+#define ISO8583_DECODER_BATCH      16    // Count of frames of a work unit.
+#define ISO8583_DECODER_WINDOW     1024  // Count of frames decoded ahead of delivery in the ordered mode.
+#define ISO8583_DECODER_CACHELINE  64    // Padding size used to separate shared variables.
+
+/**
+ * @brief Parallel decoder options.
+ */
+enum iso8583_decoder_flags_t
+{
+    /// Deliver messages in the same order as they are in the stream.
+    /// Messages are decoded in windows of ::ISO8583_DECODER_WINDOW frames,
+    /// and are delivered by the calling thread while the next window is being decoded.
+    /// Without this flag, each message will be delivered by the worker thread
+    /// which decoded it as soon as possible.
+    ISO8583_DECODER_ORDERED = 0x01,
+};
+
+/**
+ * @brief Receive a decoded message.
+ *
+ * @param userarg A user defined argument.
+ * @param index   Index of the frame in the stream.
+ * @param msg     The decoded message, it is only valid in the callback.
+ * @param errcode An error code defined in ::iso8583_err_t,
+ *                the message will be empty if the frame failed to be decoded.
+ *
+ * @remarks The callback will be called by multiple threads concurrently
+ *          if ::ISO8583_DECODER_ORDERED is not set.
+ */
+typedef void(*iso8583_on_decoded_t)(void *userarg, size_t index, const iso8583_t *msg, int errcode);
+
+/// @private
+typedef struct iso8583_decoder_ctx_t iso8583_decoder_ctx_t;
+
+/**
+ * @class iso8583_decoder_t
+ * @brief Parallel decoder of framed message streams.
+ * @details The input stream is a sequence of frames which have a size header each,
+ *          as what ::iso8583_exg_t sends and receives.
+ *          Frame boundaries are found by a sequential scan of the size headers first,
+ *          then frames are decoded by persistent worker threads,
+ *          which take batches of frames from their own ranges and
+ *          steal from the others when their own ranges are exhausted.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_decoder_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    int                    decode_flags;
+    int                    flags;
+    iso8583_decoder_ctx_t *ctx;
+} iso8583_decoder_t;
+#pragma pack(pop)
+
+ISO8583_API(int ) iso8583_decoder_init  (iso8583_decoder_t *obj, unsigned nthreads, int decode_flags, int flags);
+ISO8583_API(void) iso8583_decoder_deinit(iso8583_decoder_t *obj);
+
+ISO8583_API(int) iso8583_decoder_run(iso8583_decoder_t    *obj,
+                                     const void           *data,
+                                     size_t                size,
+                                     iso8583_on_decoded_t  on_decoded,
+                                     void                 *userarg);
+
+ISO8583_API(unsigned) iso8583_decoder_get_threads(const iso8583_decoder_t *obj);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_decoder_t.
+ */
+class TDecoder : protected iso8583_decoder_t
+{
+public:
+    TDecoder(unsigned nthreads, int decode_flags, int flags = 0) { iso8583_decoder_init  (this, nthreads, decode_flags, flags); }  ///< @see iso8583_decoder_t::iso8583_decoder_init
+    ~TDecoder()                                                  { iso8583_decoder_deinit(this); }                                ///< @see iso8583_decoder_t::iso8583_decoder_deinit
+
+private:
+    TDecoder(const TDecoder &src);
+    TDecoder& operator=(const TDecoder &src);
+
+private:
+    template < typename Func >
+    static void OnDecoded(void *userarg, size_t index, const iso8583_t *msg, int errcode)
+    {
+        (*static_cast<Func*>(userarg))(index, *static_cast<const TISO8583*>(msg), errcode);
+    }
+
+public:
+    int Run(const void *data, size_t size, iso8583_on_decoded_t on_decoded, void *userarg)
+    {
+        /// @see iso8583_decoder_t::iso8583_decoder_run
+        return iso8583_decoder_run(this, data, size, on_decoded, userarg);
+    }
+
+    template < typename Func >
+    int Run(const void *data, size_t size, Func &func)
+    {
+        /**
+         * Decode a stream and deliver messages to a function object.
+         *
+         * @param data The stream data.
+         * @param size Size of the stream data.
+         * @param func A function object which will be called as
+         *             func(size_t index, const TISO8583 &msg, int errcode).
+         * @return An error code defined in ::iso8583_err_t.
+         *
+         * @see iso8583_decoder_t::iso8583_decoder_run
+         */
+        return iso8583_decoder_run(this, data, size, OnDecoded<Func>, &func);
+    }
+
+    unsigned GetThreads() const { return iso8583_decoder_get_threads(this); }  ///< @see iso8583_decoder_t::iso8583_decoder_get_threads
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
@@ -0,0 +1,166 @@
+/**
+ * @file
+ * @brief     Message handlers dispatched by MTI.
+ * @details   Handlers are registered to MTI patterns, such as
+ *            @code
+ *            iso8583_dispatcher_set(&disp, 0x0200, 0, on_financial_request, NULL);
+ *            iso8583_dispatcher_set(&disp, 0x0400, ISO8583_MTI_ORI_MASK, on_reversal, NULL);
+ *            iso8583_dispatcher_set(&disp, 0x0800, ISO8583_MTI_FUN_MASK | ISO8583_MTI_ORI_MASK, on_network, NULL);
+ *            iso8583_dispatcher_set_default(&disp, on_unsupported, NULL);
+ *            @endcode
+ *            and then each message is delivered to its handler by ::iso8583_dispatcher_dispatch.
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_DISPATCH_H_
+#define _ISO8583_DISPATCH_H_
+
+#include "iso8583.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISO8583_DISPATCH_SLOTS 4096  // Count of table slots, indexed by the class, function, and origin digits.
+
+/**
+ * @brief Handle a message.
+ *
+ * @param userarg  The user defined argument registered with the handler.
+ * @param context  The user defined argument passed to ::iso8583_dispatcher_dispatch,
+ *                 such as the connection which the message came from.
+ * @param msg      The message.
+ * @param resp_mti MTI of the response (see ::iso8583_mti_get_response);
+ *                 or -1 if the message has no response.
+ * @return A user defined value, which is returned by ::iso8583_dispatcher_dispatch.
+ */
+typedef int(*iso8583_handler_t)(void *userarg, void *context, iso8583_t *msg, int resp_mti);
+
+/// @private
+typedef struct iso8583_dispatch_slot_t
+{
+    iso8583_handler_t  handler;
+    void              *userarg;
+} iso8583_dispatch_slot_t;
+
+/**
+ * @class iso8583_dispatcher_t
+ * @brief MTI dispatch table of message handlers.
+ * @details Handlers are resolved when they are registered:
+ *          each MTI pattern fills all table slots it matches,
+ *          unless a slot is taken by a more specific pattern,
+ *          and the default handler fills the slots which no pattern matches.
+ *          So that dispatching a message is one indexed load of the table.
+ *
+ * @remarks The version digit is not a part of the index,
+ *          messages of all versions are delivered to the same handlers,
+ *          and handlers can check the version if needed.
+ * @remarks Handlers should be registered before messages be dispatched,
+ *          dispatching is thread safe, but registration is not.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_dispatcher_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    iso8583_dispatch_slot_t   *slots;
+    int8_t                    *ranks;  // Count of digits matched by the handler of each slot, -1 for the default.
+    const iso8583_allocator_t *allocator;
+} iso8583_dispatcher_t;
+#pragma pack(pop)
+
+ISO8583_API(void) iso8583_dispatcher_init  (iso8583_dispatcher_t *obj);
+ISO8583_API(void) iso8583_dispatcher_deinit(iso8583_dispatcher_t *obj);
+
+ISO8583_API(int ) iso8583_dispatcher_set        (iso8583_dispatcher_t *obj,
+                                                 int                   mti,
+                                                 int                   anymask,
+                                                 iso8583_handler_t     handler,
+                                                 void                 *userarg);
+ISO8583_API(void) iso8583_dispatcher_set_default(iso8583_dispatcher_t *obj, iso8583_handler_t handler, void *userarg);
+
+static inline
+int iso8583_dispatcher_dispatch(const iso8583_dispatcher_t *obj, iso8583_t *msg, void *context)
+{
+    /**
+     * @memberof iso8583_dispatcher_t
+     * @brief Deliver a message to its handler.
+     *
+     * @param obj     Object instance.
+     * @param msg     The message.
+     * @param context A user defined argument passed to the handler.
+     * @return The value returned by the handler;
+     *         or ::ISO8583_ERR_NO_HANDLER if no handler is registered for the message.
+     */
+    int                            mti  = msg->mti;
+    const iso8583_dispatch_slot_t *slot = &obj->slots[ mti & ( ISO8583_DISPATCH_SLOTS - 1 ) ];
+    return slot->handler ?
+           slot->handler(slot->userarg, context, msg, iso8583_mti_get_response(mti)) :
+           ISO8583_ERR_NO_HANDLER;
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_dispatcher_t.
+ */
+class TDispatcher : protected iso8583_dispatcher_t
+{
+public:
+    TDispatcher()  { iso8583_dispatcher_init  (this); }  ///< @see iso8583_dispatcher_t::iso8583_dispatcher_init
+    ~TDispatcher() { iso8583_dispatcher_deinit(this); }  ///< @see iso8583_dispatcher_t::iso8583_dispatcher_deinit
+
+private:
+    TDispatcher(const TDispatcher &src);
+    TDispatcher& operator=(const TDispatcher &src);
+
+private:
+    template < typename Func >
+    static int OnMessage(void *userarg, void *context, iso8583_t *msg, int resp_mti)
+    {
+        return (*static_cast<Func*>(userarg))(*static_cast<TISO8583*>(msg), context, resp_mti);
+    }
+
+public:
+    int  Set       (int mti, int anymask, iso8583_handler_t handler, void *userarg) { return iso8583_dispatcher_set(this, mti, anymask, handler, userarg); }  ///< @see iso8583_dispatcher_t::iso8583_dispatcher_set
+    void SetDefault(iso8583_handler_t handler, void *userarg)                       {        iso8583_dispatcher_set_default(this, handler, userarg); }      ///< @see iso8583_dispatcher_t::iso8583_dispatcher_set_default
+
+    template < typename Func >
+    int Set(int mti, int anymask, Func &func)
+    {
+        /**
+         * Register a function object, which will be called as
+         * func(TISO8583 &msg, void *context, int resp_mti), and must outlive the dispatcher.
+         *
+         * @see iso8583_dispatcher_t::iso8583_dispatcher_set
+         */
+        return iso8583_dispatcher_set(this, mti, anymask, OnMessage<Func>, &func);
+    }
+
+    template < typename Func >
+    void SetDefault(Func &func)
+    {
+        /**
+         * Register a function object as the default handler, see TDispatcher::Set.
+         *
+         * @see iso8583_dispatcher_t::iso8583_dispatcher_set_default
+         */
+        iso8583_dispatcher_set_default(this, OnMessage<Func>, &func);
+    }
+
+    int Dispatch(TISO8583 &msg, void *context = NULL) const { return iso8583_dispatcher_dispatch(this, &msg, context); }  ///< @see iso8583_dispatcher_t::iso8583_dispatcher_dispatch
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
@@ -37,6 +37,11 @@ enum iso8583_err_t
     ISO8583_ERR_FIELD_SIZE_ERROR = -7,      ///< Size of field item not match to what it should be!
     ISO8583_ERR_LVAR_TOO_LONG    = -8,      ///< LVAR payload size too long!
     ISO8583_ERR_LVAR_HDR_FORMAT  = -9,      ///< LVAR header value unrecognised!
+    ISO8583_ERR_FIELD_CHARSET    = -10,     ///< Field content not match to its element type!
+    ISO8583_ERR_TLV_FORMAT       = -11,     ///< TLV data format error!
+    ISO8583_ERR_SUBFIELD_FORMAT  = -12,     ///< Sub-field data format error!
+    ISO8583_ERR_TEXT_FORMAT      = -13,     ///< MTI or bitmap in text format unrecognised!
+    ISO8583_ERR_NO_HANDLER       = -14,     ///< No handler for the message type!
 
     ISO8583_ERR_TIMEOUT          = -20,     ///< Time out!
     ISO8583_ERR_STREAM_FAILED    = -21,     ///< Stream operation failed!
@@ -61,6 +66,11 @@ const char* iso8583_err_get_description(int errcode)
     case ISO8583_ERR_FIELD_SIZE_ERROR :  return "Size of field item not match to what it should be!";
     case ISO8583_ERR_LVAR_TOO_LONG    :  return "LVAR payload size too long!";
     case ISO8583_ERR_LVAR_HDR_FORMAT  :  return "LVAR header value unrecognised!";
+    case ISO8583_ERR_FIELD_CHARSET    :  return "Field content not match to its element type!";
+    case ISO8583_ERR_TLV_FORMAT       :  return "TLV data format error!";
+    case ISO8583_ERR_SUBFIELD_FORMAT  :  return "Sub-field data format error!";
+    case ISO8583_ERR_TEXT_FORMAT      :  return "MTI or bitmap in text format unrecognised!";
+    case ISO8583_ERR_NO_HANDLER       :  return "No handler for the message type!";
     }
 
     return "Unknown error occurred!";
@@ -10,12 +10,14 @@
 #define _ISO8583_EXCHANGE_H_
 
 #include "iso8583.h"
+#include "histogram.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define ISO8583_EXG_BUFSIZE 8192  // Size of the internal data buffer.
+#define ISO8583_EXG_SIZEHDR    2  // Size of the size header of each frame.
 
 /**
  * @brief Send data.
@@ -41,6 +43,43 @@ typedef int(*iso8583_on_send_t)(void *userarg, const void *data, size_t size);
  */
 typedef int(*iso8583_on_recv_t)(void *userarg, void *buf, size_t size);
 
+/**
+ * @brief Stages of message exchange which latencies are recorded.
+ */
+typedef enum iso8583_exg_stage_t
+{
+    ISO8583_EXG_STAGE_ENCODE,  ///< Encode the message to the send buffer.
+    ISO8583_EXG_STAGE_SEND,    ///< Pass the encoded data to the send callback.
+    ISO8583_EXG_STAGE_WAIT,    ///< Wait until a whole frame be received.
+    ISO8583_EXG_STAGE_DECODE,  ///< Decode the message from the received frame.
+
+    ISO8583_EXG_STAGE_COUNT
+} iso8583_exg_stage_t;
+
+/**
+ * @class iso8583_exg_stats_t
+ * @brief Latency histograms of each exchange stage.
+ * @details A statistics object can be attached to one or more exchange objects,
+ *          see ::iso8583_exg_set_stats.
+ *          Latencies are measured with a monotonic clock in nanoseconds,
+ *          and be recorded without locks.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_exg_stats_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    iso8583_histogram_t stages[ISO8583_EXG_STAGE_COUNT];
+} iso8583_exg_stats_t;
+#pragma pack(pop)
+
+ISO8583_API(void) iso8583_exg_stats_init (iso8583_exg_stats_t *obj);
+ISO8583_API(void) iso8583_exg_stats_reset(iso8583_exg_stats_t *obj);
+
+ISO8583_API(int) iso8583_exg_stats_snapshot(const iso8583_exg_stats_t *obj, int stage, iso8583_histogram_t *snapshot);
+ISO8583_API(int) iso8583_exg_stats_export  (const iso8583_exg_stats_t *obj, char *buf, size_t size);
+
 /**
  * @class iso8583_exg_t
  * @brief ISO 8583 message exchange module.
@@ -56,6 +95,8 @@ typedef struct iso8583_exg_t
     iso8583_on_send_t  on_send;
     iso8583_on_recv_t  on_recv;
 
+    iso8583_exg_stats_t *stats;
+
 } iso8583_exg_t;
 
 ISO8583_API(void) iso8583_exg_init(iso8583_exg_t *cfg, int                encode_flags,
@@ -63,9 +104,14 @@ ISO8583_API(void) iso8583_exg_init(iso8583_exg_t *cfg, int                encode
                                                        iso8583_on_send_t  on_send,
                                                        iso8583_on_recv_t  on_recv);
 
+ISO8583_API(void) iso8583_exg_set_stats(iso8583_exg_t *cfg, iso8583_exg_stats_t *stats);
+
 ISO8583_API(int) iso8583_exg_send(const iso8583_exg_t *cfg, const iso8583_t *msg, unsigned timeout);
 ISO8583_API(int) iso8583_exg_recv(const iso8583_exg_t *cfg, iso8583_t *msg, unsigned timeout);
 
+ISO8583_API(int) iso8583_exg_peek_frame(const void *data, size_t size);
+ISO8583_API(int) iso8583_exg_recv_frame(const iso8583_exg_t *cfg, iso8583_t *msg, const void *data, size_t size);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -75,6 +121,35 @@ ISO8583_API(int) iso8583_exg_recv(const iso8583_exg_t *cfg, iso8583_t *msg, unsi
 namespace ISO8583
 {
 
+/**
+ * @brief C++ wrapper of iso8583_exg_stats_t.
+ */
+class TExgStats : protected iso8583_exg_stats_t
+{
+    friend class TExchange;
+
+public:
+    TExgStats() { iso8583_exg_stats_init(this); }  ///< @see iso8583_exg_stats_t::iso8583_exg_stats_init
+
+private:
+    TExgStats(const TExgStats &src);
+    TExgStats& operator=(const TExgStats &src);
+
+public:
+    void Reset() { iso8583_exg_stats_reset(this); }  ///< @see iso8583_exg_stats_t::iso8583_exg_stats_reset
+
+    THistogram Snapshot(int stage) const
+    {
+        /// @see iso8583_exg_stats_t::iso8583_exg_stats_snapshot
+        THistogram snapshot;
+        iso8583_exg_stats_snapshot(this, stage, &snapshot);
+        return snapshot;
+    }
+
+    int Export(char *buf, size_t size) const { return iso8583_exg_stats_export(this, buf, size); }  ///< @see iso8583_exg_stats_t::iso8583_exg_stats_export
+
+};
+
 /**
  * @brief C++ wrapper of iso8583_exg_t.
  */
@@ -91,9 +166,15 @@ public:
     }
 
 public:
+    void SetStats(TExgStats *stats) { iso8583_exg_set_stats(this, stats); }  ///< @see iso8583_exg_t::iso8583_exg_set_stats
+
     int Send(const TISO8583 &msg, unsigned timeout) { return iso8583_exg_send(this, &msg, timeout); }  ///< @see iso8583_exg_t::iso8583_exg_send
     int Recv(      TISO8583 &msg, unsigned timeout) { return iso8583_exg_recv(this, &msg, timeout); }  ///< @see iso8583_exg_t::iso8583_exg_recv
 
+    int RecvFrame(TISO8583 &msg, const void *data, size_t size) const { return iso8583_exg_recv_frame(this, &msg, data, size); }  ///< @see iso8583_exg_t::iso8583_exg_recv_frame
+
+    static int PeekFrame(const void *data, size_t size) { return iso8583_exg_peek_frame(data, size); }  ///< @see iso8583_exg_t::iso8583_exg_peek_frame
+
 };
 
 }  // namespace ISO8583
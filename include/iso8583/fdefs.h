@@ -0,0 +1,215 @@
+/**
+ * @file
+ * @brief     ISO 8583 field definitions.
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_FDEFS_H_
+#define _ISO8583_FDEFS_H_
+
+/**
+ * @brief Definitions of all fields, the single source of the field information.
+ * @details Each definition is expanded by X(id, element_type, length_mode, maximum_count),
+ *          which are:
+ *          @li id            : The field ID, from 1 to 192 in order.
+ *          @li element_type  : One of NONE, A, N, S, AN, AS, NS, ANS, B, Z, PAN, or BIN
+ *                              (binary counted in bytes).
+ *          @li length_mode   : One of FIXED, LLVAR, or LLLVAR.
+ *          @li maximum_count : Maximum element count of the field
+ *                              (bits for the B type, and bytes for the BIN type).
+ */
+#define ISO8583_FIELD_DEFS(X) \
+    X(   1, B  , FIXED ,  64 )  /* Extend bitmap. */                                            \
+    X(   2, PAN, LLVAR ,  19 )  /* Primary account number (PAN). */                             \
+    X(   3, N  , FIXED ,   6 )  /* Processing code. */                                          \
+    X(   4, N  , FIXED ,  12 )  /* Amount, transaction. */                                      \
+    X(   5, N  , FIXED ,  12 )  /* Amount, settlement. */                                       \
+    X(   6, N  , FIXED ,  12 )  /* Amount, cardholders billing. */                              \
+    X(   7, N  , FIXED ,  10 )  /* Transmission date & time. */                                 \
+    X(   8, N  , FIXED ,   8 )  /* Amount, cardholders billing fee. */                          \
+    X(   9, N  , FIXED ,   8 )  /* Conversion rate, settlement. */                              \
+    X(  10, N  , FIXED ,   8 )  /* Conversion rate, cardholders billing. */                     \
+    X(  11, N  , FIXED ,   6 )  /* System trace audit number. */                                \
+    X(  12, N  , FIXED ,   6 )  /* Time, local transaction (hhmmss). */                         \
+    X(  13, N  , FIXED ,   4 )  /* Date, local transaction (MMDD). */                           \
+    X(  14, N  , FIXED ,   4 )  /* Date, expiration. */                                         \
+    X(  15, N  , FIXED ,   4 )  /* Date, settlement. */                                         \
+    X(  16, N  , FIXED ,   4 )  /* Date, conversion. */                                         \
+    X(  17, N  , FIXED ,   4 )  /* Date, capture. */                                            \
+    X(  18, N  , FIXED ,   4 )  /* Merchant type. */                                            \
+    X(  19, N  , FIXED ,   3 )  /* Acquiring institution country code. */                       \
+    X(  20, N  , FIXED ,   3 )  /* PAN extended, country code. */                               \
+    X(  21, N  , FIXED ,   3 )  /* Forwarding institution. country code. */                     \
+    X(  22, N  , FIXED ,   3 )  /* Point of service entry mode. */                              \
+    X(  23, N  , FIXED ,   3 )  /* Application PAN sequence number. */                          \
+    X(  24, N  , FIXED ,   3 )  /* Function code (ISO 8583:1993)/Network International identifier (NII). */ \
+    X(  25, N  , FIXED ,   2 )  /* Point of service condition code. */                          \
+    X(  26, N  , FIXED ,   2 )  /* Point of service capture code. */                            \
+    X(  27, N  , FIXED ,   1 )  /* Authorizing identification response length. */               \
+    X(  28, N  , FIXED ,   8 )  /* Amount, transaction fee. */                                  \
+    X(  29, N  , FIXED ,   8 )  /* Amount, settlement fee. */                                   \
+    X(  30, N  , FIXED ,   8 )  /* Amount, transaction processing fee. */                       \
+    X(  31, N  , FIXED ,   8 )  /* Amount, settlement processing fee. */                        \
+    X(  32, N  , LLVAR ,  11 )  /* Acquiring institution identification code. */                \
+    X(  33, N  , LLVAR ,  11 )  /* Forwarding institution identification code. */               \
+    X(  34, NS , LLVAR ,  28 )  /* Primary account number, extended. */                         \
+    X(  35, Z  , LLVAR ,  37 )  /* Track 2 data. */                                             \
+    X(  36, N  , LLLVAR, 104 )  /* Track 3 data. */                                             \
+    X(  37, AN , FIXED ,  12 )  /* Retrieval reference number. */                               \
+    X(  38, AN , FIXED ,   6 )  /* Authorization identification response. */                    \
+    X(  39, AN , FIXED ,   2 )  /* Response code. */                                            \
+    X(  40, AN , FIXED ,   3 )  /* Service restriction code. */                                 \
+    X(  41, ANS, FIXED ,   8 )  /* Card acceptor terminal identification. */                    \
+    X(  42, ANS, FIXED ,  15 )  /* Card acceptor identification code. */                        \
+    X(  43, ANS, FIXED ,  40 )  /* Card acceptor name/location (1-23 address 24-36 city 37-38 state 39-40 country). */ \
+    X(  44, AN , LLVAR ,  25 )  /* Additional response data. */                                 \
+    X(  45, AN , LLVAR ,  76 )  /* Track 1 data. */                                             \
+    X(  46, AN , LLLVAR, 999 )  /* Additional data - ISO. */                                    \
+    X(  47, AN , LLLVAR, 999 )  /* Additional data - national. */                               \
+    X(  48, AN , LLLVAR, 999 )  /* Additional data - private. */                                \
+    X(  49, N  , FIXED ,   3 )  /* Currency code, transaction. */                               \
+    X(  50, N  , FIXED ,   3 )  /* Currency code, settlement. */                                \
+    X(  51, N  , FIXED ,   3 )  /* Currency code, cardholders billing. */                       \
+    X(  52, B  , FIXED ,  64 )  /* Personal identification number data. */                      \
+    X(  53, N  , FIXED ,  16 )  /* Security related control information. */                     \
+    X(  54, AN , LLLVAR, 120 )  /* Additional amounts. */                                       \
+    X(  55, BIN, LLLVAR, 999 )  /* ICC data, binary in BER-TLV format. */                       \
+    X(  56, ANS, LLLVAR, 999 )  /* Reserved ISO. */                                             \
+    X(  57, ANS, LLLVAR, 999 )  /* Reserved national. */                                        \
+    X(  58, ANS, LLLVAR, 999 )  /* Reserved national. */                                        \
+    X(  59, ANS, LLLVAR, 999 )  /* Reserved national. */                                        \
+    X(  60, ANS, LLLVAR, 999 )  /* Reserved national. */                                        \
+    X(  61, ANS, LLLVAR, 999 )  /* Reserved private. */                                         \
+    X(  62, ANS, LLLVAR, 999 )  /* Reserved private. */                                         \
+    X(  63, ANS, LLLVAR, 999 )  /* Reserved private. */                                         \
+    X(  64, B  , FIXED ,  16 )  /* Message authentication code (MAC). */                        \
+    X(  65, B  , FIXED ,  64 )  /* Tertiary bitmap. */                                          \
+    X(  66, N  , FIXED ,   1 )  /* Settlement code. */                                          \
+    X(  67, N  , FIXED ,   2 )  /* Extended payment code. */                                    \
+    X(  68, N  , FIXED ,   3 )  /* Receiving institution country code. */                       \
+    X(  69, N  , FIXED ,   3 )  /* Settlement institution country code. */                      \
+    X(  70, N  , FIXED ,   3 )  /* Network management information code. */                      \
+    X(  71, N  , FIXED ,   4 )  /* Message number. */                                           \
+    X(  72, N  , FIXED ,   4 )  /* Message number, last. */                                     \
+    X(  73, N  , FIXED ,   6 )  /* Date, action (YYMMDD). */                                    \
+    X(  74, N  , FIXED ,  10 )  /* Credits, number. */                                          \
+    X(  75, N  , FIXED ,  10 )  /* Credits, reversal number. */                                 \
+    X(  76, N  , FIXED ,  10 )  /* Debits, number. */                                           \
+    X(  77, N  , FIXED ,  10 )  /* Debits, reversal number. */                                  \
+    X(  78, N  , FIXED ,  10 )  /* Transfer number. */                                          \
+    X(  79, N  , FIXED ,  10 )  /* Transfer, reversal number. */                                \
+    X(  80, N  , FIXED ,  10 )  /* Inquiries number. */                                         \
+    X(  81, N  , FIXED ,  10 )  /* Authorizations, number. */                                   \
+    X(  82, N  , FIXED ,  12 )  /* Credits, processing fee amount. */                           \
+    X(  83, N  , FIXED ,  12 )  /* Credits, transaction fee amount. */                          \
+    X(  84, N  , FIXED ,  12 )  /* Debits, processing fee amount. */                            \
+    X(  85, N  , FIXED ,  12 )  /* Debits, transaction fee amount. */                           \
+    X(  86, N  , FIXED ,  16 )  /* Credits, amount. */                                          \
+    X(  87, N  , FIXED ,  16 )  /* Credits, reversal amount. */                                 \
+    X(  88, N  , FIXED ,  16 )  /* Debits, amount. */                                           \
+    X(  89, N  , FIXED ,  16 )  /* Debits, reversal amount. */                                  \
+    X(  90, N  , FIXED ,  42 )  /* Original data elements. */                                   \
+    X(  91, AN , FIXED ,   1 )  /* File update code. */                                         \
+    X(  92, AN , FIXED ,   2 )  /* File security code. */                                       \
+    X(  93, AN , FIXED ,   5 )  /* Response indicator. */                                       \
+    X(  94, AN , FIXED ,   7 )  /* Service indicator. */                                        \
+    X(  95, AN , FIXED ,  42 )  /* Replacement amounts. */                                      \
+    X(  96, B  , FIXED ,  64 )  /* Message security code. */                                    \
+    X(  97, N  , FIXED ,  16 )  /* Amount, net settlement. */                                   \
+    X(  98, ANS, FIXED ,  25 )  /* Payee. */                                                    \
+    X(  99, N  , LLVAR ,  11 )  /* Settlement institution identification code. */               \
+    X( 100, N  , LLVAR ,  11 )  /* Receiving institution identification code. */                \
+    X( 101, ANS, LLVAR ,  17 )  /* File name. */                                                \
+    X( 102, ANS, LLVAR ,  28 )  /* Account identification 1. */                                 \
+    X( 103, ANS, LLVAR ,  28 )  /* Account identification 2. */                                 \
+    X( 104, ANS, LLLVAR, 100 )  /* Transaction description. */                                  \
+    X( 105, ANS, LLLVAR, 999 )  /* Reserved for ISO use. */                                     \
+    X( 106, ANS, LLLVAR, 999 )  /* Reserved for ISO use. */                                     \
+    X( 107, ANS, LLLVAR, 999 )  /* Reserved for ISO use. */                                     \
+    X( 108, ANS, LLLVAR, 999 )  /* Reserved for ISO use. */                                     \
+    X( 109, ANS, LLLVAR, 999 )  /* Reserved for ISO use. */                                     \
+    X( 110, ANS, LLLVAR, 999 )  /* Reserved for ISO use. */                                     \
+    X( 111, ANS, LLLVAR, 999 )  /* Reserved for ISO use. */                                     \
+    X( 112, ANS, LLLVAR, 999 )  /* Reserved for national use. */                                \
+    X( 113, ANS, LLLVAR, 999 )  /* Reserved for national use. */                                \
+    X( 114, ANS, LLLVAR, 999 )  /* Reserved for national use. */                                \
+    X( 115, ANS, LLLVAR, 999 )  /* Reserved for national use. */                                \
+    X( 116, ANS, LLLVAR, 999 )  /* Reserved for national use. */                                \
+    X( 117, ANS, LLLVAR, 999 )  /* Reserved for national use. */                                \
+    X( 118, ANS, LLLVAR, 999 )  /* Reserved for national use. */                                \
+    X( 119, ANS, LLLVAR, 999 )  /* Reserved for national use. */                                \
+    X( 120, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 121, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 122, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 123, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 124, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 125, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 126, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 127, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 128, B  , FIXED ,  64 )  /* Message authentication code. */                              \
+    X( 129, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 130, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 131, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 132, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 133, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 134, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 135, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 136, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 137, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 138, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 139, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 140, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 141, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 142, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 143, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 144, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 145, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 146, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 147, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 148, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 149, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 150, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 151, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 152, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 153, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 154, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 155, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 156, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 157, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 158, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 159, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 160, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 161, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 162, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 163, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 164, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 165, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 166, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 167, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 168, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 169, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 170, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 171, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 172, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 173, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 174, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 175, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 176, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 177, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 178, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 179, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 180, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 181, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 182, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 183, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 184, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 185, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 186, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 187, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 188, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 189, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 190, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 191, ANS, LLLVAR, 999 )  /* Reserved for private use. */                                 \
+    X( 192, ANS, LLLVAR, 999 )  /* Reserved for private use. */
+
+#endif
@@ -10,6 +10,7 @@
 #define _ISO8583_FIELDS_H_
 
 #include "fitem.h"
+#include "fmask.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,7 +32,12 @@ typedef struct iso8583_fields_t
      * WARNING : All members are private.
      */
     iso8583_fitem_t items[1+ISO8583_FITEM_ID_MAX];
+    uint64_t        present[(ISO8583_FITEM_ID_MAX+63)/64];  // Presence bits in the same order as the ISO 8583 bitmap.
+    uint64_t        touched[(ISO8583_FITEM_ID_MAX+63)/64];  // Items which have been used and may own buffers, in the same order.
     unsigned        count;
+    int             errid;  // Field ID which the last decode failed at.
+
+    const iso8583_allocator_t *allocator;  // Allocator of the items, which is taken by each item when it is used first.
 } iso8583_fields_t;
 #pragma pack(pop)
 
@@ -42,18 +48,33 @@ ISO8583_API(void) iso8583_fields_deinit    (iso8583_fields_t *obj);
 
 ISO8583_API(void) iso8583_fields_clone   (iso8583_fields_t *obj, const iso8583_fields_t *src);
 ISO8583_API(void) iso8583_fields_movefrom(iso8583_fields_t *obj, iso8583_fields_t *src);
+ISO8583_API(void) iso8583_fields_share   (iso8583_fields_t *obj, const iso8583_fields_t *src);
+
+ISO8583_API(void) iso8583_fields_share_masked(iso8583_fields_t *obj, const iso8583_fields_t *src, const iso8583_fmask_t *mask);
+ISO8583_API(void) iso8583_fields_retain      (iso8583_fields_t *obj, const iso8583_fmask_t *mask);
 
 ISO8583_API(int) iso8583_fields_encode(const iso8583_fields_t *obj, void *buf, size_t size, int flags);
 ISO8583_API(int) iso8583_fields_decode(      iso8583_fields_t *obj, const void *data, size_t size, int flags);
 
+ISO8583_API(int) iso8583_fields_get_error_id(const iso8583_fields_t *obj);
+
 ISO8583_API(unsigned              ) iso8583_fields_get_count(const iso8583_fields_t *obj);
 ISO8583_API(const iso8583_fitem_t*) iso8583_fields_get_item (const iso8583_fields_t *obj, int id);
 ISO8583_API(const iso8583_fitem_t*) iso8583_fields_get_first(const iso8583_fields_t *obj);
 ISO8583_API(const iso8583_fitem_t*) iso8583_fields_get_next (const iso8583_fields_t *obj, const iso8583_fitem_t *prev);
 
+ISO8583_API(bool    ) iso8583_fields_equal(const iso8583_fields_t *obj, const iso8583_fields_t *tar, const iso8583_fmask_t *mask);
+ISO8583_API(uint64_t) iso8583_fields_hash (const iso8583_fields_t *obj, const iso8583_fmask_t *mask, uint64_t seed);
+
 ISO8583_API(int ) iso8583_fields_insert(iso8583_fields_t *obj, const iso8583_fitem_t *item);
 ISO8583_API(void) iso8583_fields_erase (iso8583_fields_t *obj, int id);
 ISO8583_API(void) iso8583_fields_clear (iso8583_fields_t *obj);
+ISO8583_API(void) iso8583_fields_shrink(iso8583_fields_t *obj);
+
+ISO8583_API(void) iso8583_fields_set_allocator(iso8583_fields_t *obj, const iso8583_allocator_t *allocator);
+
+ISO8583_API(int  ) iso8583_fields_set_data   (iso8583_fields_t *obj, int id, const void *data, size_t size);
+ISO8583_API(void*) iso8583_fields_resize_data(iso8583_fields_t *obj, int id, size_t size);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -84,6 +105,10 @@ public:
     TFields& operator=(TFields &&src)      { iso8583_fields_movefrom  (this, &src); return *this; }  ///< @see iso8583_fields_t::iso8583_fields_movefrom
 #endif
 
+    void Share (const TFields &src)                              { iso8583_fields_share       (this, &src); }        ///< @see iso8583_fields_t::iso8583_fields_share
+    void Share (const TFields &src, const iso8583_fmask_t *mask) { iso8583_fields_share_masked(this, &src, mask); }  ///< @see iso8583_fields_t::iso8583_fields_share_masked
+    void Retain(const iso8583_fmask_t *mask)                     { iso8583_fields_retain      (this, mask); }        ///< @see iso8583_fields_t::iso8583_fields_retain
+
 public:
     iso8583_fields_t*       cptr()       { return this; }
     const iso8583_fields_t* cptr() const { return this; }
@@ -102,6 +127,8 @@ public:
     int Encode(void *buf, size_t size, int flags)  const { return iso8583_fields_encode(this, buf, size, flags); }   ///< @see iso8583_fields_t::iso8583_fields_encode
     int Decode(const void *data, size_t size, int flags) { return iso8583_fields_decode(this, data, size, flags); }  ///< @see iso8583_fields_t::iso8583_fields_decode
 
+    int GetErrorID() const { return iso8583_fields_get_error_id(this); }  ///< @see iso8583_fields_t::iso8583_fields_get_error_id
+
     unsigned GetCount() const { return iso8583_fields_get_count(this); }  ///< @see iso8583_fields_t::iso8583_fields_get_count
 
     const TFitem& GetItem(unsigned id) const
@@ -142,9 +169,24 @@ public:
         return item ? *item : npos();
     }
 
+    bool     Equal(const TFields &tar, const iso8583_fmask_t *mask = NULL) const { return iso8583_fields_equal(this, &tar, mask); }  ///< @see iso8583_fields_t::iso8583_fields_equal
+    uint64_t Hash (const iso8583_fmask_t *mask = NULL, uint64_t seed = 0)  const { return iso8583_fields_hash (this, mask, seed); }  ///< @see iso8583_fields_t::iso8583_fields_hash
+
     int  Insert(const TFitem &item) { return iso8583_fields_insert(this, &item); }  ///< @see iso8583_fields_t::iso8583_fields_insert
     void Erase (unsigned id)        {        iso8583_fields_erase (this, id); }     ///< @see iso8583_fields_t::iso8583_fields_erase
     void Clear ()                   {        iso8583_fields_clear (this); }         ///< @see iso8583_fields_t::iso8583_fields_clear
+    void Shrink()                   {        iso8583_fields_shrink(this); }         ///< @see iso8583_fields_t::iso8583_fields_shrink
+
+    int   SetData(int id, const void *data, size_t size) { return iso8583_fields_set_data   (this, id, data, size); }  ///< @see iso8583_fields_t::iso8583_fields_set_data
+    void* ResizeData(int id, size_t size)                { return iso8583_fields_resize_data(this, id, size); }        ///< @see iso8583_fields_t::iso8583_fields_resize_data
+
+    void SetAllocator(const iso8583_allocator_t *allocator) { iso8583_fields_set_allocator(this, allocator); }  ///< @see iso8583_fields_t::iso8583_fields_set_allocator
+
+public:
+    // Typed accessors, the field traits (such as ISO8583::F4) are defined in ftraits.h.
+    template < typename F > bool                  Has() const                        { return iso8583_fields_get_item(this, F::id); }  ///< Check if a field exists.
+    template < typename F > typename F::value_type Get() const                        { return F::Get(*this); }                        ///< Get value of a field, see ftraits.h.
+    template < typename F > bool                  Set(typename F::param_type value)  { return F::Set(*this, value); }                 ///< Set value of a field, see ftraits.h.
 
 };
 
@@ -9,10 +9,12 @@
 #ifndef _ISO8583_FITEM_H_
 #define _ISO8583_FITEM_H_
 
+#include <stdbool.h>
 #include <string.h>
 #include "export.h"
 #include "errcode.h"
 #include "flags.h"
+#include "allocator.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,7 +22,8 @@ extern "C" {
 
 #define ISO8583_FITEM_ID_INVALID   0
 #define ISO8583_FITEM_ID_MIN       2
-#define ISO8583_FITEM_ID_MAX     128
+#define ISO8583_FITEM_ID_MAX     192
+#define ISO8583_FITEM_ID_TERTIARY 65  // Reserved for the tertiary bitmap indicator.
 
 /**
  * @class iso8583_fitem_t
@@ -32,9 +35,13 @@ typedef struct iso8583_fitem_t
     /*
      * WARNING : All members are private.
      */
-    int     id;  // Field item ID is item index in ISO 8583 bitmap.
-    void   *buf;
-    size_t  size;
+    int         id;  // Field item ID is item index in ISO 8583 bitmap.
+    void       *buf;
+    size_t      size;
+    size_t      capacity;  // Allocated size of the buffer.
+    const void *shared;    // Payload shared from another item, which is used instead of the buffer if not NULL.
+
+    const iso8583_allocator_t *allocator;  // The allocator which owns the buffer.
 } iso8583_fitem_t;
 #pragma pack(pop)
 
@@ -46,6 +53,7 @@ ISO8583_API(void)iso8583_fitem_deinit    (iso8583_fitem_t *obj);
 
 ISO8583_API(void) iso8583_fitem_clone   (iso8583_fitem_t *obj, const iso8583_fitem_t *src);
 ISO8583_API(void) iso8583_fitem_movefrom(iso8583_fitem_t *obj, iso8583_fitem_t *src);
+ISO8583_API(void) iso8583_fitem_share   (iso8583_fitem_t *obj, const iso8583_fitem_t *src);
 
 ISO8583_API(int) iso8583_fitem_encode(const iso8583_fitem_t *obj, void *buf, size_t size, int flags);
 ISO8583_API(int) iso8583_fitem_decode(      iso8583_fitem_t *obj, const void *data,
@@ -53,14 +61,21 @@ ISO8583_API(int) iso8583_fitem_decode(      iso8583_fitem_t *obj, const void *da
                                                                   int         flags,
                                                                   int         id);
 
-ISO8583_API(void) iso8583_fitem_clear(iso8583_fitem_t *obj);
+ISO8583_API(void) iso8583_fitem_clear (iso8583_fitem_t *obj);
+ISO8583_API(void) iso8583_fitem_shrink(iso8583_fitem_t *obj);
 
 ISO8583_API(int ) iso8583_fitem_get_id(const iso8583_fitem_t *obj);
 ISO8583_API(void) iso8583_fitem_set_id(      iso8583_fitem_t *obj, int id);
 
-ISO8583_API(const void*) iso8583_fitem_get_data(const iso8583_fitem_t *obj);
-ISO8583_API(size_t     ) iso8583_fitem_get_size(const iso8583_fitem_t *obj);
-ISO8583_API(void       ) iso8583_fitem_set_data(      iso8583_fitem_t *obj, const void *data, size_t size);
+ISO8583_API(const void*) iso8583_fitem_get_data    (const iso8583_fitem_t *obj);
+ISO8583_API(size_t     ) iso8583_fitem_get_size    (const iso8583_fitem_t *obj);
+ISO8583_API(size_t     ) iso8583_fitem_get_capacity(const iso8583_fitem_t *obj);
+ISO8583_API(void       ) iso8583_fitem_set_data    (      iso8583_fitem_t *obj, const void *data, size_t size);
+ISO8583_API(void*      ) iso8583_fitem_resize_data (      iso8583_fitem_t *obj, size_t size);
+ISO8583_API(bool       ) iso8583_fitem_is_shared   (const iso8583_fitem_t *obj);
+
+ISO8583_API(const iso8583_allocator_t*) iso8583_fitem_get_allocator(const iso8583_fitem_t *obj);
+ISO8583_API(void                      ) iso8583_fitem_set_allocator(      iso8583_fitem_t *obj, const iso8583_allocator_t *allocator);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -92,20 +107,31 @@ public:
     TFitem& operator=(TFitem &&src)               { iso8583_fitem_movefrom  (this, &src); return *this; }  ///< @see iso8583_fitem_t::iso8583_fitem_movefrom
 #endif
 
+    void Share(const TFitem &src) { iso8583_fitem_share(this, &src); }  ///< @see iso8583_fitem_t::iso8583_fitem_share
+
 public:
     int Encode(void *buf, size_t size, int flags)          const { return iso8583_fitem_encode(this, buf, size, flags); }       ///< @see iso8583_fitem_t::iso8583_fitem_encode
     int Decode(const void *data, size_t size, int flags, int id) { return iso8583_fitem_decode(this, data, size, flags, id); }  ///< @see iso8583_fitem_t::iso8583_fitem_decode
 
+    void Clear () { iso8583_fitem_clear (this); }  ///< @see iso8583_fitem_t::iso8583_fitem_clear
+    void Shrink() { iso8583_fitem_shrink(this); }  ///< @see iso8583_fitem_t::iso8583_fitem_shrink
+
     int  GetID() const { return iso8583_fitem_get_id(this); }      ///< @see iso8583_fitem_t::iso8583_fitem_get_id
     void SetID(int id) {        iso8583_fitem_set_id(this, id); }  ///< @see iso8583_fitem_t::iso8583_fitem_set_id
 
     const void* GetData()                        const { return iso8583_fitem_get_data(this); }              ///< @see iso8583_fitem_t::iso8583_fitem_get_data
     size_t      GetSize()                        const { return iso8583_fitem_get_size(this); }              ///< @see iso8583_fitem_t::iso8583_fitem_get_size
+    size_t      GetCapacity()                    const { return iso8583_fitem_get_capacity(this); }          ///< @see iso8583_fitem_t::iso8583_fitem_get_capacity
     void        SetData(const void *data, size_t size) {        iso8583_fitem_set_data(this, data, size); }  ///< @see iso8583_fitem_t::iso8583_fitem_set_data
+    void*       ResizeData(size_t size)                { return iso8583_fitem_resize_data(this, size); }     ///< @see iso8583_fitem_t::iso8583_fitem_resize_data
+    bool        IsShared()                       const { return iso8583_fitem_is_shared(this); }             ///< @see iso8583_fitem_t::iso8583_fitem_is_shared
+
+    const iso8583_allocator_t* GetAllocator()                                const { return iso8583_fitem_get_allocator(this); }             ///< @see iso8583_fitem_t::iso8583_fitem_get_allocator
+    void                       SetAllocator(const iso8583_allocator_t *allocator)  {        iso8583_fitem_set_allocator(this, allocator); }  ///< @see iso8583_fitem_t::iso8583_fitem_set_allocator
 
 public:
-    bool operator==(const TFitem &tar) { return id == tar.id && size == tar.size && !memcmp(buf, tar.buf, tar.size); }  ///< Comparison.
-    bool operator!=(const TFitem &tar) { return id != tar.id || size != tar.size ||  memcmp(buf, tar.buf, tar.size); }  ///< Comparison.
+    bool operator==(const TFitem &tar) { return id == tar.id && size == tar.size && !memcmp(GetData(), tar.GetData(), tar.size); }  ///< Comparison.
+    bool operator!=(const TFitem &tar) { return id != tar.id || size != tar.size ||  memcmp(GetData(), tar.GetData(), tar.size); }  ///< Comparison.
 
 };
 
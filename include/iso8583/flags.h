@@ -29,6 +29,22 @@ enum iso8583_flags_t
                                                 ///< how many ISO 8583 data elements the payload have,
                                                 ///< not how many bytes the payload have.
     ISO8583_FLAG_LVAR_LEN_NO_LIMIT    = 0x40,   ///< Do not check payload length of LVAR object.
+    ISO8583_FLAG_VALIDATE_CHARSET     = 0x80,   ///< Check that content of each field item matches to
+                                                ///< the character class of its element type,
+                                                ///< and numeric elements are valid BCD.
+                                                ///< Binary elements (such as the ICC data
+                                                ///< in field 55) will not be checked.
+    ISO8583_FLAG_MTI_ASCII            = 0x100,  ///< MTI is in 4 ASCII digits (such as "0200"),
+                                                ///< not in 2 bytes of BCD.
+    ISO8583_FLAG_BITMAP_HEX           = 0x200,  ///< Each bitmap is in 16 ASCII hexadecimal characters,
+                                                ///< not in 8 bytes of binary.
+    ISO8583_FLAG_EBCDIC               = 0x400,  ///< Character fields (all text and track 2 elements),
+                                                ///< uncompressed LVAR length values,
+                                                ///< and the MTI and bitmaps in text mode are in EBCDIC
+                                                ///< (code page 037), and are converted from and to
+                                                ///< ASCII while they are encoded and decoded.
+                                                ///< Binary elements (such as the ICC data
+                                                ///< in field 55) will not be converted.
 };
 
 #ifdef __cplusplus
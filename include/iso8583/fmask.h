@@ -0,0 +1,115 @@
+/**
+ * @file
+ * @brief     Field masks, which select field IDs for whole message operations.
+ * @details   Such as to compare or hash messages without the volatile fields:
+ *            @code
+ *            iso8583_fmask_t mask;
+ *            iso8583_fmask_fill(&mask);
+ *            iso8583_fmask_remove(&mask, 7);
+ *            iso8583_fmask_remove(&mask, 11);
+ *            bool same = iso8583_equal(a, b, &mask);
+ *            @endcode
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_FMASK_H_
+#define _ISO8583_FMASK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "fitem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISO8583_FMASK_WORDS  ( ( ISO8583_FITEM_ID_MAX + 63 ) / 64 )
+
+/**
+ * @class iso8583_fmask_t
+ * @brief A set of field IDs.
+ * @details Bits are in the same order as the ISO 8583 bitmap:
+ *          the most significant bit of the first word is field 1,
+ *          so that the mask can be applied to the presence bits of fields directly.
+ */
+typedef struct iso8583_fmask_t
+{
+    uint64_t bits[ISO8583_FMASK_WORDS];  ///< Bits of the selected field IDs.
+} iso8583_fmask_t;
+
+static inline
+void iso8583_fmask_zero(iso8583_fmask_t *obj)
+{
+    /// @memberof iso8583_fmask_t
+    /// @brief Select no field.
+    memset(obj->bits, 0, sizeof(obj->bits));
+}
+
+static inline
+void iso8583_fmask_fill(iso8583_fmask_t *obj)
+{
+    /// @memberof iso8583_fmask_t
+    /// @brief Select all fields.
+    memset(obj->bits, 0xFF, sizeof(obj->bits));
+}
+
+static inline
+void iso8583_fmask_add(iso8583_fmask_t *obj, int id)
+{
+    /// @memberof iso8583_fmask_t
+    /// @brief Select a field, invalid IDs are ignored.
+    if( 1 <= id && id <= ISO8583_FITEM_ID_MAX )
+        obj->bits[ ( id - 1 ) >> 6 ] |= ( UINT64_C(1) << 63 ) >> ( ( id - 1 ) & 63 );
+}
+
+static inline
+void iso8583_fmask_remove(iso8583_fmask_t *obj, int id)
+{
+    /// @memberof iso8583_fmask_t
+    /// @brief Deselect a field, invalid IDs are ignored.
+    if( 1 <= id && id <= ISO8583_FITEM_ID_MAX )
+        obj->bits[ ( id - 1 ) >> 6 ] &= ~( ( UINT64_C(1) << 63 ) >> ( ( id - 1 ) & 63 ) );
+}
+
+static inline
+bool iso8583_fmask_has(const iso8583_fmask_t *obj, int id)
+{
+    /// @memberof iso8583_fmask_t
+    /// @brief Check if a field is selected.
+    return 1 <= id && id <= ISO8583_FITEM_ID_MAX &&
+           ( obj->bits[ ( id - 1 ) >> 6 ] & ( ( UINT64_C(1) << 63 ) >> ( ( id - 1 ) & 63 ) ) );
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_fmask_t.
+ */
+class TFieldMask : protected iso8583_fmask_t
+{
+public:
+    explicit TFieldMask(bool all = true) { if( all ) iso8583_fmask_fill(this); else iso8583_fmask_zero(this); }  ///< Select all fields or no field.
+
+public:
+    iso8583_fmask_t*       cptr()       { return this; }
+    const iso8583_fmask_t* cptr() const { return this; }
+
+public:
+    TFieldMask& Add   (int id)       { iso8583_fmask_add   (this, id); return *this; }  ///< @see iso8583_fmask_t::iso8583_fmask_add
+    TFieldMask& Remove(int id)       { iso8583_fmask_remove(this, id); return *this; }  ///< @see iso8583_fmask_t::iso8583_fmask_remove
+    bool        Has   (int id) const { return iso8583_fmask_has(this, id); }            ///< @see iso8583_fmask_t::iso8583_fmask_has
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
@@ -0,0 +1,280 @@
+/**
+ * @file
+ * @brief     Typed field accessors of C++.
+ * @details   Traits of each field are derived from the field definitions (see fdefs.h) at compile time,
+ *            which select the value type of the field:
+ *            @li Numeric fields of fixed length and up to 19 digits : uint64_t.
+ *            @li The PAN field                                       : Digits string in a fixed char array.
+ *            @li All other fields                                    : A view over the payload of the field item.
+ *
+ *            So that fields can be accessed as
+ *            @code
+ *            fields.Set<ISO8583::F11>(123456);
+ *            uint64_t amount = fields.Get<ISO8583::F4>();
+ *            ISO8583::field::TView termid = fields.Get<ISO8583::F41>();
+ *            @endcode
+ *            and access with a wrong value type is rejected at compile time.
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_FTRAITS_H_
+#define _ISO8583_FTRAITS_H_
+
+#include "fdefs.h"
+#include "fields.h"
+#include "helper.h"
+
+#ifdef __cplusplus
+#include <string.h>
+#include <string>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+/// C++ wrapper.
+namespace ISO8583
+{
+/// Typed field accessors.
+namespace field
+{
+
+/// Element types of fields.
+enum TEleType
+{
+    ELE_NONE,
+    ELE_A,
+    ELE_N,
+    ELE_S,
+    ELE_AN,
+    ELE_AS,
+    ELE_NS,
+    ELE_ANS,
+    ELE_B,
+    ELE_Z,
+    ELE_PAN,
+    ELE_BIN,
+};
+
+/// Length modes of fields.
+enum TLenMode
+{
+    LEN_FIXED,
+    LEN_LLVAR,
+    LEN_LLLVAR,
+};
+
+/**
+ * @brief A read only view over a range of characters (such as the payload of a field item),
+ *        which is not null terminated.
+ * @remarks A view of a field item is invalid after the field item be modified or erased.
+ */
+class TView
+{
+private:
+    const char *ptr;
+    size_t      len;
+
+public:
+    TView()                             : ptr(""), len(0) {}
+    TView(const void *data, size_t size) : ptr(static_cast<const char*>(data)), len( data ? size : 0 ) { if( !ptr ) ptr = ""; }
+    TView(const char *str)               : ptr( str ? str : "" ), len( str ? strlen(str) : 0 ) {}
+    TView(const std::string &str)        : ptr(str.data()), len(str.size()) {}
+
+public:
+    const char* data()  const { return ptr; }        ///< Get the characters.
+    size_t      size()  const { return len; }        ///< Get count of characters.
+    bool        empty() const { return !len; }       ///< Check if the view is empty.
+
+    std::string str() const { return std::string(ptr, len); }  ///< Copy to a string.
+
+#if __cplusplus >= 201703L
+    operator std::string_view() const { return std::string_view(ptr, len); }  ///< Convert to a standard string view.
+#endif
+
+    bool operator==(const TView &rhs) const { return len == rhs.len && 0 == memcmp(ptr, rhs.ptr, len); }  ///< Compare contents.
+    bool operator!=(const TView &rhs) const { return !( *this == rhs ); }                                   ///< Compare contents.
+
+};
+
+/**
+ * @brief A fixed size array of up to N characters, which is null terminated.
+ */
+template < size_t N >
+class TChars
+{
+private:
+    char buf[N+1];
+
+public:
+    TChars() { buf[0] = 0; }
+
+public:
+    char*       data()        { return buf; }          ///< Get the buffer.
+    const char* c_str() const { return buf; }          ///< Get the string.
+    size_t      size()  const { return strlen(buf); }  ///< Get length of the string.
+    bool        empty() const { return !buf[0]; }      ///< Check if the string is empty.
+
+    operator TView() const { return TView(buf); }  ///< View of the string.
+
+    bool operator==(const TView &rhs) const { return TView(buf) == rhs; }  ///< Compare contents.
+    bool operator!=(const TView &rhs) const { return TView(buf) != rhs; }  ///< Compare contents.
+
+};
+
+/// Value categories of fields.
+enum TKind
+{
+    KIND_INTEGER,
+    KIND_DIGITS,
+    KIND_VIEW,
+};
+
+/// Power of ten at compile time.
+template < int N > struct TPow10    { static const uint64_t value = 10 * TPow10<N-1>::value; };
+template <>        struct TPow10<0> { static const uint64_t value = 1; };
+
+/// Field accessor of each value category.
+template < int ID, int KIND, int ELE, int LEN, int MAX > struct TCodec;
+
+/// Accessor of numeric fields as integers.
+template < int ID, int ELE, int LEN, int MAX >
+struct TCodec<ID, KIND_INTEGER, ELE, LEN, MAX>
+{
+    typedef uint64_t value_type;  ///< Type of values read from the field.
+    typedef uint64_t param_type;  ///< Type of values written to the field.
+
+    /// Size of the BCD payload, which is known at compile time so that the conversions can be unrolled.
+    static const size_t max_size = ( MAX + 1 ) / 2;
+
+    static value_type Get(const TFields &fields)
+    {
+        /// Get value, or ZERO if the field does not exist or has a digit which is not decimal.
+        const iso8583_fitem_t *item = iso8583_fields_get_item(fields.cptr(), ID);
+        if( !item ) return 0;
+
+        const uint8_t *data = static_cast<const uint8_t*>( iso8583_fitem_get_data(item) );
+        if( !data || iso8583_fitem_get_size(item) != max_size )
+            return iso8583_helper_get_int(fields.cptr(), ID, 0);
+
+        uint64_t value = 0;
+        for(size_t i=0; i<max_size; ++i)
+        {
+            unsigned high = data[i] >> 4;
+            unsigned low  = data[i] & 0x0F;
+            if( high > 9 || low > 9 ) return 0;
+
+            value = value * 100 + high * 10 + low;
+        }
+
+        return value;
+    }
+
+    static bool Set(TFields &fields, param_type value)
+    {
+        /// Set value, and values which have more digits than the field can hold will be rejected.
+        if( value >= TPow10<MAX>::value ) return false;
+
+        uint8_t data[max_size];
+        for(size_t i=max_size; i; --i)
+        {
+            unsigned pair = value % 100;
+            value /= 100;
+            data[i-1] = ( pair / 10 ) << 4 | ( pair % 10 );
+        }
+
+        return !iso8583_fields_set_data(fields.cptr(), ID, data, max_size);
+    }
+};
+
+/// Accessor of PAN as digits string.
+template < int ID, int ELE, int LEN, int MAX >
+struct TCodec<ID, KIND_DIGITS, ELE, LEN, MAX>
+{
+    typedef TChars<MAX> value_type;  ///< Type of values read from the field.
+    typedef TView       param_type;  ///< Type of values written to the field.
+
+    static value_type Get(const TFields &fields)
+    {
+        /// Get value, or an empty string if the field does not exist or is not valid.
+        value_type value;
+        iso8583_helper_get_pan_str(fields.cptr(), value.data());
+        return value;
+    }
+
+    static bool Set(TFields &fields, param_type value)
+    {
+        /// Set value, which must be 1 to 19 digits.
+        if( value.size() > MAX ) return false;
+
+        char digits[MAX+1];
+        memcpy(digits, value.data(), value.size());
+        digits[value.size()] = 0;
+
+        return iso8583_helper_set_pan_str(fields.cptr(), digits);
+    }
+};
+
+/// Accessor of the payload of other fields.
+template < int ID, int ELE, int LEN, int MAX >
+struct TCodec<ID, KIND_VIEW, ELE, LEN, MAX>
+{
+    typedef TView value_type;  ///< Type of values read from the field.
+    typedef TView param_type;  ///< Type of values written to the field.
+
+    /// Maximum size of the payload.
+    static const size_t max_size = ELE == ELE_B ? ( MAX + 7 ) / 8 :
+                                   ELE == ELE_N ? ( MAX + 1 ) / 2 : MAX;
+
+    static value_type Get(const TFields &fields)
+    {
+        /// Get a view of the payload, or an empty view if the field does not exist.
+        const iso8583_fitem_t *item = iso8583_fields_get_item(fields.cptr(), ID);
+        return item ? TView(iso8583_fitem_get_data(item), iso8583_fitem_get_size(item)) : TView();
+    }
+
+    static bool Set(TFields &fields, param_type value)
+    {
+        /// Set payload, which must be of the exact size for fixed length fields,
+        /// and not larger than the field can hold for variable length fields.
+        bool size_ok = LEN == LEN_FIXED ? value.size() == max_size : value.size() <= max_size;
+        return size_ok && !iso8583_fields_set_data(fields.cptr(), ID, value.data(), value.size());
+    }
+};
+
+/**
+ * @brief Traits of a field.
+ */
+template < int ID, int ELE, int LEN, int MAX >
+struct TTraitsOf : TCodec< ID,
+                           ( ELE == ELE_PAN ? KIND_DIGITS :
+                             ELE == ELE_N && LEN == LEN_FIXED && MAX <= 19 ? KIND_INTEGER : KIND_VIEW ),
+                           ELE,
+                           LEN,
+                           MAX >
+{
+    static const int      id       = ID;   ///< The field ID.
+    static const TEleType eletype  = static_cast<TEleType>(ELE);  ///< Element type.
+    static const TLenMode lenmode  = static_cast<TLenMode>(LEN);  ///< Length mode.
+    static const int      maxcount = MAX;  ///< Maximum element count (bits for the B type).
+};
+
+/// Traits of each field.
+template < int ID > struct TTraits;
+
+#define ISO8583_FIELD_TRAITS(id, ele, len, max) \
+    template <> struct TTraits<id> : TTraitsOf<id, ELE_##ele, LEN_##len, max> {};
+ISO8583_FIELD_DEFS(ISO8583_FIELD_TRAITS)
+#undef ISO8583_FIELD_TRAITS
+
+}  // namespace field
+
+/// Field traits aliases, such as F2 for the PAN field, to be used with TFields::Get and TFields::Set.
+#define ISO8583_FIELD_ALIAS(id, ele, len, max) \
+    typedef field::TTraits<id> F##id;
+ISO8583_FIELD_DEFS(ISO8583_FIELD_ALIAS)
+#undef ISO8583_FIELD_ALIAS
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
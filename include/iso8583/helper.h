@@ -24,12 +24,21 @@ ISO8583_API(bool) iso8583_helper_set_bin(iso8583_fields_t *fields, int id, const
 ISO8583_API(uint64_t) iso8583_helper_get_int(const iso8583_fields_t *fields, int id, uint64_t errval);
 ISO8583_API(bool)     iso8583_helper_set_int(      iso8583_fields_t *fields, int id, uint64_t value);
 
+ISO8583_API(char*) iso8583_helper_get_digits(const iso8583_fields_t *fields, int id, char *buf, size_t bufsz);
+
+ISO8583_API(size_t)   iso8583_helper_bcd_to_ascii(char *buf, size_t bufsz, const void *bcd, size_t size);
+ISO8583_API(size_t)   iso8583_helper_ascii_to_bcd(void *buf, size_t bufsz, const char *str);
+ISO8583_API(uint64_t) iso8583_helper_bcd_to_int  (const void *bcd, size_t size);
+
 ISO8583_API(char*) iso8583_helper_get_str(const iso8583_fields_t *fields, int id, char *buf, size_t bufsz);
 ISO8583_API(bool)  iso8583_helper_set_str(      iso8583_fields_t *fields, int id, const char *str);
 
 ISO8583_API(uint64_t) iso8583_helper_get_pan(const iso8583_fields_t *fields);
 ISO8583_API(bool)     iso8583_helper_set_pan(      iso8583_fields_t *fields, uint64_t pan);
 
+ISO8583_API(char*) iso8583_helper_get_pan_str(const iso8583_fields_t *fields, char pan[19+1]);
+ISO8583_API(bool)  iso8583_helper_set_pan_str(      iso8583_fields_t *fields, const char *pan);
+
 ISO8583_API(unsigned) iso8583_helper_get_proccode(const iso8583_fields_t *fields);
 ISO8583_API(void)     iso8583_helper_set_proccode(      iso8583_fields_t *fields, unsigned proccode);
 
@@ -80,6 +89,14 @@ bool SetInteger(TFields &fields, int id, uint64_t value)
     return iso8583_helper_set_int(fields.cptr(), id, value);
 }
 
+inline
+std::string GetDigits(const TFields &fields, int id)
+{
+    /// @see ::iso8583_helper_get_digits
+    char buf[2*999+1];
+    return iso8583_helper_get_digits(fields.cptr(), id, buf, sizeof(buf));
+}
+
 inline
 std::string GetString(const TFields &fields, int id)
 {
@@ -109,6 +126,21 @@ bool SetPAN(TFields &fields, uint64_t pan)
     return iso8583_helper_set_pan(fields.cptr(), pan);
 }
 
+inline
+std::string GetPANString(const TFields &fields)
+{
+    /// @see ::iso8583_helper_get_pan_str
+    char buf[19+1];
+    return iso8583_helper_get_pan_str(fields.cptr(), buf);
+}
+
+inline
+bool SetPANString(TFields &fields, const std::string &pan)
+{
+    /// @see ::iso8583_helper_set_pan_str
+    return iso8583_helper_set_pan_str(fields.cptr(), pan.c_str());
+}
+
 inline
 unsigned GetProcCode(const TFields &fields)
 {
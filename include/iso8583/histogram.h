@@ -0,0 +1,94 @@
+/**
+ * @file
+ * @brief     Lock-free latency histogram.
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_HISTOGRAM_H_
+#define _ISO8583_HISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISO8583_HISTOGRAM_SUBBITS   5                                // Each power of two range is divided to 2^SUBBITS buckets.
+#define ISO8583_HISTOGRAM_MAXBITS  40                                // Values are limited to 2^MAXBITS-1 (about 18 minutes in nanoseconds).
+#define ISO8583_HISTOGRAM_BUCKETS  ( ( ISO8583_HISTOGRAM_MAXBITS - ISO8583_HISTOGRAM_SUBBITS + 1 ) << ISO8583_HISTOGRAM_SUBBITS )
+
+/**
+ * @class iso8583_histogram_t
+ * @brief Log-linear histogram of latency values.
+ * @details Values are counted in buckets the same way as HDR histograms:
+ *          values below 2^(SUBBITS+1) have their own buckets,
+ *          and each larger power of two range is divided to 2^SUBBITS buckets,
+ *          so that the relative error of a reported value is less than 1/2^SUBBITS (about 3%).
+ *          Values are recorded with atomic operations,
+ *          so that multiple threads can record to the same object without locks.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_histogram_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[ISO8583_HISTOGRAM_BUCKETS];
+} iso8583_histogram_t;
+#pragma pack(pop)
+
+ISO8583_API(void) iso8583_histogram_init    (iso8583_histogram_t *obj);
+ISO8583_API(void) iso8583_histogram_reset   (iso8583_histogram_t *obj);
+ISO8583_API(void) iso8583_histogram_snapshot(iso8583_histogram_t *obj, const iso8583_histogram_t *src);
+
+ISO8583_API(void) iso8583_histogram_record(iso8583_histogram_t *obj, uint64_t value);
+
+ISO8583_API(uint64_t) iso8583_histogram_get_count     (const iso8583_histogram_t *obj);
+ISO8583_API(uint64_t) iso8583_histogram_get_min       (const iso8583_histogram_t *obj);
+ISO8583_API(uint64_t) iso8583_histogram_get_max       (const iso8583_histogram_t *obj);
+ISO8583_API(double  ) iso8583_histogram_get_mean      (const iso8583_histogram_t *obj);
+ISO8583_API(uint64_t) iso8583_histogram_get_percentile(const iso8583_histogram_t *obj, double percentile);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_histogram_t.
+ */
+class THistogram : protected iso8583_histogram_t
+{
+    friend class TExgStats;
+
+public:
+    THistogram()                                 { iso8583_histogram_init    (this); }                      ///< @see iso8583_histogram_t::iso8583_histogram_init
+    THistogram(const THistogram &src)            { iso8583_histogram_snapshot(this, &src); }                ///< @see iso8583_histogram_t::iso8583_histogram_snapshot
+    THistogram& operator=(const THistogram &src) { iso8583_histogram_snapshot(this, &src); return *this; }  ///< @see iso8583_histogram_t::iso8583_histogram_snapshot
+
+public:
+    void Reset()                { iso8583_histogram_reset (this); }         ///< @see iso8583_histogram_t::iso8583_histogram_reset
+    void Record(uint64_t value) { iso8583_histogram_record(this, value); }  ///< @see iso8583_histogram_t::iso8583_histogram_record
+
+    uint64_t GetCount()                        const { return iso8583_histogram_get_count     (this); }              ///< @see iso8583_histogram_t::iso8583_histogram_get_count
+    uint64_t GetMin()                          const { return iso8583_histogram_get_min       (this); }              ///< @see iso8583_histogram_t::iso8583_histogram_get_min
+    uint64_t GetMax()                          const { return iso8583_histogram_get_max       (this); }              ///< @see iso8583_histogram_t::iso8583_histogram_get_max
+    double   GetMean()                         const { return iso8583_histogram_get_mean      (this); }              ///< @see iso8583_histogram_t::iso8583_histogram_get_mean
+    uint64_t GetPercentile(double percentile)  const { return iso8583_histogram_get_percentile(this, percentile); }  ///< @see iso8583_histogram_t::iso8583_histogram_get_percentile
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
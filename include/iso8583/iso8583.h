@@ -12,6 +12,9 @@
 #include "tpdu.h"
 #include "mti.h"
 #include "fields.h"
+#include "ftraits.h"
+#include "tlv.h"
+#include "subfield.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,9 +49,19 @@ ISO8583_API(int) iso8583_decode(      iso8583_t *obj, const void *data, size_t s
 
 ISO8583_API(void) iso8583_clear(iso8583_t *obj);
 
+ISO8583_API(void) iso8583_set_allocator(iso8583_t *obj, const iso8583_allocator_t *allocator);
+
 ISO8583_API(int ) iso8583_get_mti(const iso8583_t *obj);
 ISO8583_API(void) iso8583_set_mti(      iso8583_t *obj, int mti);
 
+ISO8583_API(bool    ) iso8583_equal(const iso8583_t *obj, const iso8583_t *tar, const iso8583_fmask_t *mask);
+ISO8583_API(uint64_t) iso8583_hash (const iso8583_t *obj, const iso8583_fmask_t *mask, uint64_t seed);
+
+ISO8583_API(int) iso8583_make_response(iso8583_t             *resp,
+                                       const iso8583_t       *req,
+                                       int                    resp_mti,
+                                       const iso8583_fmask_t *echo_mask);
+
 static inline
 iso8583_tpdu_t* iso8583_get_tpdu(iso8583_t *obj)
 {
@@ -96,9 +109,17 @@ namespace ISO8583
 class TISO8583 : protected iso8583_t
 {
     friend class TExchange;
+    friend class TQueue;
+    friend class TPool;
+    friend class TPoolCache;
+    friend class TDecoder;
+    friend class TTemplate;
+    friend class TReplayCache;
+    friend class TDispatcher;
 
 public:
     TISO8583()                               { iso8583_init      (this); }                    ///< @see iso8583_t::iso8583_init
+    explicit TISO8583(const iso8583_allocator_t *allocator) { iso8583_init(this); iso8583_set_allocator(this, allocator); }  ///< Construct with a specific allocator, see iso8583_t::iso8583_set_allocator
     TISO8583(const TISO8583 &src)            { iso8583_init_clone(this, &src); }              ///< @see iso8583_t::iso8583_init_clone
 #if __cplusplus >= 201103L
     TISO8583(TISO8583 &&src)                 { iso8583_init_move (this, &src); }              ///< @see iso8583_t::iso8583_init_move
@@ -114,9 +135,17 @@ public:
     int Encode(void *buf, size_t size, int flags)  const { return iso8583_encode(this, buf, size, flags); }   ///< @see iso8583_t::iso8583_encode
     int Decode(const void *data, size_t size, int flags) { return iso8583_decode(this, data, size, flags); }  ///< @see iso8583_t::iso8583_decode
 
+    void SetAllocator(const iso8583_allocator_t *allocator) { iso8583_set_allocator(this, allocator); }  ///< @see iso8583_t::iso8583_set_allocator
+
     int  GetMTI()  const { return iso8583_get_mti(this); }       ///< @see iso8583_t::iso8583_get_mti
     void SetMTI(int mti) {        iso8583_set_mti(this, mti); }  ///< @see iso8583_t::iso8583_set_mti
 
+    bool     Equal(const TISO8583 &tar, const iso8583_fmask_t *mask = NULL) const { return iso8583_equal(this, &tar, mask); }  ///< @see iso8583_t::iso8583_equal
+    uint64_t Hash (const iso8583_fmask_t *mask = NULL, uint64_t seed = 0)   const { return iso8583_hash (this, mask, seed); }  ///< @see iso8583_t::iso8583_hash
+
+    int MakeResponse(const TISO8583 &req, int resp_mti = -1, const iso8583_fmask_t *echo_mask = NULL) { return iso8583_make_response(this, &req, resp_mti, echo_mask); }  ///< @see iso8583_t::iso8583_make_response
+    int MakeResponse(int resp_mti = -1, const iso8583_fmask_t *echo_mask = NULL)                      { return iso8583_make_response(this, this, resp_mti, echo_mask); }  ///< Make a response in place, see iso8583_t::iso8583_make_response
+
     TTPDU&       TPDU()       { return * static_cast<      TTPDU*>( iso8583_get_tpdu (this) ); }  ///< Get TPDU.
     const TTPDU& TPDU() const { return * static_cast<const TTPDU*>( iso8583_get_ctpdu(this) ); }  ///< Get TPDU.
 
@@ -159,6 +159,27 @@ int iso8583_mti_set_origin(int mti, int ori)
     return ( mti & ~ISO8583_MTI_ORI_MASK ) | ( ori & ISO8583_MTI_ORI_MASK );
 }
 
+static inline
+int iso8583_mti_get_response(int mti)
+{
+    /**
+     * Get MTI of the response to a message,
+     * which has the function of the response (such as 0x0210 of 0x0200)
+     * and the origin without repeat (such as 0x0210 of 0x0201).
+     *
+     * @param mti MTI of the message.
+     * @return MTI of the response; or -1 if the message is not a request, an advice,
+     *         a notification, or an instruction, which has no response.
+     */
+    int fun = iso8583_mti_get_function(mti);
+    if( fun > ISO8583_MTI_FUN_INST || ( fun & ISO8583_MTI_FUN_RESPONSE ) ) return -1;
+
+    int ori = iso8583_mti_get_origin(mti);
+    if( ori > ISO8583_MTI_ORI_OTHER_REPEAT ) return -1;
+
+    return ( mti + ISO8583_MTI_FUN_RESPONSE ) & ~ISO8583_MTI_ORI_ACQ_REPEAT;
+}
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -186,6 +207,8 @@ inline int SetClass   (int mti, int cla) { return iso8583_mti_set_class   (mti,
 inline int SetFunction(int mti, int fun) { return iso8583_mti_set_function(mti, fun); }  ///< @see ::iso8583_mti_set_function
 inline int SetOrigin  (int mti, int ori) { return iso8583_mti_set_origin  (mti, ori); }  ///< @see ::iso8583_mti_set_origin
 
+inline int GetResponse(int mti) { return iso8583_mti_get_response(mti); }  ///< @see ::iso8583_mti_get_response
+
 }  // namespace mti
 }  // namespace ISO8583
 #endif  // __cplusplus
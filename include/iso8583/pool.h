@@ -0,0 +1,189 @@
+/**
+ * @file
+ * @brief     Recyclable message object pool.
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_POOL_H_
+#define _ISO8583_POOL_H_
+
+#include "queue.h"
+
+#ifdef __cplusplus
+#include <memory>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISO8583_POOL_CACHE_SIZE 32  // Maximum count of messages held by a thread cache.
+
+/**
+ * @class iso8583_pool_t
+ * @brief Recyclable message object pool.
+ * @details All messages are constructed once when the pool be created,
+ *          and be cleared and returned to a lock-free free list when released,
+ *          so that acquiring and releasing messages will not construct,
+ *          destruct, or allocate anything.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_pool_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    iso8583_t                 *msgs;
+    size_t                     count;
+    iso8583_queue_t            freelist;
+    const iso8583_allocator_t *allocator;
+} iso8583_pool_t;
+#pragma pack(pop)
+
+ISO8583_API(int ) iso8583_pool_init  (iso8583_pool_t *obj, size_t count);
+ISO8583_API(void) iso8583_pool_deinit(iso8583_pool_t *obj);
+
+ISO8583_API(iso8583_t*) iso8583_pool_acquire(iso8583_pool_t *obj);
+ISO8583_API(void      ) iso8583_pool_release(iso8583_pool_t *obj, iso8583_t *msg);
+
+ISO8583_API(size_t) iso8583_pool_get_count    (const iso8583_pool_t *obj);
+ISO8583_API(size_t) iso8583_pool_get_available(const iso8583_pool_t *obj);
+
+/**
+ * @class iso8583_pool_cache_t
+ * @brief Per thread cache of a message pool.
+ * @details Each thread can have its own cache object to acquire and release messages,
+ *          then the shared free list of the pool will only be touched
+ *          in batches when the cache is empty or full.
+ *
+ * @remarks A cache object must be used by only one thread.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_pool_cache_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    iso8583_pool_t *pool;
+    unsigned        count;
+    iso8583_t      *msgs[ISO8583_POOL_CACHE_SIZE];
+} iso8583_pool_cache_t;
+#pragma pack(pop)
+
+ISO8583_API(void) iso8583_pool_cache_init  (iso8583_pool_cache_t *obj, iso8583_pool_t *pool);
+ISO8583_API(void) iso8583_pool_cache_deinit(iso8583_pool_cache_t *obj);
+
+ISO8583_API(iso8583_t*) iso8583_pool_cache_acquire(iso8583_pool_cache_t *obj);
+ISO8583_API(void      ) iso8583_pool_cache_release(iso8583_pool_cache_t *obj, iso8583_t *msg);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_pool_t.
+ */
+class TPool : protected iso8583_pool_t
+{
+    friend class TPoolCache;
+
+public:
+    TPool(size_t count) { iso8583_pool_init  (this, count); }  ///< @see iso8583_pool_t::iso8583_pool_init
+    ~TPool()            { iso8583_pool_deinit(this); }         ///< @see iso8583_pool_t::iso8583_pool_deinit
+
+private:
+    TPool(const TPool &src);
+    TPool& operator=(const TPool &src);
+
+public:
+    TISO8583* Acquire()              { return static_cast<TISO8583*>( iso8583_pool_acquire(this) ); }  ///< @see iso8583_pool_t::iso8583_pool_acquire
+    void      Release(TISO8583 *msg) {                                iso8583_pool_release(this, msg); }  ///< @see iso8583_pool_t::iso8583_pool_release
+
+    size_t GetCount    () const { return iso8583_pool_get_count    (this); }  ///< @see iso8583_pool_t::iso8583_pool_get_count
+    size_t GetAvailable() const { return iso8583_pool_get_available(this); }  ///< @see iso8583_pool_t::iso8583_pool_get_available
+
+#if __cplusplus >= 201103L
+public:
+    /// Deleter that returns messages to the pool.
+    class TDeleter
+    {
+    public:
+        TDeleter(TPool *pool = NULL) : pool(pool) {}
+        void operator()(TISO8583 *msg) const { if( pool ) pool->Release(msg); }
+
+    private:
+        TPool *pool;
+    };
+
+    /// Smart pointer of a message borrowed from the pool.
+    typedef std::unique_ptr<TISO8583, TDeleter> TPtr;
+
+    TPtr AcquirePtr()
+    {
+        /**
+         * Acquire a message which will be returned to the pool automatically.
+         *
+         * @return The message; or an empty pointer if the pool is exhausted.
+         */
+        return TPtr(Acquire(), TDeleter(this));
+    }
+#endif
+
+};
+
+/**
+ * @brief C++ wrapper of iso8583_pool_cache_t.
+ */
+class TPoolCache : protected iso8583_pool_cache_t
+{
+public:
+    TPoolCache(TPool &pool) { iso8583_pool_cache_init  (this, &pool); }  ///< @see iso8583_pool_cache_t::iso8583_pool_cache_init
+    ~TPoolCache()           { iso8583_pool_cache_deinit(this); }         ///< @see iso8583_pool_cache_t::iso8583_pool_cache_deinit
+
+private:
+    TPoolCache(const TPoolCache &src);
+    TPoolCache& operator=(const TPoolCache &src);
+
+public:
+    TISO8583* Acquire()              { return static_cast<TISO8583*>( iso8583_pool_cache_acquire(this) ); }  ///< @see iso8583_pool_cache_t::iso8583_pool_cache_acquire
+    void      Release(TISO8583 *msg) {                                iso8583_pool_cache_release(this, msg); }  ///< @see iso8583_pool_cache_t::iso8583_pool_cache_release
+
+#if __cplusplus >= 201103L
+public:
+    /// Deleter that returns messages to the cache.
+    class TDeleter
+    {
+    public:
+        TDeleter(TPoolCache *cache = NULL) : cache(cache) {}
+        void operator()(TISO8583 *msg) const { if( cache ) cache->Release(msg); }
+
+    private:
+        TPoolCache *cache;
+    };
+
+    /// Smart pointer of a message borrowed from the cache.
+    typedef std::unique_ptr<TISO8583, TDeleter> TPtr;
+
+    TPtr AcquirePtr()
+    {
+        /**
+         * Acquire a message which will be returned to the cache automatically,
+         * neither the message nor the pointer allocates anything.
+         *
+         * @return The message; or an empty pointer if the pool is exhausted.
+         */
+        return TPtr(Acquire(), TDeleter(this));
+    }
+#endif
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
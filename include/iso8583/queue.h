@@ -0,0 +1,112 @@
+/**
+ * @file
+ * @brief     Lock-free bounded queue of message handles.
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_QUEUE_H_
+#define _ISO8583_QUEUE_H_
+
+#include <stdbool.h>
+#include "iso8583.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISO8583_QUEUE_CACHELINE 64  // Padding size used to separate shared variables.
+
+/**
+ * @brief Queue concurrency modes.
+ */
+enum iso8583_queue_mode_t
+{
+    ISO8583_QUEUE_SPSC = 0,  ///< Single producer, single consumer.
+    ISO8583_QUEUE_MPMC = 1,  ///< Multiple producers, multiple consumers.
+};
+
+/// @private
+typedef struct iso8583_queue_cell_t
+{
+    size_t     seq;
+    iso8583_t *msg;
+} iso8583_queue_cell_t;
+
+/**
+ * @class iso8583_queue_t
+ * @brief Lock-free bounded queue of message handles.
+ * @details The queue passes pointers of message objects between threads,
+ *          so that the message content will never be copied on each hop.
+ *          The ownership of a message belongs to the queue after it was pushed,
+ *          and be returned to the caller which popped it.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_queue_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    iso8583_queue_cell_t      *cells;
+    size_t                     mask;
+    int                        mode;
+    const iso8583_allocator_t *allocator;
+
+    char   pad0[ISO8583_QUEUE_CACHELINE];
+    size_t head;  // Position to push.
+    char   pad1[ISO8583_QUEUE_CACHELINE];
+    size_t tail;  // Position to pop.
+    char   pad2[ISO8583_QUEUE_CACHELINE];
+} iso8583_queue_t;
+#pragma pack(pop)
+
+ISO8583_API(int ) iso8583_queue_init  (iso8583_queue_t *obj, size_t capacity, int mode);
+ISO8583_API(void) iso8583_queue_deinit(iso8583_queue_t *obj);
+
+ISO8583_API(bool      ) iso8583_queue_push(iso8583_queue_t *obj, iso8583_t *msg);
+ISO8583_API(iso8583_t*) iso8583_queue_pop (iso8583_queue_t *obj);
+
+ISO8583_API(size_t) iso8583_queue_get_capacity(const iso8583_queue_t *obj);
+ISO8583_API(size_t) iso8583_queue_get_count   (const iso8583_queue_t *obj);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_queue_t.
+ */
+class TQueue : protected iso8583_queue_t
+{
+public:
+    /// @see iso8583_queue_t::iso8583_queue_init
+    /// @param result Receives the result of the initialization if it is not NULL.
+    TQueue(size_t capacity, int mode, int *result = NULL)
+    {
+        int err = iso8583_queue_init(this, capacity, mode);
+        if( result ) *result = err;
+    }
+
+    ~TQueue() { iso8583_queue_deinit(this); }  ///< @see iso8583_queue_t::iso8583_queue_deinit
+
+private:
+    TQueue(const TQueue &src);
+    TQueue& operator=(const TQueue &src);
+
+public:
+    bool      Push(TISO8583 *msg) { return iso8583_queue_push(this, msg); }                          ///< @see iso8583_queue_t::iso8583_queue_push
+    TISO8583* Pop ()              { return static_cast<TISO8583*>( iso8583_queue_pop(this) ); }     ///< @see iso8583_queue_t::iso8583_queue_pop
+
+    size_t GetCapacity() const { return iso8583_queue_get_capacity(this); }  ///< @see iso8583_queue_t::iso8583_queue_get_capacity
+    size_t GetCount   () const { return iso8583_queue_get_count   (this); }  ///< @see iso8583_queue_t::iso8583_queue_get_count
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
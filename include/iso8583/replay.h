@@ -0,0 +1,129 @@
+/**
+ * @file
+ * @brief     Duplicate and replay detection cache.
+ * @details   Responses are cached by the identity of their requests,
+ *            so that retransmissions (such as MTI with ::ISO8583_MTI_ORI_ACQ_REPEAT)
+ *            and duplicates can be answered with the cached response
+ *            instead of being processed again:
+ *            @code
+ *            int size = iso8583_replay_lookup(&cache, req, buf, sizeof(buf));
+ *            if( size == 0 )
+ *            {
+ *                size = process_request(req, buf, sizeof(buf));
+ *                iso8583_replay_store(&cache, req, buf, size);
+ *            }
+ *            @endcode
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_REPLAY_H_
+#define _ISO8583_REPLAY_H_
+
+#include "iso8583.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISO8583_REPLAY_SHARDS     64   // Maximum count of shards, each has its own lock.
+#define ISO8583_REPLAY_KEY_MAX    256  // Maximum size of the identity of a message.
+#define ISO8583_REPLAY_CACHELINE  64   // Padding size used to separate shared variables.
+
+/**
+ * @brief Statistics of a replay cache.
+ */
+typedef struct iso8583_replay_stats_t
+{
+    uint64_t hits;         ///< Count of lookups which found a response.
+    uint64_t misses;       ///< Count of lookups which found nothing (including the expired ones).
+    uint64_t stores;       ///< Count of responses stored.
+    uint64_t evictions;    ///< Count of entries removed because the cache is full.
+    uint64_t expirations;  ///< Count of entries removed because they are expired.
+    size_t   count;        ///< Count of entries in the cache.
+} iso8583_replay_stats_t;
+
+/// @private
+typedef struct iso8583_replay_shard_t iso8583_replay_shard_t;
+
+/**
+ * @class iso8583_replay_t
+ * @brief Duplicate and replay detection cache.
+ * @details Messages are identified by their MTI (with the repeat bit of the origin cleared)
+ *          and the payloads of the identity fields,
+ *          which are read from the field items directly without encoding the messages.
+ *          Entries are distributed to shards by the hash of the identity,
+ *          and each shard has its own lock, hash table, and list of entries in the insertion order,
+ *          so that the oldest entries are evicted when the cache is full,
+ *          and the expired ones are removed without scanning.
+ *
+ * @remarks All operations except the constructor and the destructor are thread safe.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_replay_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    iso8583_fmask_t            keymask;
+    uint64_t                   ttl;  // In nanoseconds, or ZERO for never expire.
+    unsigned                   nshards;
+    iso8583_replay_shard_t    *shards;
+    const iso8583_allocator_t *allocator;
+} iso8583_replay_t;
+#pragma pack(pop)
+
+ISO8583_API(int ) iso8583_replay_init  (iso8583_replay_t      *obj,
+                                        size_t                 capacity,
+                                        const iso8583_fmask_t *keymask,
+                                        unsigned               ttl_ms);
+ISO8583_API(void) iso8583_replay_deinit(iso8583_replay_t *obj);
+
+ISO8583_API(int ) iso8583_replay_lookup(iso8583_replay_t *obj, const iso8583_t *req, void *buf, size_t size);
+ISO8583_API(int ) iso8583_replay_store (iso8583_replay_t *obj, const iso8583_t *req, const void *resp, size_t size);
+ISO8583_API(void) iso8583_replay_remove(iso8583_replay_t *obj, const iso8583_t *req);
+ISO8583_API(void) iso8583_replay_clear (iso8583_replay_t *obj);
+
+ISO8583_API(void) iso8583_replay_get_stats(const iso8583_replay_t *obj, iso8583_replay_stats_t *stats);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_replay_t.
+ */
+class TReplayCache : protected iso8583_replay_t
+{
+public:
+    TReplayCache(size_t capacity, const TFieldMask &keymask, unsigned ttl_ms) { iso8583_replay_init(this, capacity, keymask.cptr(), ttl_ms); }  ///< @see iso8583_replay_t::iso8583_replay_init
+    ~TReplayCache() { iso8583_replay_deinit(this); }  ///< @see iso8583_replay_t::iso8583_replay_deinit
+
+private:
+    TReplayCache(const TReplayCache &src);
+    TReplayCache& operator=(const TReplayCache &src);
+
+public:
+    int  Lookup(const TISO8583 &req, void *buf, size_t size)        { return iso8583_replay_lookup(this, &req, buf, size); }   ///< @see iso8583_replay_t::iso8583_replay_lookup
+    int  Store (const TISO8583 &req, const void *resp, size_t size) { return iso8583_replay_store (this, &req, resp, size); }  ///< @see iso8583_replay_t::iso8583_replay_store
+    void Remove(const TISO8583 &req)                                {        iso8583_replay_remove(this, &req); }              ///< @see iso8583_replay_t::iso8583_replay_remove
+    void Clear ()                                                   {        iso8583_replay_clear (this); }                    ///< @see iso8583_replay_t::iso8583_replay_clear
+
+    iso8583_replay_stats_t GetStats() const
+    {
+        /// @see iso8583_replay_t::iso8583_replay_get_stats
+        iso8583_replay_stats_t stats;
+        iso8583_replay_get_stats(this, &stats);
+        return stats;
+    }
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file
+ * @brief     System Trace Audit Number (STAN) allocator.
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_STAN_H_
+#define _ISO8583_STAN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fields.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISO8583_STAN_MIN       1
+#define ISO8583_STAN_MAX       999999
+#define ISO8583_STAN_SHARDS    16  // Count of counter shards in the sharded mode.
+#define ISO8583_STAN_BLOCK     64  // Count of numbers a shard reserves at a time.
+#define ISO8583_STAN_CACHELINE 64  // Padding size used to separate shared variables.
+
+/**
+ * @brief STAN allocator options.
+ */
+enum iso8583_stan_flags_t
+{
+    /// Allocate numbers from per CPU shards.
+    /// Each shard reserves a block of numbers from the shared counter at a time,
+    /// so that threads on different CPUs will not contend on the same variable.
+    /// Numbers are not issued in strict order, and a block left in an idle shard
+    /// is dropped once the counter wraps past it, so that numbers are still unique in a cycle.
+    /// A thread suspended in the middle of an allocation for a whole cycle
+    /// may still get a number which has been issued again;
+    /// enable ::ISO8583_STAN_TRACK_OUTSTANDING if that must never happen.
+    ISO8583_STAN_SHARDED = 0x01,
+
+    /// Track the numbers which are still in use,
+    /// and skip them when the counter wraps around.
+    /// Each allocated number must be returned by ::iso8583_stan_release.
+    ISO8583_STAN_TRACK_OUTSTANDING = 0x02,
+};
+
+/// @private
+typedef struct iso8583_stan_shard_t
+{
+    uint64_t word;   // Reserved block index in high bits, and the next offset in low 16 bits.
+    uint64_t spare;  // Rest of a block reserved by a thread losing the refill race, or ZERO.
+    char     pad[ISO8583_STAN_CACHELINE - 2*sizeof(uint64_t)];
+} iso8583_stan_shard_t;
+
+/**
+ * @class iso8583_stan_t
+ * @brief STAN (field 11) allocator.
+ * @details Each link or terminal should have its own allocator object.
+ *          Numbers are taken from a 64 bits sequence counter
+ *          and be mapped to the range 1 to 999999,
+ *          and all operations are lock-free.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_stan_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    int       flags;
+    uint64_t  base;         // Sequence number of the first STAN.
+    uint64_t *outstanding;  // Bitmap of numbers in use, indexed by STAN.
+
+    const iso8583_allocator_t *allocator;
+
+    char      pad0[ISO8583_STAN_CACHELINE];
+    uint64_t  counter;      // Next sequence number, or the next block index in the sharded mode.
+    char      pad1[ISO8583_STAN_CACHELINE];
+
+    iso8583_stan_shard_t shards[ISO8583_STAN_SHARDS];
+} iso8583_stan_t;
+#pragma pack(pop)
+
+ISO8583_API(int ) iso8583_stan_init  (iso8583_stan_t *obj, unsigned first, int flags);
+ISO8583_API(void) iso8583_stan_deinit(iso8583_stan_t *obj);
+
+ISO8583_API(unsigned) iso8583_stan_next   (iso8583_stan_t *obj);
+ISO8583_API(void    ) iso8583_stan_release(iso8583_stan_t *obj, unsigned stan);
+ISO8583_API(unsigned) iso8583_stan_assign (iso8583_stan_t *obj, iso8583_fields_t *fields);
+
+ISO8583_API(bool) iso8583_stan_is_outstanding(const iso8583_stan_t *obj, unsigned stan);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_stan_t.
+ */
+class TSTAN : protected iso8583_stan_t
+{
+public:
+    TSTAN(unsigned first = ISO8583_STAN_MIN, int flags = 0) { iso8583_stan_init  (this, first, flags); }  ///< @see iso8583_stan_t::iso8583_stan_init
+    ~TSTAN()                                                 { iso8583_stan_deinit(this); }                ///< @see iso8583_stan_t::iso8583_stan_deinit
+
+private:
+    TSTAN(const TSTAN &src);
+    TSTAN& operator=(const TSTAN &src);
+
+public:
+    unsigned Next   ()                { return iso8583_stan_next   (this); }                 ///< @see iso8583_stan_t::iso8583_stan_next
+    void     Release(unsigned stan)   {        iso8583_stan_release(this, stan); }           ///< @see iso8583_stan_t::iso8583_stan_release
+    unsigned Assign (TFields &fields) { return iso8583_stan_assign (this, fields.cptr()); }  ///< @see iso8583_stan_t::iso8583_stan_assign
+
+    bool IsOutstanding(unsigned stan) const { return iso8583_stan_is_outstanding(this, stan); }  ///< @see iso8583_stan_t::iso8583_stan_is_outstanding
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
@@ -0,0 +1,185 @@
+/**
+ * @file
+ * @brief     Sub-fields of composite fields, such as the private use fields 48, 60 to 63 and 120 to 127.
+ * @details   The layout of a composite field is described by a sub-field spec, which is one of:
+ *            @li Positional : Sub-fields in a fixed order, each is of fixed length,
+ *                             or has an ASCII LL or LLL length prefix.
+ *                             Trailing sub-fields may be absent.
+ *            @li Tagged     : Sub-fields in any order, each has a tag of fixed count of characters
+ *                             and an ASCII length of fixed count of digits, such as "01" "005" "VALUE".
+ *
+ *            For example,
+ *            @code
+ *            static const iso8583_subfield_def_t f60_defs[] =
+ *            {
+ *                { ISO8583_SUBFIELD_FIXED , 2  },
+ *                { ISO8583_SUBFIELD_FIXED , 6  },
+ *                { ISO8583_SUBFIELD_LLVAR , 20 },
+ *            };
+ *            static const iso8583_subfield_spec_t f60 = ISO8583_SUBFIELD_SPEC_POSITIONAL(f60_defs);
+ *            static const iso8583_subfield_spec_t f48 = ISO8583_SUBFIELD_SPEC_TAGGED(2, 3);
+ *            @endcode
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_SUBFIELD_H_
+#define _ISO8583_SUBFIELD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "export.h"
+#include "fitem.h"
+#include "fields.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISO8583_SUBFIELD_MAX  64  // Maximum count of sub-fields in a composite field.
+
+/**
+ * Layouts of composite fields.
+ */
+enum iso8583_subfield_layout_t
+{
+    ISO8583_SUBFIELD_POSITIONAL,  ///< Sub-fields in a fixed order.
+    ISO8583_SUBFIELD_TAGGED,      ///< Sub-fields identified by tags.
+};
+
+/**
+ * Length modes of positional sub-fields.
+ */
+enum iso8583_subfield_mode_t
+{
+    ISO8583_SUBFIELD_FIXED,   ///< Fixed length.
+    ISO8583_SUBFIELD_LLVAR,   ///< Variable length with a 2 digits ASCII length prefix.
+    ISO8583_SUBFIELD_LLLVAR,  ///< Variable length with a 3 digits ASCII length prefix.
+};
+
+/**
+ * @brief Definition of a positional sub-field.
+ */
+typedef struct iso8583_subfield_def_t
+{
+    int      mode;     ///< Length mode, see ::iso8583_subfield_mode_t.
+    unsigned maxsize;  ///< Size of fixed length sub-fields, or maximum size of variable length sub-fields.
+} iso8583_subfield_def_t;
+
+/**
+ * @brief Layout of a composite field.
+ */
+typedef struct iso8583_subfield_spec_t
+{
+    int                           layout;   ///< Layout, see ::iso8583_subfield_layout_t.
+    unsigned                      tagsize;  ///< Characters count of tags (1 to 4), for the tagged layout.
+    unsigned                      lensize;  ///< Digits count of lengths (1 to 4), for the tagged layout.
+    unsigned                      count;    ///< Count of sub-field definitions, for the positional layout.
+    const iso8583_subfield_def_t *defs;     ///< Sub-field definitions, for the positional layout.
+} iso8583_subfield_spec_t;
+
+/// Initializer of a positional spec with an array of sub-field definitions.
+#define ISO8583_SUBFIELD_SPEC_POSITIONAL(defs) \
+    { ISO8583_SUBFIELD_POSITIONAL, 0, 0, sizeof(defs)/sizeof((defs)[0]), (defs) }
+
+/// Initializer of a tagged spec.
+#define ISO8583_SUBFIELD_SPEC_TAGGED(tagsize, lensize) \
+    { ISO8583_SUBFIELD_TAGGED, (tagsize), (lensize), 0, NULL }
+
+/**
+ * @brief Location of a sub-field.
+ */
+typedef struct iso8583_subfield_entry_t
+{
+    uint32_t tag;     ///< The sub-field number (start from 1) for the positional layout; or
+                      ///< characters of the tag in big endian order for the tagged layout.
+    uint16_t offset;  ///< Offset of the value from the beginning of the indexed data.
+    uint16_t length;  ///< Length of the value.
+} iso8583_subfield_entry_t;
+
+/**
+ * @brief Value of a sub-field to be encoded.
+ */
+typedef struct iso8583_subfield_t
+{
+    const char *tag;   ///< The tag, for the tagged layout; and not used for the positional layout.
+    const void *data;  ///< The value.
+    size_t      size;  ///< Size of the value.
+} iso8583_subfield_t;
+
+/**
+ * @class iso8583_subfield_index_t
+ * @brief Index of sub-fields of a composite field.
+ * @details The index is built in one pass over the data,
+ *          and has only locations of the sub-fields,
+ *          so that sub-fields can be accessed without slicing or copying the data.
+ *
+ * @remarks The indexed data and the spec are referenced but not copied,
+ *          so that the index is invalid after the data (or the field item) be modified or released.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_subfield_index_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    const uint8_t                 *data;
+    size_t                         size;
+    const iso8583_subfield_spec_t *spec;
+    unsigned                       count;
+    iso8583_subfield_entry_t       entries[ISO8583_SUBFIELD_MAX];
+} iso8583_subfield_index_t;
+#pragma pack(pop)
+
+ISO8583_API(void) iso8583_subfield_index_init(iso8583_subfield_index_t *obj);
+
+ISO8583_API(int) iso8583_subfield_index_build     (iso8583_subfield_index_t      *obj,
+                                                   const iso8583_subfield_spec_t *spec,
+                                                   const void                    *data,
+                                                   size_t                         size);
+ISO8583_API(int) iso8583_subfield_index_build_item(iso8583_subfield_index_t      *obj,
+                                                   const iso8583_subfield_spec_t *spec,
+                                                   const iso8583_fitem_t         *item);
+
+ISO8583_API(unsigned                       ) iso8583_subfield_index_get_count(const iso8583_subfield_index_t *obj);
+ISO8583_API(const iso8583_subfield_entry_t*) iso8583_subfield_index_get_entry(const iso8583_subfield_index_t *obj, unsigned index);
+ISO8583_API(const void*                    ) iso8583_subfield_index_get_value(const iso8583_subfield_index_t *obj, unsigned number, size_t *length);
+ISO8583_API(const void*                    ) iso8583_subfield_index_find     (const iso8583_subfield_index_t *obj, const char *tag, size_t *length);
+
+ISO8583_API(int) iso8583_subfield_encode(const iso8583_subfield_spec_t *spec,
+                                         iso8583_fields_t              *fields,
+                                         int                            id,
+                                         const iso8583_subfield_t      *subs,
+                                         unsigned                       count);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_subfield_index_t.
+ */
+class TSubfieldIndex : protected iso8583_subfield_index_t
+{
+public:
+    TSubfieldIndex() { iso8583_subfield_index_init(this); }  ///< @see iso8583_subfield_index_t::iso8583_subfield_index_init
+
+public:
+    int Build(const iso8583_subfield_spec_t &spec, const void *data, size_t size) { return iso8583_subfield_index_build(this, &spec, data, size); }                             ///< @see iso8583_subfield_index_t::iso8583_subfield_index_build
+    int Build(const iso8583_subfield_spec_t &spec, const TFitem &item)            { return iso8583_subfield_index_build(this, &spec, item.GetData(), item.GetSize()); }  ///< @see iso8583_subfield_index_t::iso8583_subfield_index_build
+
+    unsigned                        GetCount()                                   const { return iso8583_subfield_index_get_count(this); }                  ///< @see iso8583_subfield_index_t::iso8583_subfield_index_get_count
+    const iso8583_subfield_entry_t* GetEntry(unsigned index)                     const { return iso8583_subfield_index_get_entry(this, index); }           ///< @see iso8583_subfield_index_t::iso8583_subfield_index_get_entry
+    const void*                     GetValue(unsigned number, size_t *length)    const { return iso8583_subfield_index_get_value(this, number, length); }  ///< @see iso8583_subfield_index_t::iso8583_subfield_index_get_value
+    const void*                     Find(const char *tag, size_t *length)        const { return iso8583_subfield_index_find     (this, tag, length); }     ///< @see iso8583_subfield_index_t::iso8583_subfield_index_find
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
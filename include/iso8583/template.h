@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief     Message templates, which share their fields with derived messages.
+ * @details   Messages of a terminal or a link usually have most of their fields in common
+ *            (such as the acquirer, terminal and merchant identifications, and the currency),
+ *            those fields can be set to a template once,
+ *            and messages derived from the template will reference
+ *            the payloads of the template but not copy them.
+ *            For example,
+ *            @code
+ *            ISO8583::TISO8583 base;
+ *            base.SetMTI(0x0200);
+ *            base.Fields().SetData(41, "TERM0001", 8);
+ *            base.Fields().SetData(42, "MERCHANT0000001", 15);
+ *            ISO8583::TTemplate tmpl(base);
+ *
+ *            ISO8583::TISO8583 msg;
+ *            tmpl.Derive(msg);
+ *            msg.Fields().Set<ISO8583::F11>(stan);
+ *            msg.Fields().Set<ISO8583::F4>(amount);
+ *            @endcode
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_TEMPLATE_H_
+#define _ISO8583_TEMPLATE_H_
+
+#include "iso8583.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @class iso8583_template_t
+ * @brief Immutable message template.
+ * @details The template holds a copy of a message, which can not be modified after constructed,
+ *          so that its payloads can be shared by derived messages (see ::iso8583_fitem_share).
+ *          Fields of a derived message are copied to the buffers of the message
+ *          only when they be modified (copy on write).
+ *
+ * @remarks The template must outlive all messages derived from it,
+ *          or the messages must be cleared or derived again
+ *          before the template be destroyed.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_template_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    iso8583_t msg;
+} iso8583_template_t;
+#pragma pack(pop)
+
+ISO8583_API(void) iso8583_template_init  (iso8583_template_t *obj, const iso8583_t *msg);
+ISO8583_API(void) iso8583_template_deinit(iso8583_template_t *obj);
+
+ISO8583_API(const iso8583_t*) iso8583_template_get_message(const iso8583_template_t *obj);
+
+ISO8583_API(void) iso8583_template_derive(const iso8583_template_t *obj, iso8583_t *msg);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_template_t.
+ */
+class TTemplate : protected iso8583_template_t
+{
+public:
+    TTemplate(const TISO8583 &msg) { iso8583_template_init  (this, &msg); }  ///< @see iso8583_template_t::iso8583_template_init
+    ~TTemplate()                   { iso8583_template_deinit(this); }        ///< @see iso8583_template_t::iso8583_template_deinit
+
+private:
+    TTemplate(const TTemplate &src);
+    TTemplate& operator=(const TTemplate &src);
+
+public:
+    const TISO8583& GetMessage() const { return * static_cast<const TISO8583*>( iso8583_template_get_message(this) ); }  ///< @see iso8583_template_t::iso8583_template_get_message
+
+    void Derive(TISO8583 &msg) const { iso8583_template_derive(this, &msg); }  ///< @see iso8583_template_t::iso8583_template_derive
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
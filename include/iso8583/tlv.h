@@ -0,0 +1,156 @@
+/**
+ * @file
+ * @brief     BER-TLV sub-elements of field items, such as the EMV data in field 55.
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_TLV_H_
+#define _ISO8583_TLV_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "export.h"
+#include "fitem.h"
+#include "fields.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISO8583_TLV_INDEX_MAX   64  // Maximum count of data objects in an index.
+#define ISO8583_TLV_DEPTH_MAX    4  // Maximum nesting depth of constructed data objects in a builder.
+
+/**
+ * @brief Location of a TLV data object.
+ */
+typedef struct iso8583_tlv_entry_t
+{
+    uint32_t tag;     ///< The tag, with all bytes of the tag in big endian order, such as 0x9F26.
+    uint16_t offset;  ///< Offset of the value from the beginning of the indexed data.
+    uint16_t length;  ///< Length of the value.
+} iso8583_tlv_entry_t;
+
+/**
+ * @class iso8583_tlv_index_t
+ * @brief Index of TLV data objects.
+ * @details The index is built in one pass over the data,
+ *          and has only tags and locations of the data objects,
+ *          so that values can be found without parsing or copying the data again.
+ *          Only the top level data objects are indexed,
+ *          values of constructed data objects can be indexed by another index object.
+ *
+ * @remarks The indexed data is referenced but not copied,
+ *          so that the index is invalid after the data (or the field item) be modified or released.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_tlv_index_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    const uint8_t       *data;
+    size_t               size;
+    unsigned             count;
+    iso8583_tlv_entry_t  entries[ISO8583_TLV_INDEX_MAX];
+} iso8583_tlv_index_t;
+#pragma pack(pop)
+
+ISO8583_API(void) iso8583_tlv_index_init(iso8583_tlv_index_t *obj);
+
+ISO8583_API(int) iso8583_tlv_index_build     (iso8583_tlv_index_t *obj, const void *data, size_t size);
+ISO8583_API(int) iso8583_tlv_index_build_item(iso8583_tlv_index_t *obj, const iso8583_fitem_t *item);
+
+ISO8583_API(unsigned)                   iso8583_tlv_index_get_count(const iso8583_tlv_index_t *obj);
+ISO8583_API(const iso8583_tlv_entry_t*) iso8583_tlv_index_get_entry(const iso8583_tlv_index_t *obj, unsigned index);
+ISO8583_API(const iso8583_tlv_entry_t*) iso8583_tlv_index_find     (const iso8583_tlv_index_t *obj, uint32_t tag);
+ISO8583_API(const void*)                iso8583_tlv_index_get_value(const iso8583_tlv_index_t *obj, uint32_t tag, size_t *length);
+
+/**
+ * @class iso8583_tlv_builder_t
+ * @brief Incremental builder of TLV data objects.
+ * @details Data objects are encoded to a buffer given by the user one by one,
+ *          and constructed data objects (templates) can be built by
+ *          ::iso8583_tlv_builder_begin and ::iso8583_tlv_builder_end.
+ *          Errors are kept by the builder, so that the results of
+ *          adding data objects do not need to be checked one by one,
+ *          but be checked at the end by ::iso8583_tlv_builder_finish.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_tlv_builder_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    uint8_t  *buf;
+    size_t    size;
+    size_t    pos;
+    int       err;
+    unsigned  depth;
+    size_t    starts[ISO8583_TLV_DEPTH_MAX];
+} iso8583_tlv_builder_t;
+#pragma pack(pop)
+
+ISO8583_API(void) iso8583_tlv_builder_init (iso8583_tlv_builder_t *obj, void *buf, size_t size);
+ISO8583_API(void) iso8583_tlv_builder_reset(iso8583_tlv_builder_t *obj);
+
+ISO8583_API(int) iso8583_tlv_builder_add  (iso8583_tlv_builder_t *obj, uint32_t tag, const void *value, size_t length);
+ISO8583_API(int) iso8583_tlv_builder_begin(iso8583_tlv_builder_t *obj, uint32_t tag);
+ISO8583_API(int) iso8583_tlv_builder_end  (iso8583_tlv_builder_t *obj);
+
+ISO8583_API(int)         iso8583_tlv_builder_finish  (const iso8583_tlv_builder_t *obj);
+ISO8583_API(const void*) iso8583_tlv_builder_get_data(const iso8583_tlv_builder_t *obj);
+ISO8583_API(int)         iso8583_tlv_builder_commit  (const iso8583_tlv_builder_t *obj, iso8583_fields_t *fields, int id);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_tlv_index_t.
+ */
+class TTlvIndex : protected iso8583_tlv_index_t
+{
+public:
+    TTlvIndex() { iso8583_tlv_index_init(this); }  ///< @see iso8583_tlv_index_t::iso8583_tlv_index_init
+
+public:
+    int Build(const void *data, size_t size) { return iso8583_tlv_index_build(this, data, size); }                      ///< @see iso8583_tlv_index_t::iso8583_tlv_index_build
+    int Build(const TFitem &item)            { return iso8583_tlv_index_build(this, item.GetData(), item.GetSize()); }  ///< @see iso8583_tlv_index_t::iso8583_tlv_index_build
+
+    unsigned                   GetCount()                                 const { return iso8583_tlv_index_get_count(this); }               ///< @see iso8583_tlv_index_t::iso8583_tlv_index_get_count
+    const iso8583_tlv_entry_t* GetEntry(unsigned index)                   const { return iso8583_tlv_index_get_entry(this, index); }        ///< @see iso8583_tlv_index_t::iso8583_tlv_index_get_entry
+    const iso8583_tlv_entry_t* Find(uint32_t tag)                         const { return iso8583_tlv_index_find     (this, tag); }          ///< @see iso8583_tlv_index_t::iso8583_tlv_index_find
+    const void*                GetValue(uint32_t tag, size_t *length)     const { return iso8583_tlv_index_get_value(this, tag, length); }  ///< @see iso8583_tlv_index_t::iso8583_tlv_index_get_value
+
+};
+
+/**
+ * @brief C++ wrapper of iso8583_tlv_builder_t.
+ */
+class TTlvBuilder : protected iso8583_tlv_builder_t
+{
+public:
+    TTlvBuilder(void *buf, size_t size) { iso8583_tlv_builder_init(this, buf, size); }  ///< @see iso8583_tlv_builder_t::iso8583_tlv_builder_init
+
+public:
+    void Reset() { iso8583_tlv_builder_reset(this); }  ///< @see iso8583_tlv_builder_t::iso8583_tlv_builder_reset
+
+    int Add  (uint32_t tag, const void *value, size_t length) { return iso8583_tlv_builder_add  (this, tag, value, length); }  ///< @see iso8583_tlv_builder_t::iso8583_tlv_builder_add
+    int Begin(uint32_t tag)                                   { return iso8583_tlv_builder_begin(this, tag); }                 ///< @see iso8583_tlv_builder_t::iso8583_tlv_builder_begin
+    int End  ()                                               { return iso8583_tlv_builder_end  (this); }                      ///< @see iso8583_tlv_builder_t::iso8583_tlv_builder_end
+
+    int         Finish()                            const { return iso8583_tlv_builder_finish  (this); }                      ///< @see iso8583_tlv_builder_t::iso8583_tlv_builder_finish
+    const void* GetData()                           const { return iso8583_tlv_builder_get_data(this); }                      ///< @see iso8583_tlv_builder_t::iso8583_tlv_builder_get_data
+    int         Commit(TFields &fields, int id)     const { return iso8583_tlv_builder_commit  (this, fields.cptr(), id); }  ///< @see iso8583_tlv_builder_t::iso8583_tlv_builder_commit
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file
+ * @brief     Codec tracing hooks and per-field profiler.
+ * @copyright ZLib Licence
+ * @see       https://www.openfoundry.org/of/projects/2747/
+ */
+#ifndef _ISO8583_TRACE_H_
+#define _ISO8583_TRACE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "export.h"
+#include "fitem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Direction of a traced operation.
+ */
+typedef enum iso8583_trace_dir_t
+{
+    ISO8583_TRACE_ENCODE,  ///< A field item be encoded.
+    ISO8583_TRACE_DECODE,  ///< A field item be decoded.
+
+    ISO8583_TRACE_DIRS
+} iso8583_trace_dir_t;
+
+/**
+ * @brief Trace callback, which is called after each field item be encoded or decoded.
+ *
+ * @param userarg A user defined argument.
+ * @param dir     Direction of the operation, see ::iso8583_trace_dir_t.
+ * @param id      The field ID.
+ * @param bytes   Size of the encoded field data, including the length header.
+ * @param cycles  Cost of the operation in CPU time stamp counter cycles
+ *                (or nanoseconds on platforms which do not have one).
+ */
+typedef void(*iso8583_on_trace_t)(void *userarg, int dir, int id, size_t bytes, uint64_t cycles);
+
+ISO8583_API(bool) iso8583_trace_is_enabled(void);
+ISO8583_API(void) iso8583_trace_set_hook(iso8583_on_trace_t on_trace, void *userarg);
+
+ISO8583_API(const char*) iso8583_trace_get_field_type(int id);
+
+/**
+ * @brief Aggregated cost of a field or a field type.
+ */
+typedef struct iso8583_profile_entry_t
+{
+    uint64_t calls;   ///< Count of operations.
+    uint64_t bytes;   ///< Total size of encoded data.
+    uint64_t cycles;  ///< Total cost in cycles.
+} iso8583_profile_entry_t;
+
+/**
+ * @class iso8583_profiler_t
+ * @brief Per-field cost profiler.
+ * @details A profiler aggregates trace records of each field ID and direction,
+ *          which can be attached as the trace hook to find out
+ *          which fields and field types dominate the encode and decode time.
+ *          All counters are updated atomically,
+ *          so that it can be shared by multiple threads.
+ *
+ * @remarks The library must be built with ISO8583_ENABLE_TRACE defined
+ *          to have trace records, see ::iso8583_trace_is_enabled.
+ */
+#pragma pack(push,8)
+typedef struct iso8583_profiler_t
+{
+    /*
+     * WARNING : All members are private.
+     */
+    iso8583_profile_entry_t fields[ISO8583_TRACE_DIRS][1+ISO8583_FITEM_ID_MAX];
+} iso8583_profiler_t;
+#pragma pack(pop)
+
+ISO8583_API(void) iso8583_profiler_init  (iso8583_profiler_t *obj);
+ISO8583_API(void) iso8583_profiler_reset (iso8583_profiler_t *obj);
+ISO8583_API(void) iso8583_profiler_attach(iso8583_profiler_t *obj);
+ISO8583_API(void) iso8583_profiler_detach(iso8583_profiler_t *obj);
+
+ISO8583_API(void) iso8583_profiler_record(iso8583_profiler_t *obj, int dir, int id, size_t bytes, uint64_t cycles);
+
+ISO8583_API(iso8583_profile_entry_t) iso8583_profiler_get_field(const iso8583_profiler_t *obj, int dir, int id);
+ISO8583_API(iso8583_profile_entry_t) iso8583_profiler_get_type (const iso8583_profiler_t *obj, int dir, const char *type);
+
+ISO8583_API(int) iso8583_profiler_export(const iso8583_profiler_t *obj, char *buf, size_t size);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#ifdef __cplusplus
+/// C++ wrapper.
+namespace ISO8583
+{
+
+/**
+ * @brief C++ wrapper of iso8583_profiler_t.
+ */
+class TProfiler : protected iso8583_profiler_t
+{
+public:
+    TProfiler() { iso8583_profiler_init(this); }  ///< @see iso8583_profiler_t::iso8583_profiler_init
+
+private:
+    TProfiler(const TProfiler &src);
+    TProfiler& operator=(const TProfiler &src);
+
+public:
+    void Reset () { iso8583_profiler_reset (this); }  ///< @see iso8583_profiler_t::iso8583_profiler_reset
+    void Attach() { iso8583_profiler_attach(this); }  ///< @see iso8583_profiler_t::iso8583_profiler_attach
+    void Detach() { iso8583_profiler_detach(this); }  ///< @see iso8583_profiler_t::iso8583_profiler_detach
+
+    void Record(int dir, int id, size_t bytes, uint64_t cycles) { iso8583_profiler_record(this, dir, id, bytes, cycles); }  ///< @see iso8583_profiler_t::iso8583_profiler_record
+
+    iso8583_profile_entry_t GetField(int dir, int id)           const { return iso8583_profiler_get_field(this, dir, id); }    ///< @see iso8583_profiler_t::iso8583_profiler_get_field
+    iso8583_profile_entry_t GetType (int dir, const char *type) const { return iso8583_profiler_get_type (this, dir, type); }  ///< @see iso8583_profiler_t::iso8583_profiler_get_type
+
+    int Export(char *buf, size_t size) const { return iso8583_profiler_export(this, buf, size); }  ///< @see iso8583_profiler_t::iso8583_profiler_export
+
+};
+
+}  // namespace ISO8583
+#endif  // __cplusplus
+
+#endif
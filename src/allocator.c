@@ -0,0 +1,159 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "allocator.h"
+
+//------------------------------------------------------------------------------
+static
+void* libc_alloc(void *userarg, size_t size)
+{
+    return malloc(size);
+}
+//------------------------------------------------------------------------------
+static
+void* libc_realloc(void *userarg, void *ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+//------------------------------------------------------------------------------
+static
+void libc_free(void *userarg, void *ptr)
+{
+    free(ptr);
+}
+//------------------------------------------------------------------------------
+static const iso8583_allocator_t libc_allocator =
+{
+    .userarg    = NULL,
+    .on_alloc   = libc_alloc,
+    .on_realloc = libc_realloc,
+    .on_free    = libc_free,
+};
+
+static const iso8583_allocator_t *default_allocator = &libc_allocator;
+//------------------------------------------------------------------------------
+const iso8583_allocator_t* ISO8583_CALL iso8583_allocator_get_libc(void)
+{
+    /**
+     * @memberof iso8583_allocator_t
+     * @brief Get the allocator which uses malloc, realloc, and free of the C library.
+     */
+    return &libc_allocator;
+}
+//------------------------------------------------------------------------------
+const iso8583_allocator_t* ISO8583_CALL iso8583_allocator_get_default(void)
+{
+    /**
+     * @memberof iso8583_allocator_t
+     * @brief Get the process default allocator.
+     */
+    return __atomic_load_n(&default_allocator, __ATOMIC_ACQUIRE);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_allocator_set_default(const iso8583_allocator_t *allocator)
+{
+    /**
+     * @memberof iso8583_allocator_t
+     * @brief Set the process default allocator.
+     *
+     * @param allocator The allocator which will be used by objects constructed later;
+     *                  or NULL to restore the C library allocator.
+     *                  It must outlive all objects which use it.
+     */
+    __atomic_store_n(&default_allocator, allocator ? allocator : &libc_allocator, __ATOMIC_RELEASE);
+}
+//------------------------------------------------------------------------------
+static
+void* counting_alloc(void *userarg, size_t size)
+{
+    iso8583_counting_allocator_t *obj = userarg;
+    __atomic_fetch_add(&obj->stats.allocs, 1, __ATOMIC_RELAXED);
+    return obj->upstream->on_alloc(obj->upstream->userarg, size);
+}
+//------------------------------------------------------------------------------
+static
+void* counting_realloc(void *userarg, void *ptr, size_t size)
+{
+    iso8583_counting_allocator_t *obj = userarg;
+    __atomic_fetch_add(&obj->stats.reallocs, 1, __ATOMIC_RELAXED);
+    return obj->upstream->on_realloc(obj->upstream->userarg, ptr, size);
+}
+//------------------------------------------------------------------------------
+static
+void counting_free(void *userarg, void *ptr)
+{
+    iso8583_counting_allocator_t *obj = userarg;
+    if( ptr ) __atomic_fetch_add(&obj->stats.frees, 1, __ATOMIC_RELAXED);
+    obj->upstream->on_free(obj->upstream->userarg, ptr);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_counting_allocator_init(iso8583_counting_allocator_t *obj, const iso8583_allocator_t *upstream)
+{
+    /**
+     * @memberof iso8583_counting_allocator_t
+     * @brief Constructor.
+     *
+     * @param obj      Object instance.
+     * @param upstream The allocator which does the real work;
+     *                 or NULL to use the C library allocator.
+     */
+    assert( obj );
+
+    memset(obj, 0, sizeof(*obj));
+
+    obj->iface.userarg    = obj;
+    obj->iface.on_alloc   = counting_alloc;
+    obj->iface.on_realloc = counting_realloc;
+    obj->iface.on_free    = counting_free;
+
+    obj->upstream = upstream ? upstream : &libc_allocator;
+}
+//------------------------------------------------------------------------------
+const iso8583_allocator_t* ISO8583_CALL iso8583_counting_allocator_get_interface(const iso8583_counting_allocator_t *obj)
+{
+    /**
+     * @memberof iso8583_counting_allocator_t
+     * @brief Get the allocator interface,
+     *        which can be set as the default allocator or the allocator of messages.
+     *
+     * @param obj Object instance.
+     * @return The allocator interface.
+     */
+    assert( obj );
+    return &obj->iface;
+}
+//------------------------------------------------------------------------------
+iso8583_alloc_stats_t ISO8583_CALL iso8583_counting_allocator_get_stats(const iso8583_counting_allocator_t *obj)
+{
+    /**
+     * @memberof iso8583_counting_allocator_t
+     * @brief Get statistics.
+     *
+     * @param obj Object instance.
+     * @return Counts of calls since the object constructed or the last reset.
+     */
+    assert( obj );
+
+    iso8583_alloc_stats_t stats;
+    stats.allocs   = __atomic_load_n(&obj->stats.allocs  , __ATOMIC_RELAXED);
+    stats.reallocs = __atomic_load_n(&obj->stats.reallocs, __ATOMIC_RELAXED);
+    stats.frees    = __atomic_load_n(&obj->stats.frees   , __ATOMIC_RELAXED);
+
+    return stats;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_counting_allocator_reset_stats(iso8583_counting_allocator_t *obj)
+{
+    /**
+     * @memberof iso8583_counting_allocator_t
+     * @brief Reset all counters to zero.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    __atomic_store_n(&obj->stats.allocs  , 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&obj->stats.reallocs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&obj->stats.frees   , 0, __ATOMIC_RELAXED);
+}
+//------------------------------------------------------------------------------
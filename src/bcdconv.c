@@ -0,0 +1,257 @@
+#include <assert.h>
+#include <string.h>
+#include "bcdconv.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define BCDCONV_HAVE_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Each byte of packed BCD has two digits, the high nibble is the first one.
+ * Nibbles which are not decimal digits are not checked by the decoders,
+ * they are weighted by ten the same as the digits,
+ * so that all kernels have the same result as the simple digit by digit loop.
+ */
+
+//------------------------------------------------------------------------------
+static
+void to_ascii_scalar(char *str, const uint8_t *bcd, size_t size)
+{
+    for(size_t i=0; i<size; ++i)
+    {
+        *str++ = '0' + ( bcd[i] >> 4 );
+        *str++ = '0' + ( bcd[i] & 0x0F );
+    }
+}
+//------------------------------------------------------------------------------
+static
+bool from_ascii_scalar(uint8_t *bcd, const char *str, size_t len)
+{
+    unsigned bad = 0;
+    for(size_t i=0; i+1<len; i+=2)
+    {
+        unsigned hi = (uint8_t) str[i  ] - '0';
+        unsigned lo = (uint8_t) str[i+1] - '0';
+        bad |= ( hi > 9 ) | ( lo > 9 );
+        *bcd++ = hi << 4 | lo;
+    }
+
+    return !bad;
+}
+//------------------------------------------------------------------------------
+static
+uint64_t to_int_scalar(const uint8_t *bcd, size_t size)
+{
+    uint64_t value = 0;
+    for(size_t i=0; i<size; ++i)
+        value = value * 100 + ( bcd[i] >> 4 ) * 10 + ( bcd[i] & 0x0F );
+
+    return value;
+}
+//------------------------------------------------------------------------------
+#ifdef BCDCONV_HAVE_X86
+//------------------------------------------------------------------------------
+static __attribute__((target("ssse3")))
+void to_ascii_ssse3(char *str, const uint8_t *bcd, size_t size)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero   = _mm_set1_epi8('0');
+
+    size_t pos = 0;
+    for(; pos + 8 <= size; pos += 8)
+    {
+        // Interleave the high and low nibbles of 8 bytes to 16 digits.
+        __m128i x  = _mm_loadl_epi64((const __m128i*)( bcd + pos ));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), nibble);
+        __m128i lo = _mm_and_si128(x, nibble);
+        _mm_storeu_si128((__m128i*)( str + 2*pos ), _mm_add_epi8(_mm_unpacklo_epi8(hi, lo), zero));
+    }
+
+    to_ascii_scalar(str + 2*pos, bcd + pos, size - pos);
+}
+//------------------------------------------------------------------------------
+static __attribute__((target("ssse3")))
+bool from_ascii_ssse3(uint8_t *bcd, const char *str, size_t len)
+{
+    const __m128i zero    = _mm_set1_epi8('0');
+    const __m128i nine    = _mm_set1_epi8(9);
+    const __m128i weights = _mm_set1_epi16(0x0110);  // 16 for the first digit and 1 for the second one of each pair.
+
+    __m128i bad = _mm_setzero_si128();
+    size_t  pos = 0;
+    for(; pos + 16 <= len; pos += 16)
+    {
+        __m128i digits = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)( str + pos )), zero);
+        bad = _mm_or_si128(bad, _mm_xor_si128(_mm_cmpeq_epi8(_mm_min_epu8(digits, nine), digits),
+                                              _mm_set1_epi8(-1)));
+
+        // Pairs of digits to bytes of 16*hi+lo, which are then packed to 8 bytes.
+        __m128i pairs = _mm_maddubs_epi16(digits, weights);
+        _mm_storel_epi64((__m128i*)( bcd + pos/2 ), _mm_packus_epi16(pairs, pairs));
+    }
+
+    if( _mm_movemask_epi8(bad) ) return false;
+    return from_ascii_scalar(bcd + pos/2, str + pos, len - pos);
+}
+//------------------------------------------------------------------------------
+static __attribute__((target("ssse3")))
+uint64_t to_int_ssse3(const uint8_t *bcd, size_t size)
+{
+    // Short values have no benefit, and long ones are only truncated.
+    if( size < 8 || 16 < size ) return to_int_scalar(bcd, size);
+
+    /*
+     * Load the value right aligned to 16 bytes without reading over the input:
+     * the last 8 bytes to the high half,
+     * and the leading bytes shifted by a shuffle to the end of the low half.
+     */
+    static const int8_t slide[32] =
+    {
+        -128,-128,-128,-128,-128,-128,-128,-128,-128,-128,-128,-128,-128,-128,-128,-128,
+           0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,
+    };
+
+    __m128i head = _mm_loadl_epi64((const __m128i*) bcd);
+    __m128i tail = _mm_loadl_epi64((const __m128i*)( bcd + size - 8 ));
+    head = _mm_shuffle_epi8(head, _mm_loadu_si128((const __m128i*)( slide + size )));
+    __m128i x = _mm_unpacklo_epi64(head, tail);
+
+    // Each byte to its value of 10*hi+lo, which is byte-6*hi.
+    __m128i hi  = _mm_and_si128(_mm_srli_epi16(x, 4), _mm_set1_epi8(0x0F));
+    __m128i hi2 = _mm_add_epi8(hi, hi);
+    __m128i val = _mm_sub_epi8(x, _mm_add_epi8(_mm_add_epi8(hi2, hi2), hi2));
+
+    // Combine to 4 digits in 16 bits, 8 digits in 32 bits, and then 16 digits in 64 bits.
+    val = _mm_maddubs_epi16(val, _mm_set1_epi16(0x0164));      // 100 and 1.
+    val = _mm_madd_epi16   (val, _mm_set1_epi32(0x00012710));  // 10000 and 1.
+    val = _mm_add_epi64(_mm_mul_epu32(val, _mm_set1_epi64x(100000000)), _mm_srli_epi64(val, 32));
+
+    uint64_t parts[2];
+    _mm_storeu_si128((__m128i*) parts, val);
+    return parts[0] * UINT64_C(10000000000000000) + parts[1];
+}
+//------------------------------------------------------------------------------
+#endif  // BCDCONV_HAVE_X86
+//------------------------------------------------------------------------------
+bcdconv_isa_t bcdconv_get_best_isa(void)
+{
+    /*
+     * Get the best instruction set which is supported by the current CPU.
+     */
+#ifdef BCDCONV_HAVE_X86
+    static int best = -1;
+
+    int isa = __atomic_load_n(&best, __ATOMIC_RELAXED);
+    if( isa < 0 )
+    {
+        __builtin_cpu_init();
+        isa = __builtin_cpu_supports("ssse3") ? BCDCONV_ISA_SSSE3 : BCDCONV_ISA_SCALAR;
+        __atomic_store_n(&best, isa, __ATOMIC_RELAXED);
+    }
+
+    return isa;
+#else
+    return BCDCONV_ISA_SCALAR;
+#endif
+}
+//------------------------------------------------------------------------------
+void bcdconv_to_ascii_isa(char *str, const void *bcd, size_t size, bcdconv_isa_t isa)
+{
+    /*
+     * Convert packed BCD to digit characters (2*size characters, without the null terminator),
+     * by the specified instruction set, which must be supported by the current CPU.
+     */
+    assert( ( str && bcd ) || !size );
+
+#ifdef BCDCONV_HAVE_X86
+    if( isa == BCDCONV_ISA_SSSE3 )
+    {
+        to_ascii_ssse3(str, bcd, size);
+        return;
+    }
+#endif
+    to_ascii_scalar(str, bcd, size);
+}
+//------------------------------------------------------------------------------
+bool bcdconv_from_ascii_isa(void *bcd, const char *str, size_t len, bcdconv_isa_t isa)
+{
+    /*
+     * Convert digit characters to packed BCD ((len+1)/2 bytes),
+     * an odd count of digits will be padded with a leading zero;
+     * and returns FALSE if there have any character not a digit.
+     */
+    assert( ( str && bcd ) || !len );
+
+    uint8_t *bytes = bcd;
+    if( len & 1 )
+    {
+        unsigned first = (uint8_t) str[0] - '0';
+        if( first > 9 ) return false;
+
+        *bytes++ = first;
+        ++str;
+        --len;
+    }
+
+#ifdef BCDCONV_HAVE_X86
+    if( isa == BCDCONV_ISA_SSSE3 ) return from_ascii_ssse3(bytes, str, len);
+#endif
+    return from_ascii_scalar(bytes, str, len);
+}
+//------------------------------------------------------------------------------
+uint64_t bcdconv_to_int_isa(const void *bcd, size_t size, bcdconv_isa_t isa)
+{
+    /*
+     * Convert packed BCD to integer,
+     * values of more than 19 digits are truncated to 64 bits.
+     */
+    assert( bcd || !size );
+
+#ifdef BCDCONV_HAVE_X86
+    if( isa == BCDCONV_ISA_SSSE3 ) return to_int_ssse3(bcd, size);
+#endif
+    return to_int_scalar(bcd, size);
+}
+//------------------------------------------------------------------------------
+void bcdconv_to_ascii(char *str, const void *bcd, size_t size)
+{
+    bcdconv_to_ascii_isa(str, bcd, size, bcdconv_get_best_isa());
+}
+//------------------------------------------------------------------------------
+bool bcdconv_from_ascii(void *bcd, const char *str, size_t len)
+{
+    return bcdconv_from_ascii_isa(bcd, str, len, bcdconv_get_best_isa());
+}
+//------------------------------------------------------------------------------
+uint64_t bcdconv_to_int(const void *bcd, size_t size)
+{
+    return bcdconv_to_int_isa(bcd, size, bcdconv_get_best_isa());
+}
+//------------------------------------------------------------------------------
+void bcdconv_from_int(void *bcd, size_t size, uint64_t value)
+{
+    /*
+     * Convert integer to packed BCD of the specified size,
+     * with leading zeros, or the high digits truncated if the size is too small.
+     *
+     * The value is split to 8 digits groups first,
+     * so that most of the divisions are on 32 bits.
+     */
+    assert( bcd || !size );
+
+    uint8_t *pos = (uint8_t*) bcd + size;
+    while( pos != bcd )
+    {
+        uint32_t group = value % 100000000;
+        value /= 100000000;
+
+        for(int i=0; i<4 && pos!=bcd; ++i)
+        {
+            uint32_t pair = group % 100;
+            group /= 100;
+            *--pos = ( pair / 10 ) << 4 | ( pair % 10 );
+        }
+    }
+}
+//------------------------------------------------------------------------------
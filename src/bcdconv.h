@@ -0,0 +1,36 @@
+/*
+ * Packed BCD conversion kernels.
+ */
+#ifndef _ISO8583_BCDCONV_H_
+#define _ISO8583_BCDCONV_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum bcdconv_isa_t
+{
+    BCDCONV_ISA_SCALAR,
+    BCDCONV_ISA_SSSE3,
+} bcdconv_isa_t;
+
+bcdconv_isa_t bcdconv_get_best_isa(void);
+
+void     bcdconv_to_ascii  (char *str, const void *bcd, size_t size);
+bool     bcdconv_from_ascii(void *bcd, const char *str, size_t len);
+uint64_t bcdconv_to_int    (const void *bcd, size_t size);
+void     bcdconv_from_int  (void *bcd, size_t size, uint64_t value);
+
+void     bcdconv_to_ascii_isa  (char *str, const void *bcd, size_t size, bcdconv_isa_t isa);
+bool     bcdconv_from_ascii_isa(void *bcd, const char *str, size_t len, bcdconv_isa_t isa);
+uint64_t bcdconv_to_int_isa    (const void *bcd, size_t size, bcdconv_isa_t isa);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
@@ -1,48 +1,196 @@
 #include <assert.h>
 #include <string.h>
-#include <gen/bits.h>
+#include "flags.h"
+#include "ebcdic.h"
 #include "bitmap.h"
 
+#define BITMAP_INDICATOR  ( UINT64_C(1) << 63 )
+
+/*
+ * Tables of the hexadecimal text mode (see ISO8583_FLAG_BITMAP_HEX):
+ * characters of each byte value for encoding,
+ * and the value of each character for decoding,
+ * which is 0x10 for characters that are not hexadecimal digits.
+ */
+
+#define HEX_ROW(hi) \
+    hi "0" hi "1" hi "2" hi "3" hi "4" hi "5" hi "6" hi "7" \
+    hi "8" hi "9" hi "A" hi "B" hi "C" hi "D" hi "E" hi "F"
+
+static const char hex_pairs[2*256+1] =
+    HEX_ROW("0") HEX_ROW("1") HEX_ROW("2") HEX_ROW("3")
+    HEX_ROW("4") HEX_ROW("5") HEX_ROW("6") HEX_ROW("7")
+    HEX_ROW("8") HEX_ROW("9") HEX_ROW("A") HEX_ROW("B")
+    HEX_ROW("C") HEX_ROW("D") HEX_ROW("E") HEX_ROW("F");
+
+#undef HEX_ROW
+
+#define XX 0x10
+static const uint8_t hex_values[256] =
+{
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+     0, 1, 2, 3, 4, 5, 6, 7, 8, 9,XX,XX,XX,XX,XX,XX,
+    XX,10,11,12,13,14,15,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,10,11,12,13,14,15,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+    XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,XX,
+};
+#undef XX
+
 //------------------------------------------------------------------------------
-void bitmap_init(bitmap_t *obj)
+static inline
+uint64_t id_mask(int id)
 {
-    assert( obj );
-    memset(obj, 0, sizeof(*obj));
+    return BITMAP_INDICATOR >> ( ( id - 1 ) & 63 );
+}
+//------------------------------------------------------------------------------
+static inline
+bool id_is_valid(int id)
+{
+    return ISO8583_BITMAP_ID_MIN <= id && id <= ISO8583_BITMAP_ID_MAX &&
+           id != ISO8583_BITMAP_ID_TERTIARY;
+}
+//------------------------------------------------------------------------------
+static
+void store_word(uint8_t *buf, uint64_t word)
+{
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = __builtin_bswap64(word);
+    memcpy(buf, &word, sizeof(word));
+#else
+    for(int i=7; i>=0; --i, word>>=8)
+        buf[i] = word;
+#endif
+}
+//------------------------------------------------------------------------------
+static
+uint64_t load_word(const uint8_t *data)
+{
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    return __builtin_bswap64(word);
+#else
+    uint64_t word = 0;
+    for(int i=0; i<8; ++i)
+        word = word << 8 | data[i];
+    return word;
+#endif
+}
+//------------------------------------------------------------------------------
+static
+void store_word_hex(char *buf, uint64_t word)
+{
+    for(int i=0; i<8; ++i)
+        memcpy(buf + 2*i, hex_pairs + 2*( 0xFF & ( word >> ( 56 - 8*i ) ) ), 2);
+}
+//------------------------------------------------------------------------------
+static
+bool load_word_hex(uint64_t *word, const char *data)
+{
+    uint64_t value = 0;
+    unsigned bad   = 0;
+    for(int i=0; i<16; ++i)
+    {
+        unsigned digit = hex_values[ (uint8_t) data[i] ];
+        bad  |= digit;
+        value = value << 4 | ( digit & 0x0F );
+    }
+
+    *word = value;
+    return !( bad & 0x10 );
+}
+//------------------------------------------------------------------------------
+static
+void put_word(uint8_t *buf, uint64_t word, bool hex)
+{
+    if( hex )
+        store_word_hex((char*) buf, word);
+    else
+        store_word(buf, word);
 }
 //------------------------------------------------------------------------------
 static
-int get_last_id(const bitmap_t *obj)
+bool get_word(uint64_t *word, const uint8_t *data, bool hex)
 {
-    for(int id=ISO8583_BITMAP_ID_MAX; id; --id)
+    if( hex ) return load_word_hex(word, (const char*) data);
+
+    *word = load_word(data);
+    return true;
+}
+//------------------------------------------------------------------------------
+static
+int find_id(const bitmap_t *obj, int first)
+{
+    // Find the first ID from the specified one.
+    for(int index=( first - 1 ) >> 6; index<ISO8583_BITMAP_WORDS; ++index)
     {
-        if( obj->states[id] )
-            return id;
+        uint64_t bits = obj->words[index];
+        if( index == ( first - 1 ) >> 6 )
+            bits &= UINT64_MAX >> ( ( first - 1 ) & 63 );
+
+        if( bits )
+            return 64*index + __builtin_clzll(bits) + 1;
     }
 
     return 0;
 }
 //------------------------------------------------------------------------------
+void bitmap_init(bitmap_t *obj)
+{
+    assert( obj );
+    memset(obj, 0, sizeof(*obj));
+}
+//------------------------------------------------------------------------------
 int bitmap_encode(const bitmap_t *obj, void *buf, size_t size, int flags)
 {
+    /*
+     * The secondary bitmap follows if any of field 65 to 192 exists,
+     * and the tertiary one follows if any of field 129 to 192 exists.
+     * Each bitmap is 8 bytes of binary, or 16 hexadecimal characters
+     * with ISO8583_FLAG_BITMAP_HEX (in EBCDIC with ISO8583_FLAG_EBCDIC).
+     */
     assert( obj );
 
     if( !buf ) return ISO8583_ERR_INVALID_ARG;
 
-    bool extend_mode = get_last_id(obj) > 64;
-    int  encode_size = extend_mode ? 16 : 8;
-    if( size < encode_size ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+    bool   hex  = flags & ISO8583_FLAG_BITMAP_HEX;
+    size_t unit = hex ? 16 : 8;
+
+    uint64_t primary   = obj->words[0];
+    uint64_t secondary = obj->words[1];
+    uint64_t tertiary  = obj->words[2];
+
+    int count = tertiary ? 3 : secondary ? 2 : 1;
+    if( size < unit*count ) return ISO8583_ERR_BUF_NOT_ENOUGH;
 
-    memset(buf, 0, encode_size);
-    for(int id=ISO8583_BITMAP_ID_MIN; id<=ISO8583_BITMAP_ID_MAX; ++id)
+    uint8_t *pos = buf;
+    if( count == 1 )
     {
-        if( obj->states[id] )
-            bits_set_bit(buf, id-1);
+        put_word(pos, primary, hex);
+    }
+    else
+    {
+        put_word(pos       , primary | BITMAP_INDICATOR, hex);
+        put_word(pos + unit, secondary | ( count == 3 ? BITMAP_INDICATOR : 0 ), hex);
+        if( count == 3 )
+            put_word(pos + 2*unit, tertiary, hex);
     }
 
-    if( extend_mode )
-        bits_set_bit(buf, 0);
+    if( hex && ( flags & ISO8583_FLAG_EBCDIC ) )
+        ebcdic_from_ascii(pos, pos, unit*count);
 
-    return encode_size;
+    return unit*count;
 }
 //------------------------------------------------------------------------------
 int bitmap_decode(bitmap_t *obj, const void *data, size_t size, int flags)
@@ -50,70 +198,78 @@ int bitmap_decode(bitmap_t *obj, const void *data, size_t size, int flags)
     assert( obj );
 
     if( !data ) return ISO8583_ERR_INVALID_ARG;
-    if( !size ) return ISO8583_ERR_BUF_NOT_ENOUGH;
 
-    bool extend_mode = bits_get_bit(data, 0);
-    int  decode_size = extend_mode ? 16 : 8;
-    if( size < decode_size ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+    bool   hex  = flags & ISO8583_FLAG_BITMAP_HEX;
+    size_t unit = hex ? 16 : 8;
+    if( size < unit ) return ISO8583_ERR_BUF_NOT_ENOUGH;
 
-    bitmap_clear(obj);
+    const uint8_t *pos = data;
 
-    int id_max = extend_mode ? ISO8583_BITMAP_ID_MAX : 64;
-    for(int id=ISO8583_BITMAP_ID_MIN; id<=id_max; ++id)
+    // Hexadecimal characters in EBCDIC are converted to a local copy first.
+    uint8_t text[3*16];
+    if( hex && ( flags & ISO8583_FLAG_EBCDIC ) )
     {
-        obj->states[id] = bits_get_bit(data, id-1);
+        ebcdic_to_ascii(text, data, size < sizeof(text) ? size : sizeof(text));
+        pos = text;
     }
 
-    return decode_size;
+    bitmap_clear(obj);
+    if( !get_word(&obj->words[0], pos, hex) ) return ISO8583_ERR_TEXT_FORMAT;
+    if( !( obj->words[0] & BITMAP_INDICATOR ) ) return unit;
+
+    if( size < 2*unit ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+    obj->words[0] &= ~BITMAP_INDICATOR;
+    if( !get_word(&obj->words[1], pos + unit, hex) ) return ISO8583_ERR_TEXT_FORMAT;
+    if( !( obj->words[1] & BITMAP_INDICATOR ) ) return 2*unit;
+
+    if( size < 3*unit ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+    obj->words[1] &= ~BITMAP_INDICATOR;
+    if( !get_word(&obj->words[2], pos + 2*unit, hex) ) return ISO8583_ERR_TEXT_FORMAT;
+    return 3*unit;
 }
 //------------------------------------------------------------------------------
 bool bitmap_have_id(const bitmap_t *obj, int id)
 {
     assert( obj );
 
-    return id >= ISO8583_BITMAP_ID_MIN &&
-           id <= ISO8583_BITMAP_ID_MAX &&
-           obj->states[id];
+    return id_is_valid(id) && ( obj->words[ ( id - 1 ) >> 6 ] & id_mask(id) );
 }
 //------------------------------------------------------------------------------
 int bitmap_get_first_id(const bitmap_t *obj)
 {
-    for(int id=ISO8583_BITMAP_ID_MIN; id<=ISO8583_BITMAP_ID_MAX; ++id)
-    {
-        if( obj->states[id] )
-            return id;
-    }
+    assert( obj );
 
-    return 0;
+    return find_id(obj, ISO8583_BITMAP_ID_MIN);
 }
 //------------------------------------------------------------------------------
 int bitmap_get_next_id(const bitmap_t *obj, int prev_id)
 {
-    if( prev_id < ISO8583_BITMAP_ID_MIN ) return 0;
+    assert( obj );
 
-    for(int id=prev_id+1; id<=ISO8583_BITMAP_ID_MAX; ++id)
-    {
-        if( obj->states[id] )
-            return id;
-    }
+    if( prev_id < ISO8583_BITMAP_ID_MIN || ISO8583_BITMAP_ID_MAX <= prev_id ) return 0;
 
-    return 0;
+    return find_id(obj, prev_id + 1);
 }
 //------------------------------------------------------------------------------
 int bitmap_set_id(bitmap_t *obj, int id)
 {
     assert( obj );
 
-    if( id < ISO8583_BITMAP_ID_MIN ||
-        id > ISO8583_BITMAP_ID_MAX )
-    {
-        return ISO8583_ERR_INVALID_ARG;
-    }
+    if( !id_is_valid(id) ) return ISO8583_ERR_INVALID_ARG;
 
-    obj->states[id] = true;
+    obj->words[ ( id - 1 ) >> 6 ] |= id_mask(id);
     return ISO8583_ERR_SUCCESS;
 }
 //------------------------------------------------------------------------------
+void bitmap_clear_id(bitmap_t *obj, int id)
+{
+    assert( obj );
+
+    if( !id_is_valid(id) ) return;
+
+    obj->words[ ( id - 1 ) >> 6 ] &= ~id_mask(id);
+}
+//------------------------------------------------------------------------------
 void bitmap_clear(bitmap_t *obj)
 {
     assert( obj );
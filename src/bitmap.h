@@ -6,14 +6,22 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "errcode.h"
 
-#define ISO8583_BITMAP_ID_MIN   2
-#define ISO8583_BITMAP_ID_MAX 128
+#define ISO8583_BITMAP_ID_MIN        2
+#define ISO8583_BITMAP_ID_MAX      192
+#define ISO8583_BITMAP_ID_TERTIARY  65  // Bit of the tertiary bitmap indicator.
+#define ISO8583_BITMAP_WORDS         3
 
 typedef struct bitmap_t
 {
-    bool states[1+ISO8583_BITMAP_ID_MAX];  // Index zero (invalid), and one (extend bitmap) will not be used.
+    /*
+     * Bits in the same order as the encoded bitmap:
+     * the most significant bit of the first word is field 1.
+     * Bits of the bitmap indicators (field 1 and 65) are never set.
+     */
+    uint64_t words[ISO8583_BITMAP_WORDS];
 } bitmap_t;
 
 void bitmap_init(bitmap_t *obj);
@@ -25,7 +33,8 @@ bool bitmap_have_id     (const bitmap_t *obj, int id);
 int  bitmap_get_first_id(const bitmap_t *obj);
 int  bitmap_get_next_id (const bitmap_t *obj, int prev_id);
 
-int  bitmap_set_id(bitmap_t *obj, int id);
-void bitmap_clear (bitmap_t *obj);
+int  bitmap_set_id  (bitmap_t *obj, int id);
+void bitmap_clear_id(bitmap_t *obj, int id);
+void bitmap_clear   (bitmap_t *obj);
 
 #endif
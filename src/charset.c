@@ -0,0 +1,369 @@
+#include <assert.h>
+#include <stdint.h>
+#include "charset.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define CHARSET_HAVE_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Text elements are checked against the rules of which kinds of characters are allowed:
+ * letters (a), digits (n), and special characters (s).
+ * Space is treated as a padding character and is allowed by all text types.
+ *
+ * Numeric elements are packed in BCD, each nibble must be a decimal digit;
+ * and PAN may have a 0xF nibble at the end to pad an odd count of digits.
+ *
+ * Track 2 elements (z) have digits, the field separator ('=' or 'D'),
+ * and the start and end sentinels (';' and '?').
+ */
+
+#define RULE_LETTER   0x01
+#define RULE_DIGIT    0x02
+#define RULE_SPECIAL  0x04
+
+typedef enum kind_t
+{
+    KIND_ANY,
+    KIND_TEXT,
+    KIND_TRACK,
+    KIND_BCD,
+    KIND_PAN,
+} kind_t;
+
+//------------------------------------------------------------------------------
+static
+kind_t eletype_to_kind(finfo_eletype_t eletype, unsigned *rules)
+{
+    switch( eletype )
+    {
+    case FINFO_ELE_N   : return KIND_BCD;
+    case FINFO_ELE_PAN : return KIND_PAN;
+    case FINFO_ELE_Z   : return KIND_TRACK;
+    case FINFO_ELE_B   : return KIND_ANY;
+    case FINFO_ELE_BIN : return KIND_ANY;
+    case FINFO_ELE_NONE: return KIND_ANY;
+    default: break;
+    }
+
+    *rules = ( ( eletype & FINFO_ELE_A ) ? RULE_LETTER  : 0 ) |
+             ( ( eletype & FINFO_ELE_N ) ? RULE_DIGIT   : 0 ) |
+             ( ( eletype & FINFO_ELE_S ) ? RULE_SPECIAL : 0 );
+    return KIND_TEXT;
+}
+//------------------------------------------------------------------------------
+static
+bool is_text_char(uint8_t ch, unsigned rules)
+{
+    if( ch < 0x20 || 0x7E < ch ) return false;
+    if( ch == ' ' ) return true;
+
+    if( '0' <= ch && ch <= '9' ) return rules & RULE_DIGIT;
+
+    uint8_t lower = ch | 0x20;
+    if( 'a' <= lower && lower <= 'z' ) return rules & RULE_LETTER;
+
+    return rules & RULE_SPECIAL;
+}
+//------------------------------------------------------------------------------
+static
+bool is_track_char(uint8_t ch)
+{
+    return ( '0' <= ch && ch <= '9' ) || ch == '=' || ch == 'D' || ch == ';' || ch == '?';
+}
+//------------------------------------------------------------------------------
+static
+bool is_bcd_byte(uint8_t ch)
+{
+    return ( ch >> 4 ) <= 9 && ( ch & 0x0F ) <= 9;
+}
+//------------------------------------------------------------------------------
+static
+bool check_text_scalar(const uint8_t *data, size_t size, unsigned rules)
+{
+    for(size_t i=0; i<size; ++i)
+        if( !is_text_char(data[i], rules) ) return false;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+static
+bool check_track_scalar(const uint8_t *data, size_t size)
+{
+    for(size_t i=0; i<size; ++i)
+        if( !is_track_char(data[i]) ) return false;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+static
+bool check_bcd_scalar(const uint8_t *data, size_t size)
+{
+    for(size_t i=0; i<size; ++i)
+        if( !is_bcd_byte(data[i]) ) return false;
+
+    return true;
+}
+//------------------------------------------------------------------------------
+#ifdef CHARSET_HAVE_X86
+//------------------------------------------------------------------------------
+/*
+ * Unsigned range test of each byte: ( x - lo ) <= ( hi - lo ) in unsigned,
+ * which is done by a wrapping subtraction and an unsigned minimum.
+ */
+#define SSE2_IN_RANGE(x, lo, hi) \
+    _mm_cmpeq_epi8(_mm_min_epu8(_mm_sub_epi8((x), _mm_set1_epi8(lo)), _mm_set1_epi8((hi)-(lo))), \
+                   _mm_sub_epi8((x), _mm_set1_epi8(lo)))
+
+#define AVX2_IN_RANGE(x, lo, hi) \
+    _mm256_cmpeq_epi8(_mm256_min_epu8(_mm256_sub_epi8((x), _mm256_set1_epi8(lo)), _mm256_set1_epi8((hi)-(lo))), \
+                      _mm256_sub_epi8((x), _mm256_set1_epi8(lo)))
+//------------------------------------------------------------------------------
+static __attribute__((target("sse2")))
+bool check_text_sse2(const uint8_t *data, size_t size, unsigned rules)
+{
+    const __m128i deny_letter  = _mm_set1_epi8( ( rules & RULE_LETTER  ) ? 0 : -1 );
+    const __m128i deny_digit   = _mm_set1_epi8( ( rules & RULE_DIGIT   ) ? 0 : -1 );
+    const __m128i deny_special = _mm_set1_epi8( ( rules & RULE_SPECIAL ) ? 0 : -1 );
+
+    __m128i bad = _mm_setzero_si128();
+    size_t  pos = 0;
+    for(; pos + 16 <= size; pos += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)( data + pos ));
+
+        __m128i printable = SSE2_IN_RANGE(x, 0x20, 0x7E);
+        __m128i digit     = SSE2_IN_RANGE(x, '0', '9');
+        __m128i letter    = SSE2_IN_RANGE(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+        __m128i space     = _mm_cmpeq_epi8(x, _mm_set1_epi8(' '));
+        __m128i special   = _mm_andnot_si128(_mm_or_si128(_mm_or_si128(letter, digit), space), printable);
+
+        bad = _mm_or_si128(bad, _mm_andnot_si128(printable, _mm_set1_epi8(-1)));
+        bad = _mm_or_si128(bad, _mm_and_si128(letter , deny_letter ));
+        bad = _mm_or_si128(bad, _mm_and_si128(digit  , deny_digit  ));
+        bad = _mm_or_si128(bad, _mm_and_si128(special, deny_special));
+    }
+
+    if( _mm_movemask_epi8(bad) ) return false;
+    return check_text_scalar(data + pos, size - pos, rules);
+}
+//------------------------------------------------------------------------------
+static __attribute__((target("sse2")))
+bool check_track_sse2(const uint8_t *data, size_t size)
+{
+    __m128i bad = _mm_setzero_si128();
+    size_t  pos = 0;
+    for(; pos + 16 <= size; pos += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)( data + pos ));
+
+        __m128i good = SSE2_IN_RANGE(x, '0', '9');
+        good = _mm_or_si128(good, _mm_cmpeq_epi8(x, _mm_set1_epi8('=')));
+        good = _mm_or_si128(good, _mm_cmpeq_epi8(x, _mm_set1_epi8('D')));
+        good = _mm_or_si128(good, _mm_cmpeq_epi8(x, _mm_set1_epi8(';')));
+        good = _mm_or_si128(good, _mm_cmpeq_epi8(x, _mm_set1_epi8('?')));
+
+        bad = _mm_or_si128(bad, _mm_andnot_si128(good, _mm_set1_epi8(-1)));
+    }
+
+    if( _mm_movemask_epi8(bad) ) return false;
+    return check_track_scalar(data + pos, size - pos);
+}
+//------------------------------------------------------------------------------
+static __attribute__((target("sse2")))
+bool check_bcd_sse2(const uint8_t *data, size_t size)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i nine   = _mm_set1_epi8(9);
+
+    __m128i bad = _mm_setzero_si128();
+    size_t  pos = 0;
+    for(; pos + 16 <= size; pos += 16)
+    {
+        __m128i x  = _mm_loadu_si128((const __m128i*)( data + pos ));
+        __m128i lo = _mm_and_si128(x, nibble);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), nibble);
+
+        __m128i good = _mm_and_si128(_mm_cmpeq_epi8(_mm_min_epu8(lo, nine), lo),
+                                     _mm_cmpeq_epi8(_mm_min_epu8(hi, nine), hi));
+        bad = _mm_or_si128(bad, _mm_andnot_si128(good, _mm_set1_epi8(-1)));
+    }
+
+    if( _mm_movemask_epi8(bad) ) return false;
+    return check_bcd_scalar(data + pos, size - pos);
+}
+//------------------------------------------------------------------------------
+static __attribute__((target("avx2")))
+bool check_text_avx2(const uint8_t *data, size_t size, unsigned rules)
+{
+    const __m256i deny_letter  = _mm256_set1_epi8( ( rules & RULE_LETTER  ) ? 0 : -1 );
+    const __m256i deny_digit   = _mm256_set1_epi8( ( rules & RULE_DIGIT   ) ? 0 : -1 );
+    const __m256i deny_special = _mm256_set1_epi8( ( rules & RULE_SPECIAL ) ? 0 : -1 );
+
+    __m256i bad = _mm256_setzero_si256();
+    size_t  pos = 0;
+    for(; pos + 32 <= size; pos += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*)( data + pos ));
+
+        __m256i printable = AVX2_IN_RANGE(x, 0x20, 0x7E);
+        __m256i digit     = AVX2_IN_RANGE(x, '0', '9');
+        __m256i letter    = AVX2_IN_RANGE(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i space     = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' '));
+        __m256i special   = _mm256_andnot_si256(_mm256_or_si256(_mm256_or_si256(letter, digit), space), printable);
+
+        bad = _mm256_or_si256(bad, _mm256_andnot_si256(printable, _mm256_set1_epi8(-1)));
+        bad = _mm256_or_si256(bad, _mm256_and_si256(letter , deny_letter ));
+        bad = _mm256_or_si256(bad, _mm256_and_si256(digit  , deny_digit  ));
+        bad = _mm256_or_si256(bad, _mm256_and_si256(special, deny_special));
+    }
+
+    if( _mm256_movemask_epi8(bad) ) return false;
+    return check_text_sse2(data + pos, size - pos, rules);
+}
+//------------------------------------------------------------------------------
+static __attribute__((target("avx2")))
+bool check_track_avx2(const uint8_t *data, size_t size)
+{
+    __m256i bad = _mm256_setzero_si256();
+    size_t  pos = 0;
+    for(; pos + 32 <= size; pos += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*)( data + pos ));
+
+        __m256i good = AVX2_IN_RANGE(x, '0', '9');
+        good = _mm256_or_si256(good, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('=')));
+        good = _mm256_or_si256(good, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('D')));
+        good = _mm256_or_si256(good, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(';')));
+        good = _mm256_or_si256(good, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('?')));
+
+        bad = _mm256_or_si256(bad, _mm256_andnot_si256(good, _mm256_set1_epi8(-1)));
+    }
+
+    if( _mm256_movemask_epi8(bad) ) return false;
+    return check_track_sse2(data + pos, size - pos);
+}
+//------------------------------------------------------------------------------
+static __attribute__((target("avx2")))
+bool check_bcd_avx2(const uint8_t *data, size_t size)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i nine   = _mm256_set1_epi8(9);
+
+    __m256i bad = _mm256_setzero_si256();
+    size_t  pos = 0;
+    for(; pos + 32 <= size; pos += 32)
+    {
+        __m256i x  = _mm256_loadu_si256((const __m256i*)( data + pos ));
+        __m256i lo = _mm256_and_si256(x, nibble);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+
+        __m256i good = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(lo, nine), lo),
+                                        _mm256_cmpeq_epi8(_mm256_min_epu8(hi, nine), hi));
+        bad = _mm256_or_si256(bad, _mm256_andnot_si256(good, _mm256_set1_epi8(-1)));
+    }
+
+    if( _mm256_movemask_epi8(bad) ) return false;
+    return check_bcd_sse2(data + pos, size - pos);
+}
+//------------------------------------------------------------------------------
+#endif  // CHARSET_HAVE_X86
+//------------------------------------------------------------------------------
+charset_isa_t charset_get_best_isa(void)
+{
+    /*
+     * Get the best instruction set which is supported by the current CPU.
+     */
+#ifdef CHARSET_HAVE_X86
+    static int best = -1;
+
+    int isa = __atomic_load_n(&best, __ATOMIC_RELAXED);
+    if( isa < 0 )
+    {
+        __builtin_cpu_init();
+        isa = __builtin_cpu_supports("avx2") ? CHARSET_ISA_AVX2 :
+              __builtin_cpu_supports("sse2") ? CHARSET_ISA_SSE2 : CHARSET_ISA_SCALAR;
+        __atomic_store_n(&best, isa, __ATOMIC_RELAXED);
+    }
+
+    return isa;
+#else
+    return CHARSET_ISA_SCALAR;
+#endif
+}
+//------------------------------------------------------------------------------
+static
+bool check_text(const uint8_t *data, size_t size, unsigned rules, charset_isa_t isa)
+{
+#ifdef CHARSET_HAVE_X86
+    if( isa == CHARSET_ISA_AVX2 ) return check_text_avx2(data, size, rules);
+    if( isa == CHARSET_ISA_SSE2 ) return check_text_sse2(data, size, rules);
+#endif
+    return check_text_scalar(data, size, rules);
+}
+//------------------------------------------------------------------------------
+static
+bool check_track(const uint8_t *data, size_t size, charset_isa_t isa)
+{
+#ifdef CHARSET_HAVE_X86
+    if( isa == CHARSET_ISA_AVX2 ) return check_track_avx2(data, size);
+    if( isa == CHARSET_ISA_SSE2 ) return check_track_sse2(data, size);
+#endif
+    return check_track_scalar(data, size);
+}
+//------------------------------------------------------------------------------
+static
+bool check_bcd(const uint8_t *data, size_t size, charset_isa_t isa)
+{
+#ifdef CHARSET_HAVE_X86
+    if( isa == CHARSET_ISA_AVX2 ) return check_bcd_avx2(data, size);
+    if( isa == CHARSET_ISA_SSE2 ) return check_bcd_sse2(data, size);
+#endif
+    return check_bcd_scalar(data, size);
+}
+//------------------------------------------------------------------------------
+bool charset_validate_isa(const void *data, size_t size, finfo_eletype_t eletype, charset_isa_t isa)
+{
+    /*
+     * Check if the content of a field matches to its element type
+     * by the specified instruction set, which must be supported by the current CPU.
+     */
+    assert( data || !size );
+
+    const uint8_t *bytes = data;
+    unsigned       rules = 0;
+
+    switch( eletype_to_kind(eletype, &rules) )
+    {
+    case KIND_TEXT:
+        return check_text(bytes, size, rules, isa);
+
+    case KIND_TRACK:
+        return check_track(bytes, size, isa);
+
+    case KIND_BCD:
+        return check_bcd(bytes, size, isa);
+
+    case KIND_PAN:
+        // The last nibble may be a padding.
+        if( !size ) return true;
+        if( ( bytes[size-1] & 0x0F ) == 0x0F )
+            return check_bcd(bytes, size-1, isa) && ( bytes[size-1] >> 4 ) <= 9;
+        else
+            return check_bcd(bytes, size, isa);
+
+    default:
+        return true;
+    }
+}
+//------------------------------------------------------------------------------
+bool charset_validate(const void *data, size_t size, finfo_eletype_t eletype)
+{
+    /*
+     * Check if the content of a field matches to its element type
+     * by the best instruction set of the current CPU.
+     */
+    return charset_validate_isa(data, size, eletype, charset_get_best_isa());
+}
+//------------------------------------------------------------------------------
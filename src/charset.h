@@ -0,0 +1,31 @@
+/*
+ * Character class validation of field elements.
+ */
+#ifndef _ISO8583_CHARSET_H_
+#define _ISO8583_CHARSET_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "finfo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum charset_isa_t
+{
+    CHARSET_ISA_SCALAR,
+    CHARSET_ISA_SSE2,
+    CHARSET_ISA_AVX2,
+} charset_isa_t;
+
+charset_isa_t charset_get_best_isa(void);
+
+bool charset_validate    (const void *data, size_t size, finfo_eletype_t eletype);
+bool charset_validate_isa(const void *data, size_t size, finfo_eletype_t eletype, charset_isa_t isa);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
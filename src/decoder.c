@@ -0,0 +1,499 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if   defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "exchange.h"
+#include "decoder.h"
+#include "memory.h"
+
+#define RANGE_BITS 32
+#define RANGE_MASK 0xFFFFFFFFULL
+
+// Count of frames of a job in the unordered mode,
+// limited that batch indices of a job can fit to the range word.
+#define UNORDERED_JOB_FRAMES ( (size_t) RANGE_MASK * ISO8583_DECODER_BATCH )
+
+typedef struct worker_t
+{
+    char     pad0[ISO8583_DECODER_CACHELINE];
+    uint64_t range;  // Batches to be decoded, the begin index in high bits and the end index in low bits.
+    char     pad1[ISO8583_DECODER_CACHELINE];
+
+    iso8583_decoder_ctx_t *ctx;
+    unsigned               index;
+    pthread_t              thread;
+    iso8583_t              msg;  // Message to decode to in the unordered mode.
+} worker_t;
+
+typedef struct job_t
+{
+    size_t     first;     // Index of the first frame.
+    size_t     count;     // Count of frames.
+    iso8583_t *msgs;      // Output messages in the ordered mode; or NULL to deliver immediately.
+    int       *errcodes;  // Output error codes in the ordered mode.
+} job_t;
+
+struct iso8583_decoder_ctx_t
+{
+    const iso8583_allocator_t *allocator;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  job_posted;
+    pthread_cond_t  job_done;
+    unsigned        generation;
+    unsigned        active;
+    bool            stop;
+
+    int                   decode_flags;
+    const uint8_t        *data;
+    size_t               *offsets;  // Frame i is in range offsets[i] to offsets[i+1].
+    size_t                offcap;
+    iso8583_on_decoded_t  on_decoded;
+    void                 *userarg;
+    job_t                 job;
+
+    iso8583_t *winmsgs[2];  // Double buffered windows of the ordered mode.
+    int       *winerrs[2];
+
+    unsigned  nworkers;
+    worker_t *workers;
+};
+
+//------------------------------------------------------------------------------
+static
+unsigned get_cpu_count(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count : 1;
+#endif
+}
+//------------------------------------------------------------------------------
+static
+void decode_batch(iso8583_decoder_ctx_t *ctx, worker_t *worker, uint32_t batch)
+{
+    const job_t *job = &ctx->job;
+
+    size_t begin = job->first + (size_t) batch * ISO8583_DECODER_BATCH;
+    size_t end   = begin + ISO8583_DECODER_BATCH;
+    if( end > job->first + job->count ) end = job->first + job->count;
+
+    for(size_t i=begin; i<end; ++i)
+    {
+        const uint8_t *frame = ctx->data + ctx->offsets[i];
+        size_t         size  = ctx->offsets[i+1] - ctx->offsets[i];
+
+        if( job->msgs )
+        {
+            int readsz = iso8583_decode(&job->msgs[ i - job->first ], frame, size, ctx->decode_flags);
+            job->errcodes[ i - job->first ] = readsz < 0 ? readsz : ISO8583_ERR_SUCCESS;
+        }
+        else
+        {
+            int readsz = iso8583_decode(&worker->msg, frame, size, ctx->decode_flags);
+            ctx->on_decoded(ctx->userarg, i, &worker->msg, readsz < 0 ? readsz : ISO8583_ERR_SUCCESS);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+static
+bool take_own_batch(worker_t *worker, uint32_t *batch)
+{
+    uint64_t word = __atomic_load_n(&worker->range, __ATOMIC_ACQUIRE);
+    while( true )
+    {
+        uint32_t begin = word >> RANGE_BITS;
+        uint32_t end   = word &  RANGE_MASK;
+        if( begin >= end ) return false;
+
+        uint64_t newword = word + ( 1ULL << RANGE_BITS );
+        if( __atomic_compare_exchange_n(&worker->range, &word, newword, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) )
+        {
+            *batch = begin;
+            return true;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+static
+bool steal_batches(iso8583_decoder_ctx_t *ctx, worker_t *thief, uint32_t *batch)
+{
+    for(unsigned k=1; k<ctx->nworkers; ++k)
+    {
+        worker_t *victim = &ctx->workers[ ( thief->index + k ) % ctx->nworkers ];
+
+        uint64_t word = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+        while( true )
+        {
+            uint32_t begin = word >> RANGE_BITS;
+            uint32_t end   = word &  RANGE_MASK;
+            if( begin >= end ) break;
+
+            // Take the back half of the victim's range.
+            uint32_t mid     = end - ( end - begin + 1 ) / 2;
+            uint64_t newword = ( (uint64_t) begin << RANGE_BITS ) | mid;
+            if( __atomic_compare_exchange_n(&victim->range, &word, newword, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) )
+            {
+                // Keep the first stolen batch to work on,
+                // and publish the rest as our own range so that they can be stolen again.
+                uint64_t rest = ( (uint64_t)( mid + 1 ) << RANGE_BITS ) | end;
+                __atomic_store_n(&thief->range, rest, __ATOMIC_RELEASE);
+
+                *batch = mid;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+//------------------------------------------------------------------------------
+static
+void* worker_main(void *arg)
+{
+    worker_t              *worker = arg;
+    iso8583_decoder_ctx_t *ctx    = worker->ctx;
+
+    unsigned seen = 0;
+    while( true )
+    {
+        pthread_mutex_lock(&ctx->lock);
+        while( !ctx->stop && ctx->generation == seen )
+            pthread_cond_wait(&ctx->job_posted, &ctx->lock);
+        seen = ctx->generation;
+        bool stop = ctx->stop;
+        pthread_mutex_unlock(&ctx->lock);
+
+        if( stop ) break;
+
+        uint32_t batch;
+        while( take_own_batch(worker, &batch) || steal_batches(ctx, worker, &batch) )
+            decode_batch(ctx, worker, batch);
+
+        pthread_mutex_lock(&ctx->lock);
+        if( !--ctx->active ) pthread_cond_signal(&ctx->job_done);
+        pthread_mutex_unlock(&ctx->lock);
+    }
+
+    return NULL;
+}
+//------------------------------------------------------------------------------
+static
+void stop_workers(iso8583_decoder_ctx_t *ctx, unsigned nstarted)
+{
+    pthread_mutex_lock(&ctx->lock);
+    ctx->stop = true;
+    pthread_cond_broadcast(&ctx->job_posted);
+    pthread_mutex_unlock(&ctx->lock);
+
+    for(unsigned i=0; i<nstarted; ++i)
+        pthread_join(ctx->workers[i].thread, NULL);
+}
+//------------------------------------------------------------------------------
+static
+void free_context(iso8583_decoder_ctx_t *ctx)
+{
+    for(unsigned i=0; i<ctx->nworkers; ++i)
+        iso8583_deinit(&ctx->workers[i].msg);
+
+    for(int w=0; w<2; ++w)
+    {
+        if( !ctx->winmsgs[w] ) continue;
+
+        for(size_t i=0; i<ISO8583_DECODER_WINDOW; ++i)
+            iso8583_deinit(&ctx->winmsgs[w][i]);
+
+        mem_free(ctx->allocator, ctx->winmsgs[w]);
+        mem_free(ctx->allocator, ctx->winerrs[w]);
+    }
+
+    if( ctx->offsets ) mem_free(ctx->allocator, ctx->offsets);
+    mem_free(ctx->allocator, ctx->workers);
+
+    pthread_cond_destroy(&ctx->job_done);
+    pthread_cond_destroy(&ctx->job_posted);
+    pthread_mutex_destroy(&ctx->lock);
+
+    mem_free(ctx->allocator, ctx);
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_decoder_init(iso8583_decoder_t *obj, unsigned nthreads, int decode_flags, int flags)
+{
+    /**
+     * @memberof iso8583_decoder_t
+     * @brief Constructor.
+     *
+     * @param obj          Object instance.
+     * @param nthreads     Count of worker threads; or ZERO to use one thread for each CPU.
+     * @param decode_flags Decode options, see ::iso8583_flags_t for more information.
+     *                     The stream is framed by size headers,
+     *                     so ::ISO8583_FLAG_HAVE_SIZEHDR should normally be set.
+     * @param flags        Decoder options, see ::iso8583_decoder_flags_t for more information.
+     * @return An error code defined in ::iso8583_err_t.
+     */
+    assert( obj );
+
+    memset(obj, 0, sizeof(*obj));
+    obj->decode_flags = decode_flags;
+    obj->flags        = flags;
+
+    if( !nthreads ) nthreads = get_cpu_count();
+    if( nthreads > ISO8583_DECODER_MAXTHREADS ) return ISO8583_ERR_INVALID_ARG;
+
+    const iso8583_allocator_t *allocator = iso8583_allocator_get_default();
+
+    iso8583_decoder_ctx_t *ctx = mem_calloc(allocator, 1, sizeof(*ctx));
+    assert( ctx );
+
+    ctx->allocator = allocator;
+
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthread_cond_init(&ctx->job_posted, NULL);
+    pthread_cond_init(&ctx->job_done, NULL);
+    ctx->decode_flags = decode_flags;
+
+    ctx->nworkers = nthreads;
+    ctx->workers  = mem_calloc(ctx->allocator, nthreads, sizeof(ctx->workers[0]));
+    assert( ctx->workers );
+
+    for(unsigned i=0; i<nthreads; ++i)
+    {
+        ctx->workers[i].ctx   = ctx;
+        ctx->workers[i].index = i;
+        iso8583_init(&ctx->workers[i].msg);
+    }
+
+    if( flags & ISO8583_DECODER_ORDERED )
+    {
+        for(int w=0; w<2; ++w)
+        {
+            ctx->winmsgs[w] = mem_alloc(ctx->allocator, ISO8583_DECODER_WINDOW * sizeof(ctx->winmsgs[w][0]));
+            ctx->winerrs[w] = mem_alloc(ctx->allocator, ISO8583_DECODER_WINDOW * sizeof(ctx->winerrs[w][0]));
+            assert( ctx->winmsgs[w] && ctx->winerrs[w] );
+
+            for(size_t i=0; i<ISO8583_DECODER_WINDOW; ++i)
+                iso8583_init(&ctx->winmsgs[w][i]);
+        }
+    }
+
+    for(unsigned i=0; i<nthreads; ++i)
+    {
+        if( pthread_create(&ctx->workers[i].thread, NULL, worker_main, &ctx->workers[i]) )
+        {
+            stop_workers(ctx, i);
+            free_context(ctx);
+            return ISO8583_ERR_GENERAL;
+        }
+    }
+
+    obj->ctx = ctx;
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_decoder_deinit(iso8583_decoder_t *obj)
+{
+    /**
+     * @memberof iso8583_decoder_t
+     * @brief Destructor.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    if( !obj->ctx ) return;
+
+    stop_workers(obj->ctx, obj->ctx->nworkers);
+    free_context(obj->ctx);
+    obj->ctx = NULL;
+}
+//------------------------------------------------------------------------------
+static
+void push_offset(iso8583_decoder_ctx_t *ctx, size_t count, size_t offset)
+{
+    if( count >= ctx->offcap )
+    {
+        ctx->offcap  = ctx->offcap ? 2 * ctx->offcap : 4096;
+        ctx->offsets = mem_realloc(ctx->allocator, ctx->offsets, ctx->offcap * sizeof(ctx->offsets[0]));
+        assert( ctx->offsets );
+    }
+
+    ctx->offsets[count] = offset;
+}
+//------------------------------------------------------------------------------
+static
+int scan_frames(iso8583_decoder_ctx_t *ctx, const uint8_t *data, size_t size, size_t *count)
+{
+    int    errcode = ISO8583_ERR_SUCCESS;
+    size_t pos     = 0;
+
+    *count = 0;
+    while( pos < size )
+    {
+        int framesz = iso8583_exg_peek_frame(data + pos, size - pos);
+        if( framesz <= 0 || size - pos < framesz )
+        {
+            // The last frame is truncated, it will not be decoded.
+            errcode = ISO8583_ERR_BUF_NOT_ENOUGH;
+            break;
+        }
+
+        push_offset(ctx, (*count)++, pos);
+        pos += framesz;
+    }
+
+    push_offset(ctx, *count, pos);
+    return errcode;
+}
+//------------------------------------------------------------------------------
+static
+void post_job(iso8583_decoder_ctx_t *ctx, size_t first, size_t count, iso8583_t *msgs, int *errcodes)
+{
+    ctx->job.first    = first;
+    ctx->job.count    = count;
+    ctx->job.msgs     = msgs;
+    ctx->job.errcodes = errcodes;
+
+    // Split batches to workers evenly, the unbalanced part will be fixed by stealing.
+    uint64_t nbatches = ( count + ISO8583_DECODER_BATCH - 1 ) / ISO8583_DECODER_BATCH;
+    for(unsigned i=0; i<ctx->nworkers; ++i)
+    {
+        uint64_t begin = nbatches *  i      / ctx->nworkers;
+        uint64_t end   = nbatches * ( i+1 ) / ctx->nworkers;
+        __atomic_store_n(&ctx->workers[i].range, ( begin << RANGE_BITS ) | end, __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->active = ctx->nworkers;
+    ++ ctx->generation;
+    pthread_cond_broadcast(&ctx->job_posted);
+    pthread_mutex_unlock(&ctx->lock);
+}
+//------------------------------------------------------------------------------
+static
+void wait_job(iso8583_decoder_ctx_t *ctx)
+{
+    pthread_mutex_lock(&ctx->lock);
+    while( ctx->active )
+        pthread_cond_wait(&ctx->job_done, &ctx->lock);
+    pthread_mutex_unlock(&ctx->lock);
+}
+//------------------------------------------------------------------------------
+static
+void run_unordered(iso8583_decoder_ctx_t *ctx, size_t count)
+{
+    for(size_t first=0; first<count; first+=UNORDERED_JOB_FRAMES)
+    {
+        size_t jobsz = count - first;
+        if( jobsz > UNORDERED_JOB_FRAMES ) jobsz = UNORDERED_JOB_FRAMES;
+
+        post_job(ctx, first, jobsz, NULL, NULL);
+        wait_job(ctx);
+    }
+}
+//------------------------------------------------------------------------------
+static
+void run_ordered(iso8583_decoder_ctx_t *ctx, size_t count)
+{
+    size_t nwindows = ( count + ISO8583_DECODER_WINDOW - 1 ) / ISO8583_DECODER_WINDOW;
+    if( !nwindows ) return;
+
+    post_job(ctx, 0, count < ISO8583_DECODER_WINDOW ? count : ISO8583_DECODER_WINDOW, ctx->winmsgs[0], ctx->winerrs[0]);
+    wait_job(ctx);
+
+    for(size_t w=0; w<nwindows; ++w)
+    {
+        // Decode the next window while this one is being delivered.
+        bool has_next = w + 1 < nwindows;
+        if( has_next )
+        {
+            size_t first = ( w + 1 ) * ISO8583_DECODER_WINDOW;
+            size_t jobsz = count - first;
+            if( jobsz > ISO8583_DECODER_WINDOW ) jobsz = ISO8583_DECODER_WINDOW;
+
+            int slot = ( w + 1 ) & 1;
+            post_job(ctx, first, jobsz, ctx->winmsgs[slot], ctx->winerrs[slot]);
+        }
+
+        size_t     first = w * ISO8583_DECODER_WINDOW;
+        size_t     last  = has_next ? first + ISO8583_DECODER_WINDOW : count;
+        iso8583_t *msgs  = ctx->winmsgs[ w & 1 ];
+        int       *errs  = ctx->winerrs[ w & 1 ];
+        for(size_t i=first; i<last; ++i)
+            ctx->on_decoded(ctx->userarg, i, &msgs[ i - first ], errs[ i - first ]);
+
+        if( has_next ) wait_job(ctx);
+    }
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_decoder_run(iso8583_decoder_t    *obj,
+                                     const void           *data,
+                                     size_t                size,
+                                     iso8583_on_decoded_t  on_decoded,
+                                     void                 *userarg)
+{
+    /**
+     * @memberof iso8583_decoder_t
+     * @brief Decode all frames of a stream.
+     *
+     * @param obj        Object instance.
+     * @param data       The stream data, it should begin with the size header of a frame.
+     * @param size       Size of the stream data.
+     * @param on_decoded A function to receive decoded messages.
+     * @param userarg    A user defined argument which will be passed to @a on_decoded.
+     * @retval ISO8583_ERR_SUCCESS        All frames are delivered.
+     * @retval ISO8583_ERR_BUF_NOT_ENOUGH The stream ends with an incomplete frame,
+     *                                    all complete frames before it are still delivered.
+     * @retval Negative Other error codes defined in ::iso8583_err_t.
+     *
+     * @remarks Decode errors of each frame are passed to @a on_decoded,
+     *          and will not stop the process.
+     * @remarks The function returns after all messages are delivered,
+     *          and it should not be called by multiple threads concurrently.
+     */
+    assert( obj );
+
+    iso8583_decoder_ctx_t *ctx = obj->ctx;
+    if( !ctx ) return ISO8583_ERR_GENERAL;
+    if( !data || !on_decoded ) return ISO8583_ERR_INVALID_ARG;
+
+    size_t count;
+    int errcode = scan_frames(ctx, data, size, &count);
+
+    ctx->data       = data;
+    ctx->on_decoded = on_decoded;
+    ctx->userarg    = userarg;
+
+    if( obj->flags & ISO8583_DECODER_ORDERED )
+        run_ordered(ctx, count);
+    else
+        run_unordered(ctx, count);
+
+    return errcode;
+}
+//------------------------------------------------------------------------------
+unsigned ISO8583_CALL iso8583_decoder_get_threads(const iso8583_decoder_t *obj)
+{
+    /**
+     * @memberof iso8583_decoder_t
+     * @brief Get count of worker threads.
+     *
+     * @param obj Object instance.
+     * @return Count of worker threads; or ZERO if the object failed to be initialised.
+     */
+    assert( obj );
+    return obj->ctx ? obj->ctx->nworkers : 0;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,119 @@
+#include <assert.h>
+#include <string.h>
+#include "memory.h"
+#include "dispatch.h"
+
+#define DIGIT_MASKS ( ISO8583_MTI_CLA_MASK | ISO8583_MTI_FUN_MASK | ISO8583_MTI_ORI_MASK )
+
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_dispatcher_init(iso8583_dispatcher_t *obj)
+{
+    /**
+     * @memberof iso8583_dispatcher_t
+     * @brief Constructor.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    obj->allocator = iso8583_allocator_get_default();
+
+    obj->slots = mem_calloc(obj->allocator, ISO8583_DISPATCH_SLOTS, sizeof(obj->slots[0]));
+    assert( obj->slots );
+
+    obj->ranks = mem_alloc(obj->allocator, ISO8583_DISPATCH_SLOTS * sizeof(obj->ranks[0]));
+    assert( obj->ranks );
+    memset(obj->ranks, -1, ISO8583_DISPATCH_SLOTS * sizeof(obj->ranks[0]));
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_dispatcher_deinit(iso8583_dispatcher_t *obj)
+{
+    /**
+     * @memberof iso8583_dispatcher_t
+     * @brief Destructor.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    mem_free(obj->allocator, obj->slots);
+    mem_free(obj->allocator, obj->ranks);
+    obj->slots = NULL;
+    obj->ranks = NULL;
+}
+//------------------------------------------------------------------------------
+static
+int count_digits(int mask)
+{
+    // Count of MTI digits (excluding the version) selected by a mask.
+    return !!( mask & ISO8583_MTI_CLA_MASK ) +
+           !!( mask & ISO8583_MTI_FUN_MASK ) +
+           !!( mask & ISO8583_MTI_ORI_MASK );
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_dispatcher_set(iso8583_dispatcher_t *obj,
+                                        int                   mti,
+                                        int                   anymask,
+                                        iso8583_handler_t     handler,
+                                        void                 *userarg)
+{
+    /**
+     * @memberof iso8583_dispatcher_t
+     * @brief Register a handler for a MTI pattern.
+     *
+     * @param obj     Object instance.
+     * @param mti     The MTI, the version digit is ignored.
+     * @param anymask Digits which match any value, a combination of
+     *                ::ISO8583_MTI_CLA_MASK, ::ISO8583_MTI_FUN_MASK, and ::ISO8583_MTI_ORI_MASK;
+     *                or ZERO to match the exact MTI.
+     * @param handler The handler; or NULL to leave the matched messages unhandled.
+     * @param userarg A user defined argument passed to the handler.
+     * @return An error code defined in ::iso8583_err_t.
+     *
+     * @remarks A message is delivered to the handler of the most specific pattern it matches
+     *          (the one with fewest wildcard digits), no matter the order they are registered;
+     *          and a pattern registered again replaces the handler.
+     *          Patterns of the same specificity which overlap, such as 0x020F and 0x02F0,
+     *          take the slots they share by the last registered.
+     */
+    assert( obj );
+
+    if( anymask & ~DIGIT_MASKS ) return ISO8583_ERR_INVALID_ARG;
+
+    int rank  = 3 - count_digits(anymask);
+    int fixed = ~anymask & DIGIT_MASKS;
+
+    for(int index=0; index<ISO8583_DISPATCH_SLOTS; ++index)
+    {
+        if( ( index ^ mti ) & fixed ) continue;
+        if( obj->ranks[index] > rank ) continue;
+
+        obj->slots[index].handler = handler;
+        obj->slots[index].userarg = userarg;
+        obj->ranks[index]         = rank;
+    }
+
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_dispatcher_set_default(iso8583_dispatcher_t *obj, iso8583_handler_t handler, void *userarg)
+{
+    /**
+     * @memberof iso8583_dispatcher_t
+     * @brief Register the handler for messages which no pattern matches.
+     *
+     * @param obj     Object instance.
+     * @param handler The handler; or NULL to leave the messages unhandled.
+     * @param userarg A user defined argument passed to the handler.
+     */
+    assert( obj );
+
+    for(int index=0; index<ISO8583_DISPATCH_SLOTS; ++index)
+    {
+        if( obj->ranks[index] >= 0 ) continue;
+
+        obj->slots[index].handler = handler;
+        obj->slots[index].userarg = userarg;
+    }
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,204 @@
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include "ebcdic.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define EBCDIC_HAVE_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Characters are converted by 256 bytes lookup tables of code page 037,
+ * which map all byte values one to one, so that any data can be converted back.
+ *
+ * The vector kernels look up a table as 16 rows of 16 bytes by byte shuffles:
+ * for row H, each byte X is shifted to X-16*H, which is a valid shuffle index
+ * (the low nibble of X) only if the high nibble of X is H,
+ * otherwise it is saturated to have the high bit set and the shuffle gives zero.
+ * The results of all rows are combined by bit or.
+ * It takes 16 shuffles for each vector, and so only the 32 bytes vectors of AVX2
+ * are faster than the table lookup of each byte.
+ */
+
+static const uint8_t table_to_ebcdic[256] =
+{
+    0x00,0x01,0x02,0x03,0x37,0x2D,0x2E,0x2F,0x16,0x05,0x25,0x0B,0x0C,0x0D,0x0E,0x0F,
+    0x10,0x11,0x12,0x13,0x3C,0x3D,0x32,0x26,0x18,0x19,0x3F,0x27,0x1C,0x1D,0x1E,0x1F,
+    0x40,0x5A,0x7F,0x7B,0x5B,0x6C,0x50,0x7D,0x4D,0x5D,0x5C,0x4E,0x6B,0x60,0x4B,0x61,
+    0xF0,0xF1,0xF2,0xF3,0xF4,0xF5,0xF6,0xF7,0xF8,0xF9,0x7A,0x5E,0x4C,0x7E,0x6E,0x6F,
+    0x7C,0xC1,0xC2,0xC3,0xC4,0xC5,0xC6,0xC7,0xC8,0xC9,0xD1,0xD2,0xD3,0xD4,0xD5,0xD6,
+    0xD7,0xD8,0xD9,0xE2,0xE3,0xE4,0xE5,0xE6,0xE7,0xE8,0xE9,0xBA,0xE0,0xBB,0xB0,0x6D,
+    0x79,0x81,0x82,0x83,0x84,0x85,0x86,0x87,0x88,0x89,0x91,0x92,0x93,0x94,0x95,0x96,
+    0x97,0x98,0x99,0xA2,0xA3,0xA4,0xA5,0xA6,0xA7,0xA8,0xA9,0xC0,0x4F,0xD0,0xA1,0x07,
+    0x20,0x21,0x22,0x23,0x24,0x15,0x06,0x17,0x28,0x29,0x2A,0x2B,0x2C,0x09,0x0A,0x1B,
+    0x30,0x31,0x1A,0x33,0x34,0x35,0x36,0x08,0x38,0x39,0x3A,0x3B,0x04,0x14,0x3E,0xFF,
+    0x41,0xAA,0x4A,0xB1,0x9F,0xB2,0x6A,0xB5,0xBD,0xB4,0x9A,0x8A,0x5F,0xCA,0xAF,0xBC,
+    0x90,0x8F,0xEA,0xFA,0xBE,0xA0,0xB6,0xB3,0x9D,0xDA,0x9B,0x8B,0xB7,0xB8,0xB9,0xAB,
+    0x64,0x65,0x62,0x66,0x63,0x67,0x9E,0x68,0x74,0x71,0x72,0x73,0x78,0x75,0x76,0x77,
+    0xAC,0x69,0xED,0xEE,0xEB,0xEF,0xEC,0xBF,0x80,0xFD,0xFE,0xFB,0xFC,0xAD,0xAE,0x59,
+    0x44,0x45,0x42,0x46,0x43,0x47,0x9C,0x48,0x54,0x51,0x52,0x53,0x58,0x55,0x56,0x57,
+    0x8C,0x49,0xCD,0xCE,0xCB,0xCF,0xCC,0xE1,0x70,0xDD,0xDE,0xDB,0xDC,0x8D,0x8E,0xDF,
+};
+
+static const uint8_t table_to_ascii[256] =
+{
+    0x00,0x01,0x02,0x03,0x9C,0x09,0x86,0x7F,0x97,0x8D,0x8E,0x0B,0x0C,0x0D,0x0E,0x0F,
+    0x10,0x11,0x12,0x13,0x9D,0x85,0x08,0x87,0x18,0x19,0x92,0x8F,0x1C,0x1D,0x1E,0x1F,
+    0x80,0x81,0x82,0x83,0x84,0x0A,0x17,0x1B,0x88,0x89,0x8A,0x8B,0x8C,0x05,0x06,0x07,
+    0x90,0x91,0x16,0x93,0x94,0x95,0x96,0x04,0x98,0x99,0x9A,0x9B,0x14,0x15,0x9E,0x1A,
+    0x20,0xA0,0xE2,0xE4,0xE0,0xE1,0xE3,0xE5,0xE7,0xF1,0xA2,0x2E,0x3C,0x28,0x2B,0x7C,
+    0x26,0xE9,0xEA,0xEB,0xE8,0xED,0xEE,0xEF,0xEC,0xDF,0x21,0x24,0x2A,0x29,0x3B,0xAC,
+    0x2D,0x2F,0xC2,0xC4,0xC0,0xC1,0xC3,0xC5,0xC7,0xD1,0xA6,0x2C,0x25,0x5F,0x3E,0x3F,
+    0xF8,0xC9,0xCA,0xCB,0xC8,0xCD,0xCE,0xCF,0xCC,0x60,0x3A,0x23,0x40,0x27,0x3D,0x22,
+    0xD8,0x61,0x62,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0xAB,0xBB,0xF0,0xFD,0xFE,0xB1,
+    0xB0,0x6A,0x6B,0x6C,0x6D,0x6E,0x6F,0x70,0x71,0x72,0xAA,0xBA,0xE6,0xB8,0xC6,0xA4,
+    0xB5,0x7E,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7A,0xA1,0xBF,0xD0,0xDD,0xDE,0xAE,
+    0x5E,0xA3,0xA5,0xB7,0xA9,0xA7,0xB6,0xBC,0xBD,0xBE,0x5B,0x5D,0xAF,0xA8,0xB4,0xD7,
+    0x7B,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0xAD,0xF4,0xF6,0xF2,0xF3,0xF5,
+    0x7D,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F,0x50,0x51,0x52,0xB9,0xFB,0xFC,0xF9,0xFA,0xFF,
+    0x5C,0xF7,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0xB2,0xD4,0xD6,0xD2,0xD3,0xD5,
+    0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0xB3,0xDB,0xDC,0xD9,0xDA,0x9F,
+};
+
+//------------------------------------------------------------------------------
+static
+void convert_scalar(uint8_t *dst, const uint8_t *src, size_t size, const uint8_t table[256])
+{
+    // Eight bytes are loaded and stored at once,
+    // so that the stores do not stall the following loads which may be of the same buffer.
+    size_t pos = 0;
+    for(; pos + 8 <= size; pos += 8)
+    {
+        uint8_t bytes[8];
+        memcpy(bytes, src + pos, 8);
+        for(int i=0; i<8; ++i)
+            bytes[i] = table[ bytes[i] ];
+        memcpy(dst + pos, bytes, 8);
+    }
+
+    for(; pos<size; ++pos)
+        dst[pos] = table[ src[pos] ];
+}
+//------------------------------------------------------------------------------
+#ifdef EBCDIC_HAVE_X86
+//------------------------------------------------------------------------------
+static __attribute__((target("avx2")))
+void convert_avx2(uint8_t *dst, const uint8_t *src, size_t size, const uint8_t table[256])
+{
+    const __m256i bias = _mm256_set1_epi8(0x70);
+    const __m256i step = _mm256_set1_epi8(0x10);
+
+    // Two blocks in each pass over the rows, so that each row is loaded once for 64 bytes.
+    size_t pos = 0;
+    for(; pos + 64 <= size; pos += 64)
+    {
+        __m256i x0   = _mm256_loadu_si256((const __m256i*)( src + pos ));
+        __m256i x1   = _mm256_loadu_si256((const __m256i*)( src + pos + 32 ));
+        __m256i res0 = _mm256_setzero_si256();
+        __m256i res1 = _mm256_setzero_si256();
+        for(int row=0; row<16; ++row)
+        {
+            __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)( table + 16*row )));
+            res0 = _mm256_or_si256(res0, _mm256_shuffle_epi8(lut, _mm256_adds_epu8(x0, bias)));
+            res1 = _mm256_or_si256(res1, _mm256_shuffle_epi8(lut, _mm256_adds_epu8(x1, bias)));
+            x0   = _mm256_sub_epi8(x0, step);
+            x1   = _mm256_sub_epi8(x1, step);
+        }
+        _mm256_storeu_si256((__m256i*)( dst + pos      ), res0);
+        _mm256_storeu_si256((__m256i*)( dst + pos + 32 ), res1);
+    }
+    for(; pos + 32 <= size; pos += 32)
+    {
+        __m256i x   = _mm256_loadu_si256((const __m256i*)( src + pos ));
+        __m256i res = _mm256_setzero_si256();
+        for(int row=0; row<16; ++row)
+        {
+            __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)( table + 16*row )));
+            res = _mm256_or_si256(res, _mm256_shuffle_epi8(lut, _mm256_adds_epu8(x, bias)));
+            x   = _mm256_sub_epi8(x, step);
+        }
+        _mm256_storeu_si256((__m256i*)( dst + pos ), res);
+    }
+
+    convert_scalar(dst + pos, src + pos, size - pos, table);
+}
+//------------------------------------------------------------------------------
+#endif  // EBCDIC_HAVE_X86
+//------------------------------------------------------------------------------
+ebcdic_isa_t ebcdic_get_best_isa(void)
+{
+    /*
+     * Get the best instruction set which is supported by the current CPU.
+     */
+#ifdef EBCDIC_HAVE_X86
+    static int best = -1;
+
+    int isa = __atomic_load_n(&best, __ATOMIC_RELAXED);
+    if( isa < 0 )
+    {
+        __builtin_cpu_init();
+        isa = __builtin_cpu_supports("avx2") ? EBCDIC_ISA_AVX2 : EBCDIC_ISA_SCALAR;
+        __atomic_store_n(&best, isa, __ATOMIC_RELAXED);
+    }
+
+    return isa;
+#else
+    return EBCDIC_ISA_SCALAR;
+#endif
+}
+//------------------------------------------------------------------------------
+static
+void convert(void *dst, const void *src, size_t size, const uint8_t table[256], ebcdic_isa_t isa)
+{
+#ifdef EBCDIC_HAVE_X86
+    if( isa == EBCDIC_ISA_AVX2 )
+    {
+        convert_avx2(dst, src, size, table);
+        return;
+    }
+#endif
+    convert_scalar(dst, src, size, table);
+}
+//------------------------------------------------------------------------------
+bool ebcdic_is_char_type(finfo_eletype_t eletype)
+{
+    /*
+     * Check if elements of the type are characters (text and track 2 data),
+     * which are to be transcoded; numeric and binary elements are not.
+     */
+    return eletype & ( FINFO_ELE_A | FINFO_ELE_S | FINFO_ELE_Z );
+}
+//------------------------------------------------------------------------------
+void ebcdic_from_ascii_isa(void *dst, const void *src, size_t size, ebcdic_isa_t isa)
+{
+    /*
+     * Convert ASCII characters to EBCDIC
+     * by the specified instruction set, which must be supported by the current CPU.
+     * The output may be the same buffer as the input.
+     */
+    assert( ( dst && src ) || !size );
+    convert(dst, src, size, table_to_ebcdic, isa);
+}
+//------------------------------------------------------------------------------
+void ebcdic_to_ascii_isa(void *dst, const void *src, size_t size, ebcdic_isa_t isa)
+{
+    /*
+     * Convert EBCDIC characters to ASCII
+     * by the specified instruction set, which must be supported by the current CPU.
+     * The output may be the same buffer as the input.
+     */
+    assert( ( dst && src ) || !size );
+    convert(dst, src, size, table_to_ascii, isa);
+}
+//------------------------------------------------------------------------------
+void ebcdic_from_ascii(void *dst, const void *src, size_t size)
+{
+    ebcdic_from_ascii_isa(dst, src, size, ebcdic_get_best_isa());
+}
+//------------------------------------------------------------------------------
+void ebcdic_to_ascii(void *dst, const void *src, size_t size)
+{
+    ebcdic_to_ascii_isa(dst, src, size, ebcdic_get_best_isa());
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,35 @@
+/*
+ * EBCDIC (code page 037) transcoding of character fields.
+ */
+#ifndef _ISO8583_EBCDIC_H_
+#define _ISO8583_EBCDIC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "finfo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum ebcdic_isa_t
+{
+    EBCDIC_ISA_SCALAR,
+    EBCDIC_ISA_AVX2,
+} ebcdic_isa_t;
+
+ebcdic_isa_t ebcdic_get_best_isa(void);
+
+bool ebcdic_is_char_type(finfo_eletype_t eletype);
+
+void ebcdic_from_ascii(void *dst, const void *src, size_t size);
+void ebcdic_to_ascii  (void *dst, const void *src, size_t size);
+
+void ebcdic_from_ascii_isa(void *dst, const void *src, size_t size, ebcdic_isa_t isa);
+void ebcdic_to_ascii_isa  (void *dst, const void *src, size_t size, ebcdic_isa_t isa);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
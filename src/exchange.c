@@ -1,9 +1,115 @@
 #include <assert.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <gen/systime.h>
 #include <gen/timectr.h>
+#include "monoclock.h"
 #include "exchange.h"
 
+static const char *stage_names[ISO8583_EXG_STAGE_COUNT] =
+{
+    "encode",
+    "send",
+    "wait",
+    "decode",
+};
+
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_exg_stats_init(iso8583_exg_stats_t *obj)
+{
+    /**
+     * @memberof iso8583_exg_stats_t
+     * @brief Constructor.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    for(int i=0; i<ISO8583_EXG_STAGE_COUNT; ++i)
+        iso8583_histogram_init(&obj->stages[i]);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_exg_stats_reset(iso8583_exg_stats_t *obj)
+{
+    /**
+     * @memberof iso8583_exg_stats_t
+     * @brief Clear all recorded latencies.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    for(int i=0; i<ISO8583_EXG_STAGE_COUNT; ++i)
+        iso8583_histogram_reset(&obj->stages[i]);
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_exg_stats_snapshot(const iso8583_exg_stats_t *obj, int stage, iso8583_histogram_t *snapshot)
+{
+    /**
+     * @memberof iso8583_exg_stats_t
+     * @brief Get a copy of latencies of a stage.
+     *
+     * @param obj      Object instance.
+     * @param stage    The stage, see ::iso8583_exg_stage_t for more information.
+     * @param snapshot The histogram to receive the copy.
+     * @return An error code defined in ::iso8583_err_t.
+     *
+     * @remarks It is safe to call this function while the exchange objects are working.
+     */
+    assert( obj );
+
+    if( stage < 0 || ISO8583_EXG_STAGE_COUNT <= stage ) return ISO8583_ERR_INVALID_ARG;
+    if( !snapshot ) return ISO8583_ERR_INVALID_ARG;
+
+    iso8583_histogram_snapshot(snapshot, &obj->stages[stage]);
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_exg_stats_export(const iso8583_exg_stats_t *obj, char *buf, size_t size)
+{
+    /**
+     * @memberof iso8583_exg_stats_t
+     * @brief Export a text report of all stages.
+     * @details Each stage takes a line in the format of: @n
+     *          "<stage> count=<n> min=<ns> p50=<ns> p99=<ns> p999=<ns> max=<ns> mean=<ns>"
+     *
+     * @param obj  Object instance.
+     * @param buf  The output buffer.
+     * @param size Size of the output buffer.
+     *
+     * @retval Positive Length of the report, not including the null terminator.
+     * @retval Negative An error code indicates that an error occurred during the process,
+     *         see ::iso8583_err_t for more information.
+     */
+    assert( obj );
+
+    if( !buf || !size ) return ISO8583_ERR_INVALID_ARG;
+
+    size_t len = 0;
+    for(int i=0; i<ISO8583_EXG_STAGE_COUNT; ++i)
+    {
+        iso8583_histogram_t snapshot;
+        iso8583_histogram_snapshot(&snapshot, &obj->stages[i]);
+
+        int linelen = snprintf(buf + len,
+                               size - len,
+                               "%s count=%llu min=%llu p50=%llu p99=%llu p999=%llu max=%llu mean=%.0f\n",
+                               stage_names[i],
+                               (unsigned long long) iso8583_histogram_get_count(&snapshot),
+                               (unsigned long long) iso8583_histogram_get_min(&snapshot),
+                               (unsigned long long) iso8583_histogram_get_percentile(&snapshot, 50),
+                               (unsigned long long) iso8583_histogram_get_percentile(&snapshot, 99),
+                               (unsigned long long) iso8583_histogram_get_percentile(&snapshot, 99.9),
+                               (unsigned long long) iso8583_histogram_get_max(&snapshot),
+                               iso8583_histogram_get_mean(&snapshot));
+        if( linelen < 0 || size - len <= linelen ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+
+        len += linelen;
+    }
+
+    return len;
+}
+
 //------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_exg_init(iso8583_exg_t *cfg, int                encode_flags,
                                                        void              *userarg,
@@ -31,6 +137,40 @@ void ISO8583_CALL iso8583_exg_init(iso8583_exg_t *cfg, int                encode
     cfg->userarg      = userarg;
     cfg->on_send      = on_send;
     cfg->on_recv      = on_recv;
+    cfg->stats        = NULL;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_exg_set_stats(iso8583_exg_t *cfg, iso8583_exg_stats_t *stats)
+{
+    /**
+     * @memberof iso8583_exg_t
+     * @brief Attach a latency statistics object.
+     *
+     * @param cfg   Object instance.
+     * @param stats The statistics object which latencies of each stage will be recorded to,
+     *              it must outlive the exchange object; or NULL to stop recording.
+     *
+     * @remarks The clock will not be read when there is no statistics object attached.
+     */
+    assert( cfg );
+    cfg->stats = stats;
+}
+//------------------------------------------------------------------------------
+static
+uint64_t stage_begin(const iso8583_exg_t *cfg)
+{
+    return cfg->stats ? monoclock_ns() : 0;
+}
+//------------------------------------------------------------------------------
+static
+uint64_t stage_end(const iso8583_exg_t *cfg, int stage, uint64_t begin)
+{
+    // Record the elapsed time of a stage, and return the time as the beginning of the next stage.
+    if( !cfg->stats ) return 0;
+
+    uint64_t now = monoclock_ns();
+    iso8583_histogram_record(&cfg->stats->stages[stage], now - begin);
+    return now;
 }
 //------------------------------------------------------------------------------
 static
@@ -96,13 +236,21 @@ int ISO8583_CALL iso8583_exg_send(const iso8583_exg_t *cfg, const iso8583_t *msg
 
     if( !cfg->on_send || !msg ) return ISO8583_ERR_INVALID_ARG;
 
+    uint64_t time = stage_begin(cfg);
+
     uint8_t buf[ISO8583_EXG_BUFSIZE];
     int size = iso8583_encode(msg, buf, sizeof(buf), cfg->encode_flags);
     if( size < 0 ) return size;
 
+    time = stage_end(cfg, ISO8583_EXG_STAGE_ENCODE, time);
+
     timectr_t timer;
     timectr_init(&timer, timeout);
-    return send_bin(cfg, &timer, buf, size);
+    int errcode = send_bin(cfg, &timer, buf, size);
+    if( errcode ) return errcode;
+
+    stage_end(cfg, ISO8583_EXG_STAGE_SEND, time);
+    return ISO8583_ERR_SUCCESS;
 }
 //------------------------------------------------------------------------------
 int ISO8583_CALL iso8583_exg_recv(const iso8583_exg_t *cfg, iso8583_t *msg, unsigned timeout)
@@ -115,11 +263,16 @@ int ISO8583_CALL iso8583_exg_recv(const iso8583_exg_t *cfg, iso8583_t *msg, unsi
      * @param msg     The received message.
      * @param timeout Time out in milliseconds to receive message.
      * @return One of the result codes defined in ::iso8583_err_t.
+     *
+     * @remarks Messages larger than ::ISO8583_EXG_BUFSIZE cannot be received by this function,
+     *          use ::iso8583_exg_recv_frame with a user provided buffer in that case.
      */
     assert( cfg );
 
     if( !cfg->on_recv || !msg ) return ISO8583_ERR_INVALID_ARG;
 
+    uint64_t time = stage_begin(cfg);
+
     timectr_t timer;
     timectr_init(&timer, timeout);
 
@@ -127,21 +280,88 @@ int ISO8583_CALL iso8583_exg_recv(const iso8583_exg_t *cfg, iso8583_t *msg, unsi
     int errcode;
 
     // Receive size header.
-    static const size_t header_size = 2;
-    if(( errcode = recv_bin(cfg, &timer, buf, header_size) )) return errcode;
+    if(( errcode = recv_bin(cfg, &timer, buf, ISO8583_EXG_SIZEHDR) )) return errcode;
 
     // Calculate size.
-    size_t payload_size = ( buf[0] << 8 ) | buf[1];
-    size_t packet_size = header_size + payload_size;
+    int packet_size = iso8583_exg_peek_frame(buf, ISO8583_EXG_SIZEHDR);
+    if( packet_size < 0 ) return packet_size;
     if( packet_size > ISO8583_EXG_BUFSIZE ) return ISO8583_ERR_BUF_NOT_ENOUGH;
 
     // Receive the rest data.
-    if(( errcode = recv_bin(cfg, &timer, buf+header_size, payload_size) )) return errcode;
+    size_t payload_size = packet_size - ISO8583_EXG_SIZEHDR;
+    if(( errcode = recv_bin(cfg, &timer, buf+ISO8583_EXG_SIZEHDR, payload_size) )) return errcode;
+
+    stage_end(cfg, ISO8583_EXG_STAGE_WAIT, time);
 
     // Decode message.
-    int readsz = iso8583_decode(msg, buf, packet_size, cfg->encode_flags);
+    int readsz = iso8583_exg_recv_frame(cfg, msg, buf, packet_size);
     if( readsz < 0 ) return readsz;
 
     return ISO8583_ERR_SUCCESS;
 }
 //------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_exg_peek_frame(const void *data, size_t size)
+{
+    /**
+     * @memberof iso8583_exg_t
+     * @brief Get size of the frame at the beginning of a stream buffer.
+     *
+     * @param data The received data.
+     * @param size Size of the received data.
+     *
+     * @retval Positive Total size of the first frame, including the size header.
+     *                  It may be larger than @a size, which means that
+     *                  more data need to be received to complete the frame.
+     * @retval Zero     The size header itself is not complete yet.
+     * @retval Negative An error code indicates that an error occurred during the process,
+     *         see ::iso8583_err_t for more information.
+     */
+    if( !data ) return ISO8583_ERR_INVALID_ARG;
+    if( size < ISO8583_EXG_SIZEHDR ) return 0;
+
+    const uint8_t *hdr = data;
+    return ISO8583_EXG_SIZEHDR + ( ( hdr[0] << 8 ) | hdr[1] );
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_exg_recv_frame(const iso8583_exg_t *cfg, iso8583_t *msg, const void *data, size_t size)
+{
+    /**
+     * @memberof iso8583_exg_t
+     * @brief Decode a message from a user provided receive buffer.
+     * @details This is the counterpart of ::iso8583_exg_recv which does not use
+     *          the receive callback and the internal buffer:
+     *          the caller receives stream data to its own buffer (or a linearised
+     *          region of a ring buffer), and the message will be framed and
+     *          decoded from that buffer directly.
+     *
+     * @param cfg  Object instance.
+     * @param msg  The received message.
+     * @param data The received data, it should begin with the size header of a frame.
+     * @param size Size of the received data.
+     *
+     * @retval Positive Size of the frame consumed from the input data;
+     *                  the next frame (if any) begins right after it.
+     * @retval Zero     The frame is not complete yet, more data need to be received.
+     * @retval Negative An error code indicates that an error occurred during the process,
+     *         see ::iso8583_err_t for more information.
+     *
+     * @remarks The receive callback of the object will not be used,
+     *          and there is no limit of ::ISO8583_EXG_BUFSIZE to the message size.
+     */
+    assert( cfg );
+
+    if( !msg ) return ISO8583_ERR_INVALID_ARG;
+
+    int frame_size = iso8583_exg_peek_frame(data, size);
+    if( frame_size <= 0 ) return frame_size;
+    if( size < frame_size ) return 0;
+
+    uint64_t time = stage_begin(cfg);
+
+    int readsz = iso8583_decode(msg, data, frame_size, cfg->encode_flags);
+    if( readsz < 0 ) return readsz;
+
+    stage_end(cfg, ISO8583_EXG_STAGE_DECODE, time);
+    return frame_size;
+}
+//------------------------------------------------------------------------------
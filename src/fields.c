@@ -2,8 +2,97 @@
 #include <gen/jmpbk.h>
 #include <gen/bufstm.h>
 #include "bitmap.h"
+#include "hash64.h"
+#include "tracepoint.h"
 #include "fields.h"
 
+/*
+ * The presence bits are kept in the same layout as the bitmap object,
+ * so that the bitmap can be used to walk the present field items only,
+ * and be encoded without building it up item by item.
+ */
+typedef char present_bits_match_bitmap[ sizeof(((iso8583_fields_t*)0)->present) == sizeof(bitmap_t) ? 1 : -1 ];
+
+/*
+ * Items are not initialized one by one: a zeroed item is a valid empty item,
+ * which takes the allocator of the container when it is used first.
+ * Items which have been used are marked in the touched bits,
+ * so that only they are visited to release buffers,
+ * and a message which never has fields 129 to 192 never visits their items.
+ */
+
+//------------------------------------------------------------------------------
+static inline
+bitmap_t* present_bits(iso8583_fields_t *obj)
+{
+    return (bitmap_t*) obj->present;
+}
+//------------------------------------------------------------------------------
+static inline
+const bitmap_t* present_bits_const(const iso8583_fields_t *obj)
+{
+    return (const bitmap_t*) obj->present;
+}
+//------------------------------------------------------------------------------
+static inline
+bool id_is_valid(int id)
+{
+    return ISO8583_FITEM_ID_MIN <= id && id <= ISO8583_FITEM_ID_MAX &&
+           id != ISO8583_FITEM_ID_TERTIARY;
+}
+//------------------------------------------------------------------------------
+static
+void get_masked_bits(bitmap_t *bits, const iso8583_fields_t *obj, const iso8583_fmask_t *mask)
+{
+    *bits = *present_bits_const(obj);
+    if( !mask ) return;
+
+    for(int i=0; i<ISO8583_BITMAP_WORDS; ++i)
+        bits->words[i] &= mask->bits[i];
+}
+//------------------------------------------------------------------------------
+static inline
+const bitmap_t* touched_bits(const iso8583_fields_t *obj)
+{
+    return (const bitmap_t*) obj->touched;
+}
+//------------------------------------------------------------------------------
+static
+void touch_items(iso8583_fields_t *obj, const bitmap_t *bits)
+{
+    // Items used first take the allocator of the container.
+    bitmap_t fresh;
+    for(int i=0; i<ISO8583_BITMAP_WORDS; ++i)
+    {
+        fresh.words[i]   = bits->words[i] & ~obj->touched[i];
+        obj->touched[i] |= bits->words[i];
+    }
+
+    for(int id=bitmap_get_first_id(&fresh); id; id=bitmap_get_next_id(&fresh, id))
+        obj->items[id].allocator = obj->allocator;
+}
+//------------------------------------------------------------------------------
+static
+iso8583_fitem_t* take_item(iso8583_fields_t *obj, int id)
+{
+    // Get the item slot of a valid ID, and mark it present.
+    iso8583_fitem_t *item = &obj->items[id];
+    uint64_t         bit  = ( UINT64_C(1) << 63 ) >> ( ( id - 1 ) & 63 );
+    if( !( obj->touched[ ( id - 1 ) >> 6 ] & bit ) )
+    {
+        obj->touched[ ( id - 1 ) >> 6 ] |= bit;
+        item->allocator = obj->allocator;
+    }
+
+    if( !item->id )
+    {
+        ++ obj->count;
+        bitmap_set_id(present_bits(obj), id);
+        iso8583_fitem_set_id(item, id);
+    }
+
+    return item;
+}
 //------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_fields_init(iso8583_fields_t *obj)
 {
@@ -16,10 +105,7 @@ void ISO8583_CALL iso8583_fields_init(iso8583_fields_t *obj)
     assert( obj );
 
     memset(obj, 0, sizeof(*obj));
-    for(int id=ISO8583_FITEM_ID_MIN; id<=ISO8583_FITEM_ID_MAX; ++id)
-    {
-        iso8583_fitem_init(&obj->items[id]);
-    }
+    obj->allocator = iso8583_allocator_get_default();
 }
 //------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_fields_init_clone(iso8583_fields_t *obj, const iso8583_fields_t *src)
@@ -64,7 +150,8 @@ void ISO8583_CALL iso8583_fields_deinit(iso8583_fields_t *obj)
      */
     assert( obj );
 
-    for(int id=ISO8583_FITEM_ID_MIN; id<=ISO8583_FITEM_ID_MAX; ++id)
+    const bitmap_t *bmp = touched_bits(obj);
+    for(int id=bitmap_get_first_id(bmp); id; id=bitmap_get_next_id(bmp, id))
     {
         iso8583_fitem_deinit(&obj->items[id]);
     }
@@ -81,11 +168,19 @@ void ISO8583_CALL iso8583_fields_clone(iso8583_fields_t *obj, const iso8583_fiel
      */
     assert( obj && src );
 
-    obj->count = src->count;
-    for(int id=ISO8583_FITEM_ID_MIN; id<= ISO8583_FITEM_ID_MAX; ++id)
+    if( obj == src ) return;
+
+    iso8583_fields_clear(obj);
+
+    const bitmap_t *bmp = present_bits_const(src);
+    touch_items(obj, bmp);
+    for(int id=bitmap_get_first_id(bmp); id; id=bitmap_get_next_id(bmp, id))
     {
         iso8583_fitem_clone(&obj->items[id], &src->items[id]);
     }
+
+    memcpy(obj->present, src->present, sizeof(obj->present));
+    obj->count = src->count;
 }
 //------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_fields_movefrom(iso8583_fields_t *obj, iso8583_fields_t *src)
@@ -99,24 +194,99 @@ void ISO8583_CALL iso8583_fields_movefrom(iso8583_fields_t *obj, iso8583_fields_
      */
     assert( obj && src );
 
-    obj->count = src->count;
-    for(int id=ISO8583_FITEM_ID_MIN; id<= ISO8583_FITEM_ID_MAX; ++id)
+    if( obj == src ) return;
+
+    iso8583_fields_clear(obj);
+
+    // Only the present items are moved, buffers of the others are kept by their owners for later use.
+    const bitmap_t *bmp = present_bits_const(src);
+    touch_items(obj, bmp);
+    for(int id=bitmap_get_first_id(bmp); id; id=bitmap_get_next_id(bmp, id))
     {
         iso8583_fitem_movefrom(&obj->items[id], &src->items[id]);
     }
+
+    memcpy(obj->present, src->present, sizeof(obj->present));
+    obj->count = src->count;
+
+    memset(src->present, 0, sizeof(src->present));
+    src->count = 0;
 }
 //------------------------------------------------------------------------------
-static
-void buildup_bitmap(bitmap_t *bmp, const iso8583_fields_t *fields)
+void ISO8583_CALL iso8583_fields_share(iso8583_fields_t *obj, const iso8583_fields_t *src)
+{
+    /**
+     * @memberof iso8583_fields_t
+     * @brief Share values of another object, payloads of the items are referenced but not copied.
+     *
+     * @param obj Object instance.
+     * @param src The source object to be shared.
+     *
+     * @remarks The source object must not be modified or released
+     *          while its payloads are shared, see ::iso8583_fitem_share.
+     *          Buffers of the items are kept for later use,
+     *          so that the items which be modified after shared will not allocate
+     *          if their buffers are large enough.
+     */
+    iso8583_fields_share_masked(obj, src, NULL);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_fields_share_masked(iso8583_fields_t       *obj,
+                                              const iso8583_fields_t *src,
+                                              const iso8583_fmask_t  *mask)
 {
-    bitmap_clear(bmp);
+    /**
+     * @memberof iso8583_fields_t
+     * @brief Share the selected items of another object, and clear the others,
+     *        see ::iso8583_fields_share.
+     *
+     * @param obj  Object instance.
+     * @param src  The source object to be shared.
+     * @param mask The fields to be shared; or NULL to share all fields.
+     */
+    assert( obj && src );
 
-    for(const iso8583_fitem_t *item = iso8583_fields_get_first(fields);
-        item;
-        item = iso8583_fields_get_next(fields, item))
+    if( obj == src )
+    {
+        iso8583_fields_retain(obj, mask);
+        return;
+    }
+
+    iso8583_fields_clear(obj);
+
+    bitmap_t bits;
+    get_masked_bits(&bits, src, mask);
+    touch_items(obj, &bits);
+    for(int id=bitmap_get_first_id(&bits); id; id=bitmap_get_next_id(&bits, id))
     {
-        bitmap_set_id(bmp, item->id);
+        iso8583_fitem_share(&obj->items[id], &src->items[id]);
+        ++ obj->count;
     }
+
+    *present_bits(obj) = bits;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_fields_retain(iso8583_fields_t *obj, const iso8583_fmask_t *mask)
+{
+    /**
+     * @memberof iso8583_fields_t
+     * @brief Erase all items except the selected ones.
+     *
+     * @param obj  Object instance.
+     * @param mask The fields to be kept; or NULL to keep all fields.
+     *
+     * @remarks Buffers of the erased items are kept for later use.
+     */
+    assert( obj );
+
+    if( !mask ) return;
+
+    bitmap_t bits = *present_bits_const(obj);
+    for(int i=0; i<ISO8583_BITMAP_WORDS; ++i)
+        bits.words[i] &= ~mask->bits[i];
+
+    for(int id=bitmap_get_first_id(&bits); id; id=bitmap_get_next_id(&bits, id))
+        iso8583_fields_erase(obj, id);
 }
 //------------------------------------------------------------------------------
 static
@@ -140,6 +310,8 @@ int write_field_items(bufostm_t *stream, const iso8583_fields_t *fields, int fla
         item;
         item = iso8583_fields_get_next(fields, item))
     {
+        TRACE_BEGIN(since);
+
         int fillsz = iso8583_fitem_encode(item,
                                           bufostm_get_buf(stream),
                                           bufostm_get_restsize(stream),
@@ -147,6 +319,8 @@ int write_field_items(bufostm_t *stream, const iso8583_fields_t *fields, int fla
         if( fillsz < 0 ) return fillsz;
         if( !bufostm_commit_write(stream, fillsz) ) return ISO8583_ERR_BUF_NOT_ENOUGH;
 
+        TRACE_END(ISO8583_TRACE_ENCODE, item->id, fillsz, since);
+
         total_fillsz += fillsz;
     }
 
@@ -180,12 +354,7 @@ int ISO8583_CALL iso8583_fields_encode(const iso8583_fields_t *obj, void *buf, s
     {
         int fillsz;
 
-        bitmap_t bmp;
-        bitmap_init(&bmp);
-
-        buildup_bitmap(&bmp, obj);
-
-        fillsz = write_bitmap(&stream, &bmp, flags);
+        fillsz = write_bitmap(&stream, present_bits_const(obj), flags);
         if( fillsz < 0 ) JMPBK_THROW(fillsz);
 
         fillsz = write_field_items(&stream, obj, flags);
@@ -217,27 +386,38 @@ int read_bitmap(bufistm_t *stream, bitmap_t *bmp, int flags)
 static
 int read_field_items(bufistm_t *stream, iso8583_fields_t *fields, const bitmap_t *bmp, int flags)
 {
-    iso8583_fitem_t item;
-    iso8583_fitem_init(&item);
-
     int total_readsz = 0;
     JMPBK_BEGIN
     {
         iso8583_fields_clear(fields);
 
+        // All items of the bitmap are marked present first,
+        // so that they will be cleared together if any one of them failed.
+        *present_bits(fields) = *bmp;
+        touch_items(fields, bmp);
+
         for(int id=bitmap_get_first_id(bmp); id; id=bitmap_get_next_id(bmp, id))
         {
-            int readsz = iso8583_fitem_decode(&item,
+            // Decode to the container slot directly to avoid an extra clone of the item.
+            iso8583_fitem_t *item = &fields->items[id];
+
+            TRACE_BEGIN(since);
+
+            int readsz = iso8583_fitem_decode(item,
                                               bufistm_get_buf(stream),
                                               bufistm_get_restsize(stream),
                                               flags,
                                               id);
-            if( readsz < 0 ) JMPBK_THROW(readsz);
+            if( readsz < 0 || !bufistm_commit_read(stream, readsz) )
+            {
+                fields->errid = id;
+                JMPBK_THROW( readsz < 0 ? readsz : ISO8583_ERR_BUF_NOT_ENOUGH );
+            }
 
-            if( !bufistm_commit_read(stream, readsz) ) JMPBK_THROW(ISO8583_ERR_BUF_NOT_ENOUGH);
+            TRACE_END(ISO8583_TRACE_DECODE, id, readsz, since);
 
             total_readsz += readsz;
-            iso8583_fields_insert(fields, &item);
+            ++ fields->count;
         }
     }
     JMPBK_CATCH_ALL
@@ -246,8 +426,6 @@ int read_field_items(bufistm_t *stream, iso8583_fields_t *fields, const bitmap_t
     }
     JMPBK_END
 
-    iso8583_fitem_deinit(&item);
-
     return total_readsz;
 }
 //------------------------------------------------------------------------------
@@ -270,6 +448,8 @@ int ISO8583_CALL iso8583_fields_decode(iso8583_fields_t *obj, const void *data,
 
     if( !data ) return ISO8583_ERR_INVALID_ARG;
 
+    obj->errid = 0;
+
     bufistm_t stream;
     bufistm_init(&stream, data, size);
 
@@ -301,6 +481,23 @@ int ISO8583_CALL iso8583_fields_decode(iso8583_fields_t *obj, const void *data,
     return res;
 }
 //------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_fields_get_error_id(const iso8583_fields_t *obj)
+{
+    /**
+     * @memberof iso8583_fields_t
+     * @brief Get the field ID which the last decode failed at.
+     * @details It can be used to find out which field item is malformed,
+     *          such as the one which has content not match to its element type
+     *          (see ::ISO8583_FLAG_VALIDATE_CHARSET).
+     *
+     * @param obj Object instance.
+     * @return The field ID; or ZERO if the last decode succeeded
+     *         or failed before any field item be decoded (such as at the bitmap).
+     */
+    assert( obj );
+    return obj->errid;
+}
+//------------------------------------------------------------------------------
 unsigned ISO8583_CALL iso8583_fields_get_count(const iso8583_fields_t *obj)
 {
     /**
@@ -326,7 +523,7 @@ const iso8583_fitem_t* ISO8583_CALL iso8583_fields_get_item(const iso8583_fields
      */
     assert( obj );
 
-    if( id < ISO8583_FITEM_ID_MIN || ISO8583_FITEM_ID_MAX < id ) return NULL;
+    if( !id_is_valid(id) ) return NULL;
 
     const iso8583_fitem_t *item = &obj->items[id];
     return item->id ? item : NULL;
@@ -343,13 +540,8 @@ const iso8583_fitem_t* ISO8583_CALL iso8583_fields_get_first(const iso8583_field
      */
     assert( obj );
 
-    for(int id=ISO8583_FITEM_ID_MIN; id<=ISO8583_FITEM_ID_MAX; ++id)
-    {
-        const iso8583_fitem_t *item = &obj->items[id];
-        if( item->id ) return item;
-    }
-
-    return NULL;
+    int id = bitmap_get_first_id(present_bits_const(obj));
+    return id ? &obj->items[id] : NULL;
 }
 //------------------------------------------------------------------------------
 const iso8583_fitem_t* ISO8583_CALL iso8583_fields_get_next(const iso8583_fields_t *obj,
@@ -367,13 +559,81 @@ const iso8583_fitem_t* ISO8583_CALL iso8583_fields_get_next(const iso8583_fields
 
     if( prev->id < ISO8583_FITEM_ID_MIN ) return NULL;
 
-    for(int id=prev->id+1; id<=ISO8583_FITEM_ID_MAX; ++id)
+    int id = bitmap_get_next_id(present_bits_const(obj), prev->id);
+    return id ? &obj->items[id] : NULL;
+}
+//------------------------------------------------------------------------------
+bool ISO8583_CALL iso8583_fields_equal(const iso8583_fields_t *obj,
+                                       const iso8583_fields_t *tar,
+                                       const iso8583_fmask_t  *mask)
+{
+    /**
+     * @memberof iso8583_fields_t
+     * @brief Compare the selected field items of two objects.
+     * @details The presence of the selected items are compared first,
+     *          and then the sizes and payloads of the items which are present on both objects,
+     *          so that only the present items be visited.
+     *
+     * @param obj  Object instance.
+     * @param tar  The object to be compared with.
+     * @param mask The fields to be compared; or NULL to compare all fields.
+     * @return TRUE if all selected items are the same; and FALSE if not.
+     */
+    assert( obj && tar );
+
+    if( obj == tar ) return true;
+
+    bitmap_t bits, tarbits;
+    get_masked_bits(&bits   , obj, mask);
+    get_masked_bits(&tarbits, tar, mask);
+    if( memcmp(&bits, &tarbits, sizeof(bits)) ) return false;
+
+    for(int id=bitmap_get_first_id(&bits); id; id=bitmap_get_next_id(&bits, id))
+    {
+        size_t size = iso8583_fitem_get_size(&obj->items[id]);
+        if( size != iso8583_fitem_get_size(&tar->items[id]) ) return false;
+
+        const void *data    = iso8583_fitem_get_data(&obj->items[id]);
+        const void *tardata = iso8583_fitem_get_data(&tar->items[id]);
+        if( data != tardata && memcmp(data, tardata, size) ) return false;  // Shared payloads are the same.
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+uint64_t ISO8583_CALL iso8583_fields_hash(const iso8583_fields_t *obj, const iso8583_fmask_t *mask, uint64_t seed)
+{
+    /**
+     * @memberof iso8583_fields_t
+     * @brief Calculate hash value of the selected field items.
+     * @details IDs, sizes, and payloads of the present items are hashed by a fast non-cryptographic hash,
+     *          so that objects which are equal (see ::iso8583_fields_equal) with the same mask
+     *          have the same hash value, without encoding them.
+     *
+     * @param obj  Object instance.
+     * @param mask The fields to be hashed; or NULL to hash all fields.
+     * @param seed Seed of the hash.
+     * @return The hash value.
+     *
+     * @remarks Hash values are for lookups inside the process (such as the key of hash tables),
+     *          they should not be stored or transmitted.
+     */
+    assert( obj );
+
+    bitmap_t bits;
+    get_masked_bits(&bits, obj, mask);
+
+    uint64_t hash = seed + HASH64_PRIME3;
+    for(int id=bitmap_get_first_id(&bits); id; id=bitmap_get_next_id(&bits, id))
     {
         const iso8583_fitem_t *item = &obj->items[id];
-        if( item->id ) return item;
+        size_t                 size = iso8583_fitem_get_size(item);
+
+        hash = hash64_mix(hash, (uint64_t)id << 32 | size);
+        hash = hash64_update(hash, iso8583_fitem_get_data(item), size);
     }
 
-    return NULL;
+    return hash64_final(hash);
 }
 //------------------------------------------------------------------------------
 int ISO8583_CALL iso8583_fields_insert(iso8583_fields_t *obj, const iso8583_fitem_t *item)
@@ -385,21 +645,65 @@ int ISO8583_CALL iso8583_fields_insert(iso8583_fields_t *obj, const iso8583_fite
      * @param obj  Object instance.
      * @param item The item to be inserted.
      * @return An error code defined in ::iso8583_err_t.
+     *
+     * @remarks Field 65 is reserved for the tertiary bitmap indicator,
+     *          and items of it will be rejected.
      */
     assert( obj );
 
     if( !item ) return ISO8583_ERR_INVALID_ARG;
 
     int id = item->id;
-    if( id < ISO8583_FITEM_ID_MIN || ISO8583_FITEM_ID_MAX < id ) return ISO8583_ERR_INVALID_FIELD_ID;
+    if( !id_is_valid(id) ) return ISO8583_ERR_INVALID_FIELD_ID;
+
+    iso8583_fitem_clone(take_item(obj, id), item);
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_fields_set_data(iso8583_fields_t *obj, int id, const void *data, size_t size)
+{
+    /**
+     * @memberof iso8583_fields_t
+     * @brief Set data of a field item directly.
+     * @details This is the same as ::iso8583_fields_insert with an item of the same ID and data,
+     *          but no temporary item needed.
+     *
+     * @param obj  Object instance.
+     * @param id   The field ID.
+     * @param data The data to be set.
+     * @param size Size of the input data.
+     * @return An error code defined in ::iso8583_err_t.
+     */
+    assert( obj );
+
+    if( !id_is_valid(id) ) return ISO8583_ERR_INVALID_FIELD_ID;
 
-    iso8583_fitem_t *olditem = &obj->items[id];
-    if( !olditem->id ) ++ obj->count;
+    iso8583_fitem_set_data(take_item(obj, id), data, size);
 
-    iso8583_fitem_clone(olditem, item);
     return ISO8583_ERR_SUCCESS;
 }
 //------------------------------------------------------------------------------
+void* ISO8583_CALL iso8583_fields_resize_data(iso8583_fields_t *obj, int id, size_t size)
+{
+    /**
+     * @memberof iso8583_fields_t
+     * @brief Resize data of a field item, and get the buffer to write data to it directly.
+     * @details The field item will be inserted if it does not exist,
+     *          so that a field can be built in place without a temporary buffer.
+     *
+     * @param obj  Object instance.
+     * @param id   The field ID.
+     * @param size The new size of the field data.
+     * @return The buffer of the field data, see ::iso8583_fitem_resize_data; or
+     *         NULL if the field ID is invalid.
+     */
+    assert( obj );
+
+    if( !id_is_valid(id) ) return NULL;
+
+    return iso8583_fitem_resize_data(take_item(obj, id), size);
+}
+//------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_fields_erase(iso8583_fields_t *obj, int id)
 {
     /**
@@ -412,13 +716,14 @@ void ISO8583_CALL iso8583_fields_erase(iso8583_fields_t *obj, int id)
     assert( obj );
 
     if( !obj->count ) return;
-    if( id < ISO8583_FITEM_ID_MIN || ISO8583_FITEM_ID_MAX < id ) return;
+    if( !id_is_valid(id) ) return;
 
     iso8583_fitem_t *item = &obj->items[id];
     if( !item->id ) return;
 
     iso8583_fitem_clear(item);
     iso8583_fitem_set_id(item, 0);
+    bitmap_clear_id(present_bits(obj), id);
 
     -- obj->count;
 }
@@ -433,13 +738,61 @@ void ISO8583_CALL iso8583_fields_clear(iso8583_fields_t *obj)
      */
     assert( obj );
 
-    obj->count = 0;
-    for(int id=ISO8583_FITEM_ID_MIN; id<=ISO8583_FITEM_ID_MAX; ++id)
+    const bitmap_t *bmp = present_bits_const(obj);
+    for(int id=bitmap_get_first_id(bmp); id; id=bitmap_get_next_id(bmp, id))
     {
         iso8583_fitem_t *item = &obj->items[id];
 
         iso8583_fitem_clear(item);
         iso8583_fitem_set_id(item, 0);
     }
+
+    bitmap_clear(present_bits(obj));
+    obj->count = 0;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_fields_shrink(iso8583_fields_t *obj)
+{
+    /**
+     * @memberof iso8583_fields_t
+     * @brief Release buffers which are not used by the field items.
+     * @details Field buffers are kept after items be erased or cleared,
+     *          so that a reused container will not allocate again;
+     *          call this function to return the memory when it is no longer needed.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    const bitmap_t *bmp = touched_bits(obj);
+    for(int id=bitmap_get_first_id(bmp); id; id=bitmap_get_next_id(bmp, id))
+    {
+        iso8583_fitem_shrink(&obj->items[id]);
+    }
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_fields_set_allocator(iso8583_fields_t *obj, const iso8583_allocator_t *allocator)
+{
+    /**
+     * @memberof iso8583_fields_t
+     * @brief Change the allocator of all field buffers.
+     *
+     * @param obj       Object instance.
+     * @param allocator The allocator to be used;
+     *                  or NULL to use the current default allocator.
+     *                  It must outlive the object.
+     *
+     * @remarks Existing buffers will be moved to memory allocated by the new allocator.
+     */
+    assert( obj );
+
+    // Items not used yet will take the allocator when they are used first.
+    obj->allocator = allocator ? allocator : iso8583_allocator_get_default();
+
+    const bitmap_t *bmp = touched_bits(obj);
+    for(int id=bitmap_get_first_id(bmp); id; id=bitmap_get_next_id(bmp, id))
+    {
+        iso8583_fitem_set_allocator(&obj->items[id], obj->allocator);
+    }
 }
 //------------------------------------------------------------------------------
@@ -2,26 +2,33 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
-#include <gen/jmpbk.h>
+#include "charset.h"
+#include "ebcdic.h"
 #include "lvar.h"
+#include "memory.h"
 #include "fitem.h"
 
 //------------------------------------------------------------------------------
 static
-void* resize_buffer(void *buf, size_t size)
+void reserve_buffer(iso8583_fitem_t *obj, size_t size)
 {
-    if( size )
-    {
-        buf = realloc(buf, size);
-        assert( buf );
-    }
-    else
-    {
-        if( buf ) free(buf);
-        buf = NULL;
-    }
+    // The buffer only grows, so that a reused item will not allocate again.
+    if( size <= obj->capacity ) return;
+
+    // An item without allocator takes the default one when it allocates first,
+    // so that the buffer is always released by the one which allocated it.
+    if( !obj->allocator ) obj->allocator = iso8583_allocator_get_default();
 
-    return buf;
+    obj->buf = mem_realloc(obj->allocator, obj->buf, size);
+    assert( obj->buf );
+
+    obj->capacity = size;
+}
+//------------------------------------------------------------------------------
+static inline
+const void* payload_of(const iso8583_fitem_t *obj)
+{
+    return obj->shared ? obj->shared : obj->buf;
 }
 //------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_fitem_init(iso8583_fitem_t *obj)
@@ -31,9 +38,14 @@ void ISO8583_CALL iso8583_fitem_init(iso8583_fitem_t *obj)
      * @brief Constructor.
      *
      * @param obj Object instance.
+     *
+     * @remarks The object takes the current default allocator,
+     *          see ::iso8583_allocator_set_default.
      */
     assert( obj );
+
     memset(obj, 0, sizeof(*obj));
+    obj->allocator = iso8583_allocator_get_default();
 }
 //------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_fitem_init_value(iso8583_fitem_t *obj, int id, const void *data, size_t size)
@@ -96,7 +108,7 @@ void ISO8583_CALL iso8583_fitem_deinit(iso8583_fitem_t *obj)
      * @param obj Object instance.
      */
     assert( obj );
-    if( obj->buf ) free(obj->buf);
+    if( obj->buf ) mem_free(obj->allocator, obj->buf);
 }
 //------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_fitem_clone(iso8583_fitem_t *obj, const iso8583_fitem_t *src)
@@ -110,10 +122,14 @@ void ISO8583_CALL iso8583_fitem_clone(iso8583_fitem_t *obj, const iso8583_fitem_
      */
     assert( obj && src );
 
-    obj->id   = src->id;
-    obj->size = src->size;
-    obj->buf  = resize_buffer(obj->buf, src->size);
-    memcpy(obj->buf, src->buf, src->size);
+    if( obj == src ) return;
+
+    reserve_buffer(obj, src->size);
+    if( src->size ) memcpy(obj->buf, payload_of(src), src->size);
+
+    obj->id     = src->id;
+    obj->size   = src->size;
+    obj->shared = NULL;
 }
 //------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_fitem_movefrom(iso8583_fitem_t *obj, iso8583_fitem_t *src)
@@ -124,12 +140,44 @@ void ISO8583_CALL iso8583_fitem_movefrom(iso8583_fitem_t *obj, iso8583_fitem_t *
      *
      * @param obj Object instance.
      * @param src The source object to be moved from.
+     *
+     * @remarks The buffer is moved along with its allocator,
+     *          and the source object keeps its allocator for later use.
      */
     assert( obj && src );
 
+    const iso8583_allocator_t *allocator = src->allocator;
+
     iso8583_fitem_deinit(obj);
     *obj = *src;
-    iso8583_fitem_init(src);
+
+    memset(src, 0, sizeof(*src));
+    src->allocator = allocator;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_fitem_share(iso8583_fitem_t *obj, const iso8583_fitem_t *src)
+{
+    /**
+     * @memberof iso8583_fitem_t
+     * @brief Share values of another object, the payload is referenced but not copied.
+     *
+     * @param obj Object instance.
+     * @param src The source object to be shared.
+     *
+     * @remarks The shared payload must not be modified or released
+     *          while it is shared, such as the payloads of a message template
+     *          (see ::iso8583_template_t).
+     *          The payload will be copied to the buffer of the object
+     *          when the object be modified, and the buffer is kept for later use
+     *          while the payload is shared.
+     */
+    assert( obj && src );
+
+    if( obj == src ) return;
+
+    obj->id     = src->id;
+    obj->size   = src->size;
+    obj->shared = src->size ? payload_of(src) : NULL;
 }
 //------------------------------------------------------------------------------
 static
@@ -140,14 +188,22 @@ const finfo_t* get_finfo(int id)
 }
 //------------------------------------------------------------------------------
 static
-int elecount_to_bytes(finfo_eletype_t eletype, unsigned elecount)
+bool validate_ebcdic(const uint8_t *data, size_t size, finfo_eletype_t eletype)
 {
-    if( !( eletype & ~( FINFO_ELE_N | FINFO_ELE_PAN ) ) )
-        return ( elecount + 1 ) >> 1;  // Convert BCD counts to byte counts.
-    else if( !( eletype & ~FINFO_ELE_B ) )
-        return ( elecount + ( 8 - 1 ) ) >> 3;  // Convert bit counts to byte counts.
-    else
-        return elecount;
+    // Characters are converted to a small buffer piece by piece to be validated,
+    // so that no buffer as large as the payload is needed.
+    uint8_t text[256];
+    while( size )
+    {
+        size_t count = size < sizeof(text) ? size : sizeof(text);
+        ebcdic_to_ascii(text, data, count);
+        if( !charset_validate(text, count, eletype) ) return false;
+
+        data += count;
+        size -= count;
+    }
+
+    return true;
 }
 //------------------------------------------------------------------------------
 int ISO8583_CALL iso8583_fitem_encode(const iso8583_fitem_t *obj, void *buf, size_t size, int flags)
@@ -172,21 +228,30 @@ int ISO8583_CALL iso8583_fitem_encode(const iso8583_fitem_t *obj, void *buf, siz
     const finfo_t *finfo = get_finfo(obj->id);
     if( !finfo ) return ISO8583_ERR_INVALID_FIELD_ID;
 
+    if( ( flags & ISO8583_FLAG_VALIDATE_CHARSET ) &&
+        !charset_validate(payload_of(obj), obj->size, finfo->eletype) )
+    {
+        return ISO8583_ERR_FIELD_CHARSET;
+    }
+
     if( finfo->lenmode == FINFO_LEN_FIXED )
     {
-        int fieldsize = elecount_to_bytes(finfo->eletype, finfo->maxcount);
+        int fieldsize = finfo_get_size(finfo);
         if( obj->size != fieldsize ) return ISO8583_ERR_FIELD_SIZE_ERROR;
 
         if( size < fieldsize ) return ISO8583_ERR_BUF_NOT_ENOUGH;
 
-        memcpy(buf, obj->buf, obj->size);
+        if( ( flags & ISO8583_FLAG_EBCDIC ) && ebcdic_is_char_type(finfo->eletype) )
+            ebcdic_from_ascii(buf, payload_of(obj), obj->size);
+        else
+            memcpy(buf, payload_of(obj), obj->size);
         return fieldsize;
     }
     else
     {
         return lvar_encode(buf,
                            size,
-                           obj->buf,
+                           payload_of(obj),
                            obj->size,
                            finfo->eletype,
                            finfo->lenmode,
@@ -218,54 +283,61 @@ int ISO8583_CALL iso8583_fitem_decode(iso8583_fitem_t *obj, const void *data,
 
     if( !data ) return ISO8583_ERR_INVALID_ARG;
 
-    static const size_t bufsz = 9999;
-    uint8_t *buf = malloc(bufsz);
-    assert( buf );
+    const finfo_t *finfo = get_finfo(id);
+    if( !finfo ) return ISO8583_ERR_INVALID_FIELD_ID;
 
-    int res = 0;
-    JMPBK_BEGIN
-    {
-        int    readsz;
-        size_t paysz;
+    // The payload will be copied from the input data directly,
+    // no intermediate buffer needed.
+    const void *payload;
+    size_t      paysz;
+    int         readsz;
 
-        const finfo_t *finfo = get_finfo(id);
-        if( !finfo ) JMPBK_THROW(ISO8583_ERR_INVALID_FIELD_ID);
+    if( finfo->lenmode == FINFO_LEN_FIXED )
+    {
+        paysz = readsz = finfo_get_size(finfo);
+        if( size < readsz ) return ISO8583_ERR_BUF_NOT_ENOUGH;
 
-        if( finfo->lenmode == FINFO_LEN_FIXED )
-        {
-            paysz = readsz = elecount_to_bytes(finfo->eletype, finfo->maxcount);
-            if( size < readsz ) JMPBK_THROW(ISO8583_ERR_BUF_NOT_ENOUGH);
+        payload = data;
+    }
+    else
+    {
+        readsz = lvar_decode_view(&payload,
+                                  &paysz,
+                                  data,
+                                  size,
+                                  finfo->eletype,
+                                  finfo->lenmode,
+                                  finfo->maxcount,
+                                  flags);
+        if( readsz < 0 ) return readsz;
+    }
 
-            memcpy(buf, data, paysz);
-        }
-        else
+    if( ( flags & ISO8583_FLAG_EBCDIC ) && ebcdic_is_char_type(finfo->eletype) )
+    {
+        // Validate the converted characters before the item is modified,
+        // and then convert the payload in the same pass as the copy.
+        if( ( flags & ISO8583_FLAG_VALIDATE_CHARSET ) &&
+            !validate_ebcdic(payload, paysz, finfo->eletype) )
         {
-            readsz = lvar_decode(buf,
-                                 bufsz,
-                                 &paysz,
-                                 data,
-                                 size,
-                                 finfo->eletype,
-                                 finfo->lenmode,
-                                 finfo->maxcount,
-                                 flags);
-            if( readsz < 0 ) JMPBK_THROW(readsz);
+            return ISO8583_ERR_FIELD_CHARSET;
         }
 
         iso8583_fitem_set_id(obj, id);
-        iso8583_fitem_set_data(obj, buf, paysz);
-
-        res = readsz;
+        ebcdic_to_ascii(iso8583_fitem_resize_data(obj, paysz), payload, paysz);
+        return readsz;
     }
-    JMPBK_CATCH_ALL
+
+    // Validate the payload in the input buffer, before it is copied.
+    if( ( flags & ISO8583_FLAG_VALIDATE_CHARSET ) &&
+        !charset_validate(payload, paysz, finfo->eletype) )
     {
-        res = JMPBK_ERRCODE;
+        return ISO8583_ERR_FIELD_CHARSET;
     }
-    JMPBK_END
 
-    free(buf);
+    iso8583_fitem_set_id(obj, id);
+    iso8583_fitem_set_data(obj, payload, paysz);
 
-    return res;
+    return readsz;
 }
 //------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_fitem_clear(iso8583_fitem_t *obj)
@@ -275,11 +347,41 @@ void ISO8583_CALL iso8583_fitem_clear(iso8583_fitem_t *obj)
      * @brief Clear all values it contained.
      *
      * @param obj Object instance.
+     *
+     * @remarks The allocated buffer will be kept for later use,
+     *          use ::iso8583_fitem_shrink to release it.
+     */
+    assert( obj );
+    obj->size   = 0;
+    obj->shared = NULL;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_fitem_shrink(iso8583_fitem_t *obj)
+{
+    /**
+     * @memberof iso8583_fitem_t
+     * @brief Release the unused part of the allocated buffer.
+     *
+     * @param obj Object instance.
      */
     assert( obj );
 
-    obj->size = 0;
-    obj->buf  = resize_buffer(obj->buf, 0);
+    // The buffer is not used by a shared payload.
+    size_t used = obj->shared ? 0 : obj->size;
+    if( obj->capacity == used ) return;
+
+    if( used )
+    {
+        obj->buf = mem_realloc(obj->allocator, obj->buf, used);
+        assert( obj->buf );
+    }
+    else
+    {
+        mem_free(obj->allocator, obj->buf);
+        obj->buf = NULL;
+    }
+
+    obj->capacity = used;
 }
 //------------------------------------------------------------------------------
 int ISO8583_CALL iso8583_fitem_get_id(const iso8583_fitem_t *obj)
@@ -318,7 +420,7 @@ const void* ISO8583_CALL iso8583_fitem_get_data(const iso8583_fitem_t *obj)
      * @return Pointer to the field data; or NULL if no data contained.
      */
     assert( obj );
-    return obj->buf;
+    return obj->size ? payload_of(obj) : NULL;
 }
 //------------------------------------------------------------------------------
 size_t ISO8583_CALL iso8583_fitem_get_size(const iso8583_fitem_t *obj)
@@ -334,6 +436,19 @@ size_t ISO8583_CALL iso8583_fitem_get_size(const iso8583_fitem_t *obj)
     return obj->size;
 }
 //------------------------------------------------------------------------------
+size_t ISO8583_CALL iso8583_fitem_get_capacity(const iso8583_fitem_t *obj)
+{
+    /**
+     * @memberof iso8583_fitem_t
+     * @brief Get allocated size of the field buffer.
+     *
+     * @param obj Object instance.
+     * @return Size of the allocated buffer, it is never less than the data size.
+     */
+    assert( obj );
+    return obj->capacity;
+}
+//------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_fitem_set_data(iso8583_fitem_t *obj, const void *data, size_t size)
 {
     /**
@@ -343,13 +458,112 @@ void ISO8583_CALL iso8583_fitem_set_data(iso8583_fitem_t *obj, const void *data,
      * @param obj  Object instance.
      * @param data The data to be set.
      * @param size Size of the input data.
+     *
+     * @remarks The buffer will only be reallocated when it is too small to hold the data.
      */
     assert( obj );
 
     if( !data ) size = 0;
 
+    reserve_buffer(obj, size);
+    if( size ) memcpy(obj->buf, data, size);
+
+    obj->size   = size;
+    obj->shared = NULL;
+}
+//------------------------------------------------------------------------------
+void* ISO8583_CALL iso8583_fitem_resize_data(iso8583_fitem_t *obj, size_t size)
+{
+    /**
+     * @memberof iso8583_fitem_t
+     * @brief Resize field data, and get the buffer to write data to it directly.
+     *
+     * @param obj  Object instance.
+     * @param size The new size of the field data.
+     * @return The buffer of the field data, which is writable in the range of the new size; or
+     *         NULL if the new size is ZERO.
+     *
+     * @remarks The data in the range of the new size are kept,
+     *          and the buffer will only be reallocated when it is too small.
+     *          A shared payload is copied to the buffer first.
+     */
+    assert( obj );
+
+    reserve_buffer(obj, size);
+    if( obj->shared )
+    {
+        memcpy(obj->buf, obj->shared, size < obj->size ? size : obj->size);
+        obj->shared = NULL;
+    }
     obj->size = size;
-    obj->buf  = resize_buffer(obj->buf, size);
-    memcpy(obj->buf, data, size);
+
+    return size ? obj->buf : NULL;
+}
+//------------------------------------------------------------------------------
+bool ISO8583_CALL iso8583_fitem_is_shared(const iso8583_fitem_t *obj)
+{
+    /**
+     * @memberof iso8583_fitem_t
+     * @brief Check if the payload is shared from another object, see ::iso8583_fitem_share.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+    return obj->shared;
+}
+//------------------------------------------------------------------------------
+const iso8583_allocator_t* ISO8583_CALL iso8583_fitem_get_allocator(const iso8583_fitem_t *obj)
+{
+    /**
+     * @memberof iso8583_fitem_t
+     * @brief Get the allocator of the field buffer.
+     *
+     * @param obj Object instance.
+     * @return The allocator.
+     */
+    assert( obj );
+
+    // An item which has never allocated may not have taken an allocator yet.
+    return obj->allocator ? obj->allocator : iso8583_allocator_get_default();
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_fitem_set_allocator(iso8583_fitem_t *obj, const iso8583_allocator_t *allocator)
+{
+    /**
+     * @memberof iso8583_fitem_t
+     * @brief Change the allocator of the field buffer.
+     *
+     * @param obj       Object instance.
+     * @param allocator The allocator to be used;
+     *                  or NULL to use the current default allocator.
+     *                  It must outlive the object.
+     *
+     * @remarks The existing buffer will be moved to memory allocated by the new allocator.
+     */
+    assert( obj );
+
+    if( !allocator ) allocator = iso8583_allocator_get_default();
+    if( allocator == iso8583_fitem_get_allocator(obj) )
+    {
+        obj->allocator = allocator;
+        return;
+    }
+
+    // A shared payload is kept, and the buffer is not used by it.
+    size_t used = obj->shared ? 0 : obj->size;
+
+    void *buf = NULL;
+    if( used )
+    {
+        buf = mem_alloc(allocator, used);
+        assert( buf );
+        memcpy(buf, obj->buf, used);
+    }
+
+    if( obj->buf ) mem_free(obj->allocator, obj->buf);
+
+    obj->buf       = buf;
+    obj->capacity  = used;
+    obj->allocator = allocator;
 }
 //------------------------------------------------------------------------------
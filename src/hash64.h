@@ -0,0 +1,77 @@
+/*
+ * Fast non-cryptographic 64 bits hash of field payloads.
+ *
+ * Each 8 bytes word is mixed by a round of multiplications and rotations (as xxHash64),
+ * and the result is finalized by the avalanche of MurmurHash3.
+ * Hash values are only for lookups inside the process,
+ * they are not stable across platforms of different byte orders.
+ */
+#ifndef _ISO8583_HASH64_H_
+#define _ISO8583_HASH64_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HASH64_PRIME1  UINT64_C(0x9E3779B185EBCA87)
+#define HASH64_PRIME2  UINT64_C(0xC2B2AE3D27D4EB4F)
+#define HASH64_PRIME3  UINT64_C(0x165667B19E3779F9)
+
+static inline
+uint64_t hash64_rotl(uint64_t x, int r)
+{
+    return ( x << r ) | ( x >> ( 64 - r ) );
+}
+
+static inline
+uint64_t hash64_mix(uint64_t hash, uint64_t word)
+{
+    word *= HASH64_PRIME2;
+    word  = hash64_rotl(word, 31);
+    word *= HASH64_PRIME1;
+    hash ^= word;
+    return hash64_rotl(hash, 27) * HASH64_PRIME1 + HASH64_PRIME3;
+}
+
+static inline
+uint64_t hash64_update(uint64_t hash, const void *data, size_t size)
+{
+    // The tail is padded with zeros, so that the size should be mixed by the caller.
+    const uint8_t *pos = (const uint8_t*) data;
+    for(; size >= 8; pos += 8, size -= 8)
+    {
+        uint64_t word;
+        memcpy(&word, pos, 8);
+        hash = hash64_mix(hash, word);
+    }
+
+    if( size )
+    {
+        uint64_t word = 0;
+        memcpy(&word, pos, size);
+        hash = hash64_mix(hash, word);
+    }
+
+    return hash;
+}
+
+static inline
+uint64_t hash64_final(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xFF51AFD7ED558CCD);
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xC4CEB9FE1A85EC53);
+    hash ^= hash >> 33;
+    return hash;
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
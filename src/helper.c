@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <gen/bcd.h>
 #include <gen/timeinf.h>
+#include "bcdconv.h"
 #include "panval.h"
 #include "mti.h"
 #include "finfo.h"
@@ -72,14 +73,7 @@ ISO8583_API(bool) iso8583_helper_set_bin(iso8583_fields_t *fields, int id, const
     if( !data || !size ) return false;
     if( id < ISO8583_FITEM_ID_MIN || ISO8583_FITEM_ID_MAX < id ) return false;
 
-    iso8583_fitem_t item;
-    iso8583_fitem_init_value(&item, id, data, size);
-
-    bool res = !iso8583_fields_insert(fields, &item);
-
-    iso8583_fitem_deinit(&item);
-
-    return res;
+    return !iso8583_fields_set_data(fields, id, data, size);
 }
 //------------------------------------------------------------------------------
 uint64_t ISO8583_CALL iso8583_helper_get_int(const iso8583_fields_t *fields, int id, uint64_t errval)
@@ -102,7 +96,7 @@ uint64_t ISO8583_CALL iso8583_helper_get_int(const iso8583_fields_t *fields, int
     size_t         size = iso8583_fitem_get_size(item);
     if( !data || !size ) return errval;
 
-    return bcd_decode(data, size);
+    return bcdconv_to_int(data, size);
 }
 //------------------------------------------------------------------------------
 bool ISO8583_CALL iso8583_helper_set_int(iso8583_fields_t *fields, int id, uint64_t value)
@@ -122,16 +116,114 @@ bool ISO8583_CALL iso8583_helper_set_int(iso8583_fields_t *fields, int id, uint6
 
     int size = ( finfo->maxcount + 1 ) >> 1;
     uint8_t data[size];
-    bcd_encode(data, size, value);
+    bcdconv_from_int(data, size, value);
+
+    return !iso8583_fields_set_data(fields, id, data, size);
+}
+//------------------------------------------------------------------------------
+char* ISO8583_CALL iso8583_helper_get_digits(const iso8583_fields_t *fields, int id, char *buf, size_t bufsz)
+{
+    /**
+     * Get digits of a numeric field item as a string,
+     * such as to print amounts to logs.
+     *
+     * @param fields The field item container to be operated.
+     * @param id     A field ID to get field value, the field must be a numeric (n) field.
+     * @param buf    A buffer to receive the result.
+     * @param bufsz  Size of the output buffer.
+     * @return The output buffer.
+     *
+     * @remarks The result will have the same digits count as the field definition for fixed length fields,
+     *          and all digits of the encoded data for variable length fields.
+     *          The result string will be an empty string if data read failed,
+     *          such like the field item does not existed, or
+     *          the output buffer is too small to hold all data.
+     */
+    assert( fields );
+
+    if( !buf || !bufsz ) return buf;
+    buf[0] = 0;
+
+    if( id < ISO8583_FITEM_ID_MIN || ISO8583_FITEM_ID_MAX < id ) return buf;
+    const finfo_t *finfo = &finfo_list[id];
+    if( finfo->eletype != FINFO_ELE_N ) return buf;
+
+    const iso8583_fitem_t *item = iso8583_fields_get_item(fields, id);
+    if( !item ) return buf;
 
-    iso8583_fitem_t item;
-    iso8583_fitem_init_value(&item, id, data, size);
+    const uint8_t *data = iso8583_fitem_get_data(item);
+    size_t         size = iso8583_fitem_get_size(item);
+    if( !data || !size ) return buf;
+    if( bufsz <= 2*size ) return buf;
 
-    bool res = !iso8583_fields_insert(fields, &item);
+    bcdconv_to_ascii(buf, data, size);
+    buf[2*size] = 0;
 
-    iso8583_fitem_deinit(&item);
+    // Skip the padding digit of an odd digits count.
+    if( finfo->lenmode == FINFO_LEN_FIXED && ( finfo->maxcount & 1 ) && 2*size == finfo->maxcount + 1 )
+        memmove(buf, buf + 1, 2*size);
 
-    return res;
+    return buf;
+}
+//------------------------------------------------------------------------------
+size_t ISO8583_CALL iso8583_helper_bcd_to_ascii(char *buf, size_t bufsz, const void *bcd, size_t size)
+{
+    /**
+     * Convert packed BCD data to a digits string.
+     *
+     * @param buf   A buffer to receive the result string.
+     * @param bufsz Size of the output buffer.
+     * @param bcd   The packed BCD data, two digits in each byte.
+     * @param size  Size of the BCD data.
+     * @return Length of the result string (two times of @a size); or
+     *         ZERO if the output buffer is too small.
+     *
+     * @remarks The conversion is vectorized on CPUs which support SSSE3.
+     */
+    if( !buf || !bcd || bufsz <= 2*size ) return 0;
+
+    bcdconv_to_ascii(buf, bcd, size);
+    buf[2*size] = 0;
+
+    return 2*size;
+}
+//------------------------------------------------------------------------------
+size_t ISO8583_CALL iso8583_helper_ascii_to_bcd(void *buf, size_t bufsz, const char *str)
+{
+    /**
+     * Convert a digits string to packed BCD data.
+     *
+     * @param buf   A buffer to receive the BCD data.
+     * @param bufsz Size of the output buffer.
+     * @param str   The digits string, an odd count of digits will be padded with a leading zero.
+     * @return Size of the BCD data; or
+     *         ZERO if the string is empty, has any character not a digit,
+     *         or the output buffer is too small.
+     *
+     * @remarks The conversion is vectorized on CPUs which support SSSE3.
+     */
+    if( !buf || !str ) return 0;
+
+    size_t len  = strlen(str);
+    size_t size = ( len + 1 ) >> 1;
+    if( !size || size > bufsz ) return 0;
+
+    return bcdconv_from_ascii(buf, str, len) ? size : 0;
+}
+//------------------------------------------------------------------------------
+uint64_t ISO8583_CALL iso8583_helper_bcd_to_int(const void *bcd, size_t size)
+{
+    /**
+     * Convert packed BCD data to integer.
+     *
+     * @param bcd  The packed BCD data, two digits in each byte.
+     * @param size Size of the BCD data.
+     * @return The integer value; or ZERO if the input is empty.
+     *
+     * @remarks Values of more than 19 digits will be truncated to 64 bits,
+     *          and the conversion is vectorized on CPUs which support SSSE3.
+     */
+    return bcd ? bcdconv_to_int(bcd, size) : 0;
 }
 //------------------------------------------------------------------------------
 char* ISO8583_CALL iso8583_helper_get_str(const iso8583_fields_t *fields, int id, char *buf, size_t bufsz)
@@ -189,14 +281,7 @@ bool ISO8583_CALL iso8583_helper_set_str(iso8583_fields_t *fields, int id, const
 
     memcpy(data, str, size);
 
-    iso8583_fitem_t item;
-    iso8583_fitem_init_value(&item, id, data, size);
-
-    bool res = !iso8583_fields_insert(fields, &item);
-
-    iso8583_fitem_deinit(&item);
-
-    return res;
+    return !iso8583_fields_set_data(fields, id, data, size);
 }
 //------------------------------------------------------------------------------
 uint64_t ISO8583_CALL iso8583_helper_get_pan(const iso8583_fields_t *fields)
@@ -235,6 +320,57 @@ bool ISO8583_CALL iso8583_helper_set_pan(iso8583_fields_t *fields, uint64_t pan)
     return size && iso8583_helper_set_bin(fields, 2, data, size);
 }
 //------------------------------------------------------------------------------
+char* ISO8583_CALL iso8583_helper_get_pan_str(const iso8583_fields_t *fields, char pan[19+1])
+{
+    /**
+     * Get PAN as a digits string.
+     *
+     * @param fields The field item container to be operated.
+     * @param pan    A buffer to receive the PAN string.
+     * @return The output buffer.
+     *
+     * @remarks Different from ::iso8583_helper_get_pan,
+     *          all digits of the PAN (include the leading zeros) are kept.
+     *          The result string will be an empty string if read failed,
+     *          or the field data is not a valid PAN.
+     */
+    assert( fields );
+
+    if( !pan ) return pan;
+    pan[0] = 0;
+
+    const iso8583_fitem_t *item = iso8583_fields_get_item(fields, 2);
+    if( !item ) return pan;
+
+    const uint8_t *data = iso8583_fitem_get_data(item);
+    size_t         size = iso8583_fitem_get_size(item);
+    if( !data || !size ) return pan;
+
+    panval_decode_str(pan, 19+1, data, size);
+    return pan;
+}
+//------------------------------------------------------------------------------
+bool ISO8583_CALL iso8583_helper_set_pan_str(iso8583_fields_t *fields, const char *pan)
+{
+    /**
+     * Set PAN from a digits string.
+     *
+     * @param fields The field item container to be operated.
+     * @param pan    The PAN string, must be 1 to 19 digits.
+     * @return TRUE if succeed; and FALSE if failed.
+     *
+     * @remarks Different from ::iso8583_helper_set_pan,
+     *          all digits of the PAN (include the leading zeros) are kept.
+     */
+    assert( fields );
+
+    if( !pan ) return false;
+
+    uint8_t data[16];
+    size_t size = panval_encode_str(data, sizeof(data), pan, strlen(pan));
+    return size && iso8583_helper_set_bin(fields, 2, data, size);
+}
+//------------------------------------------------------------------------------
 unsigned ISO8583_CALL iso8583_helper_get_proccode(const iso8583_fields_t *fields)
 {
     /**
@@ -311,18 +447,8 @@ void ISO8583_CALL iso8583_helper_set_local_datetime(iso8583_fields_t *fields, lo
     bcd_encode(bcdtime.minute, sizeof(bcdtime.minute), timeinf.minute);
     bcd_encode(bcdtime.second, sizeof(bcdtime.second), timeinf.second);
 
-    iso8583_fitem_t item;
-    iso8583_fitem_init(&item);
-
-    iso8583_fitem_set_id(&item, 12);
-    iso8583_fitem_set_data(&item, &bcdtime, sizeof(bcdtime));
-    iso8583_fields_insert(fields, &item);
-
-    iso8583_fitem_set_id(&item, 13);
-    iso8583_fitem_set_data(&item, &bcddate, sizeof(bcddate));
-    iso8583_fields_insert(fields, &item);
-
-    iso8583_fitem_deinit(&item);
+    iso8583_fields_set_data(fields, 12, &bcdtime, sizeof(bcdtime));
+    iso8583_fields_set_data(fields, 13, &bcddate, sizeof(bcddate));
 }
 //------------------------------------------------------------------------------
 char* ISO8583_CALL iso8583_helper_get_respcode(const iso8583_fields_t *fields, char respcode[2+1])
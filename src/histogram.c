@@ -0,0 +1,230 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include "histogram.h"
+
+#define SUBCOUNT  ( 1U << ISO8583_HISTOGRAM_SUBBITS )
+#define MAXVALUE  ( ( UINT64_C(1) << ISO8583_HISTOGRAM_MAXBITS ) - 1 )
+
+//------------------------------------------------------------------------------
+static
+unsigned value_to_bucket(uint64_t value)
+{
+    if( value > MAXVALUE ) value = MAXVALUE;
+    if( value < 2*SUBCOUNT ) return value;
+
+    // Keep the highest SUBBITS+1 bits of the value,
+    // the leading one selects the range and the rest select the bucket in the range.
+    unsigned msb   = 63 - __builtin_clzll(value);
+    unsigned shift = msb - ISO8583_HISTOGRAM_SUBBITS;
+    return ( ( shift + 1 ) << ISO8583_HISTOGRAM_SUBBITS ) + ( ( value >> shift ) - SUBCOUNT );
+}
+//------------------------------------------------------------------------------
+static
+uint64_t bucket_to_highest(unsigned index)
+{
+    // The highest value which will be counted in the bucket.
+    if( index < 2*SUBCOUNT ) return index;
+
+    unsigned shift = ( index >> ISO8583_HISTOGRAM_SUBBITS ) - 1;
+    uint64_t lowest = (uint64_t)( SUBCOUNT + ( index & ( SUBCOUNT - 1 ) ) ) << shift;
+    return lowest + ( ( UINT64_C(1) << shift ) - 1 );
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_histogram_init(iso8583_histogram_t *obj)
+{
+    /**
+     * @memberof iso8583_histogram_t
+     * @brief Constructor.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    memset(obj, 0, sizeof(*obj));
+    obj->min = UINT64_MAX;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_histogram_reset(iso8583_histogram_t *obj)
+{
+    /**
+     * @memberof iso8583_histogram_t
+     * @brief Clear all recorded values.
+     *
+     * @param obj Object instance.
+     *
+     * @remarks Values recorded by other threads during the reset may be partially lost.
+     */
+    assert( obj );
+
+    for(unsigned i=0; i<ISO8583_HISTOGRAM_BUCKETS; ++i)
+        __atomic_store_n(&obj->buckets[i], 0, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&obj->count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&obj->sum  , 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&obj->min  , UINT64_MAX, __ATOMIC_RELAXED);
+    __atomic_store_n(&obj->max  , 0, __ATOMIC_RELAXED);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_histogram_snapshot(iso8583_histogram_t *obj, const iso8583_histogram_t *src)
+{
+    /**
+     * @memberof iso8583_histogram_t
+     * @brief Copy values from a histogram which may be recording by other threads.
+     *
+     * @param obj Object instance.
+     * @param src The source object to be copied.
+     *
+     * @remarks Each counter is read atomically, but values recorded during the copy
+     *          may be only partially included, such as in the total count but not in the buckets.
+     */
+    assert( obj && src );
+
+    if( obj == src ) return;
+
+    for(unsigned i=0; i<ISO8583_HISTOGRAM_BUCKETS; ++i)
+        obj->buckets[i] = __atomic_load_n(&src->buckets[i], __ATOMIC_RELAXED);
+
+    obj->count = __atomic_load_n(&src->count, __ATOMIC_RELAXED);
+    obj->sum   = __atomic_load_n(&src->sum  , __ATOMIC_RELAXED);
+    obj->min   = __atomic_load_n(&src->min  , __ATOMIC_RELAXED);
+    obj->max   = __atomic_load_n(&src->max  , __ATOMIC_RELAXED);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_histogram_record(iso8583_histogram_t *obj, uint64_t value)
+{
+    /**
+     * @memberof iso8583_histogram_t
+     * @brief Record a value.
+     *
+     * @param obj   Object instance.
+     * @param value The value to be recorded, normally a latency in nanoseconds.
+     *
+     * @remarks This function is thread safe and lock-free.
+     */
+    assert( obj );
+
+    __atomic_fetch_add(&obj->buckets[ value_to_bucket(value) ], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&obj->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&obj->sum, value, __ATOMIC_RELAXED);
+
+    // The extremes are rarely changed after warm up,
+    // so they are checked before any write.
+    uint64_t min = __atomic_load_n(&obj->min, __ATOMIC_RELAXED);
+    while( value < min &&
+           !__atomic_compare_exchange_n(&obj->min, &min, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+    {
+    }
+
+    uint64_t max = __atomic_load_n(&obj->max, __ATOMIC_RELAXED);
+    while( value > max &&
+           !__atomic_compare_exchange_n(&obj->max, &max, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+    {
+    }
+}
+//------------------------------------------------------------------------------
+uint64_t ISO8583_CALL iso8583_histogram_get_count(const iso8583_histogram_t *obj)
+{
+    /**
+     * @memberof iso8583_histogram_t
+     * @brief Get count of recorded values.
+     *
+     * @param obj Object instance.
+     * @return Count of values.
+     */
+    assert( obj );
+    return __atomic_load_n(&obj->count, __ATOMIC_RELAXED);
+}
+//------------------------------------------------------------------------------
+uint64_t ISO8583_CALL iso8583_histogram_get_min(const iso8583_histogram_t *obj)
+{
+    /**
+     * @memberof iso8583_histogram_t
+     * @brief Get the minimum recorded value.
+     *
+     * @param obj Object instance.
+     * @return The minimum value; or ZERO if no value recorded.
+     */
+    assert( obj );
+
+    uint64_t min = __atomic_load_n(&obj->min, __ATOMIC_RELAXED);
+    return min == UINT64_MAX ? 0 : min;
+}
+//------------------------------------------------------------------------------
+uint64_t ISO8583_CALL iso8583_histogram_get_max(const iso8583_histogram_t *obj)
+{
+    /**
+     * @memberof iso8583_histogram_t
+     * @brief Get the maximum recorded value.
+     *
+     * @param obj Object instance.
+     * @return The maximum value; or ZERO if no value recorded.
+     */
+    assert( obj );
+    return __atomic_load_n(&obj->max, __ATOMIC_RELAXED);
+}
+//------------------------------------------------------------------------------
+double ISO8583_CALL iso8583_histogram_get_mean(const iso8583_histogram_t *obj)
+{
+    /**
+     * @memberof iso8583_histogram_t
+     * @brief Get the arithmetic mean of recorded values.
+     *
+     * @param obj Object instance.
+     * @return The mean value; or ZERO if no value recorded.
+     */
+    assert( obj );
+
+    uint64_t count = __atomic_load_n(&obj->count, __ATOMIC_RELAXED);
+    uint64_t sum   = __atomic_load_n(&obj->sum  , __ATOMIC_RELAXED);
+    return count ? (double) sum / count : 0;
+}
+//------------------------------------------------------------------------------
+uint64_t ISO8583_CALL iso8583_histogram_get_percentile(const iso8583_histogram_t *obj, double percentile)
+{
+    /**
+     * @memberof iso8583_histogram_t
+     * @brief Get the value at a percentile.
+     *
+     * @param obj        Object instance.
+     * @param percentile The percentile in range 0 to 100, such as 50, 99, or 99.9.
+     * @return The highest value which is equivalent to the value at the percentile,
+     *         in the precision of the buckets; or ZERO if no value recorded.
+     *
+     * @remarks Call this function on a snapshot to get consistent results
+     *          of multiple percentiles, see ::iso8583_histogram_snapshot.
+     */
+    assert( obj );
+
+    uint64_t total = 0;
+    for(unsigned i=0; i<ISO8583_HISTOGRAM_BUCKETS; ++i)
+        total += __atomic_load_n(&obj->buckets[i], __ATOMIC_RELAXED);
+
+    if( !total ) return 0;
+
+    if( percentile < 0   ) percentile = 0;
+    if( percentile > 100 ) percentile = 100;
+
+    uint64_t target = percentile / 100 * total + 0.5;
+    if( target < 1     ) target = 1;
+    if( target > total ) target = total;
+
+    uint64_t min = iso8583_histogram_get_min(obj);
+    uint64_t max = iso8583_histogram_get_max(obj);
+
+    uint64_t accum = 0;
+    for(unsigned i=0; i<ISO8583_HISTOGRAM_BUCKETS; ++i)
+    {
+        accum += __atomic_load_n(&obj->buckets[i], __ATOMIC_RELAXED);
+        if( accum < target ) continue;
+
+        // Values beyond the limit are all counted in the last bucket.
+        uint64_t value = i < ISO8583_HISTOGRAM_BUCKETS - 1 ? bucket_to_highest(i) : max;
+        if( value > max ) value = max;
+        if( value < min ) value = min;
+        return value;
+    }
+
+    return max;
+}
+//------------------------------------------------------------------------------
@@ -2,9 +2,16 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
+#include "bcdconv.h"
 #include "bitmap.h"
+#include "charset.h"
+#include "ebcdic.h"
+#include "flags.h"
 #include "lvar.h"
+#include "panval.h"
+#include "stanshard.h"
 #include "internal_test.h"
 
 //------------------------------------------------------------------------------
@@ -115,6 +122,114 @@ void test_bitmap_case2(void)
 }
 //------------------------------------------------------------------------------
 static
+void test_bitmap_case3(void)
+{
+    static const uint8_t raw[] =
+    {
+        0xC0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+        0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x01,
+        0x40,0x00,0x00,0x00,0x00,0x00,0x00,0x01,
+    };
+
+    // Encode test.
+    {
+        bitmap_t bmp;
+        bitmap_init(&bmp);
+
+        assert( !bitmap_set_id(&bmp,   2) );
+        assert( !bitmap_set_id(&bmp, 128) );
+        assert( !bitmap_set_id(&bmp, 130) );
+        assert( !bitmap_set_id(&bmp, 192) );
+        assert(  bitmap_set_id(&bmp,  65) );
+        assert(  bitmap_set_id(&bmp, 193) );
+
+        uint8_t buf[64] = {0};
+        assert( ISO8583_ERR_BUF_NOT_ENOUGH == bitmap_encode(&bmp, buf, 16, 0) );
+        assert( sizeof(raw) == bitmap_encode(&bmp, buf, sizeof(buf), 0) );
+        assert( 0 == memcmp(buf, raw, sizeof(raw)) );
+
+        // The tertiary bitmap is dropped when no field above 128 exists.
+        bitmap_clear_id(&bmp, 130);
+        bitmap_clear_id(&bmp, 192);
+        assert( 16 == bitmap_encode(&bmp, buf, sizeof(buf), 0) );
+        assert( buf[8] == 0x00 && buf[15] == 0x01 );
+    }
+
+    // Decode test.
+    {
+        bitmap_t bmp;
+        bitmap_init(&bmp);
+
+        assert( ISO8583_ERR_BUF_NOT_ENOUGH == bitmap_decode(&bmp, raw, 16, 0) );
+        assert( sizeof(raw) == bitmap_decode(&bmp, raw, sizeof(raw), 0) );
+        assert( !bitmap_have_id(&bmp, 65) );
+
+        int id = 0;
+        id = bitmap_get_first_id(&bmp);     assert( id ==   2 );
+        id = bitmap_get_next_id(&bmp, id);  assert( id == 128 );
+        id = bitmap_get_next_id(&bmp, id);  assert( id == 130 );
+        id = bitmap_get_next_id(&bmp, id);  assert( id == 192 );
+        id = bitmap_get_next_id(&bmp, id);  assert( id ==   0 );
+    }
+}
+//------------------------------------------------------------------------------
+static
+void test_bitmap_hex(void)
+{
+    static const char text[] = "C000000000000000" "80000000000000A1" "4000000000000001";
+    int flags = ISO8583_FLAG_BITMAP_HEX;
+
+    // Encode test.
+    {
+        bitmap_t bmp;
+        bitmap_init(&bmp);
+
+        assert( !bitmap_set_id(&bmp,   2) );
+        assert( !bitmap_set_id(&bmp, 121) );
+        assert( !bitmap_set_id(&bmp, 123) );
+        assert( !bitmap_set_id(&bmp, 128) );
+        assert( !bitmap_set_id(&bmp, 130) );
+        assert( !bitmap_set_id(&bmp, 192) );
+
+        char buf[64] = {0};
+        assert( ISO8583_ERR_BUF_NOT_ENOUGH == bitmap_encode(&bmp, buf, 47, flags) );
+        assert( 48 == bitmap_encode(&bmp, buf, sizeof(buf), flags) );
+        assert( 0 == memcmp(buf, text, 48) );
+
+        bitmap_clear(&bmp);
+        assert( !bitmap_set_id(&bmp, 64) );
+        assert( 16 == bitmap_encode(&bmp, buf, sizeof(buf), flags) );
+        assert( 0 == memcmp(buf, "0000000000000001", 16) );
+    }
+
+    // Decode test.
+    {
+        bitmap_t bmp;
+        bitmap_init(&bmp);
+
+        assert( ISO8583_ERR_BUF_NOT_ENOUGH == bitmap_decode(&bmp, text, 32, flags) );
+        assert( 48 == bitmap_decode(&bmp, text, 48, flags) );
+
+        int id = 0;
+        id = bitmap_get_first_id(&bmp);     assert( id ==   2 );
+        id = bitmap_get_next_id(&bmp, id);  assert( id == 121 );
+        id = bitmap_get_next_id(&bmp, id);  assert( id == 123 );
+        id = bitmap_get_next_id(&bmp, id);  assert( id == 128 );
+        id = bitmap_get_next_id(&bmp, id);  assert( id == 130 );
+        id = bitmap_get_next_id(&bmp, id);  assert( id == 192 );
+        id = bitmap_get_next_id(&bmp, id);  assert( id ==   0 );
+
+        // Lower case digits are accepted.
+        assert( 16 == bitmap_decode(&bmp, "72340541a8c2880f", 16, flags) );
+        assert( bmp.words[0] == UINT64_C(0x72340541A8C2880F) );
+
+        // Characters that are not hexadecimal digits.
+        assert( ISO8583_ERR_TEXT_FORMAT == bitmap_decode(&bmp, "7234054128C2880G", 16, flags) );
+        assert( ISO8583_ERR_TEXT_FORMAT == bitmap_decode(&bmp, "8000000000000000 000000000000001", 32, flags) );
+    }
+}
+//------------------------------------------------------------------------------
+static
 void test_lvar_compress_type(void)
 {
     // LLVAR, uncompressed.
@@ -257,12 +372,357 @@ void test_lvar_size_mode(void)
     }
 }
 //------------------------------------------------------------------------------
+static
+void test_charset_isa(charset_isa_t isa)
+{
+    uint8_t buf[100];
+
+    // Text elements, with a bad character placed at each position
+    // to go through both the vector loops and the tails.
+    for(size_t size=1; size<=sizeof(buf); ++size)
+    {
+        for(size_t pos=0; pos<size; ++pos)
+        {
+            memset(buf, 'A', size);
+            assert( charset_validate_isa(buf, size, FINFO_ELE_A, isa) );
+            buf[pos] = '5';
+            assert( !charset_validate_isa(buf, size, FINFO_ELE_A  , isa) );
+            assert(  charset_validate_isa(buf, size, FINFO_ELE_AN , isa) );
+            buf[pos] = '*';
+            assert( !charset_validate_isa(buf, size, FINFO_ELE_AN , isa) );
+            assert(  charset_validate_isa(buf, size, FINFO_ELE_ANS, isa) );
+            buf[pos] = 0x80;
+            assert( !charset_validate_isa(buf, size, FINFO_ELE_ANS, isa) );
+            buf[pos] = 0x1F;
+            assert( !charset_validate_isa(buf, size, FINFO_ELE_ANS, isa) );
+            buf[pos] = ' ';
+            assert(  charset_validate_isa(buf, size, FINFO_ELE_A  , isa) );
+        }
+    }
+
+    // Classes of all characters.
+    for(unsigned ch=0; ch<256; ++ch)
+    {
+        memset(buf, '+', sizeof(buf));
+        buf[sizeof(buf)-40] = ch;
+
+        bool printable = 0x20 <= ch && ch <= 0x7E;
+        bool letter    = ( 'A' <= ch && ch <= 'Z' ) || ( 'a' <= ch && ch <= 'z' );
+        bool digit     = '0' <= ch && ch <= '9';
+        bool special   = printable && !letter && !digit;
+
+        assert( charset_validate_isa(buf, sizeof(buf), FINFO_ELE_S  , isa) == ( ch == ' ' || special ) );
+        assert( charset_validate_isa(buf, sizeof(buf), FINFO_ELE_NS , isa) == ( ch == ' ' || special || digit ) );
+        assert( charset_validate_isa(buf, sizeof(buf), FINFO_ELE_AS , isa) == ( ch == ' ' || special || letter ) );
+        assert( charset_validate_isa(buf, sizeof(buf), FINFO_ELE_ANS, isa) == printable );
+        assert( charset_validate_isa(buf, sizeof(buf), FINFO_ELE_B  , isa) );
+        assert( charset_validate_isa(buf, sizeof(buf), FINFO_ELE_BIN, isa) );
+
+        memset(buf, '0', sizeof(buf));
+        buf[sizeof(buf)-40] = ch;
+        bool track = digit || ch == '=' || ch == 'D' || ch == ';' || ch == '?';
+        assert( charset_validate_isa(buf, sizeof(buf), FINFO_ELE_Z, isa) == track );
+
+        memset(buf, 0x99, sizeof(buf));
+        buf[sizeof(buf)-40] = ch;
+        bool bcd = ( ch >> 4 ) <= 9 && ( ch & 0x0F ) <= 9;
+        assert( charset_validate_isa(buf, sizeof(buf), FINFO_ELE_N  , isa) == bcd );
+        assert( charset_validate_isa(buf, sizeof(buf), FINFO_ELE_PAN, isa) == bcd );
+    }
+
+    // PAN with the padding nibble.
+    {
+        static const uint8_t pan[] = { 0x12,0x34,0x56,0x78,0x90,0x12,0x34,0x56,0x78,0x90,
+                                       0x12,0x34,0x56,0x78,0x90,0x12,0x34,0x56,0x78,0x9F };
+        assert(  charset_validate_isa(pan, sizeof(pan), FINFO_ELE_PAN, isa) );
+        assert( !charset_validate_isa(pan, sizeof(pan), FINFO_ELE_N  , isa) );
+        assert(  charset_validate_isa(pan, sizeof(pan)-1, FINFO_ELE_PAN, isa) );
+
+        static const uint8_t bad[] = { 0x12,0x34,0xF5,0x6F };
+        assert( !charset_validate_isa(bad, sizeof(bad), FINFO_ELE_PAN, isa) );
+
+        static const uint8_t pad[] = { 0xFF };
+        assert( !charset_validate_isa(pad, sizeof(pad), FINFO_ELE_PAN, isa) );
+    }
+
+    assert( charset_validate_isa(NULL, 0, FINFO_ELE_N, isa) );
+}
+//------------------------------------------------------------------------------
+static
+void test_charset(void)
+{
+    for(int isa=CHARSET_ISA_SCALAR; isa<=(int)charset_get_best_isa(); ++isa)
+        test_charset_isa(isa);
+}
+//------------------------------------------------------------------------------
+static
+void test_bcdconv_isa(bcdconv_isa_t isa)
+{
+    uint8_t bcd[40];
+    char    str[80+1];
+    uint8_t out[40];
+
+    // Conversions of all lengths, to go through both the vector loops and the tails.
+    for(size_t size=0; size<=sizeof(bcd); ++size)
+    {
+        for(size_t i=0; i<size; ++i)
+            bcd[i] = ( ( ( i * 7 + size ) % 10 ) << 4 ) | ( ( i * 3 + 1 ) % 10 );
+
+        memset(str, 0, sizeof(str));
+        bcdconv_to_ascii_isa(str, bcd, size, isa);
+        assert( strlen(str) == 2*size );
+        for(size_t i=0; i<size; ++i)
+        {
+            assert( str[2*i  ] == '0' + ( bcd[i] >> 4 ) );
+            assert( str[2*i+1] == '0' + ( bcd[i] & 0x0F ) );
+        }
+
+        memset(out, 0xCC, sizeof(out));
+        assert( bcdconv_from_ascii_isa(out, str, 2*size, isa) );
+        assert( 0 == memcmp(out, bcd, size) );
+        assert( size == sizeof(out) || out[size] == 0xCC );
+
+        // Bad characters at each position.
+        for(size_t pos=0; pos<2*size; ++pos)
+        {
+            char ch = str[pos];
+            str[pos] = '0' - 1;
+            assert( !bcdconv_from_ascii_isa(out, str, 2*size, isa) );
+            str[pos] = '9' + 1;
+            assert( !bcdconv_from_ascii_isa(out, str, 2*size, isa) );
+            str[pos] = ch;
+        }
+
+        // Integer conversion has the same result as the digit by digit loop,
+        // include the invalid nibbles and the truncated values.
+        bcd[size/2] |= 0xAF & -(size & 1);
+        uint64_t value = 0;
+        for(size_t i=0; i<size; ++i)
+            value = value * 100 + ( bcd[i] >> 4 ) * 10 + ( bcd[i] & 0x0F );
+        assert( value == bcdconv_to_int_isa(bcd, size, isa) );
+    }
+
+    // Odd count of digits.
+    {
+        static const uint8_t bcd_odd[] = { 0x01,0x23,0x45 };
+        assert( bcdconv_from_ascii_isa(out, "12345", 5, isa) );
+        assert( 0 == memcmp(out, bcd_odd, sizeof(bcd_odd)) );
+        assert( !bcdconv_from_ascii_isa(out, "X2345", 5, isa) );
+    }
+
+    // Integer limits.
+    {
+        static const uint8_t bcd_max[] = { 0x18,0x44,0x67,0x44,0x07,0x37,0x09,0x55,0x16,0x15 };
+        assert( UINT64_MAX == bcdconv_to_int_isa(bcd_max, sizeof(bcd_max), isa) );
+
+        static const uint8_t bcd_pan[] = { 0x00,0x00,0x47,0x61,0x73,0x90,0x01,0x01,0x00,0x10 };
+        assert( 4761739001010010ULL == bcdconv_to_int_isa(bcd_pan, sizeof(bcd_pan), isa) );
+    }
+}
+//------------------------------------------------------------------------------
+static
+void test_bcdconv(void)
+{
+    for(int isa=BCDCONV_ISA_SCALAR; isa<=(int)bcdconv_get_best_isa(); ++isa)
+        test_bcdconv_isa(isa);
+
+    uint8_t bcd[10];
+
+    bcdconv_from_int(bcd, sizeof(bcd), UINT64_MAX);
+    static const uint8_t bcd_max[] = { 0x18,0x44,0x67,0x44,0x07,0x37,0x09,0x55,0x16,0x15 };
+    assert( 0 == memcmp(bcd, bcd_max, sizeof(bcd_max)) );
+
+    bcdconv_from_int(bcd, 3, 1234567);
+    static const uint8_t bcd_trunc[] = { 0x23,0x45,0x67 };
+    assert( 0 == memcmp(bcd, bcd_trunc, sizeof(bcd_trunc)) );
+
+    bcdconv_from_int(bcd, 6, 0);
+    static const uint8_t bcd_zero[6] = {0};
+    assert( 0 == memcmp(bcd, bcd_zero, sizeof(bcd_zero)) );
+
+    for(uint64_t value=1; value<UINT64_MAX/7; value=value*7+3)
+    {
+        bcdconv_from_int(bcd, sizeof(bcd), value);
+        assert( value == bcdconv_to_int(bcd, sizeof(bcd)) );
+    }
+}
+//------------------------------------------------------------------------------
+static
+void test_panval(void)
+{
+    uint8_t buf[16];
+    char    str[32];
+
+    // Values around each power of ten, to check the digits counting.
+    uint64_t power = 1;
+    for(unsigned digits=1; digits<=20; ++digits, power*=10)
+    {
+        uint64_t values[] = { power - 1, power, power + 1 };
+        for(size_t i=0; i<sizeof(values)/sizeof(values[0]); ++i)
+        {
+            uint64_t value = values[i];
+            if( !value ) continue;
+
+            unsigned count = 0;
+            for(uint64_t rest=value; rest; rest/=10) ++count;
+
+            size_t size = panval_encode(buf, sizeof(buf), value);
+            assert( size == ( count + 1 ) / 2 );
+            assert( ( count & 1 ) == ( ( buf[size-1] & 0x0F ) == 0x0F ) );
+            assert( value == panval_decode(buf, size) );
+
+            snprintf(str, sizeof(str), "%llu", (unsigned long long) value);
+            if( count > 19 )
+            {
+                assert( !panval_encode_str(buf, sizeof(buf), str, strlen(str)) );
+                continue;
+            }
+
+            uint8_t buf2[16];
+            assert( size == panval_encode_str(buf2, sizeof(buf2), str, strlen(str)) );
+            assert( 0 == memcmp(buf, buf2, size) );
+
+            char str2[32];
+            assert( count == panval_decode_str(str2, sizeof(str2), buf, size) );
+            assert( 0 == strcmp(str, str2) );
+            assert( !panval_decode_str(str2, count, buf, size) );
+        }
+    }
+
+    assert( !panval_encode(buf, sizeof(buf), 0) );
+    assert( !panval_encode(buf, 2, 12345) );
+
+    // Leading zeros and invalid data.
+    {
+        static const uint8_t pan[] = { 0x00,0x47,0x6F };
+        assert( 3 == panval_encode_str(buf, sizeof(buf), "00476", 5) );
+        assert( 0 == memcmp(buf, pan, sizeof(pan)) );
+        assert( 5 == panval_decode_str(str, sizeof(str), pan, sizeof(pan)) );
+        assert( 0 == strcmp(str, "00476") );
+        assert( 476 == panval_decode(pan, sizeof(pan)) );
+
+        static const uint8_t bad[] = { 0x0F,0x47,0x6F };
+        assert( !panval_decode_str(str, sizeof(str), bad, sizeof(bad)) );
+        assert( str[0] == 0 );
+        assert( !panval_encode_str(buf, sizeof(buf), "00A76", 5) );
+        assert( !panval_encode_str(buf, sizeof(buf), "0047X", 5) );
+    }
+}
+//------------------------------------------------------------------------------
+static
+void test_ebcdic_isa(ebcdic_isa_t isa)
+{
+    // All byte values at all offsets of the vector blocks and the tail,
+    // compared to the scalar kernel.
+    uint8_t src[256+35], enc[256+35], ref[256+35], dec[256+35];
+    for(size_t i=0; i<sizeof(src); ++i)
+        src[i] = i * 7 + 3;
+
+    for(size_t size=0; size<=sizeof(src); size+=( size < 70 ? 1 : 29 ))
+    {
+        ebcdic_from_ascii_isa(enc, src, size, isa);
+        ebcdic_from_ascii_isa(ref, src, size, EBCDIC_ISA_SCALAR);
+        assert( 0 == memcmp(enc, ref, size) );
+
+        ebcdic_to_ascii_isa(dec, enc, size, isa);
+        assert( 0 == memcmp(dec, src, size) );
+    }
+
+    // Characters of code page 037, converted in place.
+    {
+        char str[] = "AZaz09 =?;D,.-/*";
+        static const uint8_t ebc[] = { 0xC1,0xE9,0x81,0xA9,0xF0,0xF9,0x40,0x7E,
+                                       0x6F,0x5E,0xC4,0x6B,0x4B,0x60,0x61,0x5C };
+
+        ebcdic_from_ascii_isa(str, str, sizeof(ebc), isa);
+        assert( 0 == memcmp(str, ebc, sizeof(ebc)) );
+        ebcdic_to_ascii_isa(str, str, sizeof(ebc), isa);
+        assert( 0 == strcmp(str, "AZaz09 =?;D,.-/*") );
+    }
+}
+//------------------------------------------------------------------------------
+static
+void test_ebcdic(void)
+{
+    for(int isa=EBCDIC_ISA_SCALAR; isa<=(int)ebcdic_get_best_isa(); ++isa)
+        test_ebcdic_isa(isa);
+
+    assert(  ebcdic_is_char_type(FINFO_ELE_ANS) );
+    assert(  ebcdic_is_char_type(FINFO_ELE_NS ) );
+    assert(  ebcdic_is_char_type(FINFO_ELE_Z  ) );
+    assert( !ebcdic_is_char_type(FINFO_ELE_N  ) );
+    assert( !ebcdic_is_char_type(FINFO_ELE_B  ) );
+    assert( !ebcdic_is_char_type(FINFO_ELE_PAN) );
+    assert( !ebcdic_is_char_type(FINFO_ELE_BIN) );
+
+    // LVAR header and payload.
+    {
+        static const uint8_t raw[] = { 0xF0,0xF0,0xF5, 0xC1,0xC2,0xF1,0x40,0x5C };
+
+        uint8_t buf[16];
+        int flags = ISO8583_FLAG_EBCDIC;
+        assert( sizeof(raw) == lvar_encode(buf, sizeof(buf), "AB1 *", 5, FINFO_ELE_ANS, FINFO_LEN_LLLVAR, 999, flags) );
+        assert( 0 == memcmp(buf, raw, sizeof(raw)) );
+
+        size_t readsz;
+        memset(buf, 0, sizeof(buf));
+        assert( sizeof(raw) == lvar_decode(buf, sizeof(buf), &readsz, raw, sizeof(raw), FINFO_ELE_ANS, FINFO_LEN_LLLVAR, 999, flags) );
+        assert( readsz == 5 && 0 == memcmp(buf, "AB1 *", 5) );
+
+        // ASCII length digits are not accepted.
+        static const uint8_t bad[] = { '0','0','5', 0xC1,0xC2,0xF1,0x40,0x5C };
+        assert( ISO8583_ERR_LVAR_HDR_FORMAT == lvar_decode(buf, sizeof(buf), &readsz, bad, sizeof(bad), FINFO_ELE_ANS, FINFO_LEN_LLLVAR, 999, flags) );
+
+        // Compressed length values and binary payloads are not converted.
+        static const uint8_t bin[] = { 0x02, 0xC1,0xC2 };
+        flags |= ISO8583_FLAG_LVAR_COMPRESSED;
+        assert( sizeof(bin) == lvar_encode(buf, sizeof(buf), "\xC1\xC2", 2, FINFO_ELE_B, FINFO_LEN_LLVAR, 999, flags) );
+        assert( 0 == memcmp(buf, bin, sizeof(bin)) );
+    }
+}
+//------------------------------------------------------------------------------
+static
+void test_stanshard(void)
+{
+    // Allocation index (from 1) of each number which was last issued.
+    static uint32_t issued[ISO8583_STAN_MAX+1];
+    memset(issued, 0, sizeof(issued));
+
+    const uint32_t range   = ISO8583_STAN_MAX - ISO8583_STAN_MIN + 1;
+    const uint32_t mindist = range - ISO8583_STAN_SHARDS * ISO8583_STAN_BLOCK;
+
+    iso8583_stan_t stan;
+    assert( !iso8583_stan_init(&stan, ISO8583_STAN_MIN, ISO8583_STAN_SHARDED) );
+
+    // Shard 0 reserves a block and then stays idle while shard 1 wraps the counter around,
+    // after that both shards are used in turn.
+    // A number must not be issued again until most of the cycle has passed.
+    for(uint32_t index=1; index<=2*range; ++index)
+    {
+        unsigned shard = index == 1 ? 0 : index < range ? 1 : index % 2;
+        unsigned num   = stanshard_next(&stan, shard);
+
+        assert( ISO8583_STAN_MIN <= num && num <= ISO8583_STAN_MAX );
+        assert( !issued[num] || index - issued[num] >= mindist );
+        issued[num] = index;
+    }
+
+    iso8583_stan_deinit(&stan);
+}
+//------------------------------------------------------------------------------
 void ISO8583_CALL iso8583_internal_test(void)
 {
     test_bitmap_case1();
     test_bitmap_case2();
+    test_bitmap_case3();
+    test_bitmap_hex();
     test_lvar_compress_type();
     test_lvar_size_mode();
+    test_charset();
+    test_bcdconv();
+    test_panval();
+    test_ebcdic();
+    test_stanshard();
 }
 //------------------------------------------------------------------------------
 
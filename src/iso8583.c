@@ -275,6 +275,7 @@ int ISO8583_CALL iso8583_decode(iso8583_t *obj, const void *data, size_t size, i
         int readsz;
 
         iso8583_clear(obj);
+        obj->fields.errid = 0;
 
         if( flags & ISO8583_FLAG_HAVE_SIZEHDR )
         {
@@ -321,6 +322,26 @@ void ISO8583_CALL iso8583_clear(iso8583_t *obj)
     iso8583_fields_clear(&obj->fields);
 }
 //------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_set_allocator(iso8583_t *obj, const iso8583_allocator_t *allocator)
+{
+    /**
+     * @memberof iso8583_t
+     * @brief Set the allocator used by the message.
+     * @details A message takes the process default allocator when it is constructed,
+     *          this function assigns a specific allocator to a single message,
+     *          so that its heap traffic can be tracked or served from a private heap.
+     *
+     * @param obj       Object instance.
+     * @param allocator The allocator to be used;
+     *                  or NULL to use the current default allocator.
+     *                  It must outlive the object.
+     *
+     * @remarks Buffers already allocated will be moved to memory allocated by the new allocator.
+     */
+    assert( obj );
+    iso8583_fields_set_allocator(&obj->fields, allocator);
+}
+//------------------------------------------------------------------------------
 int ISO8583_CALL iso8583_get_mti(const iso8583_t *obj)
 {
     /**
@@ -351,3 +372,102 @@ void ISO8583_CALL iso8583_set_mti(iso8583_t *obj, int mti)
     obj->mti = 0xFFFF & mti;
 }
 //------------------------------------------------------------------------------
+bool ISO8583_CALL iso8583_equal(const iso8583_t *obj, const iso8583_t *tar, const iso8583_fmask_t *mask)
+{
+    /**
+     * @memberof iso8583_t
+     * @brief Compare MTI and the selected field items of two messages.
+     *
+     * @param obj  Object instance.
+     * @param tar  The object to be compared with.
+     * @param mask The fields to be compared; or NULL to compare all fields.
+     *             The volatile fields (such as the transmission date and time and the STAN)
+     *             can be excluded by the mask.
+     * @return TRUE if MTI and all selected items are the same; and FALSE if not.
+     *
+     * @remarks TPDU is not compared, which belongs to the transport but not the message.
+     */
+    assert( obj && tar );
+    return obj->mti == tar->mti && iso8583_fields_equal(&obj->fields, &tar->fields, mask);
+}
+//------------------------------------------------------------------------------
+uint64_t ISO8583_CALL iso8583_hash(const iso8583_t *obj, const iso8583_fmask_t *mask, uint64_t seed)
+{
+    /**
+     * @memberof iso8583_t
+     * @brief Calculate hash value of MTI and the selected field items.
+     * @details Messages which are equal (see ::iso8583_equal) with the same mask
+     *          have the same hash value, see ::iso8583_fields_hash.
+     *
+     * @param obj  Object instance.
+     * @param mask The fields to be hashed; or NULL to hash all fields.
+     * @param seed Seed of the hash.
+     * @return The hash value.
+     *
+     * @remarks TPDU is not hashed.
+     */
+    assert( obj );
+    return iso8583_fields_hash(&obj->fields, mask, seed ^ ( (uint64_t) obj->mti << 48 ));
+}
+//------------------------------------------------------------------------------
+#define ECHO_BIT(id)  ( ( UINT64_C(1) << 63 ) >> ( (id) - 1 ) )  // Field 1 to 64 only.
+
+/*
+ * Fields echoed by default: those identify the transaction,
+ * but not the sensitive ones such as the track data (35, 36, 45),
+ * the PIN block (52), and the ICC data (55).
+ */
+static const iso8583_fmask_t default_echo_mask =
+{{
+    ECHO_BIT( 2) | ECHO_BIT( 3) | ECHO_BIT( 4) | ECHO_BIT( 7) | ECHO_BIT(11) | ECHO_BIT(12) | ECHO_BIT(13) |
+    ECHO_BIT(22) | ECHO_BIT(25) | ECHO_BIT(32) | ECHO_BIT(37) | ECHO_BIT(41) | ECHO_BIT(42) | ECHO_BIT(49)
+}};
+
+#undef ECHO_BIT
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_make_response(iso8583_t             *resp,
+                                       const iso8583_t       *req,
+                                       int                    resp_mti,
+                                       const iso8583_fmask_t *echo_mask)
+{
+    /**
+     * @memberof iso8583_t
+     * @brief Make a response of a request, with the echo fields of the request.
+     * @details The response takes the TPDU of the request with the source and destination swapped,
+     *          the response MTI, and the echo fields of the request;
+     *          the other fields of the request (such as the PIN block and the track data) are dropped,
+     *          and then the response specific fields (such as 38 and 39) can be set.
+     *
+     * @param resp      The response message to be made,
+     *                  or the request itself to turn the request into its response in place,
+     *                  which does not copy or allocate anything.
+     *                  Otherwise, payloads of the echo fields are shared but not copied,
+     *                  see ::iso8583_fields_share.
+     * @param req       The request message.
+     * @param resp_mti  MTI of the response; or -1 to take the one of ::iso8583_mti_get_response.
+     * @param echo_mask The fields to be echoed; or NULL to echo the standard set:
+     *                  2, 3, 4, 7, 11, 12, 13, 22, 25, 32, 37, 41, 42, and 49.
+     *                  The sensitive fields (such as 35, 36, 45, 52, and 55) are never in the standard set.
+     * @return An error code defined in ::iso8583_err_t,
+     *         and ::ISO8583_ERR_INVALID_ARG if -1 is given as the response MTI
+     *         of a message which has no response.
+     *
+     * @remarks In the shared mode, the request must not be modified or released
+     *          while the echo fields of the response are shared.
+     */
+    assert( resp && req );
+
+    if( resp_mti < 0 ) resp_mti = iso8583_mti_get_response(req->mti);
+    if( resp_mti < 0 ) return ISO8583_ERR_INVALID_ARG;
+
+    iso8583_tpdu_t tpdu = req->tpdu;
+    resp->tpdu.id   = tpdu.id;
+    resp->tpdu.dest = tpdu.src;
+    resp->tpdu.src  = tpdu.dest;
+    resp->mti       = 0xFFFF & resp_mti;
+
+    iso8583_fields_share_masked(&resp->fields, &req->fields, echo_mask ? echo_mask : &default_echo_mask);
+
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
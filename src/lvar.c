@@ -1,7 +1,9 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <gen/bcd.h>
 #include <gen/bufstm.h>
+#include "ebcdic.h"
 #include "lvar.h"
 
 //------------------------------------------------------------------------------
@@ -25,6 +27,7 @@ int llvar_write_header(uint8_t buf[3+1], size_t value, finfo_eletype_t eletype,
     else
     {
         snprintf((char*)buf, 2+1, "%02u", (unsigned)value);
+        if( flags & ISO8583_FLAG_EBCDIC ) ebcdic_from_ascii(buf, buf, 2);
         return 2;
     }
 }
@@ -49,6 +52,7 @@ int lllvar_write_header(uint8_t buf[3+1], size_t value, finfo_eletype_t eletype,
     else
     {
         snprintf((char*)buf, 3+1, "%03u", (unsigned)value);
+        if( flags & ISO8583_FLAG_EBCDIC ) ebcdic_from_ascii(buf, buf, 3);
         return 3;
     }
 }
@@ -93,7 +97,18 @@ int lvar_encode(void           *buf,
     bufostm_init(&stream, buf, bufsz);
 
     if( !bufostm_write(&stream, hdr , hdrsz) ) return ISO8583_ERR_BUF_NOT_ENOUGH;
-    if( !bufostm_write(&stream, data, datsz) ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+
+    if( ( flags & ISO8583_FLAG_EBCDIC ) && ebcdic_is_char_type(eletype) )
+    {
+        if( bufostm_get_restsize(&stream) < datsz ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+
+        ebcdic_from_ascii(bufostm_get_buf(&stream), data, datsz);
+        bufostm_commit_write(&stream, datsz);
+    }
+    else
+    {
+        if( !bufostm_write(&stream, data, datsz) ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+    }
 
     return bufostm_get_datasize(&stream);
 }
@@ -115,6 +130,7 @@ int llvar_read_header(bufistm_t       *stream,
     {
         char hdr[2+1] = {0};
         if( !bufistm_read(stream, hdr, 2) ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+        if( flags & ISO8583_FLAG_EBCDIC ) ebcdic_to_ascii(hdr, hdr, 2);
 
         char *readend;
         *value = strtoul(hdr, &readend, 10);
@@ -149,6 +165,7 @@ int lllvar_read_header(bufistm_t       *stream,
     {
         char hdr[3+1] = {0};
         if( !bufistm_read(stream, hdr, 3) ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+        if( flags & ISO8583_FLAG_EBCDIC ) ebcdic_to_ascii(hdr, hdr, 3);
 
         char *readend;
         *value = strtoul(hdr, &readend, 10);
@@ -181,17 +198,16 @@ int lvar_read_header(bufistm_t       *stream,
     }
 }
 //------------------------------------------------------------------------------
-int lvar_decode(void           *buf,
-                size_t          bufsz,
-                size_t         *fillsz,  // Return data bytes filled to the output buffer.
-                const void     *data,
-                size_t          datsz,
-                finfo_eletype_t eletype,
-                finfo_lenmode_t lvartype,
-                size_t          maxcount,
-                int             flags)
+int lvar_decode_view(const void    **payload,  // Return pointer to the payload inside the input data.
+                     size_t         *paysz,    // Return size of the payload.
+                     const void     *data,
+                     size_t          datsz,
+                     finfo_eletype_t eletype,
+                     finfo_lenmode_t lvartype,
+                     size_t          maxcount,
+                     int             flags)
 {
-    if( !buf || !data ) return ISO8583_ERR_INVALID_ARG;
+    if( !payload || !paysz || !data ) return ISO8583_ERR_INVALID_ARG;
 
     bufistm_t stream;
     bufistm_init(&stream, data, datsz);
@@ -200,17 +216,52 @@ int lvar_decode(void           *buf,
     int hdrsz = lvar_read_header(&stream, &hdrval, eletype, lvartype, flags);
     if( hdrsz < 0 ) return hdrsz;
 
-    if( bufsz < hdrval ) return ISO8583_ERR_BUF_NOT_ENOUGH;
-
     if( !( flags & ISO8583_FLAG_LVAR_LEN_NO_LIMIT ) &&
         hdrval > maxcount )
     {
         return ISO8583_ERR_LVAR_TOO_LONG;
     }
 
-    if( !bufistm_read(&stream, buf, hdrval) ) return ISO8583_ERR_BUF_NOT_ENOUGH;
-    *fillsz = hdrval;
+    if( bufistm_get_restsize(&stream) < hdrval ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+
+    *payload = bufistm_get_buf(&stream);
+    *paysz   = hdrval;
+
+    return hdrsz + hdrval;
+}
+//------------------------------------------------------------------------------
+int lvar_decode(void           *buf,
+                size_t          bufsz,
+                size_t         *fillsz,  // Return data bytes filled to the output buffer.
+                const void     *data,
+                size_t          datsz,
+                finfo_eletype_t eletype,
+                finfo_lenmode_t lvartype,
+                size_t          maxcount,
+                int             flags)
+{
+    if( !buf || !fillsz ) return ISO8583_ERR_INVALID_ARG;
+
+    const void *payload;
+    size_t      paysz;
+    int readsz = lvar_decode_view(&payload,
+                                  &paysz,
+                                  data,
+                                  datsz,
+                                  eletype,
+                                  lvartype,
+                                  maxcount,
+                                  flags);
+    if( readsz < 0 ) return readsz;
+
+    if( bufsz < paysz ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+
+    if( ( flags & ISO8583_FLAG_EBCDIC ) && ebcdic_is_char_type(eletype) )
+        ebcdic_to_ascii(buf, payload, paysz);
+    else
+        memcpy(buf, payload, paysz);
+    *fillsz = paysz;
 
-    return bufistm_get_readsize(&stream);
+    return readsz;
 }
 //------------------------------------------------------------------------------
@@ -28,4 +28,13 @@ int lvar_decode(void           *buf,
                 size_t          maxcount,
                 int             flags);
 
+int lvar_decode_view(const void    **payload,  // Return pointer to the payload inside the input data.
+                     size_t         *paysz,    // Return size of the payload.
+                     const void     *data,
+                     size_t          datsz,
+                     finfo_eletype_t eletype,
+                     finfo_lenmode_t lvartype,
+                     size_t          maxcount,
+                     int             flags);
+
 #endif
@@ -0,0 +1,58 @@
+/*
+ * Memory operations through the pluggable allocator.
+ */
+#ifndef _ISO8583_MEMORY_H_
+#define _ISO8583_MEMORY_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "allocator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Each object takes the allocator when it is constructed (or when it allocates first),
+ * and passes it to all these operations, so that the memory is always released
+ * by the same allocator which allocated it, even if the default one is changed later.
+ */
+
+static inline
+void* mem_alloc(const iso8583_allocator_t *allocator, size_t size)
+{
+    assert( allocator );
+    return allocator->on_alloc(allocator->userarg, size);
+}
+
+static inline
+void* mem_calloc(const iso8583_allocator_t *allocator, size_t count, size_t size)
+{
+    if( size && count > SIZE_MAX / size ) return NULL;
+
+    void *ptr = mem_alloc(allocator, count * size);
+    if( ptr ) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+static inline
+void* mem_realloc(const iso8583_allocator_t *allocator, void *ptr, size_t size)
+{
+    assert( allocator );
+    return allocator->on_realloc(allocator->userarg, ptr, size);
+}
+
+static inline
+void mem_free(const iso8583_allocator_t *allocator, void *ptr)
+{
+    assert( allocator );
+    allocator->on_free(allocator->userarg, ptr);
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
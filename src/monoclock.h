@@ -0,0 +1,39 @@
+/*
+ * Monotonic clock for latency measurement.
+ */
+#ifndef _ISO8583_MONOCLOCK_H_
+#define _ISO8583_MONOCLOCK_H_
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline
+uint64_t monoclock_ns(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)( counter.QuadPart / freq.QuadPart ) * 1000000000 +
+           (uint64_t)( counter.QuadPart % freq.QuadPart ) * 1000000000 / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
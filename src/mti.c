@@ -1,4 +1,7 @@
 #include <stdint.h>
+#include <string.h>
+#include "flags.h"
+#include "ebcdic.h"
 #include "mti.h"
 
 //------------------------------------------------------------------------------
@@ -17,6 +20,24 @@ int ISO8583_CALL iso8583_mti_encode(int mti, void *buf, size_t size, int flags)
      *         see ::iso8583_err_t for more information.
      */
     if( !buf ) return ISO8583_ERR_INVALID_ARG;
+
+    if( flags & ISO8583_FLAG_MTI_ASCII )
+    {
+        if( mti & ~0xFFFF ) return ISO8583_ERR_INVALID_ARG;
+        if( size < 4 ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+
+        char *str = buf;
+        for(int i=0; i<4; ++i)
+        {
+            unsigned digit = 0x0F & ( mti >> ( 12 - 4*i ) );
+            if( digit > 9 ) return ISO8583_ERR_INVALID_ARG;
+            str[i] = '0' + digit;
+        }
+        if( flags & ISO8583_FLAG_EBCDIC ) ebcdic_from_ascii(str, str, 4);
+
+        return 4;
+    }
+
     if( size < 2 ) return ISO8583_ERR_BUF_NOT_ENOUGH;
 
     uint8_t *arr = buf;
@@ -41,6 +62,31 @@ int ISO8583_CALL iso8583_mti_decode(int *mti, const void *data, size_t size, int
      *         see ::iso8583_err_t for more information.
      */
     if( !mti || !data ) return ISO8583_ERR_INVALID_ARG;
+
+    if( flags & ISO8583_FLAG_MTI_ASCII )
+    {
+        if( size < 4 ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+
+        char str[4];
+        if( flags & ISO8583_FLAG_EBCDIC )
+            ebcdic_to_ascii(str, data, 4);
+        else
+            memcpy(str, data, 4);
+
+        int      value = 0;
+        unsigned bad   = 0;
+        for(int i=0; i<4; ++i)
+        {
+            unsigned digit = (uint8_t) str[i] - '0';
+            bad  |= digit > 9;
+            value = value << 4 | ( digit & 0x0F );
+        }
+        if( bad ) return ISO8583_ERR_TEXT_FORMAT;
+
+        *mti = value;
+        return 4;
+    }
+
     if( size < 2 ) return ISO8583_ERR_BUF_NOT_ENOUGH;
 
     const uint8_t *arr = data;
@@ -1,19 +1,67 @@
 #include <stdbool.h>
-#include <gen/bcd.h>
+#include <string.h>
+#include "bcdconv.h"
 #include "panval.h"
 
+#define PANVAL_MAX_DIGITS 19
+
 //------------------------------------------------------------------------------
 static
 unsigned count_digits(uint64_t value)
 {
-    unsigned count = 0;
-    while( value )
+    /*
+     * The bits count gives an estimate of the digits count (log10(2) is about 1233/4096),
+     * which is less by one at most, and then be corrected by a powers of ten table.
+     */
+    static const uint64_t powers[] =
+    {
+        UINT64_C(1),
+        UINT64_C(10),
+        UINT64_C(100),
+        UINT64_C(1000),
+        UINT64_C(10000),
+        UINT64_C(100000),
+        UINT64_C(1000000),
+        UINT64_C(10000000),
+        UINT64_C(100000000),
+        UINT64_C(1000000000),
+        UINT64_C(10000000000),
+        UINT64_C(100000000000),
+        UINT64_C(1000000000000),
+        UINT64_C(10000000000000),
+        UINT64_C(100000000000000),
+        UINT64_C(1000000000000000),
+        UINT64_C(10000000000000000),
+        UINT64_C(100000000000000000),
+        UINT64_C(1000000000000000000),
+        UINT64_C(10000000000000000000),
+    };
+
+    if( !value ) return 0;
+
+    unsigned bits  = 64 - __builtin_clzll(value);
+    unsigned count = ( bits * 1233 ) >> 12;
+    return count + ( value >= powers[count] );
+}
+//------------------------------------------------------------------------------
+static
+size_t pack_digits(uint8_t *buf, size_t bufsize, uint64_t value, unsigned digits)
+{
+    size_t fillsize = ( digits + 1 ) >> 1;
+    if( !fillsize || fillsize > bufsize ) return 0;
+
+    if( digits & 1 )
     {
-        value /= 10;
-        ++count;
+        // The last digit goes to the high nibble of the last byte, followed by the 0xF padding.
+        buf[fillsize-1] = ( value % 10 ) << 4 | 0x0F;
+        bcdconv_from_int(buf, fillsize - 1, value / 10);
+    }
+    else
+    {
+        bcdconv_from_int(buf, fillsize, value);
     }
 
-    return count;
+    return fillsize;
 }
 //------------------------------------------------------------------------------
 size_t panval_encode(void *buf, size_t bufsize, uint64_t pan)
@@ -29,19 +77,9 @@ size_t panval_encode(void *buf, size_t bufsize, uint64_t pan)
      * @return The size of data filled to the output buffer; or
      *         ZERO if buffer too small.
      */
-    uint8_t *bufpos = buf;
-    if( !bufpos || !bufsize ) return 0;
-
-    unsigned digits = count_digits(pan);
-    unsigned fillsize = ( digits + 1 ) >> 1;
-    if( !fillsize || fillsize > bufsize ) return 0;
-
-    bool need_append = digits & 1;
-    if( need_append ) pan *= 10;
-    bcd_encode(bufpos, fillsize, pan);
-    if( need_append ) bufpos[fillsize-1] |= 0x0F;
+    if( !buf || !bufsize ) return 0;
 
-    return fillsize;
+    return pack_digits(buf, bufsize, pan, count_digits(pan));
 }
 //------------------------------------------------------------------------------
 uint64_t panval_decode(const void *data, size_t size)
@@ -59,15 +97,104 @@ uint64_t panval_decode(const void *data, size_t size)
     if( !data || !size ) return 0;
 
     const uint8_t *bufpos = data;
-    unsigned last_digit = bufpos[size-1] & 0x0F;
+    uint8_t        last   = bufpos[size-1];
+
+    if( ( last & 0x0F ) == 0x0F )
+        return bcdconv_to_int(data, size - 1) * 10 + ( last >> 4 );
+    else
+        return bcdconv_to_int(data, size);
+}
+//------------------------------------------------------------------------------
+size_t panval_encode_str(void *buf, size_t bufsize, const char *pan, size_t len)
+{
+    /**
+     * @brief Encode PAN digits string.
+     * @details The same as ::panval_encode, but the PAN is given as a string,
+     *          so that all digits (include the leading zeros) are kept.
+     *
+     * @param buf     A buffer to receive the output data.
+     * @param bufsize Size of the output buffer.
+     * @param pan     The PAN digits, must be 1 to 19 digits.
+     * @param len     Length of the PAN string.
+     * @return The size of data filled to the output buffer; or
+     *         ZERO if buffer too small or the PAN string is invalid.
+     */
+    if( !buf || !pan ) return 0;
+    if( !len || len > PANVAL_MAX_DIGITS ) return 0;
+
+    size_t fillsize = ( len + 1 ) >> 1;
+    if( fillsize > bufsize ) return 0;
+
+    uint8_t *bufpos = buf;
+    if( len & 1 )
+    {
+        unsigned last = (uint8_t) pan[len-1] - '0';
+        if( last > 9 ) return 0;
+
+        bufpos[fillsize-1] = last << 4 | 0x0F;
+        --len;
+    }
+
+    return bcdconv_from_ascii(bufpos, pan, len) ? fillsize : 0;
+}
+//------------------------------------------------------------------------------
+size_t panval_decode_str(char *str, size_t strsize, const void *data, size_t size)
+{
+    /**
+     * @brief Decode PAN to digits string.
+     * @details The same as ::panval_decode, but the PAN is extracted as a string,
+     *          so that all digits (include the leading zeros) are kept.
+     *
+     * @param str     A buffer to receive the PAN string, which will be null terminated.
+     * @param strsize Size of the string buffer.
+     * @param data    Data of the encoded PAN.
+     * @param size    Size of the input data.
+     * @return Length of the PAN string; or
+     *         ZERO if buffer too small or the data is not a valid PAN.
+     */
+    if( !str || !strsize ) return 0;
+    str[0] = 0;
+
+    if( !data || !size ) return 0;
+
+    const uint8_t *bufpos = data;
+    bool           padded = ( bufpos[size-1] & 0x0F ) == 0x0F;
+
+    size_t len = 2*size - padded;
+    if( strsize <= len ) return 0;
+
+    if( padded )
+    {
+        bcdconv_to_ascii(str, data, size - 1);
+        str[len-1] = '0' + ( bufpos[size-1] >> 4 );
+    }
+    else
+    {
+        bcdconv_to_ascii(str, data, size);
+    }
+
+    // Characters converted from nibbles are in range '0' to '0'+15,
+    // and only the ones of nibbles above 9 reach bit 6 after adding 6.
+    uint64_t bad = 0;
+    size_t   pos = 0;
+    for(; pos + 8 <= len; pos += 8)
+    {
+        uint64_t chars;
+        memcpy(&chars, str + pos, sizeof(chars));
+        bad |= chars + UINT64_C(0x0606060606060606);
+    }
+    for(; pos < len; ++pos)
+        bad |= (uint8_t)( str[pos] + 6 );
+
+    bad &= UINT64_C(0x4040404040404040);
 
-    uint64_t pan = bcd_decode(data, size);
-    if( last_digit == 0xF )
+    if( bad || len > PANVAL_MAX_DIGITS )
     {
-        pan -= last_digit;
-        pan /= 10;
+        str[0] = 0;
+        return 0;
     }
 
-    return pan;
+    str[len] = 0;
+    return len;
 }
 //------------------------------------------------------------------------------
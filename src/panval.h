@@ -14,6 +14,9 @@ extern "C" {
 size_t   panval_encode(void *buf, size_t bufsize, uint64_t value);
 uint64_t panval_decode(const void *data, size_t size);
 
+size_t panval_encode_str(void *buf, size_t bufsize, const char *pan, size_t len);
+size_t panval_decode_str(char *str, size_t strsize, const void *data, size_t size);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
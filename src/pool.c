@@ -0,0 +1,233 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gen/systime.h>
+#include "memory.h"
+#include "pool.h"
+
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_pool_init(iso8583_pool_t *obj, size_t count)
+{
+    /**
+     * @memberof iso8583_pool_t
+     * @brief Constructor.
+     *
+     * @param obj   Object instance.
+     * @param count Count of messages the pool holds.
+     * @return An error code defined in ::iso8583_err_t.
+     */
+    assert( obj );
+
+    memset(obj, 0, sizeof(*obj));
+
+    if( !count ) return ISO8583_ERR_INVALID_ARG;
+    if( count > SIZE_MAX / 2 / sizeof(obj->msgs[0]) ) return ISO8583_ERR_INVALID_ARG;
+
+    // The free list has extra room, so that a push will not meet a cell
+    // which is still being read by a slow consumer in the last lap.
+    int errcode = iso8583_queue_init(&obj->freelist, 2*count, ISO8583_QUEUE_MPMC);
+    if( errcode ) return errcode;
+
+    obj->allocator = iso8583_allocator_get_default();
+    obj->msgs      = mem_alloc(obj->allocator, count * sizeof(obj->msgs[0]));
+    assert( obj->msgs );
+
+    obj->count = count;
+    for(size_t i=0; i<count; ++i)
+    {
+        iso8583_init(&obj->msgs[i]);
+        iso8583_queue_push(&obj->freelist, &obj->msgs[i]);
+    }
+
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_pool_deinit(iso8583_pool_t *obj)
+{
+    /**
+     * @memberof iso8583_pool_t
+     * @brief Destructor.
+     *
+     * @param obj Object instance.
+     *
+     * @remarks All messages should be released before the pool be destroyed,
+     *          messages still acquired will be invalid after this call.
+     */
+    assert( obj );
+
+    for(size_t i=0; i<obj->count; ++i)
+        iso8583_deinit(&obj->msgs[i]);
+
+    if( obj->msgs ) mem_free(obj->allocator, obj->msgs);
+    obj->msgs  = NULL;
+    obj->count = 0;
+
+    iso8583_queue_deinit(&obj->freelist);
+}
+//------------------------------------------------------------------------------
+static
+bool is_pool_member(const iso8583_pool_t *obj, const iso8583_t *msg)
+{
+    return obj->msgs <= msg && msg < obj->msgs + obj->count;
+}
+//------------------------------------------------------------------------------
+static
+void push_to_freelist(iso8583_pool_t *obj, iso8583_t *msg)
+{
+    // The free list can always hold all messages,
+    // a failure is only a transient state that another thread is popping the same cell.
+    while( !iso8583_queue_push(&obj->freelist, msg) )
+        systime_sleep_awhile();
+}
+//------------------------------------------------------------------------------
+iso8583_t* ISO8583_CALL iso8583_pool_acquire(iso8583_pool_t *obj)
+{
+    /**
+     * @memberof iso8583_pool_t
+     * @brief Acquire an empty message from the pool.
+     *
+     * @param obj Object instance.
+     * @return The message; or NULL if all messages are in use.
+     *
+     * @remarks This function is thread safe.
+     */
+    assert( obj );
+    return iso8583_queue_pop(&obj->freelist);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_pool_release(iso8583_pool_t *obj, iso8583_t *msg)
+{
+    /**
+     * @memberof iso8583_pool_t
+     * @brief Return a message to the pool.
+     *
+     * @param obj Object instance.
+     * @param msg The message to be returned, it must be acquired from the same pool.
+     *
+     * @remarks The message will be cleared before it is put back,
+     *          field buffers are kept with the object for later reuse.
+     * @remarks This function is thread safe.
+     */
+    assert( obj );
+
+    if( !msg ) return;
+    assert( is_pool_member(obj, msg) );
+
+    iso8583_clear(msg);
+    push_to_freelist(obj, msg);
+}
+//------------------------------------------------------------------------------
+size_t ISO8583_CALL iso8583_pool_get_count(const iso8583_pool_t *obj)
+{
+    /**
+     * @memberof iso8583_pool_t
+     * @brief Get count of messages the pool holds.
+     *
+     * @param obj Object instance.
+     * @return Total count of messages, including which are in use.
+     */
+    assert( obj );
+    return obj->count;
+}
+//------------------------------------------------------------------------------
+size_t ISO8583_CALL iso8583_pool_get_available(const iso8583_pool_t *obj)
+{
+    /**
+     * @memberof iso8583_pool_t
+     * @brief Get count of messages available to be acquired.
+     *
+     * @param obj Object instance.
+     * @return Count of messages in the free list.
+     *
+     * @remarks Messages held by thread caches are not counted.
+     */
+    assert( obj );
+    return iso8583_queue_get_count(&obj->freelist);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_pool_cache_init(iso8583_pool_cache_t *obj, iso8583_pool_t *pool)
+{
+    /**
+     * @memberof iso8583_pool_cache_t
+     * @brief Constructor.
+     *
+     * @param obj  Object instance.
+     * @param pool The pool to be cached, it must outlive the cache object.
+     */
+    assert( obj && pool );
+
+    memset(obj, 0, sizeof(*obj));
+    obj->pool = pool;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_pool_cache_deinit(iso8583_pool_cache_t *obj)
+{
+    /**
+     * @memberof iso8583_pool_cache_t
+     * @brief Destructor.
+     * @details All messages held by the cache will be returned to the pool.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    while( obj->count )
+        push_to_freelist(obj->pool, obj->msgs[ --obj->count ]);
+}
+//------------------------------------------------------------------------------
+iso8583_t* ISO8583_CALL iso8583_pool_cache_acquire(iso8583_pool_cache_t *obj)
+{
+    /**
+     * @memberof iso8583_pool_cache_t
+     * @brief Acquire an empty message from the cache.
+     *
+     * @param obj Object instance.
+     * @return The message; or NULL if all messages of the pool are in use.
+     */
+    assert( obj );
+
+    if( !obj->count )
+    {
+        // Refill half of the cache, so that the next release will not flush immediately.
+        iso8583_t *msg;
+        while( obj->count < ISO8583_POOL_CACHE_SIZE/2 &&
+               ( msg = iso8583_queue_pop(&obj->pool->freelist) ) )
+        {
+            obj->msgs[ obj->count++ ] = msg;
+        }
+
+        if( !obj->count ) return NULL;
+    }
+
+    return obj->msgs[ --obj->count ];
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_pool_cache_release(iso8583_pool_cache_t *obj, iso8583_t *msg)
+{
+    /**
+     * @memberof iso8583_pool_cache_t
+     * @brief Return a message to the cache.
+     *
+     * @param obj Object instance.
+     * @param msg The message to be returned, it must be acquired from the same pool.
+     *
+     * @remarks The message can be acquired by one thread and be released by another.
+     */
+    assert( obj );
+
+    if( !msg ) return;
+    assert( is_pool_member(obj->pool, msg) );
+
+    iso8583_clear(msg);
+
+    if( obj->count == ISO8583_POOL_CACHE_SIZE )
+    {
+        // Flush half of the cache back to the pool.
+        while( obj->count > ISO8583_POOL_CACHE_SIZE/2 )
+            push_to_freelist(obj->pool, obj->msgs[ --obj->count ]);
+    }
+
+    obj->msgs[ obj->count++ ] = msg;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,244 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory.h"
+#include "queue.h"
+
+/*
+ * The multiple producers multiple consumers mode is the bounded queue algorithm
+ * designed by Dmitry Vyukov: each cell carries a sequence number which tells
+ * whether the cell is ready to be written or to be read in the current lap,
+ * so that producers and consumers only contend on their own position counter.
+ */
+
+//------------------------------------------------------------------------------
+static
+size_t round_up_pow2(size_t value)
+{
+    size_t res = 1;
+    while( res < value ) res <<= 1;
+    return res;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_queue_init(iso8583_queue_t *obj, size_t capacity, int mode)
+{
+    /**
+     * @memberof iso8583_queue_t
+     * @brief Constructor.
+     *
+     * @param obj      Object instance.
+     * @param capacity Maximum count of messages the queue can hold,
+     *                 it will be rounded up to a power of two.
+     * @param mode     Concurrency mode, see ::iso8583_queue_mode_t for more information.
+     * @return An error code defined in ::iso8583_err_t;
+     *         the queue holds nothing if it failed, and its capacity will be ZERO.
+     *
+     * @remarks The single producer single consumer mode is faster,
+     *          but it is only safe when there is exactly one thread
+     *          pushing and one thread popping.
+     */
+    assert( obj );
+
+    memset(obj, 0, sizeof(*obj));
+
+    if( !capacity ) return ISO8583_ERR_INVALID_ARG;
+    if( mode != ISO8583_QUEUE_SPSC && mode != ISO8583_QUEUE_MPMC ) return ISO8583_ERR_INVALID_ARG;
+
+    // The capacity can at most be doubled by the rounding,
+    // and neither the rounding nor the array size may overflow after that.
+    if( capacity > SIZE_MAX / 2 / sizeof(obj->cells[0]) ) return ISO8583_ERR_INVALID_ARG;
+
+    capacity = round_up_pow2(capacity);
+
+    obj->allocator = iso8583_allocator_get_default();
+    obj->cells     = mem_alloc(obj->allocator, capacity * sizeof(obj->cells[0]));
+    if( !obj->cells ) return ISO8583_ERR_GENERAL;
+
+    obj->mask = capacity - 1;
+    obj->mode = mode;
+
+    for(size_t i=0; i<capacity; ++i)
+    {
+        obj->cells[i].seq = i;
+        obj->cells[i].msg = NULL;
+    }
+
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_queue_deinit(iso8583_queue_t *obj)
+{
+    /**
+     * @memberof iso8583_queue_t
+     * @brief Destructor.
+     *
+     * @param obj Object instance.
+     *
+     * @remarks Messages still in the queue will not be released,
+     *          they are owned by whom created them.
+     */
+    assert( obj );
+
+    if( obj->cells ) mem_free(obj->allocator, obj->cells);
+    obj->cells = NULL;
+}
+//------------------------------------------------------------------------------
+static
+bool spsc_push(iso8583_queue_t *obj, iso8583_t *msg)
+{
+    size_t head = obj->head;
+    size_t tail = __atomic_load_n(&obj->tail, __ATOMIC_ACQUIRE);
+    if( head - tail > obj->mask ) return false;
+
+    obj->cells[ head & obj->mask ].msg = msg;
+    __atomic_store_n(&obj->head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+//------------------------------------------------------------------------------
+static
+iso8583_t* spsc_pop(iso8583_queue_t *obj)
+{
+    size_t tail = obj->tail;
+    size_t head = __atomic_load_n(&obj->head, __ATOMIC_ACQUIRE);
+    if( tail == head ) return NULL;
+
+    iso8583_t *msg = obj->cells[ tail & obj->mask ].msg;
+    __atomic_store_n(&obj->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return msg;
+}
+//------------------------------------------------------------------------------
+static
+bool mpmc_push(iso8583_queue_t *obj, iso8583_t *msg)
+{
+    iso8583_queue_cell_t *cell;
+    size_t pos = __atomic_load_n(&obj->head, __ATOMIC_RELAXED);
+
+    while( true )
+    {
+        cell = &obj->cells[ pos & obj->mask ];
+        size_t   seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+        if( dif == 0 )
+        {
+            if( __atomic_compare_exchange_n(&obj->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+                break;
+        }
+        else if( dif < 0 )
+        {
+            return false;  // Queue full.
+        }
+        else
+        {
+            pos = __atomic_load_n(&obj->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->msg = msg;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+//------------------------------------------------------------------------------
+static
+iso8583_t* mpmc_pop(iso8583_queue_t *obj)
+{
+    iso8583_queue_cell_t *cell;
+    size_t pos = __atomic_load_n(&obj->tail, __ATOMIC_RELAXED);
+
+    while( true )
+    {
+        cell = &obj->cells[ pos & obj->mask ];
+        size_t   seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        intptr_t dif = (intptr_t)seq - (intptr_t)( pos + 1 );
+
+        if( dif == 0 )
+        {
+            if( __atomic_compare_exchange_n(&obj->tail, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+                break;
+        }
+        else if( dif < 0 )
+        {
+            return NULL;  // Queue empty.
+        }
+        else
+        {
+            pos = __atomic_load_n(&obj->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    iso8583_t *msg = cell->msg;
+    __atomic_store_n(&cell->seq, pos + obj->mask + 1, __ATOMIC_RELEASE);
+
+    return msg;
+}
+//------------------------------------------------------------------------------
+bool ISO8583_CALL iso8583_queue_push(iso8583_queue_t *obj, iso8583_t *msg)
+{
+    /**
+     * @memberof iso8583_queue_t
+     * @brief Push a message to the queue.
+     *
+     * @param obj Object instance.
+     * @param msg The message to be pushed, its ownership will be passed to the queue.
+     * @return TRUE if succeed; and FALSE if the queue is full.
+     */
+    assert( obj );
+
+    if( !obj->cells || !msg ) return false;
+
+    return obj->mode == ISO8583_QUEUE_SPSC ? spsc_push(obj, msg) : mpmc_push(obj, msg);
+}
+//------------------------------------------------------------------------------
+iso8583_t* ISO8583_CALL iso8583_queue_pop(iso8583_queue_t *obj)
+{
+    /**
+     * @memberof iso8583_queue_t
+     * @brief Pop a message from the queue.
+     *
+     * @param obj Object instance.
+     * @return The message popped; or NULL if the queue is empty.
+     */
+    assert( obj );
+
+    if( !obj->cells ) return NULL;
+
+    return obj->mode == ISO8583_QUEUE_SPSC ? spsc_pop(obj) : mpmc_pop(obj);
+}
+//------------------------------------------------------------------------------
+size_t ISO8583_CALL iso8583_queue_get_capacity(const iso8583_queue_t *obj)
+{
+    /**
+     * @memberof iso8583_queue_t
+     * @brief Get maximum count of messages the queue can hold.
+     *
+     * @param obj Object instance.
+     * @return The queue capacity; or ZERO if the queue failed to initialize.
+     */
+    assert( obj );
+    return obj->cells ? obj->mask + 1 : 0;
+}
+//------------------------------------------------------------------------------
+size_t ISO8583_CALL iso8583_queue_get_count(const iso8583_queue_t *obj)
+{
+    /**
+     * @memberof iso8583_queue_t
+     * @brief Get count of messages in the queue.
+     *
+     * @param obj Object instance.
+     * @return Count of messages in the queue.
+     *
+     * @remarks The result is only an estimation when other threads
+     *          are pushing or popping at the same time.
+     */
+    assert( obj );
+
+    size_t tail = __atomic_load_n(&obj->tail, __ATOMIC_ACQUIRE);
+    size_t head = __atomic_load_n(&obj->head, __ATOMIC_ACQUIRE);
+
+    return head > tail ? head - tail : 0;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,480 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "bitmap.h"
+#include "hash64.h"
+#include "memory.h"
+#include "monoclock.h"
+#include "replay.h"
+
+// Sizes of each shard are not smaller than this, unless the whole cache is smaller.
+#define SHARD_MIN_CAPACITY 1024
+
+typedef struct entry_t
+{
+    struct entry_t *chain;  // Next entry in the same bucket.
+    struct entry_t *prev;   // The older entry.
+    struct entry_t *next;   // The newer entry.
+    uint64_t        hash;
+    uint64_t        expiry;
+    size_t          keysize;
+    size_t          respsize;
+    uint8_t         data[];  // The key followed by the response.
+} entry_t;
+
+struct iso8583_replay_shard_t
+{
+    pthread_mutex_t lock;
+
+    entry_t **buckets;
+    size_t    bucketmask;
+    size_t    capacity;
+    size_t    count;
+    entry_t  *oldest;
+    entry_t  *newest;
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t evictions;
+    uint64_t expirations;
+
+    char pad[ISO8583_REPLAY_CACHELINE];
+};
+
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_replay_init(iso8583_replay_t      *obj,
+                                     size_t                 capacity,
+                                     const iso8583_fmask_t *keymask,
+                                     unsigned               ttl_ms)
+{
+    /**
+     * @memberof iso8583_replay_t
+     * @brief Constructor.
+     *
+     * @param obj      Object instance.
+     * @param capacity Maximum count of entries,
+     *                 the oldest entries will be evicted when the cache is full.
+     * @param keymask  The identity fields, such as 2, 11, 32, 37, and 41.
+     * @param ttl_ms   Time to live of entries in milliseconds; or ZERO for never expire.
+     * @return An error code defined in ::iso8583_err_t.
+     *
+     * @remarks If failed, the object is still safe to be used and released:
+     *          lookups and stores return ::ISO8583_ERR_INVALID_ARG,
+     *          and the other operations do nothing.
+     */
+    assert( obj );
+
+    memset(obj, 0, sizeof(*obj));
+
+    if( !capacity || !keymask ) return ISO8583_ERR_INVALID_ARG;
+    if( capacity > SIZE_MAX / 2 / sizeof(obj->shards[0].buckets[0]) ) return ISO8583_ERR_INVALID_ARG;
+
+    obj->keymask   = *keymask;
+    obj->ttl       = (uint64_t) ttl_ms * 1000000;
+    obj->allocator = iso8583_allocator_get_default();
+
+    obj->nshards = 1;
+    while( obj->nshards < ISO8583_REPLAY_SHARDS && capacity / ( 2 * obj->nshards ) >= SHARD_MIN_CAPACITY )
+        obj->nshards *= 2;
+
+    obj->shards = mem_calloc(obj->allocator, obj->nshards, sizeof(obj->shards[0]));
+    assert( obj->shards );
+
+    for(unsigned i=0; i<obj->nshards; ++i)
+    {
+        iso8583_replay_shard_t *shard = &obj->shards[i];
+        pthread_mutex_init(&shard->lock, NULL);
+
+        // Capacities of shards are different by at most one,
+        // so that the total is exactly the capacity of the cache.
+        shard->capacity = capacity / obj->nshards + ( i < capacity % obj->nshards );
+
+        size_t nbuckets = 8;
+        while( nbuckets < shard->capacity ) nbuckets *= 2;
+
+        shard->bucketmask = nbuckets - 1;
+        shard->buckets    = mem_calloc(obj->allocator, nbuckets, sizeof(shard->buckets[0]));
+        assert( shard->buckets );
+    }
+
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+static
+void free_entries(const iso8583_allocator_t *allocator, entry_t *list)
+{
+    // Free a list of entries linked by the chain pointers.
+    while( list )
+    {
+        entry_t *next = list->chain;
+        mem_free(allocator, list);
+        list = next;
+    }
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_replay_deinit(iso8583_replay_t *obj)
+{
+    /**
+     * @memberof iso8583_replay_t
+     * @brief Destructor.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    if( !obj->shards ) return;
+
+    iso8583_replay_clear(obj);
+
+    for(unsigned i=0; i<obj->nshards; ++i)
+    {
+        mem_free(obj->allocator, obj->shards[i].buckets);
+        pthread_mutex_destroy(&obj->shards[i].lock);
+    }
+
+    mem_free(obj->allocator, obj->shards);
+    obj->shards  = NULL;
+    obj->nshards = 0;
+}
+//------------------------------------------------------------------------------
+static
+size_t build_key(const iso8583_replay_t *obj, const iso8583_t *req, uint8_t *buf)
+{
+    /*
+     * Serialize the identity of a message to the buffer, which has ISO8583_REPLAY_KEY_MAX bytes.
+     * Returns size of the key; or ZERO if the message has no identity field,
+     * or the identity is too long.
+     *
+     * The key is the MTI without the repeat bit,
+     * followed by the ID, size, and payload of each identity field.
+     */
+    int mti = iso8583_get_mti(req) & ~ISO8583_MTI_ORI_ACQ_REPEAT;
+    buf[0] = mti >> 8;
+    buf[1] = mti;
+
+    size_t          keysize = 2;
+    const bitmap_t *present = (const bitmap_t*) req->fields.present;
+
+    bitmap_t bits;
+    for(int i=0; i<ISO8583_BITMAP_WORDS; ++i)
+        bits.words[i] = present->words[i] & obj->keymask.bits[i];
+
+    for(int id=bitmap_get_first_id(&bits); id; id=bitmap_get_next_id(&bits, id))
+    {
+        const iso8583_fitem_t *item = &req->fields.items[id];
+        size_t                 size = iso8583_fitem_get_size(item);
+        if( keysize + 3 + size > ISO8583_REPLAY_KEY_MAX ) return 0;
+
+        buf[keysize++] = id;
+        buf[keysize++] = size >> 8;
+        buf[keysize++] = size;
+        memcpy(buf + keysize, iso8583_fitem_get_data(item), size);
+        keysize += size;
+    }
+
+    return keysize > 2 ? keysize : 0;
+}
+//------------------------------------------------------------------------------
+static
+uint64_t hash_key(const uint8_t *key, size_t keysize)
+{
+    return hash64_final(hash64_update(HASH64_PRIME3 + keysize, key, keysize));
+}
+//------------------------------------------------------------------------------
+static
+iso8583_replay_shard_t* get_shard(const iso8583_replay_t *obj, uint64_t hash)
+{
+    // Shards are selected by the high bits, and buckets by the low bits.
+    return &obj->shards[ ( hash >> 32 ) & ( obj->nshards - 1 ) ];
+}
+//------------------------------------------------------------------------------
+static
+entry_t** find_slot(iso8583_replay_shard_t *shard, uint64_t hash, const uint8_t *key, size_t keysize)
+{
+    // Find the chain pointer which points to the entry of the key,
+    // or the NULL at the end of the chain if not found.
+    entry_t **slot = &shard->buckets[ hash & shard->bucketmask ];
+    for(; *slot; slot = &(*slot)->chain)
+    {
+        const entry_t *entry = *slot;
+        if( entry->hash == hash && entry->keysize == keysize && 0 == memcmp(entry->data, key, keysize) )
+            break;
+    }
+
+    return slot;
+}
+//------------------------------------------------------------------------------
+static
+void unlink_entry(iso8583_replay_shard_t *shard, entry_t **slot)
+{
+    entry_t *entry = *slot;
+    *slot = entry->chain;
+
+    if( entry->prev ) entry->prev->next = entry->next; else shard->oldest = entry->next;
+    if( entry->next ) entry->next->prev = entry->prev; else shard->newest = entry->prev;
+
+    entry->chain = NULL;
+    --shard->count;
+}
+//------------------------------------------------------------------------------
+static
+entry_t* unlink_oldest(iso8583_replay_shard_t *shard)
+{
+    entry_t  *entry = shard->oldest;
+    entry_t **slot  = &shard->buckets[ entry->hash & shard->bucketmask ];
+    while( *slot != entry ) slot = &(*slot)->chain;
+
+    unlink_entry(shard, slot);
+    return entry;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_replay_lookup(iso8583_replay_t *obj, const iso8583_t *req, void *buf, size_t size)
+{
+    /**
+     * @memberof iso8583_replay_t
+     * @brief Find the response of a request.
+     *
+     * @param obj  Object instance.
+     * @param req  The request message.
+     * @param buf  A buffer to receive the response.
+     * @param size Size of the buffer.
+     * @return Size of the response if found; or ZERO if not found;
+     *         or an error code defined in ::iso8583_err_t, such as
+     *         ::ISO8583_ERR_INVALID_ARG if the request has no identity field,
+     *         and ::ISO8583_ERR_BUF_NOT_ENOUGH if the buffer cannot hold the response.
+     */
+    assert( obj && req );
+
+    if( !obj->shards ) return ISO8583_ERR_INVALID_ARG;
+
+    uint8_t key[ISO8583_REPLAY_KEY_MAX];
+    size_t  keysize = build_key(obj, req, key);
+    if( !keysize ) return ISO8583_ERR_INVALID_ARG;
+
+    uint64_t                hash    = hash_key(key, keysize);
+    iso8583_replay_shard_t *shard   = get_shard(obj, hash);
+    entry_t                *expired = NULL;
+    int                     res     = 0;
+
+    pthread_mutex_lock(&shard->lock);
+
+    entry_t **slot  = find_slot(shard, hash, key, keysize);
+    entry_t  *entry = *slot;
+    if( entry && obj->ttl && entry->expiry <= monoclock_ns() )
+    {
+        unlink_entry(shard, slot);
+        expired = entry;
+        entry   = NULL;
+        ++shard->expirations;
+    }
+
+    if( !entry )
+    {
+        ++shard->misses;
+    }
+    else if( entry->respsize > size )
+    {
+        res = ISO8583_ERR_BUF_NOT_ENOUGH;
+    }
+    else
+    {
+        memcpy(buf, entry->data + entry->keysize, entry->respsize);
+        res = entry->respsize;
+        ++shard->hits;
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+
+    free_entries(obj->allocator, expired);
+    return res;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_replay_store(iso8583_replay_t *obj, const iso8583_t *req, const void *resp, size_t size)
+{
+    /**
+     * @memberof iso8583_replay_t
+     * @brief Store the response of a request.
+     *
+     * @param obj  Object instance.
+     * @param req  The request message.
+     * @param resp The encoded response.
+     * @param size Size of the response.
+     * @return An error code defined in ::iso8583_err_t.
+     *
+     * @remarks The response replaces the one stored with the same identity,
+     *          and the oldest entry of the shard is evicted if the shard is full.
+     */
+    assert( obj && req );
+
+    if( !obj->shards || !resp || !size || size > INT32_MAX ) return ISO8583_ERR_INVALID_ARG;
+
+    uint8_t key[ISO8583_REPLAY_KEY_MAX];
+    size_t  keysize = build_key(obj, req, key);
+    if( !keysize ) return ISO8583_ERR_INVALID_ARG;
+
+    // The entry is built before the shard be locked,
+    // and entries removed are released after the shard be unlocked.
+    entry_t *entry = mem_alloc(obj->allocator, sizeof(entry_t) + keysize + size);
+    assert( entry );
+
+    entry->chain    = NULL;
+    entry->hash     = hash_key(key, keysize);
+    entry->keysize  = keysize;
+    entry->respsize = size;
+    memcpy(entry->data, key, keysize);
+    memcpy(entry->data + keysize, resp, size);
+
+    iso8583_replay_shard_t *shard   = get_shard(obj, entry->hash);
+    entry_t                *removed = NULL;
+
+    pthread_mutex_lock(&shard->lock);
+
+    if( obj->ttl )
+    {
+        uint64_t now = monoclock_ns();
+        entry->expiry = now + obj->ttl;
+
+        // All entries have the same time to live, so that the oldest ones expire first.
+        while( shard->oldest && shard->oldest->expiry <= now )
+        {
+            entry_t *old = unlink_oldest(shard);
+            old->chain = removed;
+            removed = old;
+            ++shard->expirations;
+        }
+    }
+
+    entry_t **slot = find_slot(shard, entry->hash, key, keysize);
+    if( *slot )
+    {
+        entry_t *old = *slot;
+        unlink_entry(shard, slot);
+        old->chain = removed;
+        removed = old;
+    }
+    else if( shard->count >= shard->capacity )
+    {
+        entry_t *old = unlink_oldest(shard);
+        old->chain = removed;
+        removed = old;
+        ++shard->evictions;
+
+        slot = find_slot(shard, entry->hash, key, keysize);
+    }
+
+    *slot = entry;
+
+    entry->prev = shard->newest;
+    entry->next = NULL;
+    if( shard->newest ) shard->newest->next = entry; else shard->oldest = entry;
+    shard->newest = entry;
+
+    ++shard->count;
+    ++shard->stores;
+
+    pthread_mutex_unlock(&shard->lock);
+
+    free_entries(obj->allocator, removed);
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_replay_remove(iso8583_replay_t *obj, const iso8583_t *req)
+{
+    /**
+     * @memberof iso8583_replay_t
+     * @brief Remove the response of a request.
+     *
+     * @param obj Object instance.
+     * @param req The request message.
+     */
+    assert( obj && req );
+
+    if( !obj->shards ) return;
+
+    uint8_t key[ISO8583_REPLAY_KEY_MAX];
+    size_t  keysize = build_key(obj, req, key);
+    if( !keysize ) return;
+
+    uint64_t                hash    = hash_key(key, keysize);
+    iso8583_replay_shard_t *shard   = get_shard(obj, hash);
+    entry_t                *removed = NULL;
+
+    pthread_mutex_lock(&shard->lock);
+
+    entry_t **slot = find_slot(shard, hash, key, keysize);
+    if( *slot )
+    {
+        removed = *slot;
+        unlink_entry(shard, slot);
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+
+    free_entries(obj->allocator, removed);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_replay_clear(iso8583_replay_t *obj)
+{
+    /**
+     * @memberof iso8583_replay_t
+     * @brief Remove all entries.
+     *
+     * @param obj Object instance.
+     *
+     * @remarks Statistics are not reset.
+     */
+    assert( obj );
+
+    for(unsigned i=0; i<obj->nshards; ++i)
+    {
+        iso8583_replay_shard_t *shard = &obj->shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+
+        entry_t *removed = shard->oldest;
+        for(entry_t *entry = removed; entry; entry = entry->next)
+            entry->chain = entry->next;
+
+        memset(shard->buckets, 0, ( shard->bucketmask + 1 ) * sizeof(shard->buckets[0]));
+        shard->oldest = shard->newest = NULL;
+        shard->count  = 0;
+
+        pthread_mutex_unlock(&shard->lock);
+
+        free_entries(obj->allocator, removed);
+    }
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_replay_get_stats(const iso8583_replay_t *obj, iso8583_replay_stats_t *stats)
+{
+    /**
+     * @memberof iso8583_replay_t
+     * @brief Get statistics.
+     *
+     * @param obj   Object instance.
+     * @param stats Receives the statistics summed over all shards.
+     */
+    assert( obj && stats );
+
+    memset(stats, 0, sizeof(*stats));
+
+    for(unsigned i=0; i<obj->nshards; ++i)
+    {
+        iso8583_replay_shard_t *shard = &obj->shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+
+        stats->hits        += shard->hits;
+        stats->misses      += shard->misses;
+        stats->stores      += shard->stores;
+        stats->evictions   += shard->evictions;
+        stats->expirations += shard->expirations;
+        stats->count       += shard->count;
+
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
+//------------------------------------------------------------------------------
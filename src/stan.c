@@ -0,0 +1,277 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // For sched_getcpu.
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if   defined(__linux__)
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "helper.h"
+#include "memory.h"
+#include "stan.h"
+#include "stanshard.h"
+
+#define STAN_RANGE  ( ISO8583_STAN_MAX - ISO8583_STAN_MIN + 1 )
+#define OFFSET_BITS 16
+#define OFFSET_MASK ( ( 1 << OFFSET_BITS ) - 1 )
+
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_stan_init(iso8583_stan_t *obj, unsigned first, int flags)
+{
+    /**
+     * @memberof iso8583_stan_t
+     * @brief Constructor.
+     *
+     * @param obj   Object instance.
+     * @param first The first number to be allocated,
+     *              it can be used to continue the sequence after a restart.
+     * @param flags Allocator options, see ::iso8583_stan_flags_t for more information.
+     * @return An error code defined in ::iso8583_err_t.
+     */
+    assert( obj );
+
+    memset(obj, 0, sizeof(*obj));
+
+    if( first < ISO8583_STAN_MIN || ISO8583_STAN_MAX < first ) return ISO8583_ERR_INVALID_ARG;
+
+    obj->flags     = flags;
+    obj->base      = first - ISO8583_STAN_MIN;
+    obj->allocator = iso8583_allocator_get_default();
+
+    // All shards are marked as exhausted, so that they will reserve blocks on the first use.
+    for(int i=0; i<ISO8583_STAN_SHARDS; ++i)
+        obj->shards[i].word = ISO8583_STAN_BLOCK;
+
+    if( flags & ISO8583_STAN_TRACK_OUTSTANDING )
+    {
+        size_t words = ( ISO8583_STAN_MAX + 1 + 63 ) / 64;
+        obj->outstanding = mem_calloc(obj->allocator, words, sizeof(obj->outstanding[0]));
+        assert( obj->outstanding );
+    }
+
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_stan_deinit(iso8583_stan_t *obj)
+{
+    /**
+     * @memberof iso8583_stan_t
+     * @brief Destructor.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    if( obj->outstanding ) mem_free(obj->allocator, obj->outstanding);
+    obj->outstanding = NULL;
+}
+//------------------------------------------------------------------------------
+static
+unsigned current_cpu(void)
+{
+#if   defined(__linux__)
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : cpu;
+#elif defined(_WIN32)
+    return GetCurrentProcessorNumber();
+#else
+    return 0;
+#endif
+}
+//------------------------------------------------------------------------------
+static
+uint64_t next_seq_shared(iso8583_stan_t *obj)
+{
+    return __atomic_fetch_add(&obj->counter, 1, __ATOMIC_RELAXED);
+}
+//------------------------------------------------------------------------------
+static
+uint64_t word_to_seq(uint64_t word)
+{
+    return ( word >> OFFSET_BITS ) * ISO8583_STAN_BLOCK + ( word & OFFSET_MASK );
+}
+//------------------------------------------------------------------------------
+static
+bool is_stale(const iso8583_stan_t *obj, uint64_t seq)
+{
+    // A number is stale if the shared counter has wrapped past it,
+    // that is, a block of a later cycle which covers the same number has been reserved.
+    uint64_t next = __atomic_load_n(&obj->counter, __ATOMIC_RELAXED);
+    return ( seq + STAN_RANGE ) / ISO8583_STAN_BLOCK < next;
+}
+//------------------------------------------------------------------------------
+static
+void park_block(iso8583_stan_t *obj, unsigned home, uint64_t word)
+{
+    // Keep the rest of a block in the spare slot of its shard, or of any other shard,
+    // so that the numbers will not be skipped.
+    // They can only be skipped if more threads race to refill than there are shards.
+    if( ( word & OFFSET_MASK ) >= ISO8583_STAN_BLOCK ) return;
+
+    for(unsigned i=0; i<ISO8583_STAN_SHARDS; ++i)
+    {
+        uint64_t empty = 0;
+        iso8583_stan_shard_t *shard = &obj->shards[ ( home + i ) % ISO8583_STAN_SHARDS ];
+        if( __atomic_compare_exchange_n(&shard->spare, &empty, word, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+            return;
+    }
+}
+//------------------------------------------------------------------------------
+static
+uint64_t next_seq_on_shard(iso8583_stan_t *obj, unsigned index)
+{
+    iso8583_stan_shard_t *shard = &obj->shards[index];
+
+    uint64_t word = __atomic_load_n(&shard->word, __ATOMIC_RELAXED);
+    while( true )
+    {
+        uint64_t seq = word_to_seq(word);
+        if( ( word & OFFSET_MASK ) < ISO8583_STAN_BLOCK && !is_stale(obj, seq) )
+        {
+            if( __atomic_compare_exchange_n(&shard->word, &word, word + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+                return seq;
+            continue;
+        }
+
+        // The shard is exhausted, or its block is left stale while the shard is idle;
+        // refill it with the spare block, or with a newly reserved one.
+        uint64_t newword = __atomic_exchange_n(&shard->spare, 0, __ATOMIC_RELAXED);
+        if( !newword || is_stale(obj, word_to_seq(newword)) )
+            newword = __atomic_fetch_add(&obj->counter, 1, __ATOMIC_RELAXED) << OFFSET_BITS;
+
+        if( !__atomic_compare_exchange_n(&shard->word, &word, newword + 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+        {
+            // Another thread has refilled the shard first,
+            // the rest of the block we hold is kept as a spare one.
+            park_block(obj, index, newword + 1);
+        }
+
+        return word_to_seq(newword);
+    }
+}
+//------------------------------------------------------------------------------
+static
+uint64_t next_seq_sharded(iso8583_stan_t *obj)
+{
+    // The shard choice only affects contention, not correctness,
+    // so it is fine that the thread be migrated to another CPU in the middle.
+    return next_seq_on_shard(obj, current_cpu() % ISO8583_STAN_SHARDS);
+}
+//------------------------------------------------------------------------------
+static
+unsigned seq_to_stan(const iso8583_stan_t *obj, uint64_t seq)
+{
+    return ( obj->base + seq ) % STAN_RANGE + ISO8583_STAN_MIN;
+}
+//------------------------------------------------------------------------------
+static
+bool try_mark_outstanding(iso8583_stan_t *obj, unsigned stan)
+{
+    uint64_t mask = (uint64_t) 1 << ( stan & 63 );
+    uint64_t prev = __atomic_fetch_or(&obj->outstanding[ stan >> 6 ], mask, __ATOMIC_ACQ_REL);
+    return !( prev & mask );
+}
+//------------------------------------------------------------------------------
+unsigned ISO8583_CALL iso8583_stan_next(iso8583_stan_t *obj)
+{
+    /**
+     * @memberof iso8583_stan_t
+     * @brief Allocate a number.
+     *
+     * @param obj Object instance.
+     * @return The number in range 1 to 999999; or
+     *         ZERO if all numbers are outstanding.
+     *
+     * @remarks This function is thread safe.
+     */
+    assert( obj );
+
+    for(unsigned tries=0; tries<STAN_RANGE; ++tries)
+    {
+        uint64_t seq = ( obj->flags & ISO8583_STAN_SHARDED )?
+                       ( next_seq_sharded(obj) ):( next_seq_shared(obj) );
+        unsigned stan = seq_to_stan(obj, seq);
+
+        if( !obj->outstanding || try_mark_outstanding(obj, stan) )
+            return stan;
+    }
+
+    return 0;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_stan_release(iso8583_stan_t *obj, unsigned stan)
+{
+    /**
+     * @memberof iso8583_stan_t
+     * @brief Return a number which is no longer in use.
+     *
+     * @param obj  Object instance.
+     * @param stan The number to be returned.
+     *
+     * @remarks This function has no effect if
+     *          ::ISO8583_STAN_TRACK_OUTSTANDING is not enabled.
+     * @remarks This function is thread safe.
+     */
+    assert( obj );
+
+    if( !obj->outstanding ) return;
+    if( stan < ISO8583_STAN_MIN || ISO8583_STAN_MAX < stan ) return;
+
+    uint64_t mask = (uint64_t) 1 << ( stan & 63 );
+    __atomic_fetch_and(&obj->outstanding[ stan >> 6 ], ~mask, __ATOMIC_RELEASE);
+}
+//------------------------------------------------------------------------------
+unsigned ISO8583_CALL iso8583_stan_assign(iso8583_stan_t *obj, iso8583_fields_t *fields)
+{
+    /**
+     * @memberof iso8583_stan_t
+     * @brief Allocate a number and set it to field 11.
+     *
+     * @param obj    Object instance.
+     * @param fields The field item container to be set.
+     * @return The number allocated; or
+     *         ZERO if all numbers are outstanding, and the fields will not be changed.
+     */
+    assert( obj && fields );
+
+    unsigned stan = iso8583_stan_next(obj);
+    if( stan ) iso8583_helper_set_stan(fields, stan);
+
+    return stan;
+}
+//------------------------------------------------------------------------------
+bool ISO8583_CALL iso8583_stan_is_outstanding(const iso8583_stan_t *obj, unsigned stan)
+{
+    /**
+     * @memberof iso8583_stan_t
+     * @brief Check if a number is still in use.
+     *
+     * @param obj  Object instance.
+     * @param stan The number to be checked.
+     * @return TRUE if the number is allocated and not be released yet; and
+     *         FALSE if not, or ::ISO8583_STAN_TRACK_OUTSTANDING is not enabled.
+     */
+    assert( obj );
+
+    if( !obj->outstanding ) return false;
+    if( stan < ISO8583_STAN_MIN || ISO8583_STAN_MAX < stan ) return false;
+
+    uint64_t word = __atomic_load_n(&obj->outstanding[ stan >> 6 ], __ATOMIC_ACQUIRE);
+    return word & ( (uint64_t) 1 << ( stan & 63 ) );
+}
+//------------------------------------------------------------------------------
+#ifdef ISO8583_DEBUGTEST
+unsigned stanshard_next(iso8583_stan_t *obj, unsigned index)
+{
+    // Allocate a number from the specified shard, so that tests can keep other shards idle.
+    assert( obj && index < ISO8583_STAN_SHARDS );
+    return seq_to_stan(obj, next_seq_on_shard(obj, index));
+}
+//------------------------------------------------------------------------------
+#endif
@@ -0,0 +1,21 @@
+/*
+ * Per CPU shards of the STAN allocator.
+ */
+#ifndef _ISO8583_STANSHARD_H_
+#define _ISO8583_STANSHARD_H_
+
+#include "stan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef ISO8583_DEBUGTEST
+unsigned stanshard_next(iso8583_stan_t *obj, unsigned index);
+#endif
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif
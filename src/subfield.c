@@ -0,0 +1,461 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "errcode.h"
+#include "finfo.h"
+#include "subfield.h"
+
+#define SUBFIELD_TAG_MAX    4
+#define SUBFIELD_LEN_MAX    4
+#define SUBFIELD_DATA_MAX   0xFFFF
+#define SUBFIELD_FIELD_MAX  999  // Maximum payload size of all fields.
+
+//------------------------------------------------------------------------------
+static
+bool read_digits(const uint8_t *pos, unsigned count, size_t *value)
+{
+    size_t   result = 0;
+    unsigned bad    = 0;
+    for(unsigned i=0; i<count; ++i)
+    {
+        unsigned digit = pos[i] - '0';
+        bad |= digit > 9;
+        result = result * 10 + digit;
+    }
+
+    *value = result;
+    return !bad;
+}
+//------------------------------------------------------------------------------
+static
+void write_digits(uint8_t *pos, unsigned count, size_t value)
+{
+    for(unsigned i=count; i; --i)
+    {
+        pos[i-1] = '0' + value % 10;
+        value /= 10;
+    }
+}
+//------------------------------------------------------------------------------
+static
+size_t max_of_digits(unsigned count)
+{
+    size_t value = 1;
+    while( count-- ) value *= 10;
+
+    return value - 1;
+}
+//------------------------------------------------------------------------------
+static
+uint32_t pack_tag(const uint8_t *tag, unsigned size)
+{
+    uint32_t value = 0;
+    for(unsigned i=0; i<size; ++i)
+        value = value << 8 | tag[i];
+
+    return value;
+}
+//------------------------------------------------------------------------------
+static
+unsigned prefix_size(int mode)
+{
+    return mode == ISO8583_SUBFIELD_LLVAR  ? 2 :
+           mode == ISO8583_SUBFIELD_LLLVAR ? 3 : 0;
+}
+//------------------------------------------------------------------------------
+static
+bool spec_is_valid(const iso8583_subfield_spec_t *spec)
+{
+    switch( spec->layout )
+    {
+    case ISO8583_SUBFIELD_POSITIONAL :
+        return spec->defs && spec->count && spec->count <= ISO8583_SUBFIELD_MAX;
+
+    case ISO8583_SUBFIELD_TAGGED :
+        return 1 <= spec->tagsize && spec->tagsize <= SUBFIELD_TAG_MAX &&
+               1 <= spec->lensize && spec->lensize <= SUBFIELD_LEN_MAX;
+
+    default:
+        return false;
+    }
+}
+//------------------------------------------------------------------------------
+static
+int index_positional(iso8583_subfield_index_t *obj, const uint8_t *data, size_t size)
+{
+    const iso8583_subfield_spec_t *spec = obj->spec;
+
+    const uint8_t *end = data + size;
+    const uint8_t *pos = data;
+    for(unsigned i=0; i<spec->count && pos<end; ++i)
+    {
+        const iso8583_subfield_def_t *def = &spec->defs[i];
+
+        size_t   length  = def->maxsize;
+        unsigned hdrsize = prefix_size(def->mode);
+        if( hdrsize )
+        {
+            if( hdrsize > (size_t)( end - pos ) ) return ISO8583_ERR_SUBFIELD_FORMAT;
+            if( !read_digits(pos, hdrsize, &length) ) return ISO8583_ERR_SUBFIELD_FORMAT;
+            if( length > def->maxsize ) return ISO8583_ERR_SUBFIELD_FORMAT;
+            pos += hdrsize;
+        }
+
+        if( length > (size_t)( end - pos ) ) return ISO8583_ERR_SUBFIELD_FORMAT;
+
+        iso8583_subfield_entry_t *entry = &obj->entries[obj->count++];
+        entry->tag    = i + 1;
+        entry->offset = pos - data;
+        entry->length = length;
+
+        pos += length;
+    }
+
+    return pos == end ? ISO8583_ERR_SUCCESS : ISO8583_ERR_SUBFIELD_FORMAT;
+}
+//------------------------------------------------------------------------------
+static
+int index_tagged(iso8583_subfield_index_t *obj, const uint8_t *data, size_t size)
+{
+    const iso8583_subfield_spec_t *spec = obj->spec;
+
+    size_t hdrsize = spec->tagsize + spec->lensize;
+
+    const uint8_t *end = data + size;
+    const uint8_t *pos = data;
+    while( pos < end )
+    {
+        if( hdrsize > (size_t)( end - pos ) ) return ISO8583_ERR_SUBFIELD_FORMAT;
+
+        size_t length;
+        if( !read_digits(pos + spec->tagsize, spec->lensize, &length) ) return ISO8583_ERR_SUBFIELD_FORMAT;
+        if( length > (size_t)( end - pos ) - hdrsize ) return ISO8583_ERR_SUBFIELD_FORMAT;
+
+        if( obj->count >= ISO8583_SUBFIELD_MAX ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+
+        iso8583_subfield_entry_t *entry = &obj->entries[obj->count++];
+        entry->tag    = pack_tag(pos, spec->tagsize);
+        entry->offset = pos + hdrsize - data;
+        entry->length = length;
+
+        pos += hdrsize + length;
+    }
+
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_subfield_index_init(iso8583_subfield_index_t *obj)
+{
+    /**
+     * @memberof iso8583_subfield_index_t
+     * @brief Constructor.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    obj->data  = NULL;
+    obj->size  = 0;
+    obj->spec  = NULL;
+    obj->count = 0;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_subfield_index_build(iso8583_subfield_index_t      *obj,
+                                              const iso8583_subfield_spec_t *spec,
+                                              const void                    *data,
+                                              size_t                         size)
+{
+    /**
+     * @memberof iso8583_subfield_index_t
+     * @brief Build index of sub-fields.
+     * @details Parse the data in one pass and record location of each sub-field.
+     *
+     * @param obj  Object instance.
+     * @param spec Layout of the composite field, which must be kept until the index be no longer used.
+     * @param data Data of the composite field, which must be kept until the index be no longer used.
+     * @param size Size of the data.
+     * @return Count of sub-fields indexed if succeed; or
+     *         ISO8583_ERR_INVALID_ARG if the spec is not valid; or
+     *         ISO8583_ERR_SUBFIELD_FORMAT if the data does not match to the spec; or
+     *         ISO8583_ERR_BUF_NOT_ENOUGH if there have more than ::ISO8583_SUBFIELD_MAX sub-fields.
+     *         The index will be empty if failed.
+     */
+    assert( obj );
+
+    iso8583_subfield_index_init(obj);
+
+    if( !spec || !spec_is_valid(spec) ) return ISO8583_ERR_INVALID_ARG;
+    if( !data && size ) return ISO8583_ERR_INVALID_ARG;
+    if( size > SUBFIELD_DATA_MAX ) return ISO8583_ERR_SUBFIELD_FORMAT;
+
+    obj->spec = spec;
+
+    int err = spec->layout == ISO8583_SUBFIELD_POSITIONAL ?
+              index_positional(obj, data, size) :
+              index_tagged    (obj, data, size);
+    if( err )
+    {
+        obj->count = 0;
+        return err;
+    }
+
+    obj->data = data;
+    obj->size = size;
+
+    return obj->count;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_subfield_index_build_item(iso8583_subfield_index_t      *obj,
+                                                   const iso8583_subfield_spec_t *spec,
+                                                   const iso8583_fitem_t         *item)
+{
+    /**
+     * @memberof iso8583_subfield_index_t
+     * @brief Build index of sub-fields in the payload of a field item.
+     *
+     * @param obj  Object instance.
+     * @param spec Layout of the composite field, which must be kept until the index be no longer used.
+     * @param item The field item, which must not be modified until the index be no longer used.
+     * @return The same as ::iso8583_subfield_index_build.
+     */
+    assert( obj && item );
+
+    return iso8583_subfield_index_build(obj, spec, iso8583_fitem_get_data(item), iso8583_fitem_get_size(item));
+}
+//------------------------------------------------------------------------------
+unsigned ISO8583_CALL iso8583_subfield_index_get_count(const iso8583_subfield_index_t *obj)
+{
+    /**
+     * @memberof iso8583_subfield_index_t
+     * @brief Get count of sub-fields indexed.
+     *
+     * @param obj Object instance.
+     * @return Count of sub-fields.
+     */
+    assert( obj );
+
+    return obj->count;
+}
+//------------------------------------------------------------------------------
+const iso8583_subfield_entry_t* ISO8583_CALL iso8583_subfield_index_get_entry(const iso8583_subfield_index_t *obj, unsigned index)
+{
+    /**
+     * @memberof iso8583_subfield_index_t
+     * @brief Get a sub-field by its order in the data.
+     *
+     * @param obj   Object instance.
+     * @param index Index of the sub-field.
+     * @return The sub-field location if succeed; or NULL if index out of range.
+     */
+    assert( obj );
+
+    return index < obj->count ? &obj->entries[index] : NULL;
+}
+//------------------------------------------------------------------------------
+const void* ISO8583_CALL iso8583_subfield_index_get_value(const iso8583_subfield_index_t *obj, unsigned number, size_t *length)
+{
+    /**
+     * @memberof iso8583_subfield_index_t
+     * @brief Get value of a positional sub-field.
+     *
+     * @param obj    Object instance.
+     * @param number The sub-field number, start from 1.
+     * @param length Returns length of the value; and can be NULL if not needed.
+     * @return The value in the indexed data if the sub-field exists; or
+     *         NULL if the sub-field is absent, or the layout is not positional.
+     */
+    assert( obj );
+
+    bool found = obj->spec && obj->spec->layout == ISO8583_SUBFIELD_POSITIONAL &&
+                 1 <= number && number <= obj->count;
+
+    const iso8583_subfield_entry_t *entry = found ? &obj->entries[number-1] : NULL;
+    if( length ) *length = entry ? entry->length : 0;
+
+    return entry ? obj->data + entry->offset : NULL;
+}
+//------------------------------------------------------------------------------
+const void* ISO8583_CALL iso8583_subfield_index_find(const iso8583_subfield_index_t *obj, const char *tag, size_t *length)
+{
+    /**
+     * @memberof iso8583_subfield_index_t
+     * @brief Get value of a tagged sub-field.
+     *
+     * @param obj    Object instance.
+     * @param tag    The tag, which must have the same characters count as the spec defined.
+     * @param length Returns length of the value; and can be NULL if not needed.
+     * @return The value of the first sub-field with the tag if found; or
+     *         NULL if not found, or the layout is not tagged.
+     */
+    assert( obj );
+
+    const iso8583_subfield_entry_t *entry = NULL;
+    if( tag && obj->spec && obj->spec->layout == ISO8583_SUBFIELD_TAGGED &&
+        strlen(tag) == obj->spec->tagsize )
+    {
+        uint32_t key = pack_tag((const uint8_t*) tag, obj->spec->tagsize);
+        for(unsigned i=0; i<obj->count && !entry; ++i)
+        {
+            if( obj->entries[i].tag == key )
+                entry = &obj->entries[i];
+        }
+    }
+
+    if( length ) *length = entry ? entry->length : 0;
+
+    return entry ? obj->data + entry->offset : NULL;
+}
+//------------------------------------------------------------------------------
+static
+int measure_positional(const iso8583_subfield_spec_t *spec, const iso8583_subfield_t *subs, unsigned count, size_t *total)
+{
+    if( count > spec->count ) return ISO8583_ERR_INVALID_ARG;
+
+    size_t sum = 0;
+    for(unsigned i=0; i<count; ++i)
+    {
+        const iso8583_subfield_def_t *def = &spec->defs[i];
+
+        unsigned hdrsize = prefix_size(def->mode);
+        if( hdrsize )
+        {
+            if( subs[i].size > def->maxsize || subs[i].size > max_of_digits(hdrsize) )
+                return ISO8583_ERR_LVAR_TOO_LONG;
+        }
+        else
+        {
+            if( subs[i].size != def->maxsize ) return ISO8583_ERR_FIELD_SIZE_ERROR;
+        }
+
+        sum += hdrsize + subs[i].size;
+    }
+
+    *total = sum;
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+static
+int measure_tagged(const iso8583_subfield_spec_t *spec, const iso8583_subfield_t *subs, unsigned count, size_t *total)
+{
+    size_t maxlen = max_of_digits(spec->lensize);
+
+    size_t sum = 0;
+    for(unsigned i=0; i<count; ++i)
+    {
+        if( !subs[i].tag || strlen(subs[i].tag) != spec->tagsize ) return ISO8583_ERR_INVALID_ARG;
+        if( subs[i].size > maxlen ) return ISO8583_ERR_LVAR_TOO_LONG;
+
+        sum += spec->tagsize + spec->lensize + subs[i].size;
+    }
+
+    *total = sum;
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+static
+void write_subfields(uint8_t *pos, const iso8583_subfield_spec_t *spec, const iso8583_subfield_t *subs, unsigned count)
+{
+    for(unsigned i=0; i<count; ++i)
+    {
+        if( spec->layout == ISO8583_SUBFIELD_POSITIONAL )
+        {
+            unsigned hdrsize = prefix_size(spec->defs[i].mode);
+            write_digits(pos, hdrsize, subs[i].size);
+            pos += hdrsize;
+        }
+        else
+        {
+            memcpy(pos, subs[i].tag, spec->tagsize);
+            write_digits(pos + spec->tagsize, spec->lensize, subs[i].size);
+            pos += spec->tagsize + spec->lensize;
+        }
+
+        if( subs[i].size ) memcpy(pos, subs[i].data, subs[i].size);
+        pos += subs[i].size;
+    }
+}
+//------------------------------------------------------------------------------
+static
+bool subfields_alias(const iso8583_subfield_t *subs, unsigned count, const iso8583_fitem_t *item)
+{
+    if( !item ) return false;
+
+    uintptr_t begin = (uintptr_t) iso8583_fitem_get_data(item);
+    uintptr_t end   = begin + iso8583_fitem_get_size(item);
+    for(unsigned i=0; i<count; ++i)
+    {
+        uintptr_t data = (uintptr_t) subs[i].data;
+        if( subs[i].size && data < end && begin < data + subs[i].size ) return true;
+    }
+
+    return false;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_subfield_encode(const iso8583_subfield_spec_t *spec,
+                                         iso8583_fields_t              *fields,
+                                         int                            id,
+                                         const iso8583_subfield_t      *subs,
+                                         unsigned                       count)
+{
+    /**
+     * @brief Encode sub-fields to a composite field.
+     * @details Sizes of all sub-fields are checked first,
+     *          and then the sub-fields are written to the buffer of the field item directly,
+     *          so that no temporary buffer or string slicing is needed.
+     *          Sub-field values may refer to the current data of the same field
+     *          (such as values taken from an index built over it, to modify one sub-field of them),
+     *          in that case the field is assembled in a scratch buffer first.
+     *
+     * @param spec   Layout of the composite field.
+     * @param fields The fields object to be set.
+     * @param id     The field ID.
+     * @param subs   Values of sub-fields.
+     *               For the positional layout, the values are in order of the sub-field definitions,
+     *               and the trailing sub-fields which are not given will be absent.
+     * @param count  Count of sub-field values.
+     * @return Size of the field data if succeed; or
+     *         ISO8583_ERR_INVALID_ARG if the spec or any tag is not valid; or
+     *         ISO8583_ERR_INVALID_FIELD_ID if the field ID is not valid; or
+     *         ISO8583_ERR_FIELD_SIZE_ERROR if size of a fixed length sub-field not match to its definition; or
+     *         ISO8583_ERR_LVAR_TOO_LONG if a variable length sub-field is too long,
+     *         or the whole data is longer than the maximum size of the field.
+     *         The field will not be modified if failed.
+     */
+    assert( fields );
+
+    if( !spec || !spec_is_valid(spec) || ( !subs && count ) ) return ISO8583_ERR_INVALID_ARG;
+    if( id < ISO8583_FITEM_ID_MIN || ISO8583_FITEM_ID_MAX < id || id == ISO8583_FITEM_ID_TERTIARY )
+        return ISO8583_ERR_INVALID_FIELD_ID;
+
+    for(unsigned i=0; i<count; ++i)
+    {
+        if( !subs[i].data && subs[i].size ) return ISO8583_ERR_INVALID_ARG;
+    }
+
+    size_t total;
+    int    err = spec->layout == ISO8583_SUBFIELD_POSITIONAL ?
+                 measure_positional(spec, subs, count, &total) :
+                 measure_tagged    (spec, subs, count, &total);
+    if( err ) return err;
+
+    const finfo_t *finfo   = &finfo_list[id];
+    size_t         maxsize = finfo_get_size(finfo);
+    if( finfo->lenmode == FINFO_LEN_FIXED && total != maxsize ) return ISO8583_ERR_FIELD_SIZE_ERROR;
+    if( total > maxsize ) return ISO8583_ERR_LVAR_TOO_LONG;
+    assert( total <= SUBFIELD_FIELD_MAX );
+
+    if( subfields_alias(subs, count, iso8583_fields_get_item(fields, id)) )
+    {
+        uint8_t scratch[SUBFIELD_FIELD_MAX];
+        write_subfields(scratch, spec, subs, count);
+        iso8583_fields_set_data(fields, id, scratch, total);
+    }
+    else
+    {
+        write_subfields(iso8583_fields_resize_data(fields, id, total), spec, subs, count);
+    }
+
+    return total;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,69 @@
+#include <assert.h>
+#include "template.h"
+
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_template_init(iso8583_template_t *obj, const iso8583_t *msg)
+{
+    /**
+     * @memberof iso8583_template_t
+     * @brief Constructor.
+     *
+     * @param obj Object instance.
+     * @param msg The message to be copied as the template.
+     */
+    assert( obj && msg );
+
+    iso8583_init_clone(&obj->msg, msg);
+    iso8583_fields_shrink(&obj->msg.fields);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_template_deinit(iso8583_template_t *obj)
+{
+    /**
+     * @memberof iso8583_template_t
+     * @brief Destructor.
+     *
+     * @param obj Object instance.
+     *
+     * @remarks Messages derived from the template will be invalid after this call,
+     *          unless they are cleared or derived from another template before.
+     */
+    assert( obj );
+    iso8583_deinit(&obj->msg);
+}
+//------------------------------------------------------------------------------
+const iso8583_t* ISO8583_CALL iso8583_template_get_message(const iso8583_template_t *obj)
+{
+    /**
+     * @memberof iso8583_template_t
+     * @brief Get the template message.
+     *
+     * @param obj Object instance.
+     * @return The message, which is read only.
+     */
+    assert( obj );
+    return &obj->msg;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_template_derive(const iso8583_template_t *obj, iso8583_t *msg)
+{
+    /**
+     * @memberof iso8583_template_t
+     * @brief Reset a message to the values of the template.
+     *
+     * @param obj Object instance.
+     * @param msg The message to be reset.
+     *            All its values are replaced by the ones of the template,
+     *            and the field payloads of the template are shared but not copied.
+     *
+     * @remarks Buffers of the message are kept for later use,
+     *          so that deriving a reused message and then overriding some fields of it
+     *          will not allocate, if the buffers are large enough.
+     */
+    assert( obj && msg );
+
+    msg->tpdu = obj->msg.tpdu;
+    msg->mti  = obj->msg.mti;
+    iso8583_fields_share(&msg->fields, &obj->msg.fields);
+}
+//------------------------------------------------------------------------------
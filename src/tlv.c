@@ -0,0 +1,482 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include "errcode.h"
+#include "tlv.h"
+
+#define TLV_TAG_MAX_BYTES   4
+#define TLV_LEN_MAX_BYTES   4
+#define TLV_VALUE_MAX       0xFFFF
+
+//------------------------------------------------------------------------------
+static
+size_t read_tag(const uint8_t *pos, const uint8_t *end, uint32_t *tag)
+{
+    /*
+     * The tag has subsequent bytes if all the tag number bits of the first byte are set,
+     * and each subsequent byte with bit 8 set is followed by another one.
+     */
+    uint32_t value = *pos;
+    size_t   count = 1;
+
+    if( ( value & 0x1F ) == 0x1F )
+    {
+        uint8_t byte;
+        do
+        {
+            if( count >= TLV_TAG_MAX_BYTES || pos + count >= end ) return 0;
+
+            byte  = pos[count++];
+            value = value << 8 | byte;
+        } while( byte & 0x80 );
+    }
+
+    *tag = value;
+    return count;
+}
+//------------------------------------------------------------------------------
+static
+size_t read_length(const uint8_t *pos, const uint8_t *end, size_t *length)
+{
+    /*
+     * Short form of one byte for lengths up to 127,
+     * or long form of 0x81 to 0x84 followed by the length bytes.
+     * The indefinite form (0x80) is not allowed.
+     */
+    if( pos >= end ) return 0;
+
+    if( !( *pos & 0x80 ) )
+    {
+        *length = *pos;
+        return 1;
+    }
+
+    size_t count = *pos & 0x7F;
+    if( !count || count > TLV_LEN_MAX_BYTES || (size_t)( end - pos ) <= count ) return 0;
+
+    size_t value = 0;
+    for(size_t i=1; i<=count; ++i)
+        value = value << 8 | pos[i];
+
+    *length = value;
+    return count + 1;
+}
+//------------------------------------------------------------------------------
+static
+size_t tag_size(uint32_t tag)
+{
+    return tag > 0xFFFFFF ? 4 :
+           tag > 0xFFFF   ? 3 :
+           tag > 0xFF     ? 2 : 1;
+}
+//------------------------------------------------------------------------------
+static
+size_t length_size(size_t length)
+{
+    return length < 0x80 ? 1 :
+           length > 0xFF ? 3 : 2;
+}
+//------------------------------------------------------------------------------
+static
+void write_tag(uint8_t *buf, uint32_t tag, size_t size)
+{
+    for(size_t i=size; i; --i)
+    {
+        buf[i-1] = tag;
+        tag >>= 8;
+    }
+}
+//------------------------------------------------------------------------------
+static
+void write_length(uint8_t *buf, size_t length, size_t size)
+{
+    if( size == 1 )
+    {
+        buf[0] = length;
+        return;
+    }
+
+    buf[0] = 0x80 | ( size - 1 );
+    for(size_t i=size-1; i; --i)
+    {
+        buf[i] = length;
+        length >>= 8;
+    }
+}
+//------------------------------------------------------------------------------
+static
+int index_entries(iso8583_tlv_index_t *obj, const uint8_t *data, size_t size)
+{
+    const uint8_t *begin = data;
+    const uint8_t *end   = begin + size;
+    const uint8_t *pos   = begin;
+    while( pos < end )
+    {
+        if( *pos == 0x00 || *pos == 0xFF )
+        {
+            ++pos;
+            continue;
+        }
+
+        uint32_t tag;
+        size_t   tagsize = read_tag(pos, end, &tag);
+        if( !tagsize ) return ISO8583_ERR_TLV_FORMAT;
+        pos += tagsize;
+
+        size_t length;
+        size_t lensize = read_length(pos, end, &length);
+        if( !lensize ) return ISO8583_ERR_TLV_FORMAT;
+        pos += lensize;
+
+        if( length > (size_t)( end - pos ) ) return ISO8583_ERR_TLV_FORMAT;
+
+        if( obj->count >= ISO8583_TLV_INDEX_MAX ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+
+        iso8583_tlv_entry_t *entry = &obj->entries[obj->count++];
+        entry->tag    = tag;
+        entry->offset = pos - begin;
+        entry->length = length;
+
+        pos += length;
+    }
+
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_tlv_index_init(iso8583_tlv_index_t *obj)
+{
+    /**
+     * @memberof iso8583_tlv_index_t
+     * @brief Constructor.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    obj->data  = NULL;
+    obj->size  = 0;
+    obj->count = 0;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_tlv_index_build(iso8583_tlv_index_t *obj, const void *data, size_t size)
+{
+    /**
+     * @memberof iso8583_tlv_index_t
+     * @brief Build index of TLV data objects.
+     * @details Parse the data in one pass and record tag and location of each data object,
+     *          tags and lengths of multiple bytes are supported,
+     *          and padding bytes (0x00 or 0xFF) between data objects are skipped.
+     *
+     * @param obj  Object instance.
+     * @param data The TLV data, which must be kept until the index be no longer used.
+     * @param size Size of the TLV data.
+     * @return Count of data objects indexed if succeed; or
+     *         ISO8583_ERR_TLV_FORMAT if the data is not well formed; or
+     *         ISO8583_ERR_BUF_NOT_ENOUGH if there have more than ::ISO8583_TLV_INDEX_MAX data objects.
+     *         The index will be empty if failed.
+     */
+    assert( obj );
+
+    iso8583_tlv_index_init(obj);
+
+    if( !data && size ) return ISO8583_ERR_INVALID_ARG;
+    if( size > TLV_VALUE_MAX ) return ISO8583_ERR_TLV_FORMAT;
+
+    int err = index_entries(obj, data, size);
+    if( err )
+    {
+        obj->count = 0;
+        return err;
+    }
+
+    obj->data = data;
+    obj->size = size;
+
+    return obj->count;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_tlv_index_build_item(iso8583_tlv_index_t *obj, const iso8583_fitem_t *item)
+{
+    /**
+     * @memberof iso8583_tlv_index_t
+     * @brief Build index of TLV data objects in the payload of a field item.
+     *
+     * @param obj  Object instance.
+     * @param item The field item, such as field 55, which must not be modified
+     *             until the index be no longer used.
+     * @return The same as ::iso8583_tlv_index_build.
+     */
+    assert( obj && item );
+
+    return iso8583_tlv_index_build(obj, iso8583_fitem_get_data(item), iso8583_fitem_get_size(item));
+}
+//------------------------------------------------------------------------------
+unsigned ISO8583_CALL iso8583_tlv_index_get_count(const iso8583_tlv_index_t *obj)
+{
+    /**
+     * @memberof iso8583_tlv_index_t
+     * @brief Get count of data objects indexed.
+     *
+     * @param obj Object instance.
+     * @return Count of data objects.
+     */
+    assert( obj );
+
+    return obj->count;
+}
+//------------------------------------------------------------------------------
+const iso8583_tlv_entry_t* ISO8583_CALL iso8583_tlv_index_get_entry(const iso8583_tlv_index_t *obj, unsigned index)
+{
+    /**
+     * @memberof iso8583_tlv_index_t
+     * @brief Get a data object by its order in the data.
+     *
+     * @param obj   Object instance.
+     * @param index Index of the data object.
+     * @return The data object location if succeed; or NULL if index out of range.
+     */
+    assert( obj );
+
+    return index < obj->count ? &obj->entries[index] : NULL;
+}
+//------------------------------------------------------------------------------
+const iso8583_tlv_entry_t* ISO8583_CALL iso8583_tlv_index_find(const iso8583_tlv_index_t *obj, uint32_t tag)
+{
+    /**
+     * @memberof iso8583_tlv_index_t
+     * @brief Find a data object by tag.
+     *
+     * @param obj Object instance.
+     * @param tag The tag to find, such as 0x9F26.
+     * @return The location of the first data object with the tag if found; or
+     *         NULL if not found.
+     */
+    assert( obj );
+
+    for(unsigned i=0; i<obj->count; ++i)
+    {
+        if( obj->entries[i].tag == tag )
+            return &obj->entries[i];
+    }
+
+    return NULL;
+}
+//------------------------------------------------------------------------------
+const void* ISO8583_CALL iso8583_tlv_index_get_value(const iso8583_tlv_index_t *obj, uint32_t tag, size_t *length)
+{
+    /**
+     * @memberof iso8583_tlv_index_t
+     * @brief Get value of a data object by tag.
+     *
+     * @param obj    Object instance.
+     * @param tag    The tag to find, such as 0x9F26.
+     * @param length Returns length of the value; and can be NULL if not needed.
+     * @return The value in the indexed data if found; or
+     *         NULL if not found.
+     */
+    assert( obj );
+
+    const iso8583_tlv_entry_t *entry = iso8583_tlv_index_find(obj, tag);
+    if( length ) *length = entry ? entry->length : 0;
+
+    return entry ? obj->data + entry->offset : NULL;
+}
+//------------------------------------------------------------------------------
+static
+bool builder_reserve(iso8583_tlv_builder_t *obj, size_t size)
+{
+    if( obj->err ) return false;
+
+    if( size > obj->size - obj->pos )
+    {
+        obj->err = ISO8583_ERR_BUF_NOT_ENOUGH;
+        return false;
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_tlv_builder_init(iso8583_tlv_builder_t *obj, void *buf, size_t size)
+{
+    /**
+     * @memberof iso8583_tlv_builder_t
+     * @brief Constructor.
+     *
+     * @param obj  Object instance.
+     * @param buf  The buffer to receive the encoded data.
+     * @param size Size of the buffer.
+     */
+    assert( obj );
+
+    obj->buf  = buf;
+    obj->size = buf ? size : 0;
+    iso8583_tlv_builder_reset(obj);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_tlv_builder_reset(iso8583_tlv_builder_t *obj)
+{
+    /**
+     * @memberof iso8583_tlv_builder_t
+     * @brief Clear all data and errors, and restart from the beginning of the buffer.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    obj->pos   = 0;
+    obj->err   = ISO8583_ERR_SUCCESS;
+    obj->depth = 0;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_tlv_builder_add(iso8583_tlv_builder_t *obj, uint32_t tag, const void *value, size_t length)
+{
+    /**
+     * @memberof iso8583_tlv_builder_t
+     * @brief Add a primitive data object.
+     *
+     * @param obj    Object instance.
+     * @param tag    The tag, such as 0x9F26.
+     * @param value  The value.
+     * @param length Length of the value, up to 65535.
+     * @return ISO8583_ERR_SUCCESS if succeed; or
+     *         the error code of this or any previous operation.
+     */
+    assert( obj );
+
+    if( obj->err ) return obj->err;
+
+    if( !tag || length > TLV_VALUE_MAX || ( !value && length ) )
+        return obj->err = ISO8583_ERR_INVALID_ARG;
+
+    size_t tagsize = tag_size(tag);
+    size_t lensize = length_size(length);
+    if( !builder_reserve(obj, tagsize + lensize + length) ) return obj->err;
+
+    uint8_t *pos = obj->buf + obj->pos;
+    write_tag(pos, tag, tagsize);
+    write_length(pos + tagsize, length, lensize);
+    if( length ) memcpy(pos + tagsize + lensize, value, length);
+
+    obj->pos += tagsize + lensize + length;
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_tlv_builder_begin(iso8583_tlv_builder_t *obj, uint32_t tag)
+{
+    /**
+     * @memberof iso8583_tlv_builder_t
+     * @brief Begin a constructed data object,
+     *        and data objects added after this call are its value,
+     *        until ::iso8583_tlv_builder_end be called.
+     *
+     * @param obj Object instance.
+     * @param tag The tag, which must be of a constructed data object, such as 0x70.
+     * @return ISO8583_ERR_SUCCESS if succeed; or
+     *         the error code of this or any previous operation.
+     *
+     * @remarks The nesting depth is limited to ::ISO8583_TLV_DEPTH_MAX.
+     */
+    assert( obj );
+
+    if( obj->err ) return obj->err;
+
+    size_t tagsize = tag_size(tag);
+    if( !tag || !( ( tag >> 8*( tagsize - 1 ) ) & 0x20 ) || obj->depth >= ISO8583_TLV_DEPTH_MAX )
+        return obj->err = ISO8583_ERR_INVALID_ARG;
+
+    // The length is reserved as one byte, and be expanded at the end if needed.
+    if( !builder_reserve(obj, tagsize + 1) ) return obj->err;
+
+    write_tag(obj->buf + obj->pos, tag, tagsize);
+    obj->pos += tagsize;
+
+    obj->starts[obj->depth++] = obj->pos++;
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_tlv_builder_end(iso8583_tlv_builder_t *obj)
+{
+    /**
+     * @memberof iso8583_tlv_builder_t
+     * @brief End the constructed data object begun by the last ::iso8583_tlv_builder_begin.
+     *
+     * @param obj Object instance.
+     * @return ISO8583_ERR_SUCCESS if succeed; or
+     *         the error code of this or any previous operation.
+     */
+    assert( obj );
+
+    if( obj->err ) return obj->err;
+    if( !obj->depth ) return obj->err = ISO8583_ERR_INVALID_ARG;
+
+    size_t lenpos = obj->starts[--obj->depth];
+    size_t length = obj->pos - lenpos - 1;
+    if( length > TLV_VALUE_MAX ) return obj->err = ISO8583_ERR_INVALID_ARG;
+
+    size_t lensize = length_size(length);
+    if( lensize > 1 )
+    {
+        if( !builder_reserve(obj, lensize - 1) ) return obj->err;
+
+        memmove(obj->buf + lenpos + lensize, obj->buf + lenpos + 1, length);
+        obj->pos += lensize - 1;
+    }
+
+    write_length(obj->buf + lenpos, length, lensize);
+    return ISO8583_ERR_SUCCESS;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_tlv_builder_finish(const iso8583_tlv_builder_t *obj)
+{
+    /**
+     * @memberof iso8583_tlv_builder_t
+     * @brief Check result of the building.
+     *
+     * @param obj Object instance.
+     * @return Size of the encoded data if succeed; or
+     *         the error code of the first failed operation; or
+     *         ISO8583_ERR_INVALID_ARG if there have constructed data objects not be ended.
+     */
+    assert( obj );
+
+    if( obj->err ) return obj->err;
+    if( obj->depth ) return ISO8583_ERR_INVALID_ARG;
+
+    return obj->pos;
+}
+//------------------------------------------------------------------------------
+const void* ISO8583_CALL iso8583_tlv_builder_get_data(const iso8583_tlv_builder_t *obj)
+{
+    /**
+     * @memberof iso8583_tlv_builder_t
+     * @brief Get the encoded data, which is the buffer given by the user.
+     *
+     * @param obj Object instance.
+     * @return The encoded data.
+     */
+    assert( obj );
+
+    return obj->buf;
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_tlv_builder_commit(const iso8583_tlv_builder_t *obj, iso8583_fields_t *fields, int id)
+{
+    /**
+     * @memberof iso8583_tlv_builder_t
+     * @brief Set the encoded data to a field, such as field 55 of a response.
+     *
+     * @param obj    Object instance.
+     * @param fields The fields object to be set.
+     * @param id     The field ID.
+     * @return ISO8583_ERR_SUCCESS if succeed; or
+     *         the error code of the building (see ::iso8583_tlv_builder_finish); or
+     *         the error code of setting the field.
+     */
+    assert( obj && fields );
+
+    int size = iso8583_tlv_builder_finish(obj);
+    if( size < 0 ) return size;
+
+    return iso8583_fields_set_data(fields, id, obj->buf, size);
+}
+//------------------------------------------------------------------------------
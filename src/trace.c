@@ -0,0 +1,423 @@
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "finfo.h"
+#include "errcode.h"
+#include "tracepoint.h"
+#include "trace.h"
+
+/*
+ * The callback and its argument are published as one immutable pair,
+ * so that the tracing threads never see a callback with the argument of another one.
+ * Tracing threads are counted in one of two reader counters selected by the epoch,
+ * and the pair replaced is released only after all threads which may still use it left
+ * (the epoch is flipped twice and both counters are drained in turn).
+ */
+typedef struct trace_hook_t
+{
+    iso8583_on_trace_t  on_trace;
+    void               *userarg;
+} trace_hook_t;
+
+static trace_hook_t    *hook       = NULL;
+static unsigned         epoch      = 0;
+static unsigned         readers[2] = { 0, 0 };
+static pthread_mutex_t  hook_lock  = PTHREAD_MUTEX_INITIALIZER;
+
+//------------------------------------------------------------------------------
+bool ISO8583_CALL iso8583_trace_is_enabled(void)
+{
+    /**
+     * @brief Check if the library is built with tracing points.
+     *
+     * @return TRUE if the library is built with ISO8583_ENABLE_TRACE defined;
+     *         and FALSE if not, the trace hook will never be called in that case.
+     */
+#ifdef ISO8583_ENABLE_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+//------------------------------------------------------------------------------
+static
+void wait_for_readers(void)
+{
+    for(int phase=0; phase<2; ++phase)
+    {
+        unsigned prev = __atomic_fetch_add(&epoch, 1, __ATOMIC_SEQ_CST);
+        while( __atomic_load_n(&readers[ prev & 1 ], __ATOMIC_SEQ_CST) )
+            sched_yield();
+    }
+}
+//------------------------------------------------------------------------------
+static
+void replace_hook(iso8583_on_trace_t on_trace, void *userarg, const trace_hook_t *expected)
+{
+    // Replace the hook only if it is the expected one (when given).
+    trace_hook_t *pair = NULL;
+    if( on_trace )
+    {
+        pair = malloc(sizeof(*pair));
+        assert( pair );
+        pair->on_trace = on_trace;
+        pair->userarg  = userarg;
+    }
+
+    pthread_mutex_lock(&hook_lock);
+
+    trace_hook_t *old = hook;
+    if( expected &&
+        !( old && old->on_trace == expected->on_trace && old->userarg == expected->userarg ) )
+    {
+        pthread_mutex_unlock(&hook_lock);
+        free(pair);
+        return;
+    }
+
+    __atomic_store_n(&hook, pair, __ATOMIC_SEQ_CST);
+    wait_for_readers();
+
+    pthread_mutex_unlock(&hook_lock);
+
+    free(old);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_trace_set_hook(iso8583_on_trace_t on_trace, void *userarg)
+{
+    /**
+     * @brief Set the process wide trace hook.
+     *
+     * @param on_trace The callback which will be called after each field item
+     *                 be encoded or decoded; or NULL to stop tracing.
+     * @param userarg  A user defined argument that will be passed to the callback.
+     *
+     * @remarks The function returns after all calls of the previous callback finished,
+     *          so that its argument can be released then.
+     *          It must not be called by the callback itself.
+     * @remarks The callback may be called by multiple threads at the same time.
+     */
+    replace_hook(on_trace, userarg, NULL);
+}
+//------------------------------------------------------------------------------
+#ifdef ISO8583_ENABLE_TRACE
+void trace_emit(int dir, int id, size_t bytes, uint64_t cycles)
+{
+    if( !__atomic_load_n(&hook, __ATOMIC_RELAXED) ) return;
+
+    unsigned side = __atomic_load_n(&epoch, __ATOMIC_SEQ_CST) & 1;
+    __atomic_fetch_add(&readers[side], 1, __ATOMIC_SEQ_CST);
+
+    const trace_hook_t *pair = __atomic_load_n(&hook, __ATOMIC_SEQ_CST);
+    if( pair ) pair->on_trace(pair->userarg, dir, id, bytes, cycles);
+
+    __atomic_fetch_sub(&readers[side], 1, __ATOMIC_RELEASE);
+}
+#endif
+//------------------------------------------------------------------------------
+static
+int eletype_to_index(finfo_eletype_t eletype)
+{
+    switch( eletype )
+    {
+    case FINFO_ELE_A   : return 0;
+    case FINFO_ELE_N   : return 1;
+    case FINFO_ELE_S   : return 2;
+    case FINFO_ELE_AN  : return 3;
+    case FINFO_ELE_AS  : return 4;
+    case FINFO_ELE_NS  : return 5;
+    case FINFO_ELE_ANS : return 6;
+    case FINFO_ELE_B   : return 7;
+    case FINFO_ELE_Z   : return 8;
+    case FINFO_ELE_PAN : return 9;
+    case FINFO_ELE_BIN : return 10;
+    default            : return -1;
+    }
+}
+//------------------------------------------------------------------------------
+const char* ISO8583_CALL iso8583_trace_get_field_type(int id)
+{
+    /**
+     * @brief Get type name of a field.
+     *
+     * @param id The field ID.
+     * @return The type name, which is composed of the element type and the length mode,
+     *         such as "n fixed", "pan LLVAR", or "ans LLLVAR";
+     *         or NULL if the field ID is invalid.
+     */
+    static const char *names[][3] =
+    {
+        // FINFO_LEN_FIXED  FINFO_LEN_LLVAR  FINFO_LEN_LLLVAR
+        { "a fixed"  , "a LLVAR"  , "a LLLVAR"   },
+        { "n fixed"  , "n LLVAR"  , "n LLLVAR"   },
+        { "s fixed"  , "s LLVAR"  , "s LLLVAR"   },
+        { "an fixed" , "an LLVAR" , "an LLLVAR"  },
+        { "as fixed" , "as LLVAR" , "as LLLVAR"  },
+        { "ns fixed" , "ns LLVAR" , "ns LLLVAR"  },
+        { "ans fixed", "ans LLVAR", "ans LLLVAR" },
+        { "b fixed"  , "b LLVAR"  , "b LLLVAR"   },
+        { "z fixed"  , "z LLVAR"  , "z LLLVAR"   },
+        { "pan fixed", "pan LLVAR", "pan LLLVAR" },
+        { "bin fixed", "bin LLVAR", "bin LLLVAR" },
+    };
+
+    if( id < ISO8583_FITEM_ID_MIN || ISO8583_FITEM_ID_MAX < id ) return NULL;
+
+    int index = eletype_to_index(finfo_list[id].eletype);
+    assert( index >= 0 );
+
+    return names[index][ finfo_list[id].lenmode ];
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_profiler_init(iso8583_profiler_t *obj)
+{
+    /**
+     * @memberof iso8583_profiler_t
+     * @brief Constructor.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+    memset(obj, 0, sizeof(*obj));
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_profiler_reset(iso8583_profiler_t *obj)
+{
+    /**
+     * @memberof iso8583_profiler_t
+     * @brief Clear all aggregated records.
+     *
+     * @param obj Object instance.
+     */
+    assert( obj );
+
+    for(int dir=0; dir<ISO8583_TRACE_DIRS; ++dir)
+    {
+        for(int id=0; id<=ISO8583_FITEM_ID_MAX; ++id)
+        {
+            iso8583_profile_entry_t *entry = &obj->fields[dir][id];
+            __atomic_store_n(&entry->calls , 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&entry->bytes , 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&entry->cycles, 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+static
+void profiler_on_trace(void *userarg, int dir, int id, size_t bytes, uint64_t cycles)
+{
+    iso8583_profiler_record(userarg, dir, id, bytes, cycles);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_profiler_attach(iso8583_profiler_t *obj)
+{
+    /**
+     * @memberof iso8583_profiler_t
+     * @brief Set the profiler as the process wide trace hook.
+     *
+     * @param obj Object instance.
+     *
+     * @remarks The profiler must be detached before it is destroyed.
+     * @see ::iso8583_trace_set_hook
+     */
+    assert( obj );
+    iso8583_trace_set_hook(profiler_on_trace, obj);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_profiler_detach(iso8583_profiler_t *obj)
+{
+    /**
+     * @memberof iso8583_profiler_t
+     * @brief Remove the profiler from the trace hook.
+     *
+     * @param obj Object instance.
+     *
+     * @remarks The trace hook will not be changed
+     *          if it was set to another callback or profiler after this one attached.
+     *          Otherwise, the profiler will not be used by any thread after the function returns.
+     */
+    assert( obj );
+
+    const trace_hook_t self = { profiler_on_trace, obj };
+    replace_hook(NULL, NULL, &self);
+}
+//------------------------------------------------------------------------------
+void ISO8583_CALL iso8583_profiler_record(iso8583_profiler_t *obj, int dir, int id, size_t bytes, uint64_t cycles)
+{
+    /**
+     * @memberof iso8583_profiler_t
+     * @brief Aggregate a trace record.
+     *
+     * @param obj    Object instance.
+     * @param dir    Direction of the operation, see ::iso8583_trace_dir_t.
+     * @param id     The field ID.
+     * @param bytes  Size of the encoded field data.
+     * @param cycles Cost of the operation.
+     *
+     * @remarks Records with invalid direction or field ID will be ignored.
+     */
+    assert( obj );
+
+    if( dir < 0 || ISO8583_TRACE_DIRS <= dir ) return;
+    if( id < ISO8583_FITEM_ID_MIN || ISO8583_FITEM_ID_MAX < id ) return;
+
+    iso8583_profile_entry_t *entry = &obj->fields[dir][id];
+    __atomic_fetch_add(&entry->calls , 1     , __ATOMIC_RELAXED);
+    __atomic_fetch_add(&entry->bytes , bytes , __ATOMIC_RELAXED);
+    __atomic_fetch_add(&entry->cycles, cycles, __ATOMIC_RELAXED);
+}
+//------------------------------------------------------------------------------
+iso8583_profile_entry_t ISO8583_CALL iso8583_profiler_get_field(const iso8583_profiler_t *obj, int dir, int id)
+{
+    /**
+     * @memberof iso8583_profiler_t
+     * @brief Get aggregated cost of a field.
+     *
+     * @param obj Object instance.
+     * @param dir Direction of operations, see ::iso8583_trace_dir_t.
+     * @param id  The field ID.
+     * @return The aggregated cost; or all zeros if the direction or field ID is invalid.
+     */
+    assert( obj );
+
+    iso8583_profile_entry_t res = { 0, 0, 0 };
+
+    if( dir < 0 || ISO8583_TRACE_DIRS <= dir ) return res;
+    if( id < ISO8583_FITEM_ID_MIN || ISO8583_FITEM_ID_MAX < id ) return res;
+
+    const iso8583_profile_entry_t *entry = &obj->fields[dir][id];
+    res.calls  = __atomic_load_n(&entry->calls , __ATOMIC_RELAXED);
+    res.bytes  = __atomic_load_n(&entry->bytes , __ATOMIC_RELAXED);
+    res.cycles = __atomic_load_n(&entry->cycles, __ATOMIC_RELAXED);
+
+    return res;
+}
+//------------------------------------------------------------------------------
+iso8583_profile_entry_t ISO8583_CALL iso8583_profiler_get_type(const iso8583_profiler_t *obj, int dir, const char *type)
+{
+    /**
+     * @memberof iso8583_profiler_t
+     * @brief Get aggregated cost of all fields of a type.
+     *
+     * @param obj  Object instance.
+     * @param dir  Direction of operations, see ::iso8583_trace_dir_t.
+     * @param type The type name, see ::iso8583_trace_get_field_type.
+     * @return The aggregated cost; or all zeros if no field matches.
+     */
+    assert( obj );
+
+    iso8583_profile_entry_t res = { 0, 0, 0 };
+    if( !type ) return res;
+
+    for(int id=ISO8583_FITEM_ID_MIN; id<=ISO8583_FITEM_ID_MAX; ++id)
+    {
+        if( strcmp(type, iso8583_trace_get_field_type(id)) ) continue;
+
+        iso8583_profile_entry_t entry = iso8583_profiler_get_field(obj, dir, id);
+        res.calls  += entry.calls;
+        res.bytes  += entry.bytes;
+        res.cycles += entry.cycles;
+    }
+
+    return res;
+}
+//------------------------------------------------------------------------------
+static
+int print_entry(char *buf, size_t size, const char *dirname, const char *name, iso8583_profile_entry_t entry, uint64_t total)
+{
+    return snprintf(buf,
+                    size,
+                    "%s %-14s calls=%llu bytes=%llu cycles=%llu cycles/call=%.0f share=%.1f%%\n",
+                    dirname,
+                    name,
+                    (unsigned long long) entry.calls,
+                    (unsigned long long) entry.bytes,
+                    (unsigned long long) entry.cycles,
+                    (double) entry.cycles / entry.calls,
+                    total ? 100.0 * entry.cycles / total : 0.0);
+}
+//------------------------------------------------------------------------------
+int ISO8583_CALL iso8583_profiler_export(const iso8583_profiler_t *obj, char *buf, size_t size)
+{
+    /**
+     * @memberof iso8583_profiler_t
+     * @brief Export a text report.
+     * @details The report lists the cost of each field which has records,
+     *          and then the cost of each field type, such as: @n
+     *          "decode field 55     calls=<n> bytes=<n> cycles=<n> cycles/call=<n> share=<n>%" @n
+     *          "decode ans LLLVAR   calls=<n> bytes=<n> cycles=<n> cycles/call=<n> share=<n>%" @n
+     *          where the share is the percentage of cycles of all fields in the same direction.
+     *
+     * @param obj  Object instance.
+     * @param buf  The output buffer.
+     * @param size Size of the output buffer.
+     *
+     * @retval Positive Length of the report (including zero), not including the null terminator.
+     * @retval Negative An error code indicates that an error occurred during the process,
+     *         see ::iso8583_err_t for more information.
+     */
+    assert( obj );
+
+    static const char *dirnames[ISO8583_TRACE_DIRS] = { "encode", "decode" };
+
+    if( !buf || !size ) return ISO8583_ERR_INVALID_ARG;
+
+    buf[0] = 0;
+    size_t len = 0;
+
+    for(int dir=0; dir<ISO8583_TRACE_DIRS; ++dir)
+    {
+        iso8583_profile_entry_t entries[1+ISO8583_FITEM_ID_MAX];
+        uint64_t total = 0;
+        for(int id=ISO8583_FITEM_ID_MIN; id<=ISO8583_FITEM_ID_MAX; ++id)
+        {
+            entries[id] = iso8583_profiler_get_field(obj, dir, id);
+            total += entries[id].cycles;
+        }
+
+        // Fields.
+        for(int id=ISO8583_FITEM_ID_MIN; id<=ISO8583_FITEM_ID_MAX; ++id)
+        {
+            if( !entries[id].calls ) continue;
+
+            char name[16];
+            snprintf(name, sizeof(name), "field %d", id);
+
+            int linelen = print_entry(buf+len, size-len, dirnames[dir], name, entries[id], total);
+            if( linelen < 0 || size - len <= linelen ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+            len += linelen;
+        }
+
+        // Field types, each type is reported at its first field.
+        for(int id=ISO8583_FITEM_ID_MIN; id<=ISO8583_FITEM_ID_MAX; ++id)
+        {
+            const char *type = iso8583_trace_get_field_type(id);
+
+            bool reported = false;
+            for(int prev=ISO8583_FITEM_ID_MIN; prev<id && !reported; ++prev)
+                reported = !strcmp(type, iso8583_trace_get_field_type(prev));
+            if( reported ) continue;
+
+            iso8583_profile_entry_t entry = { 0, 0, 0 };
+            for(int other=id; other<=ISO8583_FITEM_ID_MAX; ++other)
+            {
+                if( strcmp(type, iso8583_trace_get_field_type(other)) ) continue;
+
+                entry.calls  += entries[other].calls;
+                entry.bytes  += entries[other].bytes;
+                entry.cycles += entries[other].cycles;
+            }
+            if( !entry.calls ) continue;
+
+            int linelen = print_entry(buf+len, size-len, dirnames[dir], type, entry, total);
+            if( linelen < 0 || size - len <= linelen ) return ISO8583_ERR_BUF_NOT_ENOUGH;
+            len += linelen;
+        }
+    }
+
+    return len;
+}
+//------------------------------------------------------------------------------
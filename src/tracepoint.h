@@ -0,0 +1,53 @@
+/*
+ * Codec tracing points.
+ *
+ * The tracing points compile to nothing
+ * unless the library is built with ISO8583_ENABLE_TRACE defined.
+ */
+#ifndef _ISO8583_TRACEPOINT_H_
+#define _ISO8583_TRACEPOINT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ISO8583_ENABLE_TRACE
+
+#include "trace.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include "monoclock.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void trace_emit(int dir, int id, size_t bytes, uint64_t cycles);
+
+static inline
+uint64_t trace_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return monoclock_ns();
+#endif
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#define TRACE_BEGIN(since)                 uint64_t since = trace_cycles()
+#define TRACE_END(dir, id, bytes, since)   trace_emit(dir, id, bytes, trace_cycles() - (since))
+
+#else
+
+#define TRACE_BEGIN(since)
+#define TRACE_END(dir, id, bytes, since)
+
+#endif  // ISO8583_ENABLE_TRACE
+
+#endif
@@ -1,10 +1,24 @@
 #include <assert.h>
 #include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <type_traits>
+#include <vector>
 #include <gen/bufstm.h>
 #include "iso8583/internal_test.h"
+#include "iso8583/allocator.h"
 #include "iso8583/iso8583.h"
 #include "iso8583/helper.h"
 #include "iso8583/exchange.h"
+#include "iso8583/queue.h"
+#include "iso8583/pool.h"
+#include "iso8583/stan.h"
+#include "iso8583/decoder.h"
+#include "iso8583/trace.h"
+#include "iso8583/template.h"
+#include "iso8583/replay.h"
+#include "iso8583/dispatch.h"
 
 #ifndef ISO8583_DEBUGTEST
     #error This test program needs to work with ISO8583_DEBUGTEST defined!
@@ -244,6 +258,29 @@ void test_helper_tools()
         assert(    777 == ISO8583::helper::GetInteger(fields, 4, 777) );
     }
 
+    // Digits and BCD conversion test.
+    {
+        fields.Clear();
+
+        assert( ISO8583::helper::SetInteger(fields, 4 , 1250) );
+        assert( ISO8583::helper::SetInteger(fields, 22, 51) );
+        assert( "000000001250" == ISO8583::helper::GetDigits(fields, 4 ) );
+        assert( "051"          == ISO8583::helper::GetDigits(fields, 22) );
+        assert( ""             == ISO8583::helper::GetDigits(fields, 5 ) );
+
+        char str[32];
+        assert( 12 == iso8583_helper_bcd_to_ascii(str, sizeof(str), "\x00\x00\x00\x00\x12\x50", 6) );
+        assert( 0  == strcmp(str, "000000001250") );
+        assert( 0  == iso8583_helper_bcd_to_ascii(str, 12, "\x00\x00\x00\x00\x12\x50", 6) );
+
+        uint8_t bcd[16];
+        assert( 10 == iso8583_helper_ascii_to_bcd(bcd, sizeof(bcd), "4761739001010010999") );
+        assert( 0  == memcmp(bcd, "\x04\x76\x17\x39\x00\x10\x10\x01\x09\x99", 10) );
+        assert( 4761739001010010999ULL == iso8583_helper_bcd_to_int(bcd, 10) );
+        assert( 0  == iso8583_helper_ascii_to_bcd(bcd, sizeof(bcd), "12A4") );
+        assert( 0  == iso8583_helper_ascii_to_bcd(bcd, 1, "1234") );
+    }
+
     // String value read write test.
     {
         fields.Clear();
@@ -284,6 +321,46 @@ void test_helper_tools()
         assert( 135792 == ISO8583::helper::GetPAN(fields) );
     }
 
+    // PAN read write test - case 3 (19 digits, which overflows if multiplied by ten).
+    {
+        fields.Clear();
+
+        assert( ISO8583::helper::SetPAN(fields, 9999999999999999999ULL) );
+
+        assert( ( item = fields.GetItem(2) ) != fields.npos() );
+        assert( item.GetSize() == 10 );
+        assert( 0 == memcmp(item.GetData(), "\x99\x99\x99\x99\x99\x99\x99\x99\x99\x9F", 10) );
+
+        assert( 9999999999999999999ULL == ISO8583::helper::GetPAN(fields) );
+        assert( "9999999999999999999" == ISO8583::helper::GetPANString(fields) );
+    }
+
+    // PAN string read write test.
+    {
+        fields.Clear();
+
+        assert( ISO8583::helper::SetPANString(fields, "0004761739001010010") );
+
+        assert( ( item = fields.GetItem(2) ) != fields.npos() );
+        assert( item.GetSize() == 10 );
+        assert( 0 == memcmp(item.GetData(), "\x00\x04\x76\x17\x39\x00\x10\x10\x01\x0F", 10) );
+
+        assert( "0004761739001010010" == ISO8583::helper::GetPANString(fields) );
+        assert( 4761739001010010ULL == ISO8583::helper::GetPAN(fields) );
+
+        assert( ISO8583::helper::SetPANString(fields, "4761739001010010") );
+        assert( fields.GetItem(2).GetSize() == 8 );
+        assert( "4761739001010010" == ISO8583::helper::GetPANString(fields) );
+
+        assert( !ISO8583::helper::SetPANString(fields, "") );
+        assert( !ISO8583::helper::SetPANString(fields, "47617390010100101234") );
+        assert( !ISO8583::helper::SetPANString(fields, "476173900101001X") );
+        assert( "4761739001010010" == ISO8583::helper::GetPANString(fields) );
+
+        assert( iso8583_helper_set_bin(fields.cptr(), 2, "\x47\xF6", 2) );
+        assert( "" == ISO8583::helper::GetPANString(fields) );
+    }
+
     // Set local time test.
     {
         fields.Clear();
@@ -360,6 +437,1584 @@ void test_exchange()
         assert( msg.GetMTI() == sample_msg.GetMTI() );
         assert( ISO8583::helper::GetSTAN(msg.Fields()) == ISO8583::helper::GetSTAN(sample_msg.Fields()) );
     }
+
+    // Receive from user buffer test.
+    {
+        uint8_t stream[2*1024];
+        memcpy(stream            , sample_bin, sample_size);
+        memcpy(stream+sample_size, sample_bin, sample_size);
+
+        ISO8583::TExchange exg(flags, NULL, NULL, NULL);
+
+        assert( 0           == ISO8583::TExchange::PeekFrame(stream, 1) );
+        assert( sample_size == ISO8583::TExchange::PeekFrame(stream, 2) );
+
+        ISO8583::TISO8583 msg;
+        assert( 0 == exg.RecvFrame(msg, stream, sample_size-1) );
+
+        size_t pos = 0;
+        for(int i=0; i<2; ++i)
+        {
+            int readsz = exg.RecvFrame(msg, stream+pos, 2*sample_size-pos);
+            assert( readsz == sample_size );
+            pos += readsz;
+
+            assert( msg.GetMTI() == sample_msg.GetMTI() );
+            assert( ISO8583::helper::GetSTAN(msg.Fields()) == ISO8583::helper::GetSTAN(sample_msg.Fields()) );
+        }
+        assert( 0 == exg.RecvFrame(msg, stream+pos, 2*sample_size-pos) );
+    }
+}
+
+void test_queue()
+{
+    static const int modes[] = { ISO8583_QUEUE_SPSC, ISO8583_QUEUE_MPMC };
+
+    for(int mode : modes)
+    {
+        ISO8583::TQueue queue(3, mode);
+        assert( queue.GetCapacity() == 4 );
+
+        ISO8583::TISO8583 msgs[5];
+        assert( queue.Pop() == NULL );
+
+        for(int i=0; i<4; ++i)
+            assert( queue.Push(&msgs[i]) );
+        assert( !queue.Push(&msgs[4]) );
+        assert( queue.GetCount() == 4 );
+
+        // Run several laps to verify the wrap around.
+        for(int lap=0; lap<3; ++lap)
+        {
+            for(int i=0; i<4; ++i)
+            {
+                assert( queue.Pop() == &msgs[i] );
+                assert( queue.Push(&msgs[i]) );
+            }
+        }
+
+        for(int i=0; i<4; ++i)
+            assert( queue.Pop() == &msgs[i] );
+        assert( queue.Pop() == NULL );
+        assert( queue.GetCount() == 0 );
+    }
+
+    // Capacities which would overflow the cell array are rejected.
+    {
+        int err = 0;
+        ISO8583::TQueue queue(SIZE_MAX / 2, ISO8583_QUEUE_MPMC, &err);
+        assert( err == ISO8583_ERR_INVALID_ARG );
+        assert( queue.GetCapacity() == 0 );
+
+        ISO8583::TISO8583 msg;
+        assert( !queue.Push(&msg) );
+        assert( queue.Pop() == NULL );
+
+        ISO8583::TQueue small(3, ISO8583_QUEUE_SPSC, &err);
+        assert( err == ISO8583_ERR_SUCCESS && small.GetCapacity() == 4 );
+    }
+}
+
+void test_pool()
+{
+    ISO8583::TPool pool(4);
+    assert( pool.GetCount()     == 4 );
+    assert( pool.GetAvailable() == 4 );
+
+    // Acquire and release test.
+    {
+        ISO8583::TISO8583 *msgs[4];
+        for(int i=0; i<4; ++i)
+            assert( ( msgs[i] = pool.Acquire() ) );
+        assert( pool.Acquire() == NULL );
+
+        msgs[0]->SetMTI(0x0200);
+        ISO8583::helper::SetSTAN(msgs[0]->Fields(), 123456);
+
+        for(int i=0; i<4; ++i)
+            pool.Release(msgs[i]);
+        assert( pool.GetAvailable() == 4 );
+
+        // Messages must be cleared when they are back.
+        for(int i=0; i<4; ++i)
+        {
+            msgs[i] = pool.Acquire();
+            assert( msgs[i]->GetMTI() == 0 );
+            assert( msgs[i]->Fields().GetCount() == 0 );
+        }
+        for(int i=0; i<4; ++i)
+            pool.Release(msgs[i]);
+    }
+
+    // Smart pointer test.
+    {
+        {
+            ISO8583::TPool::TPtr msg = pool.AcquirePtr();
+            assert( msg );
+            assert( pool.GetAvailable() == 3 );
+        }
+        assert( pool.GetAvailable() == 4 );
+    }
+
+    // Thread cache test.
+    {
+        {
+            ISO8583::TPoolCache cache(pool);
+
+            ISO8583::TISO8583 *msg = cache.Acquire();
+            assert( msg );
+            assert( pool.GetAvailable() == 0 );
+
+            cache.Release(msg);
+            assert( pool.GetAvailable() == 0 );
+        }
+        assert( pool.GetAvailable() == 4 );
+    }
+
+    // Steady state test: once the buffers of all messages have grown,
+    // processing messages from the pool makes no more heap calls.
+    {
+        ISO8583::TISO8583 sample;
+        sample.SetMTI(0x0200);
+        ISO8583::helper::SetPAN (sample.Fields(), 4761739001010010ULL);
+        ISO8583::helper::SetSTAN(sample.Fields(), 123456);
+        assert( 0 == sample.Fields().SetData(41, "TERM0001", 8) );
+
+        uint8_t buf[256];
+        int     size = sample.Encode(buf, sizeof(buf), 0);
+        assert( size > 0 );
+
+        ISO8583::TCountingAllocator counter;
+        iso8583_allocator_set_default(counter.GetInterface());
+        ISO8583::TPool      counted(4);
+        ISO8583::TPoolCache cache(counted);
+        iso8583_allocator_set_default(NULL);
+
+        {
+            ISO8583::TPoolCache::TPtr msgs[4];
+            for(auto &msg : msgs)
+            {
+                msg = cache.AcquirePtr();
+                assert( size == msg->Decode(buf, size, 0) );
+            }
+        }
+
+        counter.ResetStats();
+        for(int i=0; i<100; ++i)
+        {
+            ISO8583::TPoolCache::TPtr msg = cache.AcquirePtr();
+            assert( size == msg->Decode(buf, size, 0) );
+            assert( msg->Equal(sample) );
+        }
+
+        iso8583_alloc_stats_t stats = counter.GetStats();
+        assert( stats.allocs == 0 && stats.reallocs == 0 && stats.frees == 0 );
+    }
+
+    // Construction with a specific allocator.
+    {
+        ISO8583::TCountingAllocator counter;
+        {
+            ISO8583::TISO8583 msg(counter.GetInterface());
+            ISO8583::helper::SetSTAN(msg.Fields(), 123456);
+            assert( counter.GetStats().allocs + counter.GetStats().reallocs == 1 );
+        }
+        assert( counter.GetStats().frees == 1 );
+    }
+}
+
+void test_buffer_reuse()
+{
+    static const char data[] = "1234567890";
+
+    // Field item test.
+    {
+        ISO8583::TFitem item(2, data, 10);
+        assert( item.GetSize() == 10 && item.GetCapacity() == 10 );
+
+        item.Clear();
+        assert( item.GetSize() == 0 && item.GetCapacity() == 10 );
+        assert( item.GetData() == NULL );
+
+        item.SetData(data, 4);
+        assert( item.GetSize() == 4 && item.GetCapacity() == 10 );
+        assert( 0 == memcmp(item.GetData(), data, 4) );
+
+        item.Shrink();
+        assert( item.GetSize() == 4 && item.GetCapacity() == 4 );
+        assert( 0 == memcmp(item.GetData(), data, 4) );
+
+        item.Clear();
+        item.Shrink();
+        assert( item.GetCapacity() == 0 );
+    }
+
+    // Field container test.
+    {
+        ISO8583::TFields fields;
+        assert( 0 == fields.SetData(41, "TERM0001", 8) );
+        assert( 0 == fields.SetData(41, "TERM0002", 8) );
+        assert( fields.GetCount() == 1 );
+        assert( 0 == memcmp(fields.GetItem(41).GetData(), "TERM0002", 8) );
+        assert( fields.SetData(0, data, 1) == ISO8583_ERR_INVALID_FIELD_ID );
+
+        const void *buf = fields.GetItem(41).GetData();
+        fields.Clear();
+        assert( fields.GetCount() == 0 );
+        assert( &fields.GetItem(41) == &ISO8583::TFields::npos() );
+
+        // The same buffer will be used again.
+        assert( 0 == fields.SetData(41, "TERM0003", 8) );
+        assert( fields.GetItem(41).GetData() == buf );
+
+        fields.Erase(41);
+        fields.Shrink();
+        assert( fields.GetCount() == 0 );
+    }
+}
+
+void test_stan()
+{
+    // Sequential allocation and wrap around test.
+    {
+        ISO8583::TSTAN stan(999998);
+        assert( stan.Next() == 999998 );
+        assert( stan.Next() == 999999 );
+        assert( stan.Next() == 1 );
+        assert( stan.Next() == 2 );
+
+        ISO8583::TFields fields;
+        assert( stan.Assign(fields) == 3 );
+        assert( ISO8583::helper::GetSTAN(fields) == 3 );
+    }
+
+    // Sharded allocation test.
+    {
+        ISO8583::TSTAN stan(1, ISO8583_STAN_SHARDED);
+
+        static bool used[ISO8583_STAN_MAX+1];
+        memset(used, 0, sizeof(used));
+        for(int i=0; i<4*ISO8583_STAN_BLOCK; ++i)
+        {
+            unsigned num = stan.Next();
+            assert( ISO8583_STAN_MIN <= num && num <= ISO8583_STAN_MAX );
+            assert( !used[num] );
+            used[num] = true;
+        }
+    }
+
+    // Outstanding numbers test.
+    {
+        ISO8583::TSTAN stan(999999, ISO8583_STAN_TRACK_OUTSTANDING);
+
+        unsigned held = stan.Next();
+        assert( held == 999999 );
+        assert( stan.IsOutstanding(held) );
+
+        // Go through the whole range, the number still in use must be skipped.
+        for(unsigned i=1; i<ISO8583_STAN_MAX; ++i)
+        {
+            unsigned num = stan.Next();
+            assert( num == i );
+            stan.Release(num);
+        }
+        assert( stan.Next() == 1 );
+        stan.Release(1);
+
+        stan.Release(held);
+        assert( !stan.IsOutstanding(held) );
+    }
+}
+
+struct test_decoder_result
+{
+    std::vector<unsigned> stans;
+    std::atomic<size_t>   next;  // Messages are delivered by multiple threads in the unordered mode.
+    std::atomic<int>      errors;
+    bool                  ordered;
+
+    void operator()(size_t index, const ISO8583::TISO8583 &msg, int errcode)
+    {
+        if( ordered ) assert( index == next );
+        ++next;
+
+        if( errcode )
+            ++errors;
+        else
+            stans[index] = ISO8583::helper::GetSTAN(msg.Fields());
+    }
+};
+
+void test_decoder()
+{
+    static const unsigned count = 3*ISO8583_DECODER_WINDOW + 100;
+    int flags = ISO8583_FLAG_HAVE_SIZEHDR | ISO8583_FLAG_LVAR_COMPRESSED;
+
+    std::vector<uint8_t> stream;
+    for(unsigned i=0; i<count; ++i)
+    {
+        ISO8583::TISO8583 msg;
+        msg.SetMTI(0x0200);
+        ISO8583::helper::SetSTAN(msg.Fields(), i+1);
+
+        uint8_t buf[256];
+        int size = msg.Encode(buf, sizeof(buf), flags);
+        assert( size > 0 );
+        stream.insert(stream.end(), buf, buf+size);
+    }
+
+    for(int mode=0; mode<2; ++mode)
+    {
+        ISO8583::TDecoder decoder(3, flags, mode ? ISO8583_DECODER_ORDERED : 0);
+        assert( decoder.GetThreads() == 3 );
+
+        // Decode all frames.
+        test_decoder_result result;
+        result.stans.assign(count, 0);
+        result.next    = 0;
+        result.ordered = mode;
+        result.errors  = 0;
+
+        assert( ISO8583_ERR_SUCCESS == decoder.Run(stream.data(), stream.size(), result) );
+        assert( result.next == count );
+        assert( result.errors == 0 );
+        for(unsigned i=0; i<count; ++i)
+            assert( result.stans[i] == i+1 );
+
+        // Truncated stream test.
+        result.stans.assign(count, 0);
+        result.next = 0;
+
+        assert( ISO8583_ERR_BUF_NOT_ENOUGH == decoder.Run(stream.data(), stream.size()-1, result) );
+        assert( result.next == count-1 );
+        assert( result.stans[count-2] == count-1 );
+    }
+}
+
+void test_allocator()
+{
+    int flags = ISO8583_FLAG_HAVE_SIZEHDR | ISO8583_FLAG_LVAR_COMPRESSED;
+
+    uint8_t buf[256];
+    int     size;
+    {
+        ISO8583::TISO8583 msg;
+        msg.SetMTI(0x0200);
+        ISO8583::helper::SetSTAN(msg.Fields(), 123456);
+        assert( 0 == msg.Fields().SetData(41, "TERM0001", 8) );
+
+        size = msg.Encode(buf, sizeof(buf), flags);
+        assert( size > 0 );
+    }
+
+    // Per message allocator test.
+    {
+        ISO8583::TCountingAllocator counter;
+        ISO8583::TISO8583 msg;
+        msg.SetAllocator(counter.GetInterface());
+
+        assert( size == msg.Decode(buf, size, flags) );
+        iso8583_alloc_stats_t stats = counter.GetStats();
+        assert( stats.allocs + stats.reallocs == 2 );
+        assert( stats.frees == 0 );
+
+        // Buffers are reused, no more allocations.
+        counter.ResetStats();
+        assert( size == msg.Decode(buf, size, flags) );
+        stats = counter.GetStats();
+        assert( stats.allocs + stats.reallocs == 0 );
+
+        // Buffers are moved back to the default allocator.
+        msg.SetAllocator(NULL);
+        stats = counter.GetStats();
+        assert( stats.frees == 2 );
+        assert( ISO8583::helper::GetSTAN(msg.Fields()) == 123456 );
+    }
+
+    // Default allocator test.
+    {
+        ISO8583::TCountingAllocator counter;
+        ISO8583::TISO8583 before;
+
+        iso8583_allocator_set_default(counter.GetInterface());
+        assert( iso8583_allocator_get_default() == counter.GetInterface() );
+        {
+            ISO8583::TISO8583 after;
+            assert( size == after.Decode(buf, size, flags) );
+        }
+        iso8583_allocator_set_default(NULL);
+        assert( iso8583_allocator_get_default() == iso8583_allocator_get_libc() );
+
+        // Objects constructed before keep their allocator.
+        assert( size == before.Decode(buf, size, flags) );
+
+        iso8583_alloc_stats_t stats = counter.GetStats();
+        assert( stats.allocs + stats.reallocs == 2 );
+        assert( stats.frees == 2 );
+    }
+
+    // Buffers of erased items are still released with the container,
+    // including the items above 128, and the allocator is the one at construction.
+    {
+        ISO8583::TCountingAllocator counter;
+        iso8583_allocator_set_default(counter.GetInterface());
+        {
+            ISO8583::TFields fields;
+            iso8583_allocator_set_default(NULL);
+
+            assert( 0 == fields.SetData( 41, "TERM0001", 8) );
+            assert( 0 == fields.SetData(150, "\x01\x02", 2) );
+            fields.Erase(41);
+            fields.Erase(150);
+            assert( counter.GetStats().allocs + counter.GetStats().reallocs == 2 );
+        }
+        assert( counter.GetStats().frees == 2 );
+    }
+
+    // Other objects are also released by the allocator at construction.
+    {
+        ISO8583::TCountingAllocator counter;
+        iso8583_allocator_set_default(counter.GetInterface());
+        {
+            ISO8583::TQueue       queue (4, ISO8583_QUEUE_MPMC);
+            ISO8583::TPool        pool  (2);
+            ISO8583::TSTAN        stan  (1, ISO8583_STAN_TRACK_OUTSTANDING);
+            ISO8583::TReplayCache replay(16, ISO8583::TFieldMask(), 0);
+            iso8583_allocator_set_default(NULL);
+
+            assert( counter.GetStats().allocs > 0 );
+            assert( counter.GetStats().frees == 0 );
+        }
+        iso8583_alloc_stats_t stats = counter.GetStats();
+        assert( stats.allocs == stats.frees );
+    }
+
+    // Sizes which overflow are rejected rather than allocated.
+    {
+        iso8583_pool_t pool;
+        assert( ISO8583_ERR_INVALID_ARG == iso8583_pool_init(&pool, SIZE_MAX / 2) );
+        iso8583_pool_deinit(&pool);
+
+        ISO8583::TFieldMask mask;
+        iso8583_replay_t replay;
+        assert( ISO8583_ERR_INVALID_ARG == iso8583_replay_init(&replay, SIZE_MAX, mask.cptr(), 0) );
+        iso8583_replay_deinit(&replay);
+    }
+}
+
+void test_exchange_stats()
+{
+    // Histogram test.
+    {
+        ISO8583::THistogram hist;
+        assert( hist.GetCount() == 0 && hist.GetPercentile(50) == 0 );
+
+        for(uint64_t value=1; value<=1000; ++value)
+            hist.Record(1000*value);
+
+        assert( hist.GetCount() == 1000 );
+        assert( hist.GetMin() == 1000 && hist.GetMax() == 1000000 );
+        assert( hist.GetMean() == 500500 );
+
+        // Values are in the precision of 1/32.
+        uint64_t p50 = hist.GetPercentile(50);
+        uint64_t p99 = hist.GetPercentile(99);
+        assert( 500000 <= p50 && p50 <= 500000 + 500000/32 );
+        assert( 990000 <= p99 && p99 <= 990000 + 990000/32 );
+        assert( hist.GetPercentile(100) == 1000000 );
+        assert( 1000 <= hist.GetPercentile(0) && hist.GetPercentile(0) <= 1000 + 1000/32 );
+
+        // Small values are exact.
+        hist.Reset();
+        for(uint64_t value=0; value<64; ++value)
+            hist.Record(value);
+        assert( hist.GetPercentile(50) == 31 && hist.GetMin() == 0 );
+
+        // Huge values are limited.
+        hist.Record(UINT64_MAX);
+        assert( hist.GetMax() == UINT64_MAX && hist.GetPercentile(100) == UINT64_MAX );
+    }
+
+    // Exchange stages test.
+    {
+        int flags = ISO8583_FLAG_HAVE_SIZEHDR | ISO8583_FLAG_LVAR_COMPRESSED;
+
+        ISO8583::TISO8583 sample_msg;
+        sample_msg.SetMTI(0x0800);
+        ISO8583::helper::SetSTAN(sample_msg.Fields(), 7);
+
+        uint8_t buf[1024];
+        ISO8583::TExgStats stats;
+
+        bufostm_t ostream;
+        bufostm_init(&ostream, buf, sizeof(buf));
+        ISO8583::TExchange sender(flags,
+                                  &ostream,
+                                  (int(*)(void*,const void*,size_t)) test_exchange_on_send,
+                                  NULL);
+        sender.SetStats(&stats);
+
+        for(int i=0; i<3; ++i)
+            assert( ISO8583_ERR_SUCCESS == sender.Send(sample_msg, 3*1000) );
+
+        bufistm_t istream;
+        bufistm_init(&istream, buf, bufostm_get_datasize(&ostream));
+        ISO8583::TExchange receiver(flags,
+                                    &istream,
+                                    NULL,
+                                    (int(*)(void*,void*,size_t)) test_exchange_on_recv);
+        receiver.SetStats(&stats);
+
+        ISO8583::TISO8583 msg;
+        for(int i=0; i<3; ++i)
+            assert( ISO8583_ERR_SUCCESS == receiver.Recv(msg, 3*1000) );
+
+        // Failed operations are not recorded.
+        assert( ISO8583_ERR_SUCCESS != receiver.Recv(msg, 10) );
+
+        assert( stats.Snapshot(ISO8583_EXG_STAGE_ENCODE).GetCount() == 3 );
+        assert( stats.Snapshot(ISO8583_EXG_STAGE_SEND  ).GetCount() == 3 );
+        assert( stats.Snapshot(ISO8583_EXG_STAGE_WAIT  ).GetCount() == 3 );
+        assert( stats.Snapshot(ISO8583_EXG_STAGE_DECODE).GetCount() == 3 );
+        assert( stats.Snapshot(ISO8583_EXG_STAGE_DECODE).GetMax() > 0 );
+
+        char report[512];
+        int len = stats.Export(report, sizeof(report));
+        assert( len > 0 && len == (int)strlen(report) );
+        assert( 0 == strncmp(report, "encode count=3 ", 15) );
+        assert( strstr(report, "\ndecode count=3 ") );
+        assert( ISO8583_ERR_BUF_NOT_ENOUGH == stats.Export(report, 16) );
+
+        stats.Reset();
+        assert( stats.Snapshot(ISO8583_EXG_STAGE_ENCODE).GetCount() == 0 );
+
+        // Nothing is recorded after detached.
+        sender.SetStats(NULL);
+        bufostm_init(&ostream, buf, sizeof(buf));
+        assert( ISO8583_ERR_SUCCESS == sender.Send(sample_msg, 3*1000) );
+        assert( stats.Snapshot(ISO8583_EXG_STAGE_ENCODE).GetCount() == 0 );
+    }
+}
+
+void test_trace()
+{
+    // Field type test.
+    assert( 0 == strcmp(iso8583_trace_get_field_type(2 ), "pan LLVAR") );
+    assert( 0 == strcmp(iso8583_trace_get_field_type(11), "n fixed") );
+    assert( 0 == strcmp(iso8583_trace_get_field_type(55), "bin LLLVAR") );
+    assert( iso8583_trace_get_field_type(0) == NULL );
+
+    // Profiler test.
+    {
+        ISO8583::TProfiler profiler;
+        profiler.Record(ISO8583_TRACE_DECODE, 55, 100, 300);
+        profiler.Record(ISO8583_TRACE_DECODE, 55, 120, 500);
+        profiler.Record(ISO8583_TRACE_DECODE, 11,   3, 200);
+        profiler.Record(ISO8583_TRACE_DECODE,  0,   1, 999);  // Invalid records are ignored.
+        profiler.Record(ISO8583_TRACE_DIRS  , 11,   1, 999);
+
+        iso8583_profile_entry_t entry = profiler.GetField(ISO8583_TRACE_DECODE, 55);
+        assert( entry.calls == 2 && entry.bytes == 220 && entry.cycles == 800 );
+        entry = profiler.GetField(ISO8583_TRACE_ENCODE, 55);
+        assert( entry.calls == 0 );
+        entry = profiler.GetType(ISO8583_TRACE_DECODE, "n fixed");
+        assert( entry.calls == 1 && entry.bytes == 3 && entry.cycles == 200 );
+
+        char report[1024];
+        int len = profiler.Export(report, sizeof(report));
+        assert( len > 0 && len == (int)strlen(report) );
+        assert( strstr(report, "decode field 55       calls=2 bytes=220 cycles=800 cycles/call=400 share=80.0%\n") );
+        assert( strstr(report, "decode bin LLLVAR     calls=2 ") );
+        assert( !strstr(report, "encode ") );
+        assert( ISO8583_ERR_BUF_NOT_ENOUGH == profiler.Export(report, 32) );
+
+        profiler.Reset();
+        assert( profiler.Export(report, sizeof(report)) == 0 );
+    }
+
+    // Codec hook test.
+    if( iso8583_trace_is_enabled() )
+    {
+        ISO8583::TISO8583 msg;
+        msg.SetMTI(0x0200);
+        ISO8583::helper::SetPAN (msg.Fields(), 4761739001010010ULL);
+        ISO8583::helper::SetSTAN(msg.Fields(), 1);
+
+        ISO8583::TProfiler profiler;
+        profiler.Attach();
+
+        uint8_t buf[256];
+        int size = msg.Encode(buf, sizeof(buf), 0);
+        assert( size > 0 );
+        assert( size == msg.Decode(buf, size, 0) );
+
+        profiler.Detach();
+        assert( size == msg.Decode(buf, size, 0) );
+
+        assert( profiler.GetField(ISO8583_TRACE_ENCODE, 2 ).calls == 1 );
+        assert( profiler.GetField(ISO8583_TRACE_DECODE, 2 ).calls == 1 );
+        assert( profiler.GetField(ISO8583_TRACE_DECODE, 2 ).bytes == 2 + 8 );
+        assert( profiler.GetField(ISO8583_TRACE_DECODE, 11).bytes == 3 );
+    }
+
+    // Hooks changed while another thread is tracing.
+    if( iso8583_trace_is_enabled() )
+    {
+        ISO8583::TISO8583 msg;
+        msg.SetMTI(0x0200);
+        ISO8583::helper::SetPAN (msg.Fields(), 4761739001010010ULL);
+        ISO8583::helper::SetSTAN(msg.Fields(), 1);
+
+        std::atomic<bool> stop(false);
+        std::thread worker([&msg, &stop]()
+        {
+            uint8_t buf[256];
+            while( !stop.load() )
+                assert( msg.Encode(buf, sizeof(buf), 0) > 0 );
+        });
+
+        static int marker;
+        struct checker
+        {
+            static void on_trace(void *userarg, int, int, size_t, uint64_t) { assert( userarg == &marker ); }
+        };
+
+        for(int i=0; i<1000; ++i)
+        {
+            // Profilers are released right after they are detached or replaced.
+            ISO8583::TProfiler *first = new ISO8583::TProfiler;
+            first->Attach();
+            ISO8583::TProfiler *second = new ISO8583::TProfiler;
+            second->Attach();
+            first->Detach();  // Not the current hook.
+            delete first;
+            iso8583_trace_set_hook(checker::on_trace, &marker);
+            second->Detach();  // Not the current hook.
+            delete second;
+            iso8583_trace_set_hook(NULL, NULL);
+        }
+
+        stop = true;
+        worker.join();
+    }
+}
+
+void test_charset_validation()
+{
+    ISO8583::TISO8583 msg;
+    msg.SetMTI(0x0200);
+    ISO8583::helper::SetPAN (msg.Fields(), 4761739001010010ULL);
+    ISO8583::helper::SetSTAN(msg.Fields(), 1);
+
+    static const char termid[] = "TERM0001";
+    msg.Fields().Insert(ISO8583::TFitem(41, termid, sizeof(termid)-1));
+
+    uint8_t buf[256];
+    int size = msg.Encode(buf, sizeof(buf), ISO8583_FLAG_VALIDATE_CHARSET);
+    assert( size > 0 );
+    assert( size == msg.Decode(buf, size, ISO8583_FLAG_VALIDATE_CHARSET) );
+    assert( msg.Fields().GetErrorID() == 0 );
+
+    // Layout: MTI(2), bitmap(8), field 2 (2+8), field 11 (3), field 41 (8).
+    assert( size == 2 + 8 + 10 + 3 + 8 );
+
+    // Break the terminal ID (ans) with a control character.
+    uint8_t *pos = buf + 23;
+    assert( 0 == memcmp(pos, termid, sizeof(termid)-1) );
+    pos[4] = 0x07;
+    assert( size == msg.Decode(buf, size, 0) );
+    assert( ISO8583_ERR_FIELD_CHARSET == msg.Decode(buf, size, ISO8583_FLAG_VALIDATE_CHARSET) );
+    assert( msg.Fields().GetErrorID() == 41 );
+
+    uint8_t out[256];
+    assert( size == msg.Decode(buf, size, 0) );
+    assert( ISO8583_ERR_FIELD_CHARSET == msg.Encode(out, sizeof(out), ISO8583_FLAG_VALIDATE_CHARSET) );
+    pos[4] = '0';
+
+    // Break the STAN (n) with a nibble not a decimal digit.
+    static const uint8_t stan[] = { 0x00,0x00,0x01 };
+    pos = buf + 20;
+    assert( 0 == memcmp(pos, stan, sizeof(stan)) );
+    pos[1] = 0xA0;
+    assert( ISO8583_ERR_FIELD_CHARSET == msg.Decode(buf, size, ISO8583_FLAG_VALIDATE_CHARSET) );
+    assert( msg.Fields().GetErrorID() == 11 );
+    pos[1] = 0x00;
+
+    assert( size == msg.Decode(buf, size, ISO8583_FLAG_VALIDATE_CHARSET) );
+    assert( msg.Fields().GetErrorID() == 0 );
+
+    // Field 55 is defined as binary, and carries ICC data in any bytes.
+    static const uint8_t icc[] = { 0x9F,0x26,0x08,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08, 0x95,0x05,0x00,0x00,0x00,0x80,0x00 };
+    assert( 0 == msg.Fields().SetData(55, icc, sizeof(icc)) );
+    size = msg.Encode(buf, sizeof(buf), ISO8583_FLAG_VALIDATE_CHARSET);
+    assert( size > 0 );
+    assert( size == msg.Decode(buf, size, ISO8583_FLAG_VALIDATE_CHARSET) );
+    assert( msg.Fields().GetItem(55).GetSize() == sizeof(icc) );
+    assert( 0 == memcmp(msg.Fields().GetItem(55).GetData(), icc, sizeof(icc)) );
+}
+
+void test_typed_fields()
+{
+    using namespace ISO8583;
+
+    // Value types are derived from the field definitions.
+    static_assert( std::is_same<F4 ::value_type, uint64_t             >::value, "n 12 is an integer" );
+    static_assert( std::is_same<F2 ::value_type, field::TChars<19>    >::value, "PAN is a digits string" );
+    static_assert( std::is_same<F41::value_type, field::TView         >::value, "ans 8 is a view" );
+    static_assert( std::is_same<F32::value_type, field::TView         >::value, "n LLVAR is a view" );
+    static_assert( std::is_same<F53::value_type, uint64_t             >::value, "n 16 is an integer" );
+    static_assert( !std::is_convertible<const char*, F11::param_type>::value, "string to integer field" );
+    static_assert( !std::is_convertible<int        , F41::param_type>::value, "integer to text field" );
+    static_assert( F55::lenmode == field::LEN_LLLVAR && F55::maxcount == 999, "field 55 traits" );
+    static_assert( F128::max_size == 8, "binary size in bytes" );
+
+    TFields fields;
+
+    // Integer fields.
+    assert( !fields.Has<F4>() );
+    assert( fields.Get<F4>() == 0 );
+    assert( fields.Set<F4>(1250) );
+    assert( fields.Has<F4>() );
+    assert( fields.Get<F4>() == 1250 );
+    assert( 0 == memcmp(fields.GetItem(4).GetData(), "\x00\x00\x00\x00\x12\x50", 6) );
+    assert( fields.Set<F11>(999999) );
+    assert( !fields.Set<F11>(1000000) );
+    assert( fields.Get<F11>() == 999999 );
+
+    // Digits which are not decimal are rejected.
+    assert( 0 == fields.SetData(11, "\x12\x3A\x56", 3) );
+    assert( fields.Get<F11>() == 0 );
+    assert( 0 == fields.SetData(11, "\x12\x34\xF6", 3) );
+    assert( fields.Get<F11>() == 0 );
+    assert( fields.Set<F11>(123456) );
+    assert( fields.Get<F11>() == 123456 );
+
+    // PAN field.
+    assert( fields.Get<F2>().empty() );
+    assert( fields.Set<F2>("0004761739001010010") );
+    assert( fields.Get<F2>() == "0004761739001010010" );
+    assert( !fields.Set<F2>("47617390010100101234") );
+    assert( !fields.Set<F2>("4761X") );
+    assert( fields.Get<F2>() == "0004761739001010010" );
+
+    // View fields.
+    assert( fields.Get<F41>().empty() );
+    assert( fields.Set<F41>("TERM0001") );
+    assert( !fields.Set<F41>("TERM00012") );
+    assert( !fields.Set<F41>("TERM") );
+    field::TView termid = fields.Get<F41>();
+    assert( termid == "TERM0001" );
+    assert( termid.data() == fields.GetItem(41).GetData() );  // No copy.
+    assert( termid.str() == "TERM0001" );
+
+    std::string emv("\x9F\x26\x08\x01\x02\x03\x04\x05\x06\x07\x08", 11);
+    assert( fields.Set<F55>(emv) );
+    assert( fields.Get<F55>() == emv );
+
+    assert( fields.Set<F128>(field::TView("\x01\x02\x03\x04\x05\x06\x07\x08", 8)) );
+    assert( !fields.Set<F128>(field::TView("\x01\x02\x03\x04\x05\x06\x07\x08\x09", 9)) );
+    assert( fields.Get<F128>().size() == 8 );
+
+    // Typed values are the same as the ones of the helpers.
+    assert( ISO8583::helper::GetInteger(fields, 4, 0) == 1250 );
+    assert( ISO8583::helper::GetTerminalID(fields) == "TERM0001" );
+    assert( ISO8583::helper::GetPANString(fields) == "0004761739001010010" );
+}
+
+void test_tlv()
+{
+    using namespace ISO8583;
+
+    // Multi-byte tags, long form length, padding, and a constructed template.
+    static const uint8_t emv[] =
+    {
+        0x9F,0x26, 0x08, 0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,
+        0x82, 0x02, 0x5C,0x00,
+        0x00,0x00,
+        0x5F,0x2A, 0x02, 0x09,0x01,
+        0xDF,0x81,0x01, 0x01, 0xAB,
+        0x70, 0x06, 0x5A,0x01,0x47, 0x57,0x01,0x47,
+        0x9F,0x10, 0x00,
+    };
+
+    TFields fields;
+    fields.Insert(TFitem(55, emv, sizeof(emv)));
+
+    TTlvIndex index;
+    assert( index.Build(fields.GetItem(55)) == 6 );
+    assert( index.GetCount() == 6 );
+    assert( index.GetEntry(1)->tag == 0x82 );
+    assert( index.GetEntry(3)->tag == 0xDF8101 );
+    assert( !index.GetEntry(6) );
+    assert( !index.Find(0x9F27) );
+
+    size_t len;
+    const uint8_t *value = (const uint8_t*) index.GetValue(0x9F26, &len);
+    assert( len == 8 && value == (const uint8_t*) fields.GetItem(55).GetData() + 3 );  // No copy.
+    assert( value[0] == 0x11 && value[7] == 0x88 );
+    value = (const uint8_t*) index.GetValue(0x5F2A, &len);
+    assert( len == 2 && value[0] == 0x09 && value[1] == 0x01 );
+    value = (const uint8_t*) index.GetValue(0xDF8101, &len);
+    assert( len == 1 && value[0] == 0xAB );
+    assert( index.GetValue(0x9F10, &len) && len == 0 );
+
+    // Values of constructed data objects can be indexed again.
+    TTlvIndex inner;
+    value = (const uint8_t*) index.GetValue(0x70, &len);
+    assert( inner.Build(value, len) == 2 );
+    assert( inner.GetEntry(0)->tag == 0x5A && inner.GetEntry(1)->tag == 0x57 );
+
+    // Malformed data.
+    static const uint8_t overrun[] = { 0x9F,0x26, 0x08, 0x11,0x22 };
+    static const uint8_t badtag [] = { 0x9F };
+    static const uint8_t badlen [] = { 0x82, 0x85,0x00,0x00,0x00,0x00,0x01, 0x00 };
+    assert( ISO8583_ERR_TLV_FORMAT == index.Build(overrun, sizeof(overrun)) );
+    assert( index.GetCount() == 0 );
+    assert( ISO8583_ERR_TLV_FORMAT == index.Build(badtag, sizeof(badtag)) );
+    assert( ISO8583_ERR_TLV_FORMAT == index.Build(badlen, sizeof(badlen)) );
+
+    // Build a response, which has the same data objects as above except the padding.
+    uint8_t buf[256];
+    TTlvBuilder builder(buf, sizeof(buf));
+    builder.Add(0x9F26, emv + 3, 8);
+    builder.Add(0x82, "\x5C\x00", 2);
+    builder.Add(0x5F2A, "\x09\x01", 2);
+    builder.Add(0xDF8101, "\xAB", 1);
+    builder.Begin(0x70);
+    builder.Add(0x5A, "\x47", 1);
+    builder.Add(0x57, "\x47", 1);
+    builder.End();
+    builder.Add(0x9F10, NULL, 0);
+    assert( builder.Finish() == sizeof(emv) - 2 );
+    assert( 0 == memcmp(buf, emv, 15) );
+    assert( 0 == memcmp(buf + 15, emv + 17, sizeof(emv) - 17) );
+
+    TFields response;
+    assert( 0 == builder.Commit(response, 55) );
+    assert( response.GetItem(55).GetSize() == sizeof(emv) - 2 );
+
+    // Templates longer than 127 bytes have the length expanded.
+    uint8_t block[200] = {0};
+    builder.Reset();
+    builder.Begin(0x70);
+    builder.Add(0x9F10, block, 150);
+    builder.End();
+    assert( builder.Finish() == 1 + 2 + 2 + 2 + 150 );
+    assert( buf[0] == 0x70 && buf[1] == 0x81 && buf[2] == 2 + 2 + 150 );
+    assert( buf[3] == 0x9F && buf[4] == 0x10 && buf[5] == 0x81 && buf[6] == 150 );
+    assert( index.Build(buf, builder.Finish()) == 1 );
+    assert( index.GetEntry(0)->offset == 3 && index.GetEntry(0)->length == 154 );
+
+    // Errors are kept until reset.
+    uint8_t small[8];
+    TTlvBuilder overflow(small, sizeof(small));
+    assert( 0 == overflow.Add(0x82, "\x5C\x00", 2) );
+    assert( ISO8583_ERR_BUF_NOT_ENOUGH == overflow.Add(0x9F26, emv + 3, 8) );
+    assert( ISO8583_ERR_BUF_NOT_ENOUGH == overflow.Add(0x82, "\x5C\x00", 2) );
+    assert( ISO8583_ERR_BUF_NOT_ENOUGH == overflow.Finish() );
+    assert( ISO8583_ERR_BUF_NOT_ENOUGH == overflow.Commit(response, 55) );
+    overflow.Reset();
+    assert( ISO8583_ERR_INVALID_ARG == overflow.Begin(0x9F26) );  // Not a constructed tag.
+    overflow.Reset();
+    overflow.Begin(0x70);
+    assert( ISO8583_ERR_INVALID_ARG == overflow.Finish() );       // Not ended.
+}
+
+void test_subfield()
+{
+    using namespace ISO8583;
+
+    static const iso8583_subfield_def_t f60_defs[] =
+    {
+        { ISO8583_SUBFIELD_FIXED , 2  },
+        { ISO8583_SUBFIELD_FIXED , 6  },
+        { ISO8583_SUBFIELD_LLVAR , 20 },
+        { ISO8583_SUBFIELD_LLLVAR, 50 },
+    };
+    static const iso8583_subfield_spec_t f60 = ISO8583_SUBFIELD_SPEC_POSITIONAL(f60_defs);
+    static const iso8583_subfield_spec_t f48 = ISO8583_SUBFIELD_SPEC_TAGGED(2, 3);
+
+    TFields fields;
+    size_t  len;
+
+    // Positional layout, with the trailing sub-field absent.
+    static const iso8583_subfield_t f60_subs[] =
+    {
+        { NULL, "22"     , 2 },
+        { NULL, "000123" , 6 },
+        { NULL, "BATCH-7", 7 },
+    };
+    assert( 2 + 6 + 2+7 == iso8583_subfield_encode(&f60, fields.cptr(), 60, f60_subs, 3) );
+    assert( 0 == memcmp(fields.GetItem(60).GetData(), "2200012307BATCH-7", 17) );
+
+    TSubfieldIndex index;
+    assert( index.Build(f60, fields.GetItem(60)) == 3 );
+    const char *value = (const char*) index.GetValue(3, &len);
+    assert( len == 7 && 0 == memcmp(value, "BATCH-7", 7) );
+    assert( value == (const char*) fields.GetItem(60).GetData() + 10 );  // No copy.
+    value = (const char*) index.GetValue(2, &len);
+    assert( len == 6 && 0 == memcmp(value, "000123", 6) );
+    assert( !index.GetValue(4, &len) && len == 0 );
+    assert( !index.GetValue(0, &len) );
+    assert( !index.Find("01", &len) );
+
+    // Read-modify-write : values of other sub-fields are taken from an index over the same field.
+    {
+        static const iso8583_subfield_def_t rmw_defs[] =
+        {
+            { ISO8583_SUBFIELD_FIXED, 2  },
+            { ISO8583_SUBFIELD_LLVAR, 20 },
+            { ISO8583_SUBFIELD_LLVAR, 20 },
+        };
+        static const iso8583_subfield_spec_t rmw = ISO8583_SUBFIELD_SPEC_POSITIONAL(rmw_defs);
+        static const iso8583_subfield_t rmw_subs[] =
+        {
+            { NULL, "22"     , 2 },
+            { NULL, "AB"     , 2 },
+            { NULL, "BATCH-7", 7 },
+        };
+
+        TFields            rmw_fields;
+        iso8583_subfield_t subs[3];
+        assert( 2 + 2+2 + 2+7 == iso8583_subfield_encode(&rmw, rmw_fields.cptr(), 60, rmw_subs, 3) );
+
+        // A longer sub-field 2 grows the field buffer.
+        assert( index.Build(rmw, rmw_fields.GetItem(60)) == 3 );
+        subs[0].tag = NULL; subs[0].data = index.GetValue(1, &subs[0].size);
+        subs[1].tag = NULL; subs[1].data = "LONGER-SUB-2"; subs[1].size = 12;
+        subs[2].tag = NULL; subs[2].data = index.GetValue(3, &subs[2].size);
+        assert( 2 + 2+12 + 2+7 == iso8583_subfield_encode(&rmw, rmw_fields.cptr(), 60, subs, 3) );
+        assert( 0 == memcmp(rmw_fields.GetItem(60).GetData(), "2212LONGER-SUB-207BATCH-7", 25) );
+
+        // A shorter sub-field 2 fits in the same buffer, and moves sub-field 3 over itself.
+        assert( index.Build(rmw, rmw_fields.GetItem(60)) == 3 );
+        subs[0].data = index.GetValue(1, &subs[0].size);
+        subs[1].data = "X"; subs[1].size = 1;
+        subs[2].data = index.GetValue(3, &subs[2].size);
+        assert( 2 + 2+1 + 2+7 == iso8583_subfield_encode(&rmw, rmw_fields.cptr(), 60, subs, 3) );
+        assert( 0 == memcmp(rmw_fields.GetItem(60).GetData(), "2201X07BATCH-7", 14) );
+    }
+
+    assert( 4 == index.Build(f60, "2200012307BATCH-7003ABC", 23) );
+    assert( index.GetEntry(3)->tag == 4 && index.GetEntry(3)->length == 3 );
+
+    // Positional data not match to the spec.
+    assert( ISO8583_ERR_SUBFIELD_FORMAT == index.Build(f60, "2200012", 7) );
+    assert( index.GetCount() == 0 );
+    assert( ISO8583_ERR_SUBFIELD_FORMAT == index.Build(f60, "220001232XBATCH-7", 17) );
+    assert( ISO8583_ERR_SUBFIELD_FORMAT == index.Build(f60, "2200012321BATCH-7", 17) );
+    assert( ISO8583_ERR_SUBFIELD_FORMAT == index.Build(f60, "2200012307BATCH-7003ABCD", 24) );
+
+    // Tagged layout.
+    static const iso8583_subfield_t f48_subs[] =
+    {
+        { "01", "MERCHANT", 8 },
+        { "AB", ""        , 0 },
+        { "93", "X"       , 1 },
+    };
+    assert( 5+8 + 5 + 5+1 == iso8583_subfield_encode(&f48, fields.cptr(), 48, f48_subs, 3) );
+    assert( 0 == memcmp(fields.GetItem(48).GetData(), "01008MERCHANTAB00093001X", 24) );
+
+    assert( index.Build(f48, fields.GetItem(48)) == 3 );
+    value = (const char*) index.Find("01", &len);
+    assert( len == 8 && 0 == memcmp(value, "MERCHANT", 8) );
+    assert( index.Find("AB", &len) && len == 0 );
+    value = (const char*) index.Find("93", &len);
+    assert( len == 1 && value[0] == 'X' );
+    assert( !index.Find("02", &len) );
+    assert( !index.Find("010", &len) );
+    assert( !index.GetValue(1, &len) );
+    assert( index.GetEntry(1)->tag == ( 'A' << 8 | 'B' ) );
+
+    assert( ISO8583_ERR_SUBFIELD_FORMAT == index.Build(f48, "01008MERCHAN", 12) );
+    assert( ISO8583_ERR_SUBFIELD_FORMAT == index.Build(f48, "0100", 4) );
+    assert( ISO8583_ERR_SUBFIELD_FORMAT == index.Build(f48, "01A08MERCHANT", 13) );
+
+    // Sub-fields which do not match to the spec are rejected, and the field is not modified.
+    static const iso8583_subfield_t bad_fixed[] = { { NULL, "2", 1 } };
+    static const iso8583_subfield_t bad_lvar [] = { { NULL, "22", 2 }, { NULL, "000123", 6 }, { NULL, "123456789012345678901", 21 } };
+    static const iso8583_subfield_t bad_tag  [] = { { "1", "X", 1 } };
+    static const iso8583_subfield_t too_many [5] = {};
+    assert( ISO8583_ERR_FIELD_SIZE_ERROR == iso8583_subfield_encode(&f60, fields.cptr(), 60, bad_fixed, 1) );
+    assert( ISO8583_ERR_LVAR_TOO_LONG == iso8583_subfield_encode(&f60, fields.cptr(), 60, bad_lvar, 3) );
+    assert( ISO8583_ERR_INVALID_ARG == iso8583_subfield_encode(&f60, fields.cptr(), 60, too_many, 5) );
+    assert( ISO8583_ERR_INVALID_ARG == iso8583_subfield_encode(&f48, fields.cptr(), 48, bad_tag, 1) );
+    assert( ISO8583_ERR_INVALID_FIELD_ID == iso8583_subfield_encode(&f48, fields.cptr(), 65, f48_subs, 3) );
+
+    // The whole data must also match to the definition of the field.
+    static char large[600];
+    static const iso8583_subfield_t too_long  [] = { { "01", large, 600 }, { "02", large, 600 } };
+    static const iso8583_subfield_t wrong_size[] = { { NULL, "22", 2 } };
+    assert( ISO8583_ERR_LVAR_TOO_LONG == iso8583_subfield_encode(&f48, fields.cptr(), 48, too_long, 2) );
+    assert( ISO8583_ERR_FIELD_SIZE_ERROR == iso8583_subfield_encode(&f60, fields.cptr(), 3, wrong_size, 1) );
+    assert( fields.GetItem(60).GetSize() == 17 );
+    assert( fields.GetItem(48).GetSize() == 24 );
+}
+
+void test_tertiary_bitmap()
+{
+    ISO8583::TISO8583 msg;
+    msg.SetMTI(0x0200);
+    ISO8583::helper::SetSTAN(msg.Fields(), 1);
+
+    // Field 65 is the tertiary bitmap indicator, and can not be set.
+    static const uint8_t b65[8] = {0};
+    assert( ISO8583_ERR_INVALID_FIELD_ID == msg.Fields().SetData(65, b65, sizeof(b65)) );
+    assert( ISO8583_ERR_INVALID_FIELD_ID == msg.Fields().Insert(ISO8583::TFitem(65, b65, sizeof(b65))) );
+    assert( msg.Fields().GetCount() == 1 );
+
+    // Fields above 128.
+    static const char priv[] = "PRIVATE";
+    assert( 0 == msg.Fields().SetData(130, priv, sizeof(priv)-1) );
+    assert( 0 == msg.Fields().SetData(192, priv, 3) );
+    assert( ISO8583_ERR_INVALID_FIELD_ID == msg.Fields().SetData(193, priv, 3) );
+
+    uint8_t buf[256];
+    int size = msg.Encode(buf, sizeof(buf), 0);
+    // Layout: MTI(2), bitmaps(24), field 11 (3), field 130 (3+7), field 192 (3+3).
+    assert( size == 2 + 24 + 3 + 10 + 6 );
+    assert( buf[2] & 0x80 && buf[10] & 0x80 );
+
+    ISO8583::TISO8583 dec;
+    assert( size == dec.Decode(buf, size, 0) );
+    assert( dec.Fields().GetCount() == 3 );
+    assert( dec.Fields().GetItem(130).GetSize() == sizeof(priv)-1 );
+    assert( 0 == memcmp(dec.Fields().GetItem(130).GetData(), priv, sizeof(priv)-1) );
+    assert( dec.Fields().GetItem(192).GetSize() == 3 );
+    assert( !dec.Fields().GetItem(65).GetID() );
+
+    // Items are walked in order.
+    const ISO8583::TFitem *item = &dec.Fields().GetFirst();
+    assert( item->GetID() == 11 );
+    item = &dec.Fields().GetNext(*item);  assert( item->GetID() == 130 );
+    item = &dec.Fields().GetNext(*item);  assert( item->GetID() == 192 );
+    item = &dec.Fields().GetNext(*item);  assert( !item->GetID() );
+
+    // Back to a primary bitmap only.
+    dec.Fields().Erase(130);
+    dec.Fields().Erase(192);
+    assert( 2 + 8 + 3 == dec.Encode(buf, sizeof(buf), 0) );
+
+    ISO8583::TISO8583 copy(msg);
+    assert( copy.Fields().GetCount() == 3 );
+    assert( copy.Fields().GetItem(192).GetSize() == 3 );
+    copy.Fields().Clear();
+    assert( !copy.Fields().GetCount() && !copy.Fields().GetFirst().GetID() );
+}
+
+void test_text_mti_bitmap()
+{
+    static const int flags = ISO8583_FLAG_MTI_ASCII | ISO8583_FLAG_BITMAP_HEX;
+
+    // MTI in ASCII digits.
+    {
+        char buf[8] = {0};
+        assert( ISO8583_ERR_BUF_NOT_ENOUGH == ISO8583::mti::Encode(0x0200, buf, 3, flags) );
+        assert( 4 == ISO8583::mti::Encode(0x0200, buf, sizeof(buf), flags) );
+        assert( 0 == memcmp(buf, "0200", 4) );
+        assert( ISO8583_ERR_INVALID_ARG == ISO8583::mti::Encode(0x020A, buf, sizeof(buf), flags) );
+
+        int mti = 0;
+        assert( 4 == ISO8583::mti::Decode(mti, "1814", 4, flags) );
+        assert( mti == 0x1814 );
+        assert( ISO8583_ERR_TEXT_FORMAT == ISO8583::mti::Decode(mti, "18A4", 4, flags) );
+    }
+
+    // Total message.
+    {
+        ISO8583::TISO8583 msg;
+        msg.SetMTI(0x0200);
+        ISO8583::helper::SetSTAN(msg.Fields(), 123456);
+        assert( 0 == msg.Fields().SetData(70, "\x03\x01", 2) );
+
+        uint8_t buf[128];
+        int size = msg.Encode(buf, sizeof(buf), flags);
+        // Layout: MTI(4), bitmaps(32), field 11 (3), field 70 (2).
+        assert( size == 4 + 32 + 3 + 2 );
+        assert( 0 == memcmp(buf, "0200" "8020000000000000" "0400000000000000", 36) );
+
+        ISO8583::TISO8583 dec;
+        assert( size == dec.Decode(buf, size, flags) );
+        assert( dec.GetMTI() == 0x0200 );
+        assert( ISO8583::helper::GetSTAN(dec.Fields()) == 123456 );
+        assert( dec.Fields().GetItem(70).GetSize() == 2 );
+
+        // The same message in binary is not accepted by the text mode.
+        size = msg.Encode(buf, sizeof(buf), 0);
+        assert( ISO8583_ERR_TEXT_FORMAT == dec.Decode(buf, size, flags) );
+    }
+}
+
+void test_ebcdic_message()
+{
+    ISO8583::TISO8583 msg;
+    msg.SetMTI(0x0200);
+    ISO8583::helper::SetSTAN(msg.Fields(), 123456);
+    assert( 0 == msg.Fields().SetData(37, "REF000000042", 12) );
+    assert( 0 == msg.Fields().SetData(41, "TERM 001", 8) );
+    assert( 0 == msg.Fields().SetData(48, "Ab9", 3) );
+
+    static const uint8_t raw[] =
+    {
+        0x02,0x00,
+        0x00,0x20,0x00,0x00,0x08,0x81,0x00,0x00,                          // Bitmap.
+        0x12,0x34,0x56,                                                   // Field 11, not converted.
+        0xD9,0xC5,0xC6,0xF0,0xF0,0xF0,0xF0,0xF0,0xF0,0xF0,0xF4,0xF2,      // Field 37.
+        0xE3,0xC5,0xD9,0xD4,0x40,0xF0,0xF0,0xF1,                          // Field 41.
+        0xF0,0xF0,0xF3,0xC1,0x82,0xF9,                                    // Field 48.
+    };
+
+    uint8_t buf[128];
+    int flags = ISO8583_FLAG_EBCDIC | ISO8583_FLAG_VALIDATE_CHARSET;
+    assert( sizeof(raw) == msg.Encode(buf, sizeof(buf), flags) );
+    assert( 0 == memcmp(buf, raw, sizeof(raw)) );
+
+    ISO8583::TISO8583 dec;
+    assert( sizeof(raw) == dec.Decode(raw, sizeof(raw), flags) );
+    assert( ISO8583::helper::GetSTAN(dec.Fields()) == 123456 );
+    assert( 0 == memcmp(dec.Fields().GetItem(37).GetData(), "REF000000042", 12) );
+    assert( 0 == memcmp(dec.Fields().GetItem(41).GetData(), "TERM 001", 8) );
+    assert( dec.Fields().GetItem(48).GetSize() == 3 );
+    assert( 0 == memcmp(dec.Fields().GetItem(48).GetData(), "Ab9", 3) );
+
+    // The characters are validated after they are converted.
+    assert( ISO8583_ERR_FIELD_CHARSET == dec.Decode(raw, sizeof(raw), ISO8583_FLAG_VALIDATE_CHARSET) );
+
+    // ICC data in field 55 is binary, only its length value is converted.
+    static const uint8_t icc[] = { 0x9F,0x26,0x08,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08, 0x9F,0x27,0x01,0x80 };
+    static const uint8_t icc_raw[] = { 0xF0,0xF1,0xF5 };
+    assert( 0 == msg.Fields().SetData(55, icc, sizeof(icc)) );
+    int size = msg.Encode(buf, sizeof(buf), flags);
+    assert( size == sizeof(raw) + sizeof(icc_raw) + sizeof(icc) );
+    assert( 0 == memcmp(buf + sizeof(raw), icc_raw, sizeof(icc_raw)) );
+    assert( 0 == memcmp(buf + sizeof(raw) + sizeof(icc_raw), icc, sizeof(icc)) );
+    assert( size == dec.Decode(buf, size, flags) );
+    assert( dec.Fields().GetItem(55).GetSize() == sizeof(icc) );
+    assert( 0 == memcmp(dec.Fields().GetItem(55).GetData(), icc, sizeof(icc)) );
+    assert( dec.Fields().Equal(msg.Fields()) );
+
+    // The MTI and bitmap in text mode are converted too.
+    {
+        static const int text_flags = flags | ISO8583_FLAG_MTI_ASCII | ISO8583_FLAG_BITMAP_HEX;
+        static const uint8_t head[] =
+        {
+            0xF0,0xF2,0xF0,0xF0,                                              // MTI "0200".
+            0xF0,0xF0,0xF2,0xF0,0xF0,0xF0,0xF0,0xF0,                          // Bitmap "0020000008810200".
+            0xF0,0xF8,0xF8,0xF1,0xF0,0xF2,0xF0,0xF0,
+        };
+        size = msg.Encode(buf, sizeof(buf), text_flags);
+        assert( size == sizeof(head) + sizeof(raw) - 10 + sizeof(icc_raw) + sizeof(icc) );
+        assert( 0 == memcmp(buf, head, sizeof(head)) );
+        assert( 0 == memcmp(buf + sizeof(head), raw + 10, sizeof(raw) - 10) );
+
+        ISO8583::TISO8583 text;
+        assert( size == text.Decode(buf, size, text_flags) );
+        assert( text.GetMTI() == 0x0200 );
+        assert( text.Fields().Equal(msg.Fields()) );
+
+        char ascii[4+16];
+        memcpy(ascii, "0200" "0020000008810200", sizeof(ascii));
+        memcpy(buf, ascii, sizeof(ascii));
+        assert( ISO8583_ERR_TEXT_FORMAT == text.Decode(buf, size, text_flags) );
+    }
+
+    // Invalid characters are rejected before the item is modified.
+    static const uint8_t bad_termid[] = { 0xE3,0xC5,0xD9,0xD4,0x07,0xF0,0xF0,0xF1 };
+    ISO8583::TFitem item(41, "TERM0001", 8);
+    assert( 8 == item.Decode(raw + 25, 8, flags, 41) );
+    assert( 0 == memcmp(item.GetData(), "TERM 001", 8) );
+    assert( ISO8583_ERR_FIELD_CHARSET == item.Decode(bad_termid, sizeof(bad_termid), flags, 41) );
+    assert( item.GetID() == 41 && 0 == memcmp(item.GetData(), "TERM 001", 8) );
+    ISO8583::TFitem other(37, "REF000000042", 12);
+    assert( ISO8583_ERR_FIELD_CHARSET == other.Decode(bad_termid, sizeof(bad_termid), flags, 41) );
+    assert( other.GetID() == 37 && 0 == memcmp(other.GetData(), "REF000000042", 12) );
+}
+
+void test_template()
+{
+    ISO8583::TISO8583 base;
+    base.SetMTI(0x0200);
+    assert( 0 == base.Fields().SetData(32, "\x12\x34\x56", 3) );
+    assert( 0 == base.Fields().SetData(41, "TERM0001", 8) );
+    assert( 0 == base.Fields().SetData(42, "MERCHANT0000001", 15) );
+    assert( 0 == base.Fields().SetData(49, "\x09\x01", 2) );
+
+    ISO8583::TTemplate tmpl(base);
+    const ISO8583::TFields &shared = tmpl.GetMessage().Fields();
+    assert( shared.GetCount() == 4 );
+
+    // Payloads of the template are referenced by derived messages.
+    ISO8583::TISO8583 msg;
+    assert( 0 == msg.Fields().SetData(41, "OLD TERM", 8) );
+    assert( 0 == msg.Fields().SetData(11, "\x00\x00\x01", 3) );
+    tmpl.Derive(msg);
+    assert( msg.GetMTI() == 0x0200 );
+    assert( msg.Fields().GetCount() == 4 );
+    assert( !msg.Fields().GetItem(11).GetID() );
+    assert( msg.Fields().GetItem(42).IsShared() );
+    assert( msg.Fields().GetItem(42).GetData() == shared.GetItem(42).GetData() );
+    assert( msg.Fields().GetItem(41).GetCapacity() >= 8 );
+
+    // Modified fields are copied to their own buffers, and the template is not changed.
+    assert( 0 == msg.Fields().SetData(41, "TERM0002", 8) );
+    assert( 0 == msg.Fields().SetData(11, "\x00\x00\x02", 3) );
+    assert( !msg.Fields().GetItem(41).IsShared() );
+    assert( 0 == memcmp(msg.Fields().GetItem(41).GetData(), "TERM0002", 8) );
+    assert( 0 == memcmp(shared.GetItem(41).GetData(), "TERM0001", 8) );
+
+    char *name = static_cast<char*>( msg.Fields().ResizeData(42, 15) );
+    assert( !msg.Fields().GetItem(42).IsShared() );
+    assert( 0 == memcmp(name, "MERCHANT0000001", 15) );
+    name[14] = '2';
+    assert( 0 == memcmp(shared.GetItem(42).GetData(), "MERCHANT0000001", 15) );
+
+    // Derived messages are encoded the same as copies.
+    ISO8583::TISO8583 copy(base);
+    assert( 0 == copy.Fields().SetData(41, "TERM0002", 8) );
+    assert( 0 == copy.Fields().SetData(42, "MERCHANT0000002", 15) );
+    assert( 0 == copy.Fields().SetData(11, "\x00\x00\x02", 3) );
+
+    uint8_t buf1[128], buf2[128];
+    int size = msg.Encode(buf1, sizeof(buf1), 0);
+    assert( size > 0 && size == copy.Encode(buf2, sizeof(buf2), 0) );
+    assert( 0 == memcmp(buf1, buf2, size) );
+
+    // Clones have their own payloads, and moves keep the shared ones.
+    tmpl.Derive(msg);
+    ISO8583::TISO8583 clone(msg);
+    assert( !clone.Fields().GetItem(49).IsShared() );
+    assert( clone.Fields().GetItem(49).GetData() != shared.GetItem(49).GetData() );
+
+    ISO8583::TISO8583 moved(std::move(msg));
+    assert( moved.Fields().GetItem(49).GetData() == shared.GetItem(49).GetData() );
+
+    moved.Fields().Shrink();
+    assert( moved.Fields().GetItem(41).IsShared() );
+    assert( moved.Fields().GetItem(41).GetCapacity() == 0 );
+    moved.Fields().Erase(41);
+    assert( moved.Fields().GetCount() == 3 );
+    moved.Fields().Clear();
+    assert( !moved.Fields().GetCount() );
+}
+
+void test_equal_hash()
+{
+    ISO8583::TISO8583 msg1;
+    msg1.SetMTI(0x0200);
+    assert( 0 == msg1.Fields().SetData(  3, "\x00\x00\x00", 3) );
+    assert( 0 == msg1.Fields().SetData(  7, "\x10\x19\x12\x00\x00", 5) );
+    assert( 0 == msg1.Fields().SetData( 11, "\x00\x00\x01", 3) );
+    assert( 0 == msg1.Fields().SetData( 41, "TERM0001", 8) );
+    assert( 0 == msg1.Fields().SetData(130, "\x01\x02\x03", 3) );
+
+    ISO8583::TISO8583 msg2(msg1);
+    assert( msg1.Equal(msg2) );
+    assert( msg1.Hash() == msg2.Hash() );
+    assert( msg1.Hash(NULL, 1) != msg1.Hash(NULL, 2) );
+
+    // The volatile fields can be excluded.
+    assert( 0 == msg2.Fields().SetData( 7, "\x10\x19\x12\x00\x01", 5) );
+    assert( 0 == msg2.Fields().SetData(11, "\x00\x00\x02", 3) );
+    assert( !msg1.Equal(msg2) );
+    assert( msg1.Hash() != msg2.Hash() );
+
+    ISO8583::TFieldMask mask;
+    mask.Remove(7).Remove(11);
+    assert( !mask.Has(7) && mask.Has(41) && mask.Has(130) );
+    assert( msg1.Equal(msg2, mask.cptr()) );
+    assert( msg1.Hash(mask.cptr()) == msg2.Hash(mask.cptr()) );
+
+    msg2.Fields().Erase(11);
+    assert( msg1.Equal(msg2, mask.cptr()) );
+    assert( msg1.Hash(mask.cptr()) == msg2.Hash(mask.cptr()) );
+
+    // Presence, sizes, payloads, and MTI of the selected fields are all compared.
+    assert( 0 == msg2.Fields().SetData(130, "\x01\x02\x04", 3) );
+    assert( !msg1.Equal(msg2, mask.cptr()) );
+    assert( msg1.Hash(mask.cptr()) != msg2.Hash(mask.cptr()) );
+    assert( 0 == msg2.Fields().SetData(130, "\x01\x02\x03\x00", 4) );
+    assert( !msg1.Equal(msg2, mask.cptr()) );
+    assert( 0 == msg2.Fields().SetData(130, "\x01\x02\x03", 3) );
+    assert( msg1.Equal(msg2, mask.cptr()) );
+    msg2.Fields().Erase(130);
+    assert( !msg1.Equal(msg2, mask.cptr()) );
+    assert( msg1.Fields().Equal(msg2.Fields(), ISO8583::TFieldMask(false).Add(41).cptr()) );
+
+    ISO8583::TISO8583 msg3;
+    msg3.Fields().Share(msg1.Fields());
+    assert( msg1.Fields().Equal(msg3.Fields()) );
+    assert( msg1.Fields().Hash() == msg3.Fields().Hash() );
+    assert( !msg1.Equal(msg3) );
+
+    // The hash covers the field IDs, so that moving a payload to another field changes it.
+    ISO8583::TFields f1, f2;
+    assert( 0 == f1.SetData(41, "TERM0001", 8) );
+    assert( 0 == f2.SetData(42, "TERM0001", 8) );
+    assert( !f1.Equal(f2) );
+    assert( f1.Hash() != f2.Hash() );
+    assert( ISO8583::TFields().Equal(ISO8583::TFields()) );
+}
+
+void test_replay()
+{
+    ISO8583::TFieldMask keymask(false);
+    keymask.Add(2).Add(11).Add(32).Add(37).Add(41);
+
+    ISO8583::TISO8583 req;
+    req.SetMTI(0x0200);
+    assert( 0 == req.Fields().SetData( 2, "\x45\x11\x11\x11\x11\x11\x11\x11", 8) );
+    assert( 0 == req.Fields().SetData( 7, "\x10\x19\x12\x00\x00", 5) );
+    assert( 0 == req.Fields().SetData(11, "\x00\x00\x01", 3) );
+    assert( 0 == req.Fields().SetData(37, "000000000001", 12) );
+    assert( 0 == req.Fields().SetData(41, "TERM0001", 8) );
+
+    static const uint8_t resp[] = "\x02\x10 approved";
+    uint8_t buf[64];
+
+    {
+        ISO8583::TReplayCache cache(4, keymask, 0);
+        assert( 0 == cache.Lookup(req, buf, sizeof(buf)) );
+        assert( 0 == cache.Store(req, resp, sizeof(resp)) );
+
+        // Retransmissions and the same request with different non-identity fields hit the cache.
+        ISO8583::TISO8583 repeat(req);
+        repeat.SetMTI(0x0201);
+        assert( 0 == repeat.Fields().SetData(7, "\x10\x19\x12\x00\x05", 5) );
+        memset(buf, 0, sizeof(buf));
+        assert( sizeof(resp) == cache.Lookup(repeat, buf, sizeof(buf)) );
+        assert( 0 == memcmp(buf, resp, sizeof(resp)) );
+        assert( ISO8583_ERR_BUF_NOT_ENOUGH == cache.Lookup(repeat, buf, 4) );
+
+        // Other messages do not, including a reversal of the same transaction.
+        ISO8583::TISO8583 other(req);
+        assert( 0 == other.Fields().SetData(11, "\x00\x00\x02", 3) );
+        assert( 0 == cache.Lookup(other, buf, sizeof(buf)) );
+        other = req;
+        other.SetMTI(0x0400);
+        assert( 0 == cache.Lookup(other, buf, sizeof(buf)) );
+        other = req;
+        other.Fields().Erase(37);
+        assert( 0 == cache.Lookup(other, buf, sizeof(buf)) );
+
+        ISO8583::TISO8583 anonymous;
+        anonymous.SetMTI(0x0200);
+        assert( ISO8583_ERR_INVALID_ARG == cache.Lookup(anonymous, buf, sizeof(buf)) );
+        assert( ISO8583_ERR_INVALID_ARG == cache.Store(anonymous, resp, sizeof(resp)) );
+
+        // Stored again replaces the response.
+        assert( 0 == cache.Store(repeat, "\x02\x10", 2) );
+        assert( 2 == cache.Lookup(req, buf, sizeof(buf)) );
+
+        iso8583_replay_stats_t stats = cache.GetStats();
+        assert( stats.hits == 2 && stats.misses == 4 && stats.stores == 2 && stats.count == 1 );
+
+        // The oldest entries are evicted when the cache is full.
+        for(int i=2; i<=5; ++i)
+        {
+            uint8_t stan[3] = { 0, 0, (uint8_t) i };
+            assert( 0 == other.Fields().SetData(11, stan, 3) );
+            other.SetMTI(0x0200);
+            other.Fields().SetData(37, "000000000001", 12);
+            assert( 0 == cache.Store(other, resp, sizeof(resp)) );
+        }
+        assert( 0 == cache.Lookup(req, buf, sizeof(buf)) );
+        assert( 0 <  cache.Lookup(other, buf, sizeof(buf)) );
+        stats = cache.GetStats();
+        assert( stats.evictions == 1 && stats.count == 4 );
+
+        cache.Remove(other);
+        assert( 0 == cache.Lookup(other, buf, sizeof(buf)) );
+        cache.Clear();
+        assert( 0 == cache.GetStats().count );
+    }
+
+    {
+        // Entries expire after their time to live.
+        ISO8583::TReplayCache cache(16, keymask, 20);
+        assert( 0 == cache.Store(req, resp, sizeof(resp)) );
+        assert( 0 <  cache.Lookup(req, buf, sizeof(buf)) );
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        assert( 0 == cache.Lookup(req, buf, sizeof(buf)) );
+
+        iso8583_replay_stats_t stats = cache.GetStats();
+        assert( stats.expirations == 1 && stats.count == 0 );
+    }
+
+    {
+        // Concurrent stores and lookups of a sharded cache.
+        ISO8583::TReplayCache cache(100000, keymask, 0);
+        std::vector<std::thread> threads;
+        for(int t=0; t<4; ++t)
+        {
+            threads.push_back(std::thread([&cache, &req, t]()
+            {
+                ISO8583::TISO8583 msg(req);
+                uint8_t out[64];
+                for(int i=0; i<10000; ++i)
+                {
+                    uint8_t stan[3] = { (uint8_t) t, (uint8_t)( i >> 8 ), (uint8_t) i };
+                    msg.Fields().SetData(11, stan, 3);
+                    assert( 0 == cache.Store(msg, resp, sizeof(resp)) );
+                    assert( sizeof(resp) == cache.Lookup(msg, out, sizeof(out)) );
+                }
+            }));
+        }
+        for(std::thread &thread : threads)
+            thread.join();
+
+        iso8583_replay_stats_t stats = cache.GetStats();
+        assert( stats.count == 40000 && stats.hits == 40000 && !stats.evictions );
+    }
+
+    {
+        // A cache failed to be initialized rejects all operations.
+        ISO8583::TReplayCache cache(0, keymask, 0);
+        uint8_t out[64];
+        assert( ISO8583_ERR_INVALID_ARG == cache.Store(req, resp, sizeof(resp)) );
+        assert( ISO8583_ERR_INVALID_ARG == cache.Lookup(req, out, sizeof(out)) );
+        cache.Remove(req);
+        cache.Clear();
+        iso8583_replay_stats_t stats = cache.GetStats();
+        assert( !stats.count && !stats.stores && !stats.misses );
+    }
+}
+
+static
+int on_dispatched(void *userarg, void *context, iso8583_t *msg, int resp_mti)
+{
+    *static_cast<int*>(context) = resp_mti;
+    return (int)(intptr_t) userarg;
+}
+
+void test_dispatch()
+{
+    assert( 0x0210 == ISO8583::mti::GetResponse(0x0200) );
+    assert( 0x0210 == ISO8583::mti::GetResponse(0x0201) );
+    assert( 0x1432 == ISO8583::mti::GetResponse(0x1422) );
+    assert( 0x0810 == ISO8583::mti::GetResponse(0x0800) );
+    assert( 0x2170 == ISO8583::mti::GetResponse(0x2160) );
+    assert( -1 == ISO8583::mti::GetResponse(0x0210) );
+    assert( -1 == ISO8583::mti::GetResponse(0x0280) );
+    assert( -1 == ISO8583::mti::GetResponse(0x0206) );
+
+    ISO8583::TDispatcher disp;
+    ISO8583::TISO8583    msg;
+    int                  resp_mti = 0;
+
+    msg.SetMTI(0x0200);
+    assert( ISO8583_ERR_NO_HANDLER == disp.Dispatch(msg, &resp_mti) );
+
+    // The most specific pattern wins, no matter the order they are registered;
+    // and the last registered wins between patterns of the same specificity.
+    assert( 0 == disp.Set(0x0200, 0, on_dispatched, (void*) 200) );
+    assert( 0 == disp.Set(0x0000, ISO8583_MTI_CLA_MASK | ISO8583_MTI_ORI_MASK, on_dispatched, (void*) 1) );
+    assert( 0 == disp.Set(0x0800, ISO8583_MTI_FUN_MASK | ISO8583_MTI_ORI_MASK, on_dispatched, (void*) 8) );
+    assert( 0 == disp.Set(0x0400, ISO8583_MTI_FUN_MASK | ISO8583_MTI_ORI_MASK, on_dispatched, (void*) 4) );
+    assert( 0 == disp.Set(0x0820, 0, NULL, NULL) );
+    assert( ISO8583_ERR_INVALID_ARG == disp.Set(0x0200, ISO8583_MTI_VER_MASK, on_dispatched, NULL) );
+
+    static const struct { int mti, res, resp_mti; } cases[] =
+    {
+        { 0x0200, 200   , 0x0210 },
+        { 0x1200, 200   , 0x1210 },  // The version is not indexed.
+        { 0x0201, 1     , 0x0210 },  // Origin of financial requests falls back to the requests of all classes.
+        { 0x0100, 1     , 0x0110 },
+        { 0x0421, 4     , 0x0430 },
+        { 0x0430, 4     , -1     },
+        { 0x0800, 8     , 0x0810 },
+        { 0x0810, 8     , -1     },
+        { 0x0820, ISO8583_ERR_NO_HANDLER, 0 },
+        { 0x0220, ISO8583_ERR_NO_HANDLER, 0 },
+    };
+    for(auto &c : cases)
+    {
+        resp_mti = 0;
+        msg.SetMTI(c.mti);
+        assert( c.res == disp.Dispatch(msg, &resp_mti) );
+        assert( c.resp_mti == resp_mti );
+    }
+
+    // The default handler takes messages which no pattern matches.
+    disp.SetDefault(on_dispatched, (void*) -1);
+    msg.SetMTI(0x0220);
+    assert( -1 == disp.Dispatch(msg, &resp_mti) );
+    assert( 0x0230 == resp_mti );
+    msg.SetMTI(0x0820);
+    assert( ISO8583_ERR_NO_HANDLER == disp.Dispatch(msg, &resp_mti) );
+
+    // A pattern registered again replaces the handler, and function objects can be registered.
+    int  count = 0;
+    auto func  = [&count](ISO8583::TISO8583 &msg, void *context, int resp_mti)
+    {
+        ++count;
+        return msg.GetMTI() + resp_mti;
+    };
+    assert( 0 == disp.Set(0x0200, 0, func) );
+    msg.SetMTI(0x0200);
+    assert( 0x0200 + 0x0210 == disp.Dispatch(msg) );
+    assert( count == 1 );
+}
+
+void test_make_response()
+{
+    ISO8583::TISO8583 req;
+    req.TPDU().SetID(0x60);
+    req.TPDU().SetDest(0x0001);
+    req.TPDU().SetSrc(0x0002);
+    req.SetMTI(0x0201);
+    assert( 0 == req.Fields().SetData( 2, "\x45\x11\x11\x11\x11\x11\x11\x11", 8) );
+    assert( 0 == req.Fields().SetData( 3, "\x00\x00\x00", 3) );
+    assert( 0 == req.Fields().SetData( 4, "\x00\x00\x00\x01\x25\x00", 6) );
+    assert( 0 == req.Fields().SetData(11, "\x00\x00\x01", 3) );
+    assert( 0 == req.Fields().SetData(35, "\x45\x11\x11\x11\x11\x11\x11\x11\xD2\x51\x22\x01", 12) );
+    assert( 0 == req.Fields().SetData(41, "TERM0001", 8) );
+    assert( 0 == req.Fields().SetData(52, "\x01\x23\x45\x67\x89\xAB\xCD\xEF", 8) );
+
+    ISO8583::TFieldMask echo(false);
+    echo.Add(2).Add(3).Add(4).Add(11).Add(41);
+
+    // Echo fields are shared with the request, and request only fields are dropped.
+    ISO8583::TISO8583 resp;
+    assert( 0 == resp.Fields().SetData(39, "05", 2) );
+    assert( 0 == resp.MakeResponse(req, -1, echo.cptr()) );
+    assert( resp.GetMTI() == 0x0210 );
+    assert( resp.TPDU().GetDest() == 0x0002 && resp.TPDU().GetSrc() == 0x0001 );
+    assert( resp.Fields().GetCount() == 5 );
+    assert( !resp.Fields().GetItem(35).GetID() && !resp.Fields().GetItem(52).GetID() && !resp.Fields().GetItem(39).GetID() );
+    assert( resp.Fields().GetItem(41).IsShared() );
+    assert( resp.Fields().GetItem(41).GetData() == req.Fields().GetItem(41).GetData() );
+    assert( resp.Fields().Equal(req.Fields(), echo.cptr()) );
+    assert( 0 == resp.Fields().SetData(39, "00", 2) );
+
+    // A response made in place keeps the payloads of the request, and is encoded the same.
+    ISO8583::TISO8583 inplace(req);
+    const void *pan = inplace.Fields().GetItem(2).GetData();
+    assert( 0 == inplace.MakeResponse(0x0230, echo.cptr()) );
+    assert( inplace.GetMTI() == 0x0230 );
+    assert( inplace.TPDU().GetDest() == 0x0002 );
+    assert( inplace.Fields().GetItem(2).GetData() == pan );
+    assert( inplace.Fields().GetCount() == 5 );
+    assert( 0 == inplace.Fields().SetData(39, "00", 2) );
+    inplace.SetMTI(0x0210);
+
+    uint8_t buf1[128], buf2[128];
+    int size = resp.Encode(buf1, sizeof(buf1), 0);
+    assert( size > 0 && size == inplace.Encode(buf2, sizeof(buf2), 0) );
+    assert( 0 == memcmp(buf1, buf2, size) );
+
+    // The standard echo fields, without the sensitive ones, and messages which have no response.
+    ISO8583::TFieldMask standard(false);
+    standard.Add(2).Add(3).Add(4).Add(7).Add(11).Add(12).Add(13).Add(22).Add(25).Add(32).Add(37).Add(41).Add(42).Add(49);
+    assert( 0 == req.Fields().SetData(37, "REF000000001", 12) );
+    assert( 0 == req.Fields().SetData(55, "\x9F\x26\x01\x00", 4) );
+    assert( 0 == resp.MakeResponse(req) );
+    assert( resp.Fields().GetCount() == 6 );
+    assert( resp.Fields().GetItem(37).GetID() == 37 );
+    assert( !resp.Fields().GetItem(35).GetID() && !resp.Fields().GetItem(52).GetID() && !resp.Fields().GetItem(55).GetID() );
+    assert( resp.Fields().Equal(req.Fields(), standard.cptr()) );
+    assert( !resp.Fields().Equal(req.Fields()) );
+    assert( ISO8583_ERR_INVALID_ARG == inplace.MakeResponse() );
+    assert( inplace.GetMTI() == 0x0210 );
 }
 
 int main(int argc, char *argv[])
@@ -370,6 +2025,26 @@ int main(int argc, char *argv[])
     test_total_message();
     test_helper_tools();
     test_exchange();
+    test_queue();
+    test_pool();
+    test_buffer_reuse();
+    test_stan();
+    test_decoder();
+    test_allocator();
+    test_exchange_stats();
+    test_trace();
+    test_charset_validation();
+    test_typed_fields();
+    test_tlv();
+    test_subfield();
+    test_tertiary_bitmap();
+    test_text_mti_bitmap();
+    test_ebcdic_message();
+    test_template();
+    test_equal_hash();
+    test_replay();
+    test_dispatch();
+    test_make_response();
 
     return 0;
 }